@@ -29,5 +29,7 @@
 #include "async/runner.h"
 #include "async/task.h"
 #include "async/event_sources.h"
+#include "async/channel.h"
+#include "async/task_group.h"
 
 #endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_f628b2e5_4335_4d10_be65_8bff3841656d)
+#define      cool_ng_f628b2e5_4335_4d10_be65_8bff3841656d
+
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "cool/ng/impl/platform.h"
+#include "cool/ng/exception.h"
+#include "cool/ng/impl/async/channel.h"
+
+namespace cool { namespace ng { namespace async {
+
+/**
+ * Channel between producers and a runner.
+ *
+ * Channel objects pass items of type @a T from any number of producers to the
+ * user @em Callable @a h_, called from a task submitted to @ref runner @a r_.
+ * The producers place the items into a lock-free multi-producer single-consumer
+ * queue via @ref send() and @ref try_send() and never block. The handler
+ * receives the items in batches, in the order they were sent, thus a single
+ * task submitted to the runner may deliver many items. At most one handler
+ * call for the channel is scheduled with the runner at any time.
+ *
+ * The channel can be bounded, with the queue capacity set at creation, or
+ * unbounded.
+ *
+ * @note Channel objects created via copy construction or copy assignment
+ *   are clones and refer to the same underlying channel implementation.
+ * @note The pending items are delivered even if all channel objects referring
+ *   to the channel implementation get destroyed, as long as the runner exists.
+ * @note The exceptions thrown by the handler are caught and ignored.
+ */
+template <typename T>
+class channel
+{
+ public:
+  /**
+   * Default constructor to allow @ref channel "channels" to be stored in
+   * standard library containers.
+   *
+   * This constructor constructs an empty, non-functional @ref channel.
+   *
+   * @note The only permitted operations on an empty channel are copy assignment
+   *   and the @ref operator bool() "bool" conversion operator. Any other
+   *   operation will throw @ref cool::ng::exception::empty_object "empty_object"
+   *   exception.
+   */
+  channel() { /* noop */ }
+
+  /**
+   * Create a channel object.
+   *
+   * @tparam RunnerT <b>RunnerT</b> is the actual type of the @ref runner to
+   *         use to schedule calls to user @em Callable.
+   * @tparam HandlerT <b>HandlerT</b> is the actual type of the user @em Callable
+   *         and must be assignable to the following functional type:
+   * ~~~{.c}
+   *     std::function<void(const std::shared_ptr<RunnerT>&, std::vector<T>&)>
+   * ~~~
+   *
+   * @param r_ the @ref runner to use to schedule the calls to the handler
+   * @param h_ the user @em Callable to be called with a batch of items
+   * @param capacity_ the capacity of the channel, rounded up to the next power
+   *        of two, or 0 for unbounded channel
+   * @param batch_ the maximal number of items passed to single handler call
+   *
+   * @throw exception::illegal_argument thrown if the handler @a h_ is empty or
+   *        if the batch size is 0
+   * @throw exception::runner_not_available thrown if the runner @a r_ no longer
+   *        exists at the moment of construction
+   */
+  template <typename RunnerT, typename HandlerT>
+  channel(const std::weak_ptr<RunnerT>& r_
+        , const HandlerT& h_
+        , std::size_t capacity_ = 0
+        , std::size_t batch_ = 64)
+    : m_impl(cool::ng::util::shared_new<detail::channel<RunnerT, T>>(r_, h_, capacity_, batch_))
+  { /* noop */ }
+
+  /**
+   * Send an item through the channel.
+   *
+   * @param v_ the item to send
+   *
+   * @throw exception::operation_failed with error code @c resource_busy if the
+   *        bounded channel is full
+   * @throw exception::runner_not_available if the runner no longer exists
+   * @throw exception::empty_object if called on the empty channel object
+   */
+  void send(const T& v_)
+  {
+    send(T(v_));
+  }
+
+  /**
+   * @copydoc send(const T&)
+   */
+  void send(T&& v_)
+  {
+    if (!try_send(std::move(v_)))
+      throw exception::operation_failed(error::errc::resource_busy);
+  }
+
+  /**
+   * Send an item through the channel if there is room.
+   *
+   * @param v_ the item to send
+   * @return true if the item was sent, false if the bounded channel is full
+   *
+   * @throw exception::runner_not_available if the runner no longer exists
+   * @throw exception::empty_object if called on the empty channel object
+   */
+  bool try_send(const T& v_)
+  {
+    return try_send(T(v_));
+  }
+
+  /**
+   * @copydoc try_send(const T&)
+   */
+  bool try_send(T&& v_)
+  {
+    if (!m_impl)
+      throw exception::empty_object();
+    return m_impl->push(std::move(v_));
+  }
+
+  /**
+   * Empty channel predicate.
+   *
+   * @return true if this @ref channel is properly created and functional, false if empty.
+   */
+  explicit operator bool() const
+  {
+    return static_cast<bool>(m_impl);
+  }
+
+ private:
+  std::shared_ptr<detail::itf::channel<T>> m_impl;
+};
+
+} } } // namespace
+
+#endif
@@ -29,14 +29,27 @@
 #include <functional>
 
 #include "cool/ng/impl/platform.h"
+#include "cool/ng/async/timer_stats.h"
 #include "cool/ng/ip_address.h"
 #include "cool/ng/impl/async/event_sources_types.h"
 #include "cool/ng/impl/async/event_sources.h"
 
 #include "net/stream.h"
 #include "net/server.h"
+#include "net/datagram.h"
+#include "net/framing.h"
 
 namespace cool { namespace ng { namespace async {
+
+/**
+ * Tag type selecting the timing wheel timer service for the @ref timer.
+ */
+struct timer_wheel_t { };
+/**
+ * Tag value selecting the timing wheel timer service for the @ref timer.
+ */
+constexpr timer_wheel_t timer_wheel { };
+
 /**
  * Timer event source.
  *
@@ -241,6 +254,72 @@ class timer
     impl->initialize(p_, l_);
     m_impl = impl;
   }
+
+  /**
+   * Create a timer object using the timing wheel timer service.
+   *
+   * Creates a timer object with the specified period which, rather than
+   * using its own platform timer, is driven by the process wide timing wheel
+   * timer service. The timing wheel uses a single platform timer for all its
+   * timers, with O(1) start and stop, and delivers the expirations of all
+   * timers using the same @ref runner in a single batch. It is intended for
+   * large numbers of timers, such as per-connection idle timers, where the
+   * precision of the platform timer is not needed.
+   *
+   * @tparam RunnerT <b>RunnerT</b> is the actual type of the @ref runner to
+   *         use to schedule calls to user @em Callable.
+   * @tparam HandlerT <b>HandlerT</b> is the actual type of the user @em Callable
+   *         and must be assignable to the following functional type:
+   * ~~~{.c}
+   *     std::function<void(const std::shared_ptr<RunnerT>&)>
+   * ~~~
+   * @tparam RepT <b>RepT</b> is mapped into @c Rep template parameter of
+   *         @c std::chrono::duration class template.
+   * @tparam PeriodT <b>PeriodT</b> is mapped into @c Period template parameter of
+   *         @c std::chrono::duration class template.
+   *
+   * @param r_ the @ref runner to use to schedule the periodic task
+   * @param h_ the user @em Callable to be called from periodic task.
+   * @param p_ period of the timer.
+   *
+   * @throw exception::illegal_argument thrown if period, when converted
+   *        to microseconds, is equal to 0 or if the handler @a h_ is empty
+   * @throw exception::runner_not_available thrown if the runner @a r_ no longer
+   *        exists at the moment of construction
+   *
+   * @note The resolution of the timing wheel is one millisecond; the period
+   *       is rounded up to the whole milliseconds and the leeway is not used.
+   */
+  template <typename RunnerT, typename HandlerT, typename RepT, typename PeriodT>
+  timer(const std::weak_ptr<RunnerT>& r_
+      , const HandlerT& h_
+      , const std::chrono::duration<RepT, PeriodT>& p_
+      , const timer_wheel_t& w_)
+    : timer(r_
+          , h_
+          , static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(p_).count())
+          , w_)
+  { /* noop */ }
+
+  /**
+   * Create a timer object using the timing wheel timer service.
+   *
+   * @param r_ the @ref runner to use to schedule the periodic task
+   * @param h_ the user @em Callable to be called from periodic task.
+   * @param p_ period of the timer, in microseconds.
+   *
+   * See the constructor above for details.
+   */
+  template <typename RunnerT, typename HandlerT>
+  timer(const std::weak_ptr<RunnerT>& r_
+      , const HandlerT& h_
+      , uint64_t p_
+      , const timer_wheel_t&)
+  {
+    auto impl = cool::ng::util::shared_new<detail::timer<RunnerT>>(r_, h_);
+    impl->initialize(p_);
+    m_impl = impl;
+  }
   /**
    * Change the period of the timer.
    *
@@ -319,6 +398,51 @@ class timer
    */
   dlldecl void start();
 
+  /**
+   * Arm the timer to expire once.
+   *
+   * Arms the timer to call the user @em Callable once, one full period after
+   * the call to start_once(). Calling start_once() again before the timer
+   * expires moves the deadline rather than adding another expiration; this
+   * makes one-shot timers suitable for deadlines that are pushed back on
+   * every activity, such as per-request timeouts. Neither the re-arming nor
+   * the expiration requires the timer to be stopped.
+   *
+   * A call to start() returns the timer to periodic operation and a call to
+   * stop() disarms it.
+   */
+  dlldecl void start_once();
+
+  /**
+   * Arm the timer to expire once after the specified delay.
+   *
+   * @param d_ delay, in microseconds, until the timer expires. The delay
+   *           does not change the period of the timer.
+   *
+   * @exception cool::exception::illegal_argument Thrown if the delay is 0.
+   *
+   * See start_once() for details.
+   */
+  dlldecl void start_once(uint64_t d_);
+
+  /**
+   * Arm the timer to expire once after the specified delay.
+   *
+   * @tparam RepT <b>RepT</b> is mapped into @c Rep template parameter of
+   *         @c std::chrono::duration class template.
+   * @tparam PeriodT <b>PeriodT</b> is mapped into @c Period template parameter of
+   *         @c std::chrono::duration class template.
+   *
+   * @param d_ delay until the timer expires.
+   *
+   * See start_once() for details.
+   */
+  template <typename RepT, typename PeriodT>
+  void start_once(const std::chrono::duration<RepT, PeriodT>& d_)
+  {
+    start_once(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d_).count()));
+  }
+
   /**
    * Suspend the timer.
    *
@@ -342,10 +466,136 @@ class timer
    */
   dlldecl const std::string& name() const;
 
+  /**
+   * Return timer's accuracy statistics.
+   *
+   * Returns the histograms of the delays of this timer's expirations. The
+   * statistics are only collected for timers created while the
+   * instrumentation was enabled; for other timers all values are 0.
+   *
+   * @see instrument()
+   */
+  dlldecl timer_stats stats() const;
+
+  /**
+   * Enable or disable timer instrumentation.
+   *
+   * When enabled, all @ref timer "timers" created afterwards record, for
+   * each expiration, the delays described at @ref timer_stats into their
+   * own statistics and into the process wide aggregate statistics. Enabling
+   * or disabling the instrumentation does not affect already created timers.
+   * The instrumentation is disabled by default.
+   *
+   * @note On GCD platform the instrumented timers fire on a global queue and
+   *   submit the user @em Callable to their @ref runner, in order to tell the
+   *   two delays apart. Uninstrumented timers fire directly on the runner's
+   *   queue.
+   */
+  dlldecl static void instrument(bool enable_);
+
+  /**
+   * Return the aggregate accuracy statistics of all instrumented timers.
+   */
+  dlldecl static timer_stats aggregate_stats();
+
  private:
   std::shared_ptr<detail::itf::timer> m_impl;
 };
 
+/**
+ * Signal event source.
+ *
+ * Signal objects can be triggered from any thread, with a value, to submit
+ * a task to @ref runner @a r_ that calls the user @em Callable @a h_ with
+ * the value. The triggers are coalesced: the values of all triggers that
+ * arrive before the user @em Callable runs are merged, either added together
+ * or combined using bitwise or, and delivered to a single call. Signals are
+ * thus suitable for notifying the runner about the events that may occur
+ * much more frequently than they need to be processed, such as the arrival
+ * of work into a shared queue, without submitting a task per event.
+ *
+ * The signals map onto the native mechanism of the platform, as follows:
+ *   Platform        | Mechanism
+ *   ----------------|-----------------
+ *    MacOS/OS X     | @c DISPATCH_SOURCE_TYPE_DATA_ADD or @c DISPATCH_SOURCE_TYPE_DATA_OR dispatch source
+ *    Linux          | @c DISPATCH_SOURCE_TYPE_DATA_ADD or @c DISPATCH_SOURCE_TYPE_DATA_OR dispatch source
+ *    MS Windows     | completion port post of the merged value
+ *
+ * @note Upon creation the signal object is active and ready to be triggered.
+ * @note Signal objects created via copy construction or copy assignment
+ *   are clones and refer to the same underlying signal implementation.
+ */
+class signal_source
+{
+ public:
+  /**
+   * Default constructor to allow @ref signal_source "signals" to be stored in
+   * standard library containers.
+   *
+   * @note The only permitted operations on an empty signal are copy assignment
+   *   and the @ref operator bool() "bool" conversion operator. Any other
+   *   operation will throw @ref cool::ng::exception::empty_object "empty_object"
+   *   exception.
+   */
+  signal_source() { /* noop */ }
+
+  /**
+   * Create a signal object.
+   *
+   * @tparam RunnerT <b>RunnerT</b> is the actual type of the @ref runner to
+   *         use to schedule calls to user @em Callable.
+   * @tparam HandlerT <b>HandlerT</b> is the actual type of the user @em Callable
+   *         and must be assignable to the following functional type:
+   * ~~~{.c}
+   *     std::function<void(const std::shared_ptr<RunnerT>&, unsigned long)>
+   * ~~~
+   *
+   * @param r_ the @ref runner to use to schedule the calls to the user @em Callable
+   * @param h_ the user @em Callable to be called with the merged value
+   * @param m_ the merge mode of the trigger values
+   *
+   * @throw exception::illegal_argument thrown if the handler @a h_ is empty
+   * @throw exception::runner_not_available thrown if the runner @a r_ no longer
+   *        exists at the moment of construction
+   */
+  template <typename RunnerT, typename HandlerT>
+  signal_source(const std::weak_ptr<RunnerT>& r_
+              , const HandlerT& h_
+              , signal_merge m_ = signal_merge::add)
+  {
+    auto impl = cool::ng::util::shared_new<detail::signal_source<RunnerT>>(r_, h_);
+    impl->initialize(m_);
+    m_impl = impl;
+  }
+
+  /**
+   * Trigger the signal.
+   *
+   * Merges the value @a v_ into the value pending for the next call of the
+   * user @em Callable and, unless the call is already pending, submits it
+   * to the runner. This method may be called from any thread.
+   *
+   * @param v_ the value to merge; the value 0 has no effect.
+   */
+  dlldecl void trigger(unsigned long v_ = 1);
+
+  /**
+   * Empty signal predicate.
+   *
+   * @return true if this @ref signal_source is properly created and functional,
+   *   false if empty.
+   */
+  dlldecl explicit operator bool() const;
+
+  /**
+   * Return signal's name.
+   */
+  dlldecl const std::string& name() const;
+
+ private:
+  std::shared_ptr<detail::itf::signal> m_impl;
+};
+
 } } } // namespace
 
 #endif
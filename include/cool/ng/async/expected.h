@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_ff71bb0b_92dc_4ff1_aa74_d4a56cf40bab)
+#define      cool_ng_ff71bb0b_92dc_4ff1_aa74_d4a56cf40bab
+
+#include <system_error>
+#include <utility>
+#include <boost/optional.hpp>
+
+#include "cool/ng/impl/platform.h"
+
+namespace cool { namespace ng { namespace async {
+
+/**
+ * Error value of the failed @ref expected result.
+ *
+ * The objects of this class are used to construct the @ref expected result
+ * that reports failure rather than the value.
+ */
+class unexpected
+{
+ public:
+  /**
+   * Construct error value from the error code.
+   */
+  explicit unexpected(const std::error_code& e_) : m_error(e_)
+  { /* noop */ }
+  /**
+   * Return the error code.
+   */
+  const std::error_code& error() const
+  {
+    return m_error;
+  }
+
+ private:
+  std::error_code m_error;
+};
+
+/**
+ * Result of the task that may fail without throwing an exception.
+ *
+ * The user Callable of the @ref tag::simple "simple" task may return
+ * @c expected<T> instead of @c T to signal a failure without throwing an
+ * exception. The result type of such task is @c T. If the returned object
+ * contains the value, the value is reported as the task result. If the returned
+ * object contains the error, the task fails and the compound tasks propagate
+ * the error code the same way as they propagate exceptions, except that no
+ * exception is thrown or rethrown on the way. The @ref tag::intercept "intercept"
+ * compound task dispatches the error code to its @em catch tasks as described
+ * at @ref tag::intercept "intercept" task.
+ *
+ * @code
+ *   auto t = factory::create(r,
+ *     [] (const std::shared_ptr<my_runner>& r, const std::string& key) -> expected<int>
+ *     {
+ *       auto it = r->cache.find(key);
+ *       if (it == r->cache.end())
+ *         return unexpected(std::make_error_code(std::errc::no_such_file_or_directory));
+ *       return it->second;
+ *     });
+ * @endcode
+ */
+template <typename T>
+class expected
+{
+ public:
+  using value_type = T;
+
+ public:
+  /**
+   * Construct result containing the value.
+   */
+  expected(const T& v_) : m_value(v_)
+  { /* noop */ }
+  /**
+   * Construct result containing the value.
+   */
+  expected(T&& v_) : m_value(std::move(v_))
+  { /* noop */ }
+  /**
+   * Construct result containing the error.
+   */
+  expected(const unexpected& e_) : m_error(e_.error())
+  { /* noop */ }
+  /**
+   * Return true if this object contains the value.
+   */
+  bool has_value() const
+  {
+    return !!m_value;
+  }
+  /**
+   * Return true if this object contains the value.
+   */
+  explicit operator bool() const
+  {
+    return has_value();
+  }
+  /**
+   * Return the value. The behavior is undefined if the object contains error.
+   */
+  T& value()
+  {
+    return *m_value;
+  }
+  /**
+   * Return the value. The behavior is undefined if the object contains error.
+   */
+  const T& value() const
+  {
+    return *m_value;
+  }
+  /**
+   * Return the error code. The error code is empty if the object contains value.
+   */
+  const std::error_code& error() const
+  {
+    return m_error;
+  }
+
+ private:
+  boost::optional<T> m_value;
+  std::error_code    m_error;
+};
+
+/**
+ * Result of the task that does not return value but may fail without throwing
+ * an exception.
+ */
+template <>
+class expected<void>
+{
+ public:
+  using value_type = void;
+
+ public:
+  /**
+   * Construct successful result.
+   */
+  expected() : m_failed(false)
+  { /* noop */ }
+  /**
+   * Construct result containing the error.
+   */
+  expected(const unexpected& e_) : m_error(e_.error()), m_failed(true)
+  { /* noop */ }
+  /**
+   * Return true if this object reports success.
+   */
+  bool has_value() const
+  {
+    return !m_failed;
+  }
+  /**
+   * Return true if this object reports success.
+   */
+  explicit operator bool() const
+  {
+    return has_value();
+  }
+  /**
+   * Return the error code. The error code is empty if the object reports success.
+   */
+  const std::error_code& error() const
+  {
+    return m_error;
+  }
+
+ private:
+  std::error_code m_error;
+  bool            m_failed;
+};
+
+} } } // namespace
+
+#endif
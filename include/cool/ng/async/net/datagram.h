@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_9a4f0e27_6b3c_4d85_a1e2_7c58b0d9f364)
+#define      cool_ng_9a4f0e27_6b3c_4d85_a1e2_7c58b0d9f364
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/ip_address.h"
+#include "cool/ng/impl/platform.h"
+
+#include "cool/ng/impl/async/event_sources_types.h"
+#include "cool/ng/impl/async/net_datagram.h"
+
+namespace cool { namespace ng {
+
+namespace async { namespace net {
+
+/**
+ * Connectionless network event source for UDP datagrams.
+ *
+ * The datagram event source is bound to the local network address and port
+ * and receives the datagrams sent to it from any network peer, including
+ * the datagrams sent to the multicast groups it has joined. The received
+ * datagrams are passed to the user read handler in batches of one or more
+ * datagrams. On Linux platform the datagram event source receives and sends
+ * up to @em batch datagrams per system call, using @c recvmmsg and @c sendmmsg
+ * calls, respectively.
+ *
+ * @note This class is a thin reference counting wrapper of the underlying
+ * datagram implementation. Copies of the @ref datagram refer to the same
+ * implementation instance.
+ *
+ * @note The datagram event source is not available on MS Windows platform.
+ */
+class datagram
+{
+ public:
+  /**
+   * Default constructor to allow @ref datagram "datagrams" to be stored in
+   * standard library containers.
+   *
+   * This constructor constructs an empty, non-functional @ref datagram. The
+   * only permitted operations on an empty datagram are copy assignment and
+   * the @ref operator bool() "bool" conversion operator. Any other operation
+   * will throw @ref cool::ng::exception::empty_object "empty_object" exception.
+   */
+  datagram() { /* noop */ }
+  /**
+   * Constructs a new instance of the datagram event source.
+   *
+   * @tparam RunnerT <b>RunnerT</b> is the concrete type of the @ref cool::ng::async::runner "runner"
+   *         to be used to schedule tasks that will call the read handler.
+   *
+   * @tparam HandlerT <b>HandlerT</b> is the actual type of the read handler.
+   *         This type must be assignable to the following functional type:
+   * ~~~{.c}
+   *     std::function<void(const std::shared_ptr<RunnerT>&, const datagram_message*, std::size_t)>
+   * ~~~
+   *         The first parameter is the shared pointer to the runner. The second
+   *         parameter points to the array of received datagrams and the third
+   *         is the number of datagrams in the array. The datagram payloads
+   *         are only valid for the duration of the handler call.
+   *
+   * @param r_  weak pointer to @ref cool::ng::async::runner "runner" to use to
+   *            schedule the read handler for execution
+   * @param addr_ IP address of the local network interface to bind to, or one
+   *            of @ref cool::ng::net::ipv4::any "ipv4::any" or
+   *            @ref cool::ng::net::ipv6::any "ipv6::any" wildcards
+   * @param port_ UDP port to bind to
+   * @param h_  read handler to be called from the scheduled task when the
+   *            datagrams are received
+   * @param batch_ maximum number of datagrams received or sent per system call
+   *            and passed to a single read handler call
+   * @param size_ maximum size of the received datagram; the longer datagrams
+   *            are dropped
+   * @param opts_ optional @ref socket_options "tuning options" of the socket;
+   *            the TCP related options must be left at their defaults
+   *
+   * @throw cool::ng::exception::socket_failure if any network socket operations failed
+   * @throw cool::ng::exception::illegal_argument if the handler is not callable or
+   *        if either @a batch_ or @a size_ is 0
+   * @throw cool::ng::exception::runner_not_available if the @ref cool::ng::async::runner
+   *        "runner" specified via parameter @a r_ is no longer available
+   * @throw cool::ng::exception::operation_failed with error code @c not_available
+   *        if the platform does not support the datagram event sources
+   */
+  template <typename RunnerT, typename HandlerT>
+  datagram(const std::weak_ptr<RunnerT>& r_
+         , const cool::ng::net::ip::address& addr_
+         , uint16_t port_
+         , const HandlerT& h_
+         , std::size_t batch_ = impl::default_datagram_batch
+         , std::size_t size_ = impl::default_datagram_size
+         , const socket_options& opts_ = socket_options())
+  {
+    using handler = typename detail::types<RunnerT>::datagram_handler;
+
+    auto impl = cool::ng::util::shared_new<detail::datagram<RunnerT>>(r_, static_cast<handler>(h_));
+    m_impl = impl;
+    impl->initialize(addr_, port_, batch_, size_, opts_);
+  }
+
+  dlldecl const std::string& name() const;
+
+  /**
+   * Sends a single datagram.
+   *
+   * @param addr_ IP address of the recipient, or of the multicast group
+   * @param port_ UDP port of the recipient
+   * @param data_ pointer to the payload
+   * @param size_ size of the payload, in bytes
+   *
+   * @return true if the datagram was sent, false if the socket's send buffer
+   *   is full.
+   *
+   * @throw cool::ng::exception::socket_failure if the send failed
+   */
+  dlldecl bool send(const cool::ng::net::ip::address& addr_, uint16_t port_, const void* data_, std::size_t size_);
+  /**
+   * Sends a batch of datagrams.
+   *
+   * Sends the datagrams in the order in which they appear in the vector,
+   * moving up to @em batch datagrams per system call where the platform
+   * supports it. The call stops at the first datagram that does not fit into
+   * the socket's send buffer.
+   *
+   * @param msgs_ datagrams to send, with their recipients
+   *
+   * @return the number of datagrams sent
+   *
+   * @throw cool::ng::exception::socket_failure if the send failed
+   */
+  dlldecl std::size_t send(const std::vector<datagram_message>& msgs_);
+  /**
+   * Joins the multicast group.
+   *
+   * @param group_ address of the multicast group, of the same IP version as
+   *   the address the datagram is bound to
+   *
+   * @throw cool::ng::exception::socket_failure if the join failed
+   */
+  dlldecl void join(const cool::ng::net::ip::address& group_);
+  /**
+   * Leaves the multicast group.
+   *
+   * @param group_ address of the multicast group
+   *
+   * @throw cool::ng::exception::socket_failure if the leave failed
+   */
+  dlldecl void leave(const cool::ng::net::ip::address& group_);
+
+  /**
+   * Empty datagram predicate.
+   *
+   * @return true if this @ref datagram is properly created and functional, false if empty.
+   */
+  dlldecl explicit operator bool() const;
+
+ private:
+  std::shared_ptr<detail::itf::datagram> m_impl;
+};
+
+} } } } // namespace
+
+#endif
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_3e81c6d2_47a9_4f1b_9d05_b26e8f7a4c13)
+#define      cool_ng_3e81c6d2_47a9_4f1b_9d05_b26e8f7a4c13
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "cool/ng/impl/platform.h"
+#include "cool/ng/exception.h"
+
+#include "cool/ng/impl/async/event_sources_types.h"
+
+namespace cool { namespace ng {
+
+namespace async { namespace net {
+
+/**
+ * Byte order of the length prefix of the @ref framer::length_prefixed "length
+ * prefixed" frames.
+ */
+enum class byte_order
+{
+  big_endian,    //!< the most significant byte first, the network byte order
+  little_endian  //!< the least significant byte first
+};
+
+/**
+ * Splitter of the stream data into frames.
+ *
+ * The @ref stream delivers the data as it arrives from the network, without
+ * regard to the boundaries of the application messages. The framer splits
+ * the data into frames of one of the following kinds:
+ *   Kind             | Frame
+ *   -----------------|------
+ *   length prefixed  | 1, 2, 4 or 8 bytes of the payload size, followed by the payload
+ *   delimited        | the payload, followed by the delimiter
+ *   fixed size       | the payload of the fixed size
+ *
+ * The frames that are entirely contained in the data passed to @ref feed()
+ * are passed to the frame callback in place, as views into the data, without
+ * copying. Only the frames that span several @ref feed() calls are assembled
+ * in the framer's internal buffer, which grows as needed.
+ *
+ * Use the @ref framed() adapter to make the read handler of the @ref stream
+ * from the framer and the frame handler.
+ *
+ * @note The framer is not thread safe. The @ref stream calls its read handler
+ *   from one task at a time, which is sufficient.
+ */
+class framer
+{
+ public:
+  /**
+   * Callback receiving the frame payload. The payload is only valid for the
+   * duration of the call.
+   */
+  using frame_callback = std::function<void(const void*, std::size_t)>;
+  /**
+   * Default maximum size of the frame payload, in bytes.
+   */
+  static const std::size_t default_max_size = 16 * 1024 * 1024;
+
+ public:
+  /**
+   * Creates the framer for length prefixed frames.
+   *
+   * @param prefix_ size of the length prefix, in bytes; one of 1, 2, 4 or 8
+   * @param order_ @ref byte_order "byte order" of the length prefix
+   * @param max_size_ maximum size of the frame payload, in bytes
+   *
+   * @throw cool::ng::exception::illegal_argument if the prefix size is not
+   *   one of the supported sizes or if the maximum size is 0.
+   */
+  dlldecl static framer length_prefixed(
+      std::size_t prefix_
+    , byte_order order_ = byte_order::big_endian
+    , std::size_t max_size_ = default_max_size);
+  /**
+   * Creates the framer for delimited frames.
+   *
+   * @param delimiter_ the delimiter, one or more bytes
+   * @param max_size_ maximum size of the frame payload, not counting the
+   *   delimiter, in bytes
+   *
+   * @throw cool::ng::exception::illegal_argument if the delimiter is empty
+   *   or if the maximum size is 0.
+   */
+  dlldecl static framer delimited(const std::string& delimiter_, std::size_t max_size_ = default_max_size);
+  /**
+   * Creates the framer for fixed size frames.
+   *
+   * @param size_ size of the frame, in bytes
+   *
+   * @throw cool::ng::exception::illegal_argument if the size is 0.
+   */
+  dlldecl static framer fixed(std::size_t size_);
+
+  /**
+   * Splits the data into frames.
+   *
+   * Calls the frame callback for each complete frame, in order, and keeps
+   * the trailing incomplete frame, if any, to be completed by the data of the
+   * next call.
+   *
+   * @param data_ the data received from the stream
+   * @param size_ size of the data, in bytes
+   * @param cb_ callback to call for each frame
+   *
+   * @throw cool::ng::exception::parsing_error if the frame exceeds the maximum
+   *   size. The framer discards the data it kept, but the data that follows
+   *   is unlikely to start at the frame boundary.
+   */
+  dlldecl void feed(const void* data_, std::size_t size_, const frame_callback& cb_);
+  /**
+   * Discards the data of the incomplete frame.
+   */
+  dlldecl void reset();
+  /**
+   * Returns the number of bytes of the incomplete frame kept by the framer.
+   */
+  dlldecl std::size_t pending() const;
+
+ private:
+  enum class kind { length, delimiter, fixed };
+
+  framer(kind kind_, std::size_t size_, byte_order order_, const std::string& delimiter_, std::size_t max_);
+  std::size_t frame_size(const uint8_t* data_, std::size_t size_) const;
+  bool complete(const uint8_t*& data_, std::size_t& size_);
+  void deliver(const uint8_t* frame_, std::size_t size_, const frame_callback& cb_) const;
+
+ private:
+  kind                 m_kind;
+  std::size_t          m_size;       // prefix size or fixed frame size
+  byte_order           m_order;
+  std::string          m_delimiter;
+  std::size_t          m_max;
+  std::vector<uint8_t> m_partial;    // incomplete frame spanning the reads
+};
+
+/**
+ * Makes the read handler of the @ref stream that passes whole frames to the
+ * frame handler.
+ *
+ * The returned read handler feeds the received data to its copy of the
+ * @ref framer and calls the frame handler for each frame. It leaves the read
+ * buffer of the @ref stream as it is.
+ *
+ * @tparam RunnerT the concrete type of the @ref cool::ng::async::runner
+ *         "runner" of the @ref stream
+ *
+ * @tparam FrameHandlerT the actual type of the frame handler. This type
+ *         must be assignable to the following functional type:
+ * ~~~{.c}
+ *     std::function<void(const std::shared_ptr<RunnerT>&, const void*, std::size_t)>
+ * ~~~
+ *         The second and the third parameter are the address and the size of
+ *         the frame payload, which is only valid for the duration of the call.
+ *
+ * @tparam ErrorHandlerT the actual type of the error handler. This type
+ *         must be assignable to the following functional type:
+ * ~~~{.c}
+ *     std::function<void(const std::shared_ptr<RunnerT>&, const std::error_code&)>
+ * ~~~
+ *
+ * @param f_ the framer to use
+ * @param hf_ the frame handler
+ * @param he_ optional error handler, called with the @c parsing_error error
+ *        code if the frame exceeds the maximum size; the stream is best
+ *        disconnected as it lost the frame boundary
+ *
+ * @return the read handler for use with the @ref stream constructors
+ */
+template <typename RunnerT
+        , typename FrameHandlerT
+        , typename ErrorHandlerT = typename detail::types<RunnerT>::error_handler>
+typename detail::types<RunnerT>::read_handler framed(
+    const framer& f_
+  , const FrameHandlerT& hf_
+  , const ErrorHandlerT& he_ = ErrorHandlerT())
+{
+  using frame_handler = typename detail::types<RunnerT>::frame_handler;
+  using error_handler = typename detail::types<RunnerT>::error_handler;
+
+  auto state = std::make_shared<framer>(f_);
+  frame_handler hf = hf_;
+  error_handler he = he_;
+
+  return [state, hf, he] (const std::shared_ptr<RunnerT>& r_, void*& buf_, std::size_t& size_)
+  {
+    try
+    {
+      state->feed(
+          buf_
+        , size_
+        , [&r_, &hf] (const void* frame_, std::size_t fsize_)
+          {
+            try { hf(r_, frame_, fsize_); } catch (...) { /* noop */ }
+          });
+    }
+    catch (const cool::ng::exception::parsing_error& e)
+    {
+      if (he)
+        he(r_, e.code());
+    }
+  };
+}
+
+} } } } // namespace
+
+#endif
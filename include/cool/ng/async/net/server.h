@@ -33,6 +33,7 @@
 #include "cool/ng/ip_address.h"
 #include "cool/ng/impl/platform.h"
 
+#include "cool/ng/async/net/stream_stats.h"
 #include "cool/ng/impl/async/event_sources_types.h"
 #include "cool/ng/impl/async/net_server.h"
 
@@ -119,6 +120,8 @@ class server
    * @param sf_ stream factory to use to spawn new @ref stream "streams" for
    *            connected peers
    * @param he_ error handle to be called should the server detect network errors
+   * @param opts_ optional @ref socket_options "tuning options" of the listen
+   *            socket; the accepted connections inherit these options
    *
    * @throw cool::ng::exception::socket_failure if any network socket operations failed
    * @throw cool::ng::exception::runner_not_available if the @ref cool::ng::async::runner
@@ -139,7 +142,8 @@ class server
        , uint16_t port_
        , const StreamFactoryT& sf_
        , const ConnectHandlerT& hc_
-       , const ErrorHandlerT& he_ = ErrorHandlerT())
+       , const ErrorHandlerT& he_ = ErrorHandlerT()
+       , const socket_options& opts_ = socket_options())
   {
     using stream_factory  = typename detail::types<RunnerT>::stream_factory;
     using connect_handler = typename detail::types<RunnerT>::connect_handler;
@@ -152,7 +156,65 @@ class server
       , static_cast<error_handler>(he_));
 
     m_impl = impl;
-    impl->initialize(addr_, port_);
+    impl->initialize(addr_, port_, opts_);
+  }
+
+  /**
+   * Constructs new instance of server listening at the local endpoint.
+   *
+   * The server listens at the Unix domain socket rather than at the network
+   * address. The file system path of the @ref local_endpoint must not exist
+   * when the server is constructed; the server removes it when destroyed.
+   * The stream factory is called with the unspecified IPv6 address and port
+   * 0 as the local peers have no network address.
+   *
+   * <b>Template Parameters</b><br>
+   * See the above constructor for details on the template parameters.
+   *
+   * @param r_  weak pointer to @ref cool::ng::async::runner "runner" to use to
+   *            schedule asynchronous notifications for execution.
+   * @param ep_ the @ref local_endpoint "local endpoint" to listen at
+   * @param sf_ stream factory to use to spawn new @ref stream "streams" for
+   *            connected peers
+   * @param hc_ read handler to be called from the scheduled task when a new connect
+   *            request has been detected.
+   * @param he_ error handle to be called should the server detect network errors
+   * @param opts_ optional @ref socket_options "tuning options" of the listen
+   *            socket; the options specific to TCP are ignored
+   *
+   * @throw cool::ng::exception::socket_failure if any network socket operations failed
+   * @throw cool::ng::exception::illegal_argument if the path of the endpoint
+   *        is empty or too long
+   * @throw cool::ng::exception::runner_not_available if the @ref cool::ng::async::runner
+   *        "runner" specified via parameter @a r_ is no longer available
+   * @throw cool::ng::exception::operation_failed with the error code
+   *        @c not_available if the platform does not support local endpoints
+   * @throw std::bad_alloc if the internal memory allocation failed
+   */
+  template <typename RunnerT
+          , typename StreamFactoryT
+          , typename ConnectHandlerT
+          , typename ErrorHandlerT = typename detail::types<RunnerT>::error_handler
+  >
+  server(const std::weak_ptr<RunnerT>& r_
+       , const local_endpoint& ep_
+       , const StreamFactoryT& sf_
+       , const ConnectHandlerT& hc_
+       , const ErrorHandlerT& he_ = ErrorHandlerT()
+       , const socket_options& opts_ = socket_options())
+  {
+    using stream_factory  = typename detail::types<RunnerT>::stream_factory;
+    using connect_handler = typename detail::types<RunnerT>::connect_handler;
+    using error_handler   = typename detail::types<RunnerT>::error_handler;
+
+    auto impl = cool::ng::util::shared_new<detail::server<RunnerT>>(
+        r_
+      , static_cast<stream_factory>(sf_)
+      , static_cast<connect_handler>(hc_)
+      , static_cast<error_handler>(he_));
+
+    m_impl = impl;
+    impl->initialize(ep_, opts_);
   }
   /**
    * Starts the @ref server.
@@ -161,6 +223,17 @@ class server
   dlldecl void stop();
   dlldecl const std::string& name() const;
 
+  /**
+   * Return the aggregate input/output statistics of the accepted connections.
+   *
+   * The aggregate covers both the open and the already closed connections.
+   * The statistics of the open @ref stream "streams" are added up at the
+   * time of the call, while a closed stream adds its statistics to the
+   * server's when it is destroyed. The stream_stats::connections counts the
+   * accepted connections.
+   */
+  dlldecl stream_stats stats() const;
+
   /**
    * Empty server predicate.
    *
@@ -173,7 +246,7 @@ class server
   dlldecl explicit operator bool() const;
 
  private:
-  std::shared_ptr<async::detail::itf::startable> m_impl;
+  std::shared_ptr<detail::itf::server> m_impl;
 };
 
 } } } } // namespace
@@ -26,6 +26,8 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <initializer_list>
 #include <functional>
 #include <cstdint>
 
@@ -33,6 +35,7 @@
 #include "cool/ng/ip_address.h"
 #include "cool/ng/impl/platform.h"
 
+#include "cool/ng/async/net/stream_stats.h"
 #include "cool/ng/impl/async/event_sources_types.h"
 #include "cool/ng/impl/async/net_stream.h"
 
@@ -127,6 +130,8 @@ class stream
    *          detail::oob_event::connect    | The stream successfully connected
    *          detail::oob_event::failure    | The stream failed to connect to network peer
    *          detail::oob_event::disconnect | The network peer closed the connection
+   *          detail::oob_event::write_blocked | The unwritten data reached the high @ref watermarks "watermark"
+   *          detail::oob_event::write_unblocked | The unwritten data dropped to the low @ref watermarks "watermark"
    *
    * @param r_  weak pointer to @ref cool::ng::async::runner "runner" to use to
    *            schedule asynchronous notifications for execution.
@@ -137,16 +142,22 @@ class stream
    * @param he_ event handler to be called from the scheduled tash when an
    *            stream related event occurs
    * @param buf_ data optional data buffer to be used to read received data
-   *            into - if set to @c nullptr the stream will allocate
-   *            its own buffer internally
-   * @param sz_ size of the user provided buffer or, if stream is to allocate
-   *            buffer internally, the size of the buffer to allocate
+   *            into - if set to @c nullptr the stream will read into the
+   *            buffers taken from the runner's buffer pool
+   * @param sz_ size of the user provided buffer or, if stream is to use
+   *            the pooled buffers, the size of the buffer to read into
+   * @param opts_ optional @ref socket_options "tuning options" of the
+   *            stream's socket
    *
    * @throw cool::ng::exception::socket_failure if any network socket operations failed
    * @throw cool::ng::exception::runner_not_available if the @ref cool::ng::async::runner
    *        "runner" specified via parameter @a r_ is no longer available
    * @throw std::bad_alloc if the internal memory allocation failed
    * @sa connect()
+   *
+   * @note The socket options are applied when the stream connects. The streams
+   *   that are created by the @ref server's stream factory first inherit the
+   *   options of the @ref server, then their own options are applied on top.
    */
   template <typename RunnerT, typename ReadHandlerT, typename WriteHandlerT, typename EvtHandlerT>
   stream(const std::weak_ptr<RunnerT>& r_
@@ -154,7 +165,8 @@ class stream
        , const WriteHandlerT& hw_
        , const EvtHandlerT& he_
        , void* buf_ = nullptr
-       , std::size_t sz_ = 16384)
+       , std::size_t sz_ = 16384
+       , const socket_options& opts_ = socket_options())
   {
     using read_handler  = typename detail::types<RunnerT>::read_handler;
     using write_handler = typename detail::types<RunnerT>::write_handler;
@@ -167,7 +179,7 @@ class stream
       , static_cast<event_handler>(he_));
 
     m_impl = impl;
-    impl->initialize(buf_, sz_);
+    impl->initialize(buf_, sz_, opts_);
   }
 
   /**
@@ -199,10 +211,12 @@ class stream
    * @param he_ event handler to be called from the scheduled tash when an
    *            stream related event occurs
    * @param buf_ data optional data buffer to be used to read received data
-   *            into - if set to @c nullptr the stream will allocate
-   *            its own buffer internally
-   * @param sz_ size of the user provided buffer or, if stream is to allocate
-   *            buffer internally, the size of the buffer to allocate
+   *            into - if set to @c nullptr the stream will read into the
+   *            buffers taken from the runner's buffer pool
+   * @param sz_ size of the user provided buffer or, if stream is to use
+   *            the pooled buffers, the size of the buffer to read into
+   * @param opts_ optional @ref socket_options "tuning options" of the
+   *            stream's socket
    *
    * @throw cool::ng::exception::socket_failure if any network socket operations failed
    * @throw cool::ng::exception::runner_not_available if the @ref cool::ng::async::runner
@@ -217,7 +231,70 @@ class stream
        , const WriteHandlerT& hw_
        , const OobHandlerT& he_
        , void* buf_ = nullptr
-       , std::size_t sz_ = 16384)
+       , std::size_t sz_ = 16384
+       , const socket_options& opts_ = socket_options())
+  {
+    using read_handler  = typename detail::types<RunnerT>::read_handler;
+    using write_handler = typename detail::types<RunnerT>::write_handler;
+    using event_handler = typename detail::types<RunnerT>::event_handler;
+
+    auto impl = cool::ng::util::shared_new<detail::stream<RunnerT>>(
+        r_
+      , static_cast<read_handler>(hr_)
+      , static_cast<write_handler>(hw_)
+      , static_cast<event_handler>(he_));
+
+    m_impl = impl;
+    impl->initialize(addr_, port_, buf_, sz_, opts_);
+  }
+
+  /**
+   * Constructs a new instance of asynchronous connection-oriented
+   * input/output stream and connects it to the local endpoint.
+   *
+   * Like the above constructor but connects to the @ref server listening at
+   * the Unix domain socket. The connect request completes like the network
+   * connect, reporting its outcome to the @a he_ event handler.
+   *
+   * <b>Template Parameters</b><br>
+   * See the first constructor for details on the template parameters.
+   *
+   * @param r_  weak pointer to @ref cool::ng::async::runner "runner" to use to
+   *            schedule asynchronous notifications for execution.
+   * @param ep_ the @ref local_endpoint "local endpoint" to connect to
+   * @param hr_ read handler to be called from the scheduled task when data has
+   *            been read from the connection
+   * @param hw_ write handler to be called from the scheduled task when the @ref
+   *            write operation has completed
+   * @param he_ event handler to be called from the scheduled tash when an
+   *            stream related event occurs
+   * @param buf_ data optional data buffer to be used to read received data
+   *            into - if set to @c nullptr the stream will read into the
+   *            buffers taken from the runner's buffer pool
+   * @param sz_ size of the user provided buffer or, if stream is to use
+   *            the pooled buffers, the size of the buffer to read into
+   * @param opts_ optional @ref socket_options "tuning options" of the
+   *            stream's socket; set socket_options::pass_handles to 1 to
+   *            accept the handles passed by the peer
+   *
+   * @throw cool::ng::exception::socket_failure if any socket operations failed
+   * @throw cool::ng::exception::illegal_argument if the path of the endpoint
+   *        is empty or too long
+   * @throw cool::ng::exception::runner_not_available if the @ref cool::ng::async::runner
+   *        "runner" specified via parameter @a r_ is no longer available
+   * @throw cool::ng::exception::operation_failed with the error code
+   *        @c not_available if the platform does not support local endpoints
+   * @throw std::bad_alloc if the internal memory allocation failed
+   */
+  template <typename RunnerT, typename ReadHandlerT, typename WriteHandlerT, typename OobHandlerT>
+  stream(const std::weak_ptr<RunnerT>& r_
+       , const local_endpoint& ep_
+       , const ReadHandlerT& hr_
+       , const WriteHandlerT& hw_
+       , const OobHandlerT& he_
+       , void* buf_ = nullptr
+       , std::size_t sz_ = 16384
+       , const socket_options& opts_ = socket_options())
   {
     using read_handler  = typename detail::types<RunnerT>::read_handler;
     using write_handler = typename detail::types<RunnerT>::write_handler;
@@ -230,16 +307,67 @@ class stream
       , static_cast<event_handler>(he_));
 
     m_impl = impl;
-    impl->initialize(addr_, port_, buf_, sz_);
+    impl->initialize(ep_, buf_, sz_, opts_);
   }
 
   dlldecl const std::string& name() const;
 
   /**
    * Send data to the connected peer.
+   *
+   * Queues the data for sending to the connected peer. The stream keeps
+   * an internal queue of outgoing buffers and sends as many of them as
+   * possible with a single vectored write system call, thus the write can be
+   * called again before the previous write completed. The write handler is
+   * called once for each buffer, in the order of the writes, after the buffer
+   * has been fully sent.
+   *
+   * @param data_ address of the data to send. The data must remain valid
+   *              until the write handler is called for this buffer.
+   * @param size_ size of the data, in bytes
+   *
+   * @throw cool::ng::exception::invalid_state if the stream is not connected.
    */
   dlldecl void write(const void* data_, std::size_t size_);
 
+  /**
+   * Send the data in several buffers to the connected peer.
+   *
+   * Queues all buffers at once, for example the header, body and trailer of
+   * a message, so that they are sent with as few system calls as possible.
+   * The write handler is called once for each buffer. See @ref write(const void*, std::size_t)
+   * for details.
+   *
+   * @param bufs_ list of buffers to send. The data must remain valid until
+   *              the write handler is called for its buffer.
+   *
+   * @throw cool::ng::exception::invalid_state if the stream is not connected.
+   */
+  dlldecl void write(std::initializer_list<const_buffer> bufs_);
+
+  /**
+   * Send the data in several buffers to the connected peer.
+   *
+   * @param bufs_ vector of buffers to send.
+   *
+   * See @ref write(std::initializer_list<const_buffer>) for details.
+   */
+  dlldecl void write(const std::vector<const_buffer>& bufs_);
+
+  /**
+   * Send data to the connected peer, taking over the ownership of the data.
+   *
+   * Queues the data like @ref write(const void*, std::size_t) but the stream
+   * takes over the vector and releases it after the data was sent, so that
+   * the user code need not keep it alive. The write handler is still called,
+   * with the address and size of the data, before the vector is released.
+   *
+   * @param data_ the data to send
+   *
+   * @throw cool::ng::exception::invalid_state if the stream is not connected.
+   */
+  dlldecl void write(std::vector<uint8_t>&& data_);
+
   /**
    * Connects the unconnected stream to the remote peer.
    *
@@ -258,6 +386,22 @@ class stream
    */
   dlldecl void connect(const cool::ng::net::ip::address& addr_, uint16_t port_);
 
+  /**
+   * Connects the unconnected stream to the local endpoint.
+   *
+   * Like @ref connect(const cool::ng::net::ip::address&, uint16_t) but
+   * connects to the @ref server listening at the Unix domain socket.
+   *
+   * @param ep_ the @ref local_endpoint "local endpoint" to connect to
+   *
+   * @throw cool::ng::exception::invalid_state if the stream is not disconnected.
+   * @throw cool::ng::exception::illegal_argument if the path of the endpoint
+   *        is empty or too long
+   * @throw cool::ng::exception::operation_failed with the error code
+   *        @c not_available if the platform does not support local endpoints
+   */
+  dlldecl void connect(const local_endpoint& ep_);
+
   /**
    * Disconnects the connected stream from the remote peer.
    *
@@ -267,6 +411,129 @@ class stream
    */
   dlldecl void disconnect();
 
+  /**
+   * Set the read budget of the stream.
+   *
+   * When the data arrives the stream keeps reading it from the network,
+   * calling the read handler for each buffer full of data, until there is
+   * no more data available or until the read budget is used up, whichever
+   * comes first. The budget keeps a single busy connection from holding the
+   * runner for too long; when used up, the remaining data is read at the next
+   * opportunity, after the other tasks queued to the runner had a chance to
+   * run. Larger budgets mean fewer trips through the event loop per megabyte
+   * on bulk transfer connections.
+   *
+   * The default budget is 256 KiB or 16 reads per read event.
+   *
+   * @param bytes_ maximum number of bytes to read per read event
+   * @param reads_ maximum number of reads per read event
+   *
+   * @throw cool::ng::exception::illegal_argument if either parameter is 0.
+   *
+   * @note On MS Windows platform, the completion port delivers one buffer per
+   *   read completion and the read budget has no effect.
+   */
+  dlldecl void read_budget(std::size_t bytes_, std::size_t reads_);
+
+  /**
+   * Set the flow control watermarks of the outgoing data.
+   *
+   * The @ref write calls never block and a peer that does not read its data
+   * lets the data queued for sending grow without bound. With the watermarks
+   * set the stream reports the detail::oob_event::write_blocked event to the
+   * event handler when the data not yet sent reaches the high watermark,
+   * and the detail::oob_event::write_unblocked event when it drops back to
+   * the low watermark. The events are reported in the runner's context, in
+   * order, and the user code is expected to stop writing in between. The
+   * stream does not refuse the writes while blocked.
+   *
+   * The stream can also stop reading from its own peer while blocked, which
+   * lets the proxies pass the back pressure from one peer to another.
+   *
+   * @param high_ the high watermark, in bytes, or 0 to disable the flow control
+   * @param low_ the low watermark, in bytes
+   * @param pause_read_ if set to true, the stream stops reading while blocked
+   *
+   * @throw cool::ng::exception::illegal_argument if @a low_ is not less than
+   *        @a high_.
+   * @throw cool::ng::exception::operation_failed with the error code
+   *        @c not_available if the platform does not support flow control
+   *
+   * @note The data of the write in progress counts towards the watermarks
+   *   until it was completely sent.
+   */
+  dlldecl void watermarks(std::size_t high_, std::size_t low_, bool pause_read_ = false);
+
+  /**
+   * Retain the read buffer passed to the read handler.
+   *
+   * The streams constructed without the user provided read buffer do not
+   * own a buffer. Instead they take one from the buffer pool shared by all
+   * streams of the same @ref cool::ng::async::runner "runner" when the data
+   * arrives, and return it back to the pool after the read handler returns.
+   * The read handler that needs the received data past its own completion
+   * may use this call to keep the buffer instead of copying the data. The
+   * buffer is returned to the pool when the last copy of the returned
+   * pointer is released, and the stream will read the next data into
+   * another buffer.
+   *
+   * @return shared pointer to the buffer passed to the currently executing
+   *   read handler, or @c nullptr if called from outside of the read handler
+   *   or if the stream reads into the user provided buffer.
+   *
+   * @note This call is only meaningful when called from within the read
+   *   handler.
+   */
+  dlldecl static std::shared_ptr<uint8_t> retain_read_buffer();
+
+  /**
+   * Pass the handle to the peer.
+   *
+   * Queues the handle, such as an open file or a socket, to be passed to the
+   * peer connected over the @ref local_endpoint "local endpoint". The handle
+   * is sent in order with the data written before and after it, together
+   * with a single byte of data with value 0 which the peer receives through
+   * its read handler. The stream duplicates the handle, thus the caller
+   * remains the owner of @a h_. No write handler is called for the handle.
+   *
+   * @param h_ the handle to pass
+   *
+   * @throw cool::ng::exception::invalid_state if the stream is not connected.
+   * @throw cool::ng::exception::socket_failure if the handle could not be duplicated.
+   * @throw cool::ng::exception::operation_failed with the error code
+   *        @c not_available if the stream is not connected over the local
+   *        endpoint or if the platform does not support passing handles
+   */
+  dlldecl void write_handle(cool::ng::net::handle h_);
+
+  /**
+   * Take the handle passed by the peer.
+   *
+   * The stream connected over the @ref local_endpoint "local endpoint", and
+   * constructed with the socket_options::pass_handles option set to 1, keeps
+   * the handles passed by the peer until taken by this call. Each handle
+   * arrives together with a byte of data with value 0, and is available to
+   * the read handler that receives this byte. The caller takes over the
+   * ownership of the returned handle. The handles not taken are closed when
+   * the stream is destroyed. Without the socket_options::pass_handles option
+   * the passed handles are closed upon arrival.
+   *
+   * @return the next handle received from the peer, or
+   *   cool::ng::net::invalid_handle if there is none.
+   */
+  dlldecl cool::ng::net::handle received_handle();
+
+  /**
+   * Return the input/output statistics of the stream.
+   *
+   * The stream counts the bytes and the system calls it used to move them,
+   * and records the connect and the write latencies, for the entire life of
+   * the stream, across reconnects. The counters are updated as the
+   * input/output progresses and the returned snapshot need not be consistent
+   * across the counters.
+   */
+  dlldecl stream_stats stats() const;
+
   /**
    * Empty stream predicate.
    *
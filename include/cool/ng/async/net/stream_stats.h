@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_9b4f2e71_c83a_4d56_a1e0_6f2d7b3c8e95)
+#define      cool_ng_9b4f2e71_c83a_4d56_a1e0_6f2d7b3c8e95
+
+#include <cstdint>
+#include <cstddef>
+
+#include "cool/ng/async/timer_stats.h"
+
+namespace cool { namespace ng { namespace async { namespace net {
+
+/**
+ * Input/output statistics of the @ref stream.
+ *
+ * The same statistics describe a single @ref stream, as returned by
+ * @ref stream::stats(), and the aggregate of all connections accepted by the
+ * @ref server, as returned by @ref server::stats(). The aggregate also
+ * includes the connections that were already closed.
+ *
+ * The histograms use the @ref timer_histogram buckets, with all delays in
+ * microseconds.
+ */
+struct stream_stats
+{
+  stream_stats()
+    : connections(0)
+    , bytes_in(0)
+    , bytes_out(0)
+    , reads(0)
+    , writes(0)
+    , read_again(0)
+    , write_again(0)
+    , read_events(0)
+  { /* noop */ }
+
+  /**
+   * Average number of bytes per read system call, or 0 if there were no
+   * reads.
+   */
+  double bytes_per_read() const
+  {
+    return reads == 0 ? 0.0 : static_cast<double>(bytes_in) / static_cast<double>(reads);
+  }
+
+  /**
+   * Number of times the stream became connected.
+   */
+  uint64_t connections;
+  /**
+   * Number of bytes received.
+   */
+  uint64_t bytes_in;
+  /**
+   * Number of bytes sent.
+   */
+  uint64_t bytes_out;
+  /**
+   * Number of read system calls, including the calls that found no data.
+   */
+  uint64_t reads;
+  /**
+   * Number of write system calls, including the calls that found the
+   * socket buffer full.
+   */
+  uint64_t writes;
+  /**
+   * Number of read system calls that found no data (@c EAGAIN). Always 0 on
+   * platforms with completion based input/output.
+   */
+  uint64_t read_again;
+  /**
+   * Number of write system calls that found the socket buffer full
+   * (@c EAGAIN). Always 0 on platforms with completion based input/output.
+   */
+  uint64_t write_again;
+  /**
+   * Number of read events handled. Each event may make several read system
+   * calls, up to the @ref stream::read_budget() "read budget". On platforms
+   * with completion based input/output each read is an event of its own.
+   */
+  uint64_t read_events;
+  /**
+   * Histogram of delays between the start of the connect and the
+   * established connection. Only the streams that connect to their peers
+   * record these delays, the streams accepted by the @ref server do not.
+   */
+  timer_histogram connect_latency;
+  /**
+   * Histogram of delays between the @ref stream::write() "write" call and
+   * the call of the write handler for the written data.
+   */
+  timer_histogram write_latency;
+};
+
+} } } } // namespace
+
+#endif
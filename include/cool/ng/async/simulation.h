@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_93ee28bf_0431_407e_aba0_9b43a1a649c0)
+#define      cool_ng_93ee28bf_0431_407e_aba0_9b43a1a649c0
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+#include "cool/ng/impl/platform.h"
+
+namespace cool { namespace ng { namespace async {
+
+/**
+ * Control of the deterministic simulation platform.
+ *
+ * The functions in this namespace are only available when the program is
+ * linked with the <tt>cool.ng-sim</tt> library, which replaces the
+ * platform executor with a deterministic, virtual time one. On this platform:
+ *   - all @ref runner "runners" share a single virtual clock and no task or
+ *     event source callback ever executes on its own; the work is executed
+ *     on the thread calling run() or advance()
+ *   - when several runners have pending work, the runner whose work executes
+ *     next is selected by a pseudo random generator. For the given seed the
+ *     order of execution is reproducible from run to run
+ *   - @ref timer "timers" expire in virtual time. A timer with one hour period
+ *     will expire ten times during advance() of ten hours, without any real
+ *     time passing
+ *   - network event sources are not available and their creation throws
+ *     @ref cool::ng::exception::operation_failed "operation_failed"
+ *
+ * The simulation platform is intended for unit tests of latency and
+ * scheduling related behavior, where the results must not depend on the
+ * load of the machine running the tests.
+ */
+namespace simulation {
+
+/**
+ * Seeds the pseudo random generator selecting the order of execution.
+ */
+dlldecl void seed(uint64_t seed_);
+/**
+ * Returns the current virtual time, in microseconds since the start.
+ */
+dlldecl uint64_t now();
+/**
+ * Executes the pending work until there is none left, without advancing the
+ * virtual time.
+ *
+ * @return number of executed work items
+ */
+dlldecl std::size_t run();
+/**
+ * Advances the virtual time for the specified interval.
+ *
+ * Executes the pending work, then fires the timers, in order of their
+ * deadlines, whose deadlines are within the interval, executing the work
+ * they generate in between.
+ *
+ * @param interval_ interval in microseconds
+ * @return number of executed work items
+ */
+dlldecl std::size_t advance(uint64_t interval_);
+/**
+ * Advances the virtual time for the specified interval.
+ */
+template <typename Rep, typename Period>
+std::size_t advance(const std::chrono::duration<Rep, Period>& interval_)
+{
+  return advance(static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(interval_).count()));
+}
+
+} // namespace simulation
+
+} } } // namespace
+
+#endif
@@ -26,12 +26,14 @@
 
 #include <string>
 #include <functional>
+#include <chrono>
 #include <iostream>
 
 #include "cool/ng/impl/platform.h"
 #include "cool/ng/exception.h"
 #include "cool/ng/traits.h"
 #include "cool/ng/async/runner.h"
+#include "cool/ng/async/expected.h"
 #include "cool/ng/impl/async/task.h"
 
 namespace cool { namespace ng {
@@ -56,7 +58,10 @@ struct tag
  *    simple task will accept no input parameter
  *  * the return value of the simple task is the return value of the user supplied
  *    @em Callable. If the @em Callable does not return value the simple task
- *    will not return value either.
+ *    will not return value either. If the @em Callable returns
+ *    @ref cool::ng::async::expected "expected<T>", the return value of the
+ *    simple task is @c T and the @em Callable may use the returned object to
+ *    report failure without throwing an exception.
  *
  * The user @em Callable may be a function pointer, lambda closure,
  * @c std::function, or any other functor object as long as it provides a 
@@ -90,7 +95,7 @@ struct tag
  *    <tr><td><tt>runner_type</tt>     <td><tt>decltype(@em runner)::%element_type</tt>
  *    <tr><td><tt>tag</tt>             <td><tt>tag::simple</tt>
  *    <tr><td><tt>input_type</tt>      <td>type of the second arg to @em callable, @c void if none
- *    <tr><td><tt>result_type</tt>     <td>return type of @em callable
+ *    <tr><td><tt>result_type</tt>     <td>return type of @em callable, or @c T if @em callable returns <tt>expected<T></tt>
  *  </table>
  *
  * The following requirements are imposed on the user @em callable:
@@ -622,6 +627,18 @@ struct tag
  * task will propagate the exception as its own and terminate. No result value
  * is produced.
  *
+ * If the @em try subtask fails with an error code returned through the
+ * @ref cool::ng::async::expected "expected" result, the intercept task will
+ * examine the @em catch_i subtasks in the creation order, as it would for the
+ * @c std::system_error exception carrying this error code, but without
+ * throwing the exception. The first @em catch subtask that accepts the input
+ * parameter of type @c std::error_code, or of type @c std::system_error or
+ * one of its base types, will receive the error code or @c std::system_error
+ * object, respectively. The catch-all @em catch subtask will receive the
+ * @c std::exception_ptr pointing to the @c std::system_error object. If no
+ * matching @em catch subtask is found, the error code is propagated out of the
+ * intercept compound task.
+ *
  * <b>Example</b>@n
  *
  * @code
@@ -681,15 +698,456 @@ struct tag
  *     // code of catch task t3
  *   }
  * @endcode
- * @note Except for catch-all @em catch task, the exception object is re-thrown
- *  and re-caught at each @em catch task to test whether this @em catch task
- *  should intercept it or not. This may incurr certain processing overhead
- *  should the intercept compound task have a long string of @em catch tasks.
+ * @note The exception object is re-thrown only once, into the nested @c try
+ *  blocks with one handler for each @em catch task, which are generated at
+ *  the compile time from the input types of the @em catch tasks. All @em catch
+ *  tasks are thus matched during a single re-throw, regardless of their number.
  */
  using intercept = detail::tag::intercept;
+/**
+ * Pipeline compound task tag.
+ *
+ * The pipeline task is a compound task that runs its subtasks (the @em stages)
+ * in sequence, like the @ref tag::sequential "sequential" compound task, but
+ * is meant to be fed a continuous stream of input items rather than to handle
+ * a single input end-to-end. Each @c run() call feeds one item into the
+ * pipeline. The stages of the pipeline work concurrently, each on its own
+ * runner, so that the stage @em i can process the item @em k+1 while the
+ * stage @em i+1 processes the item @em k.
+ *
+ * Each stage has a bounded queue of items waiting to be processed and processes
+ * at most one item at the time. The result of the stage @em i is passed as the
+ * input to the stage @em i+1. If the queue of the stage @em i+1 is full, the
+ * stage @em i holds its result and stops taking new items from its own queue
+ * until the stage @em i+1 makes room, thus propagating the backpressure
+ * towards the first stage. The order of the items is preserved throughout the
+ * pipeline. The result of the last stage, if any, is discarded.
+ *
+ * <b>Member Types And Requirements</b>@n
+ *
+ * When created with a call to:
+ * @code
+ *   ...
+ *   auto task = factory::pipeline(capacity, stage_1, stage_2, ... stage_n);
+ *   ...
+ * @endcode
+ * the resulting task type of object @c task exposes the following public type
+ * declarations:
+ *
+ *  <table><tr><th>Member type         <th>Declared as
+ *    <tr><td><tt>this_type</tt>       <td><tt>decltype(@em task)</tt>
+ *    <tr><td><tt>runner_type</tt>     <td><tt>detail::default_runner_type</tt>
+ *    <tr><td><tt>tag</tt>             <td><tt>tag::pipeline</tt>
+ *    <tr><td><tt>input_type</tt>      <td><tt>decltype(@em stage_1)::%input_type</tt>
+ *    <tr><td><tt>result_type</tt>     <td><tt>void</tt>
+ *  </table>
+ * Note that pipeline task, as all compound tasks, is not associated with any
+ * runner and uses @c detail::default_runner_type as a filler type.
+ *
+ * The following are the requirements for the stages of the pipeline task:
+ *  - for each @em i in range 1&ndash;<i>(n-1)</i>: <tt>std::is_same<decltype(stage_<i>i</i>)::%result_type, decltype(stage_<i>i+1</i>)::%input_type>::%value</tt> must yield @c true
+ *  - @em capacity, the capacity of the queue in front of each stage, must be
+ *    greater than 0
+ *
+ * Unlike other tasks, the pipeline task keeps its queues in the task object.
+ * All copies of the pipeline task share the same queues and the same stages.
+ *
+ * <b>Exception Handling</b>@n
+ *
+ * If the queue of the first stage is full, the @c run() call will throw
+ * @ref cool::ng::exception::operation_failed "operation_failed" exception
+ * with the error code @c errc::resource_busy and the item is not accepted. When
+ * the pipeline task is a subtask of another compound task, it completes as soon
+ * as the item is accepted into the queue of the first stage, or reports the
+ * @c operation_failed exception as its own exception if it was not accepted.
+ *
+ * If the stage, when run, throws an uncontained exception or fails with an
+ * error code, the item is dropped and the stage proceeds with the next item
+ * from its queue. The dropped items are counted by
+ * @ref task::dropped() "dropped()" and reported to the handler set with
+ * @ref task::on_failure() "on_failure()", which is called with the index of
+ * the failed stage and the exception, or with the error code wrapped into
+ * @c std::system_error. This is the only way to observe the failures of the
+ * items fed by the enclosing compound task, which completes as soon as the
+ * item is accepted. Alternatively, use an @ref tag::intercept "intercept"
+ * compound task as a stage to handle the exceptions within the pipeline.
+ *
+ * <b>Example</b>@n
+ *
+ * @code
+ *   #include <cool/ng/async.h>
+ *   using cool::ng::async::runner;
+ *   using cool::ng::async::factory;
+ *   class decoder : public runner { ... class content ... };
+ *   class emitter : public runner { ... class content ... };
+ *     ...
+ *   auto r1 = std::make_shared<decoder>();
+ *   auto r2 = std::make_shared<emitter>();
+ *
+ *   auto decode = factory::create(r1,
+ *     [] (const std::shared_ptr<decoder>& r, const std::string& input) -> record
+ *     {
+ *       ...
+ *     });
+ *   auto emit = factory::create(r2,
+ *     [] (const std::shared_ptr<emitter>& r, const record& input) -> void
+ *     {
+ *       ...
+ *     });
+ *
+ *   auto task = factory::pipeline(16, decode, emit);
+ *     ...
+ *   task.run(line_1);
+ *   task.run(line_2);
+ *     ...
+ * @endcode
+ */
+  using pipeline = detail::tag::pipeline;
+/**
+ * Fan-out compound task tag.
+ *
+ * The fan-out task is a compound task that runs the same subtask once for
+ * each element of its input vector. The number of subtask runs is therefore
+ * determined at run time by the size of the input vector passed to the
+ * @c run() call, rather than at the compile time. The subtask runs are
+ * scheduled for execution concurrently, optionally limited to at most
+ * @em max_concurrency concurrently running subtasks. The fan-out compound
+ * task completes when all subtask runs have completed and returns a vector
+ * of their results, in the order of their inputs.
+ *
+ * <b>Member Types And Requirements</b>@n
+ *
+ * When created with a call to:
+ * @code
+ *   ...
+ *   auto task = factory::fan_out(subtask);                   // (1)
+ *   auto task = factory::fan_out(subtask, max_concurrency);  // (2)
+ *   ...
+ * @endcode
+ * the resulting task type of object @c task exposes the following public type
+ * declarations:
+ *
+ *  <table><tr><th>Member type         <th>Declared as
+ *    <tr><td><tt>this_type</tt>       <td><tt>decltype(@em task)</tt>
+ *    <tr><td><tt>runner_type</tt>     <td><tt>detail::default_runner_type</tt>
+ *    <tr><td><tt>tag</tt>             <td><tt>tag::fan_out</tt>
+ *    <tr><td><tt>input_type</tt>      <td><tt>std::vector<decltype(@em subtask)::%input_type></tt>
+ *    <tr><td><tt>result_type</tt>     <td><tt>std::vector<decltype(@em subtask)::%result_type></tt>, or @c void if the @em subtask does not return value
+ *  </table>
+ * Note that fan-out task, as all compound tasks, is not associated with any
+ * runner and uses @c detail::default_runner_type as a filler type.
+ *
+ * The following are the requirements for the @em subtask:
+ *  - <tt>std::is_same<decltype(subtask)::input_type, void>::value</tt> must yield @c false
+ *  - <tt>decltype(subtask)::%result_type</tt> most be default constructible or @c void
+ *
+ * The @em max_concurrency of 0, which is the default for use (1), sets no
+ * limit to the number of concurrently running subtasks.
+ *
+ * <b>Exception Handling</b>@n
+ *
+ * If the subtask, when run for any element, throws an uncontained exception
+ * or fails with an error code, the fan-out task will not schedule any further
+ * subtask runs. It will wait for the subtask runs already scheduled to complete
+ * and then propagate the first exception or error code as its own. No result
+ * value is produced.
+ *
+ * <b>Example</b>@n
+ *
+ * @code
+ *   #include <cool/ng/async.h>
+ *   using cool::ng::async::runner;
+ *   using cool::ng::async::factory;
+ *   class shard : public runner { ... class content ... };
+ *     ...
+ *   auto r = std::make_shared<shard>();
+ *
+ *   auto query = factory::create(r,
+ *     [] (const std::shared_ptr<shard>& r, const std::string& key) -> int
+ *     {
+ *       ...
+ *     });
+ *   auto task = factory::fan_out(query, 4);
+ *     ...
+ *   task.run(keys);   // run query for each key in vector keys, at most 4 at the time
+ * @endcode
+ *
+ * Functionally, the fan-out compound task corresponds to the following
+ * synchronous pattern, except that the subtask runs may execute concurrently:
+ * @code
+ *   std::vector<int> result;
+ *   for (auto& key : keys)
+ *     result.push_back(query(key));
+ * @endcode
+ */
+  using fan_out = detail::tag::fan_out;
+/**
+ * Static sequential compound task tag.
+ *
+ * The static sequential task runs its subtasks in sequence, exactly as the
+ * @ref tag::sequential "sequential" compound task does, but its subtasks and
+ * their types are part of the static sequential task type. This allows the
+ * compiler to see through the entire sequence and to pass the result of each
+ * subtask directly to the next, without type erasure into @c boost::any and
+ * without a separate runtime context for each subtask. The consecutive
+ * subtasks that use the same runner are called one after another within a
+ * single dispatch of the runner; the runtime only gets involved when the
+ * sequence needs to move to another runner.
+ *
+ * <b>Member Types And Requirements</b>@n
+ *
+ * When created with a call to:
+ * @code
+ *   ...
+ *   auto task = factory::static_sequence(task_1, task_2, .... , task_n);
+ *   ...
+ * @endcode
+ * the resulting task type of object @c task exposes the following public type
+ * declarations:
+ *
+ *  <table><tr><th>Member type <th>Declared as
+ *    <tr><td><tt>this_type</tt>       <td><tt>decltype(@em task)</tt>
+ *    <tr><td><tt>runner_type</tt>     <td><tt>detail::default_runner_type</tt>
+ *    <tr><td><tt>tag</tt>             <td><tt>tag::static_sequential</tt>
+ *    <tr><td><tt>input_type</tt>      <td>decltype(@em task_1)::%input_type
+ *    <tr><td><tt>result_type</tt>     <td>decltype(@em task_n)::%result_type
+ *  </table>
+ * Note that static sequential task, as all compound tasks, is not associated
+ * with any runner and uses @c detail::default_runner_type as a filler type.
+ *
+ * The following requirements are imposed on the subtasks of the static
+ * sequential task:
+ *  - static sequential task must have at least two subtasks
+ *  - all subtasks must be @ref tag::simple "simple" tasks as returned by
+ *    @ref factory::create(), which carry the type of their user Callable
+ *  - for every @em i in range 1&ndash;(<i>n</i>-1):
+ *    <tt>std::is_same<decltype(task_<i>i</i>)::%result_type, decltype(task_<i>(i+1)</i>)::%input_type>::%value</tt> must yield @c true
+ *
+ * The static sequential task can itself be used as a subtask of any other
+ * compound task.
+ *
+ * <b>Exception Handling</b>@n
+ *
+ * If any of the subtasks throws an uncontained exception or fails with an
+ * error code, the static sequential task will terminate the sequence and
+ * propagate the exception or the error code as its own.
+ *
+ * <b>Example</b>@n
+ *
+ * @code
+ *   auto task = factory::static_sequence(parse, validate, store);
+ *     ...
+ *   task.run(input);
+ * @endcode
+ */
+  using static_sequential = detail::tag::static_sequential;
+/**
+ * Throttle compound task tag.
+ *
+ * The throttle task is a compound task that limits the number of concurrently
+ * running executions of its subtask to @em max_in_flight, across all @c run()
+ * calls of the throttle task and of compound tasks that contain it. The runs
+ * that exceed the limit are parked in a wait queue, without occupying any
+ * runner, and resumed in the order they were parked as the earlier runs
+ * complete. The throttle task passes its input to the subtask and returns
+ * the subtask's result as its own.
+ *
+ * <b>Member Types And Requirements</b>@n
+ *
+ * When created with a call to:
+ * @code
+ *   ...
+ *   auto task = factory::throttle(subtask, max_in_flight);
+ *   ...
+ * @endcode
+ * the resulting task type of object @c task exposes the following public type
+ * declarations:
+ *
+ *  <table><tr><th>Member type         <th>Declared as
+ *    <tr><td><tt>this_type</tt>       <td><tt>decltype(@em task)</tt>
+ *    <tr><td><tt>runner_type</tt>     <td><tt>detail::default_runner_type</tt>
+ *    <tr><td><tt>tag</tt>             <td><tt>tag::throttle</tt>
+ *    <tr><td><tt>input_type</tt>      <td><tt>decltype(@em subtask)::%input_type</tt>
+ *    <tr><td><tt>result_type</tt>     <td><tt>decltype(@em subtask)::%result_type</tt>
+ *  </table>
+ * Note that throttle task, as all compound tasks, is not associated with any
+ * runner and uses @c detail::default_runner_type as a filler type.
+ *
+ * The @em max_in_flight must be greater than 0.
+ *
+ * <b>Exception Handling</b>@n
+ *
+ * The throttle task propagates the exceptions and error codes of its subtask
+ * as its own. A subtask run that fails frees its slot the same as the run that
+ * completes successfully.
+ *
+ * <b>Example</b>@n
+ *
+ * @code
+ *   auto query = factory::create(r,
+ *     [] (const std::shared_ptr<database>& r, const std::string& sql) -> rows
+ *     {
+ *       ...
+ *     });
+ *   auto task = factory::throttle(query, 8);   // at most 8 queries at the time
+ *     ...
+ *   task.run(sql_1);
+ *   task.run(sql_2);
+ *     ...
+ * @endcode
+ *
+ * @note Unlike a runner with the sequential policy, which would run the
+ *   subtasks one at the time, the throttle task permits up to
+ *   @em max_in_flight subtask runs to proceed concurrently on a runner with
+ *   the concurrent policy or on several runners used by the subtask.
+ */
+  using throttle = detail::tag::throttle;
+/**
+ * Batch compound task tag.
+ *
+ * The batch task is a compound task that collects the inputs of its
+ * individual @c run() calls into a batch and runs its subtask, the @em batch
+ * task, once for the entire batch. The batch is passed to the batch task when
+ * it collects @em max_items items or at the latest after @em max_delay,
+ * whichever comes first. Each run of the batch task completes when its batch
+ * completes and receives its own item of the batch task's result vector.
+ *
+ * <b>Member Types And Requirements</b>@n
+ *
+ * When created with a call to:
+ * @code
+ *   ...
+ *   auto task = factory::batch(batch_task, max_items, max_delay);
+ *   ...
+ * @endcode
+ * the resulting task type of object @c task exposes the following public type
+ * declarations:
+ *
+ *  <table><tr><th>Member type         <th>Declared as
+ *    <tr><td><tt>this_type</tt>       <td><tt>decltype(@em task)</tt>
+ *    <tr><td><tt>runner_type</tt>     <td><tt>detail::default_runner_type</tt>
+ *    <tr><td><tt>tag</tt>             <td><tt>tag::batch</tt>
+ *    <tr><td><tt>input_type</tt>      <td><tt>decltype(@em batch_task)::%input_type::value_type</tt>
+ *    <tr><td><tt>result_type</tt>     <td><tt>decltype(@em batch_task)::%result_type::value_type</tt>, or @c void if the @em batch_task does not return value
+ *  </table>
+ * Note that batch task, as all compound tasks, is not associated with any
+ * runner and uses @c detail::default_runner_type as a filler type.
+ *
+ * The following are the requirements for the @em batch_task:
+ *  - <tt>decltype(batch_task)::input_type</tt> must be <tt>std::vector<Item></tt>
+ *  - <tt>decltype(batch_task)::%result_type</tt> must be <tt>std::vector<Result></tt>
+ *    or @c void. The @em i-th element of the result vector is returned to the
+ *    run that contributed the @em i-th element of the input vector.
+ *
+ * The @em max_delay is measured with a timer that ticks with the period of
+ * @em max_delay on the runner of the @em batch_task, starting with the first
+ * @c run() call and for as long as the batch task exists. Each tick passes the
+ * pending items, if any, to the @em batch_task.
+ *
+ * <b>Exception Handling</b>@n
+ *
+ * If the @em batch_task throws an uncontained exception or fails with an
+ * error code, the exception or the error code is propagated by all runs of
+ * the batch task whose items were in the failed batch. If the result vector
+ * is shorter than the input vector, the runs that get no result fail with
+ * the @ref cool::ng::exception::out_of_range "out_of_range" exception.
+ *
+ * <b>Example</b>@n
+ *
+ * @code
+ *   auto store = factory::create(r,
+ *     [] (const std::shared_ptr<storage>& r, const std::vector<record>& records) -> void
+ *     {
+ *       ... write all records at once ...
+ *     });
+ *   auto task = factory::batch(store, 100, std::chrono::milliseconds(10));
+ *     ...
+ *   task.run(record_1);
+ *   task.run(record_2);
+ *     ...
+ * @endcode
+ */
+  using batch = detail::tag::batch;
+/**
+ * Join task tag.
+ *
+ * The join task is created by the @ref task_group::join_task() "join_task()"
+ * method of the @ref task_group and completes when all tasks spawned into the
+ * task group have completed. It does not accept input and does not return
+ * value, thus it can be used as the first task of a
+ * @ref tag::sequential "sequential" compound task, or following a task that
+ * does not return value, to continue the work once the group completes.
+ *
+ * <b>Exception Handling</b>@n
+ *
+ * If any of the tasks spawned into the group threw an uncontained exception
+ * or failed with an error code, the join task propagates the exception or the
+ * error code of the first task to fail as its own.
+ */
+  using join = detail::tag::join;
 };
 
 struct factory;
+class task_group;
+template <typename TagT, typename RunnerT, typename InputT, typename ResultT, typename... TaskT>
+class task;
+
+/**
+ * Handle to the delayed task execution.
+ *
+ * The cancel token is returned by @ref task::run_after() "run_after()" and
+ * @ref task::run_at() "run_at()" methods and can be used to cancel the
+ * delayed execution before the task is scheduled to run. The token is cheap
+ * to copy; all copies refer to the same delayed execution.
+ */
+class cancel_token
+{
+ public:
+  /**
+   * Constructs an empty cancel token.
+   */
+  cancel_token() { /* noop */ }
+  /**
+   * Cancels the delayed execution.
+   *
+   * @return @c true if the execution was cancelled, @c false if the task was
+   *         already scheduled to run or the execution was already cancelled
+   * @throw exception::empty_object if the token is empty
+   */
+  bool cancel()
+  {
+    if (!m_impl)
+      throw exception::empty_object();
+    return m_impl->cancel();
+  }
+  /**
+   * Returns @c true if the delayed execution is still waiting for its time.
+   *
+   * @throw exception::empty_object if the token is empty
+   */
+  bool pending() const
+  {
+    if (!m_impl)
+      throw exception::empty_object();
+    return m_impl->is_pending();
+  }
+  /**
+   * Returns @c true if the cancel token is not empty.
+   */
+  explicit operator bool() const
+  {
+    return !!m_impl;
+  }
+
+ private:
+  template <typename TagT, typename RunnerT, typename InputT, typename ResultT, typename... TaskT>
+  friend class task;
+  cancel_token(const std::shared_ptr<detail::deferred>& d_) : m_impl(d_)
+  { /* noop */ }
+
+ private:
+  std::shared_ptr<detail::deferred> m_impl;
+};
 
 /**
  * A class template representing the objects that can be scheduled for
@@ -750,6 +1208,8 @@ struct factory;
  *  - @em loop
  *  - @em repeat
  *  - @em intercept
+ *  - @em pipeline
+ *  - @em fan-out
  *
  * See @ref tag for more details on ech kind of tasks.
  */
@@ -789,11 +1249,132 @@ class task
     m_impl->run(m_impl);
   }
 
+ /**
+  * Schedule task for execution after the specified delay.
+  *
+  * The task is prepared for execution at the call and handed directly to its
+  * @ref runner to run when the delay expires, which is cheaper than creating
+  * a @ref timer for a single delayed execution. The returned @ref cancel_token
+  * can be used to cancel the execution before the delay expires; the cancelled
+  * execution and its input are discarded when the delay expires. Exceptions
+  * thrown and errors reported by the task are handled as they are for
+  * @ref run().
+  *
+  * @throw exception::runner_not_available if the task's runner no longer exists
+  */
+  template <typename RepT, typename PeriodT, typename T = InputT>
+  cancel_token run_after(
+      const std::chrono::duration<RepT, PeriodT>& d_
+    , const typename std::enable_if<!std::is_same<T, void>::value, T>::type& arg_)
+  {
+    return defer(to_delay(d_), boost::any(arg_));
+  }
+
+ /**
+  * Schedule task for execution after the specified delay.
+  */
+  template <typename RepT, typename PeriodT, typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, cancel_token>::type
+  run_after(const std::chrono::duration<RepT, PeriodT>& d_)
+  {
+    return defer(to_delay(d_), boost::any());
+  }
+
+ /**
+  * Schedule task for execution at the specified point in time.
+  *
+  * If the time point is already in the past the task is scheduled for
+  * execution immediately. See @ref run_after() for details.
+  */
+  template <typename ClockT, typename DurationT, typename T = InputT>
+  cancel_token run_at(
+      const std::chrono::time_point<ClockT, DurationT>& t_
+    , const typename std::enable_if<!std::is_same<T, void>::value, T>::type& arg_)
+  {
+    return run_after(t_ - ClockT::now(), arg_);
+  }
+
+ /**
+  * Schedule task for execution at the specified point in time.
+  */
+  template <typename ClockT, typename DurationT, typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, cancel_token>::type
+  run_at(const std::chrono::time_point<ClockT, DurationT>& t_)
+  {
+    return run_after(t_ - ClockT::now());
+  }
+
+ /**
+  * Set the handler for the items that failed in one of the stages of the
+  * @ref tag::pipeline "pipeline" task.
+  *
+  * The handler is called with the zero based index of the failed stage and
+  * the exception thrown by the stage, or the error code reported by the
+  * stage wrapped into @c std::system_error. It is called from the context of
+  * the failed stage's runner and must not block. All copies of the pipeline
+  * task share the same handler.
+  */
+  template <typename T = TagT>
+  typename std::enable_if<std::is_same<T, detail::tag::pipeline>::value, void>::type
+  on_failure(const std::function<void(std::size_t, const std::exception_ptr&)>& h_)
+  {
+    m_impl->set_failure_handler(h_);
+  }
+
+ /**
+  * Return the number of items dropped by the @ref tag::pipeline "pipeline"
+  * task because they failed in one of its stages.
+  */
+  template <typename T = TagT>
+  typename std::enable_if<std::is_same<T, detail::tag::pipeline>::value, std::size_t>::type
+  dropped() const
+  {
+    return m_impl->dropped();
+  }
+
+ /**
+  * Converts the task into the task of the same kind, runner, input and result
+  * types that does not carry the types of its subtasks or its user Callable.
+  */
+  template <typename... OtherT, typename = typename std::enable_if<
+      std::is_convertible<
+          typename task<TagT, RunnerT, InputT, ResultT, OtherT...>::impl_type*
+        , impl_type*>::value>::type>
+  task(const task<TagT, RunnerT, InputT, ResultT, OtherT...>& other_) : m_impl(other_.m_impl)
+  { /* noop */ }
+
  private:
+  template <typename, typename, typename, typename, typename...> friend class task;
   friend struct factory;
+  friend class task_group;
   task(const std::shared_ptr<impl_type> impl_) : m_impl(impl_)
   { /* noop */ }
 
+  template <typename RepT, typename PeriodT>
+  static uint64_t to_delay(const std::chrono::duration<RepT, PeriodT>& d_)
+  {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(d_).count();
+    return us < 0 ? 0 : static_cast<uint64_t>(us);
+  }
+
+  cancel_token defer(uint64_t delay_, const boost::any& input_)
+  {
+    std::shared_ptr<detail::deferred> d;
+    auto stack = new detail::default_task_stack();
+    try
+    {
+      m_impl->create_context(stack, m_impl, input_);
+      d = std::make_shared<detail::deferred>(stack);
+    }
+    catch (...)
+    {
+      delete stack;
+      throw;
+    }
+    detail::kickstart_after(d, delay_);   // the deferred run owns the stack
+    return cancel_token(d);
+  }
+
  private:
   std::shared_ptr<impl_type> m_impl;
 };
@@ -882,6 +1463,11 @@ struct factory {
    * @param r_ @ref runner to use for task execution
    * @param f_ user Callable runner should invoke during task execution
    *
+   * The returned task type carries the type of the user Callable as its last
+   * template parameter. It converts to the task type without it, for instance
+   * <tt>task<tag::simple, RunnerT, InputT, ResultT></tt>, where the type of
+   * the user Callable is not wanted.
+   *
    * @see @ref tag::simple "simple" task
    */
   template <typename RunnerT, typename CallableT>
@@ -889,12 +1475,13 @@ struct factory {
       tag::simple
     , RunnerT
     , typename traits::arg_type<1, CallableT>::type
-    , typename traits::functional<CallableT>::result_type
+    , typename detail::traits::unwrap_expected<typename traits::functional<CallableT>::result_type>::type
+    , detail::typed_callable<CallableT>
   > create(const std::weak_ptr<RunnerT>& r_, const CallableT& f_)
   {
-    using result_type = typename traits::functional<CallableT>::result_type;
+    using result_type = typename detail::traits::unwrap_expected<typename traits::functional<CallableT>::result_type>::type;
     using input_type = typename traits::arg_type<1, CallableT>::type;
-    using task_type = task<tag::simple, RunnerT, input_type, result_type>;
+    using task_type = task<tag::simple, RunnerT, input_type, result_type, detail::typed_callable<CallableT>>;
 
     // Make diagnostics a bit more user friendly - do some compile time checks
     // user callable must accept one or two parameters ...
@@ -929,7 +1516,8 @@ struct factory {
       tag::simple
     , RunnerT
     , typename traits::arg_type<1, CallableT>::type
-    , typename traits::functional<CallableT>::result_type
+    , typename detail::traits::unwrap_expected<typename traits::functional<CallableT>::result_type>::type
+    , detail::typed_callable<CallableT>
   > create(const std::shared_ptr<RunnerT>& r_, const CallableT& f_)
   {
     return factory::create(std::weak_ptr<RunnerT>(r_), f_);
@@ -970,6 +1558,74 @@ struct factory {
     return task_type(std::make_shared<typename task_type::impl_type>(t_.m_impl...));
   }
 
+  /**
+   * Factory method for creating @ref tag::static_sequential "static sequential"
+   * compound tasks.
+   *
+   * @param t_ two or more simple tasks to run in sequence
+   *
+   * @see @ref tag::static_sequential "static sequential" compound task
+   */
+  template <typename... TaskT>
+  inline static task<
+      tag::static_sequential
+    , detail::default_runner_type
+    , typename detail::traits::get_first<TaskT...>::type::input_type
+    , typename detail::traits::get_sequence_result_type<TaskT...>::type
+    , TaskT...
+  > static_sequence(const TaskT&... t_)
+  {
+    static_assert(
+        sizeof...(t_) > 1
+      , "It takes at least two tasks to create a static sequential compound task");
+    static_assert(
+        detail::traits::is_same<tag::simple, typename TaskT::tag...>::value
+      , "All tasks in the static sequence must be simple tasks.");
+    static_assert(
+        detail::traits::is_chain<typename std::decay<TaskT>::type...>::result::value
+      , "The type of the parameter of each task in the sequence must match the return type of the preceding task.");
+
+    using result_type = typename detail::traits::get_sequence_result_type<TaskT...>::type;
+    using input_type = typename detail::traits::get_first<TaskT...>::type::input_type;
+    using task_type = task<tag::static_sequential, detail::default_runner_type, input_type, result_type, TaskT...>;
+
+    return task_type(std::make_shared<typename task_type::impl_type>(t_.m_impl...));
+  }
+
+  /**
+   * Factory method for creating @ref tag::pipeline "pipeline" compound tasks.
+   *
+   * @param capacity_ capacity of the queue in front of each stage
+   * @param t_ two or more tasks to run as the pipeline stages
+   *
+   * @exception cool::ng::exception::illegal_argument thrown if the capacity is 0
+   *
+   * @see @ref tag::pipeline "pipeline" compound task
+   */
+  template <typename... TaskT>
+  inline static task<
+      tag::pipeline
+    , detail::default_runner_type
+    , typename detail::traits::get_first<TaskT...>::type::input_type
+    , void
+  > pipeline(std::size_t capacity_, const TaskT&... t_)
+  {
+    static_assert(
+        sizeof...(t_) > 1
+      , "It takes at least two tasks to create a pipeline compound task");
+    static_assert(
+        detail::traits::is_chain<typename std::decay<TaskT>::type...>::result::value
+      , "The type of the parameter of each task in the pipeline must match the return type of the preceding task.");
+
+    if (capacity_ == 0)
+      throw exception::illegal_argument();
+
+    using input_type = typename detail::traits::get_first<TaskT...>::type::input_type;
+    using task_type = task<tag::pipeline, detail::default_runner_type, input_type, void>;
+
+    return task_type(std::make_shared<typename task_type::impl_type>(capacity_, t_.m_impl...));
+  }
+
   /**
    * Factory method for creating @ref tag::intercept "intercept" compound tasks.
    *
@@ -1071,6 +1727,91 @@ struct factory {
     return task_type(std::make_shared<typename task_type::impl_type>(t_.m_impl));
   }
 
+  /**
+   * Factory method for creating @ref tag::fan_out "fan-out" compound tasks.
+   *
+   * @param t_ task to run for each element of the input vector
+   * @param max_concurrency_ maximal number of concurrently running subtasks,
+   *        0 for no limit
+   *
+   * @see @ref tag::fan_out "fan-out" compound task
+   */
+  template <typename TaskT>
+  inline static task<
+      tag::fan_out
+    , detail::default_runner_type
+    , std::vector<typename TaskT::input_type>
+    , typename detail::traits::get_fan_out_result_type<typename TaskT::result_type>::type
+  > fan_out(const TaskT& t_, std::size_t max_concurrency_ = 0)
+  {
+    static_assert(
+        !std::is_same<typename TaskT::input_type, void>::value
+      , "The task to fan out must accept the input parameter.");
+
+    using result_type = typename detail::traits::get_fan_out_result_type<typename TaskT::result_type>::type;
+    using input_type = std::vector<typename TaskT::input_type>;
+    using task_type = task<tag::fan_out, detail::default_runner_type, input_type, result_type>;
+
+    return task_type(std::make_shared<typename task_type::impl_type>(max_concurrency_, t_.m_impl));
+  }
+
+  /**
+   * Factory method for creating @ref tag::throttle "throttle" compound tasks.
+   *
+   * @param t_ task whose concurrent runs to limit
+   * @param max_in_flight_ maximal number of concurrent runs of the task @a t_
+   *
+   * @exception cool::ng::exception::illegal_argument thrown if @a max_in_flight_
+   *   is 0
+   *
+   * @see @ref tag::throttle "throttle" compound task
+   */
+  template <typename TaskT>
+  inline static task<
+      tag::throttle
+    , detail::default_runner_type
+    , typename TaskT::input_type
+    , typename TaskT::result_type
+  > throttle(const TaskT& t_, std::size_t max_in_flight_)
+  {
+    using task_type = task<tag::throttle, detail::default_runner_type, typename TaskT::input_type, typename TaskT::result_type>;
+
+    if (max_in_flight_ == 0)
+      throw exception::illegal_argument();
+    return task_type(std::make_shared<typename task_type::impl_type>(max_in_flight_, t_.m_impl));
+  }
+
+  /**
+   * Factory method for creating @ref tag::batch "batch" compound tasks.
+   *
+   * @param t_ batch task to run once per batch
+   * @param max_items_ maximal number of items in one batch
+   * @param max_delay_ maximal delay between the first @c run() call that
+   *        contributes an item to the batch and the start of the batch
+   *
+   * @exception cool::ng::exception::illegal_argument thrown if @a max_items_
+   *   is 0 or if @a max_delay_, converted to microseconds, is 0
+   *
+   * @see @ref tag::batch "batch" compound task
+   */
+  template <typename TaskT, typename RepT, typename PeriodT>
+  inline static task<
+      tag::batch
+    , detail::default_runner_type
+    , typename detail::traits::get_batch_input_type<typename TaskT::input_type>::type
+    , typename detail::traits::get_batch_result_type<typename TaskT::result_type>::type
+  > batch(const TaskT& t_, std::size_t max_items_, const std::chrono::duration<RepT, PeriodT>& max_delay_)
+  {
+    using input_type = typename detail::traits::get_batch_input_type<typename TaskT::input_type>::type;
+    using result_type = typename detail::traits::get_batch_result_type<typename TaskT::result_type>::type;
+    using task_type = task<tag::batch, detail::default_runner_type, input_type, result_type>;
+
+    auto delay = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(max_delay_).count());
+    if (max_items_ == 0 || delay == 0)
+      throw exception::illegal_argument();
+    return task_type(std::make_shared<typename task_type::impl_type>(t_.m_impl, max_items_, delay));
+  }
+
   template <typename PredicateT, typename BodyT>
   inline static task<
       tag::loop
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_9698e30e_d8d2_4575_9a02_34f42fbf0e04)
+#define      cool_ng_9698e30e_d8d2_4575_9a02_34f42fbf0e04
+
+#include <memory>
+#include <chrono>
+
+#include "cool/ng/impl/platform.h"
+#include "cool/ng/exception.h"
+#include "cool/ng/async/runner.h"
+#include "cool/ng/async/task.h"
+
+namespace cool { namespace ng { namespace async {
+
+/**
+ * Group of tasks with a single completion.
+ *
+ * The task group runs any number of @ref task "tasks", each spawned via a
+ * call to @ref spawn(), and tracks them as a single unit of work. The group
+ * completes when all spawned tasks have completed. The completion of the group
+ * can be awaited either by blocking the calling thread in @ref join(), or
+ * asynchronously by the @ref tag::join "join task" created by @ref join_task(),
+ * which can be composed into other compound tasks.
+ *
+ * A call to @ref cancel() cancels all tasks spawned into the group. The tasks
+ * that have not yet started will not start, and the tasks in progress will
+ * stop at the next point where they would be scheduled with a runner. Note
+ * that the user @em Callable that is already executing completes normally.
+ * The cancelled tasks count as completed, failed with the
+ * @c errc::request_aborted error code, unless an earlier task already failed.
+ *
+ * All tasks spawned into the group share the group's memory pool and the
+ * group's reference count. The group's resources are released in one step,
+ * when the last spawned task completes and the last task_group object and
+ * join task referring to the group are destroyed.
+ *
+ * @note Task group objects created via copy construction or copy assignment
+ *   are clones and refer to the same group.
+ * @note The results of the spawned tasks are discarded. The spawned tasks that
+ *   need to pass the result elsewhere should do so themselves.
+ */
+class task_group
+{
+ public:
+  /**
+   * Create a new, empty task group.
+   */
+  task_group() : m_impl(new detail::group())
+  { /* noop */ }
+
+  task_group(const task_group& other_) : m_impl(other_.m_impl)
+  {
+    m_impl->add_ref();
+  }
+
+  task_group& operator=(const task_group& other_)
+  {
+    if (m_impl != other_.m_impl)
+    {
+      other_.m_impl->add_ref();
+      m_impl->release();
+      m_impl = other_.m_impl;
+    }
+    return *this;
+  }
+
+  ~task_group()
+  {
+    m_impl->release();
+  }
+
+  /**
+   * Spawn a task into the group.
+   *
+   * @param t_ task to spawn, which must not accept input
+   *
+   * @note Tasks spawned into a cancelled group do not run.
+   */
+  template <typename TaskT>
+  void spawn(const TaskT& t_)
+  {
+    static_assert(
+        std::is_same<typename TaskT::input_type, void>::value
+      , "The task spawned without input must not accept input parameter.");
+    start(t_.m_impl, boost::any());
+  }
+
+  /**
+   * Spawn a task into the group.
+   *
+   * @param t_ task to spawn
+   * @param i_ input to pass to the task
+   *
+   * @note Tasks spawned into a cancelled group do not run.
+   */
+  template <typename TaskT, typename InputT>
+  void spawn(const TaskT& t_, const InputT& i_)
+  {
+    static_assert(
+        !std::is_same<typename TaskT::input_type, void>::value
+      , "The task spawned with input must accept input parameter.");
+    start(t_.m_impl, boost::any(static_cast<const typename TaskT::input_type&>(i_)));
+  }
+
+  /**
+   * Cancel all tasks spawned into the group.
+   */
+  void cancel()
+  {
+    m_impl->cancel();
+  }
+
+  /**
+   * Returns true if the group was cancelled.
+   */
+  bool cancelled() const
+  {
+    return m_impl->cancelled();
+  }
+
+  /**
+   * Returns the number of spawned tasks that have not yet completed.
+   */
+  std::size_t pending() const
+  {
+    return m_impl->pending();
+  }
+
+  /**
+   * Block the calling thread until all spawned tasks complete.
+   *
+   * @throw any exception thrown by the first spawned task to fail, or
+   *   @c std::system_error if the first task to fail failed with an error code
+   *
+   * @warning Calling join() from the task running on a @ref runner may
+   *   deadlock the runner.
+   */
+  void join()
+  {
+    m_impl->wait(0);
+  }
+
+  /**
+   * Block the calling thread until all spawned tasks complete or until the
+   * timeout expires.
+   *
+   * @return true if all spawned tasks completed, false if timeout expired.
+   *
+   * @throw any exception thrown by the first spawned task to fail, or
+   *   @c std::system_error if the first task to fail failed with an error code
+   */
+  template <typename RepT, typename PeriodT>
+  bool join_for(const std::chrono::duration<RepT, PeriodT>& timeout_)
+  {
+    auto aux = std::chrono::duration_cast<std::chrono::microseconds>(timeout_).count();
+    return m_impl->wait(aux > 0 ? static_cast<uint64_t>(aux) : 1);
+  }
+
+  /**
+   * Create a @ref tag::join "join task" for this group.
+   *
+   * @param r_ the runner to use to continue after the group completes.
+   *
+   * @note The join task completes when there are no pending spawned tasks
+   *   at the moment of the join task's run or later.
+   */
+  template <typename RunnerT>
+  task<tag::join, detail::default_runner_type, void, void> join_task(const std::weak_ptr<RunnerT>& r_) const
+  {
+    using task_type = task<tag::join, detail::default_runner_type, void, void>;
+    return task_type(std::make_shared<typename task_type::impl_type>(m_impl, r_));
+  }
+
+ private:
+  void start(const std::shared_ptr<detail::task>& t_, const boost::any& input_)
+  {
+    if (m_impl->cancelled())
+      return;
+
+    auto stack = new (*m_impl) detail::group_task_stack(m_impl);
+    try
+    {
+      auto ctx = t_->create_context(stack, t_, input_);
+      auto g = m_impl;
+      ctx->set_res_reporter([] (const boost::any&) { /* noop */ });
+      ctx->set_exc_reporter([g] (const std::exception_ptr& e_) { g->member_failed(e_); });
+      ctx->set_err_reporter([g] (const std::error_code& e_) { g->member_failed(e_); });
+      detail::kickstart(stack);
+    }
+    catch (...)
+    {
+      delete stack;
+      throw;
+    }
+  }
+
+ private:
+  detail::group* m_impl;
+};
+
+} } } // namespace
+
+#endif
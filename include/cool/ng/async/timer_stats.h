@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_7d3a9e64_21c8_4f0b_b5d2_8e6f1a0c3b47)
+#define      cool_ng_7d3a9e64_21c8_4f0b_b5d2_8e6f1a0c3b47
+
+#include <cstdint>
+#include <cstddef>
+
+namespace cool { namespace ng { namespace async {
+
+/**
+ * Histogram of timer delays.
+ *
+ * The histogram uses logarithmic buckets: bucket 0 counts the delays of
+ * less than 1 microsecond, and bucket @em i counts the delays of at least
+ * 2<sup>i-1</sup> and less than 2<sup>i</sup> microseconds. The last bucket
+ * also counts all longer delays.
+ */
+struct timer_histogram
+{
+  /**
+   * Number of histogram buckets.
+   */
+  static const std::size_t size = 32;
+
+  timer_histogram() : count(0), sum(0), max(0)
+  {
+    for (auto& b : buckets)
+      b = 0;
+  }
+
+  /**
+   * Number of the recorded delays.
+   */
+  uint64_t count;
+  /**
+   * Sum of the recorded delays, in microseconds.
+   */
+  uint64_t sum;
+  /**
+   * The longest recorded delay, in microseconds.
+   */
+  uint64_t max;
+  /**
+   * Histogram buckets.
+   */
+  uint64_t buckets[size];
+};
+
+/**
+ * Timer accuracy and jitter statistics.
+ *
+ * The delivery of each timer expiration to the user @em Callable is split into
+ * two stages, each with its own histogram:
+ *   - the <em>fire delay</em> is the time from the scheduled expiration
+ *     to the moment the platform timer actually fired. It is caused by the
+ *     leeway, the coalescing of timers by the operating system and, for the
+ *     timing wheel timers, by the wheel resolution.
+ *   - the <em>dispatch delay</em> is the time from the moment the platform
+ *     timer fired to the moment the @ref runner started to execute the
+ *     user @em Callable. It is caused by the runner being busy.
+ *
+ * @see timer::instrument()
+ */
+struct timer_stats
+{
+  timer_stats() : missed(0)
+  { /* noop */ }
+
+  /**
+   * Histogram of delays between the scheduled expiration and the firing of
+   * the platform timer.
+   */
+  timer_histogram fire_delay;
+  /**
+   * Histogram of delays between the firing of the platform timer and the
+   * start of the user @em Callable.
+   */
+  timer_histogram dispatch_delay;
+  /**
+   * Number of expirations the platform timer coalesced into a later one.
+   */
+  uint64_t missed;
+};
+
+} } } // namespace
+
+#endif
@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(__COOL_INCLUDE_TASK_IMPL_FILES__)
+#error "This header file cannot be directly included in the application code."
+#endif
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Batch state shared by all runs of the batch task
+// ----
+// ---- -----------------------------------------------------------------------
+
+// ---- interface of the runs waiting for their batch to complete
+class batch_waiter
+{
+ public:
+  virtual ~batch_waiter() { /* noop */ }
+  virtual void complete(const boost::any&, const std::exception_ptr&, const std::error_code&) = 0;
+};
+
+using batch_waiters = std::vector<batch_waiter*>;
+
+// ---- distributes the results of the batch task to the waiting runs
+template <typename ResultT>
+struct batch_distributor
+{
+  static void distribute(const batch_waiters& waiters_, const boost::any& res_)
+  {
+    auto& results = boost::any_cast<const std::vector<ResultT>&>(res_);
+    for (std::size_t i = 0; i < waiters_.size(); ++i)
+    {
+      if (i < results.size())
+        waiters_[i]->complete(results[i], nullptr, std::error_code());
+      else
+        waiters_[i]->complete(
+            boost::any()
+          , std::make_exception_ptr(exception::out_of_range())
+          , std::error_code());
+    }
+  }
+};
+
+template <>
+struct batch_distributor<void>
+{
+  static void distribute(const batch_waiters& waiters_, const boost::any&)
+  {
+    for (auto& w : waiters_)
+      w->complete(boost::any(), nullptr, std::error_code());
+  }
+};
+
+// The items of the runs are collected into the pending batch which is passed
+// to the batch subtask when full or when the one-shot timer, armed with the
+// maximal delay when the first item of the batch arrives, expires, whichever
+// comes first. Each batch has its generation number and the timer expiry
+// only flushes the batch of the generation the timer was armed for. When the
+// batch gets full the timer is shut down and a new one is created for the
+// next batch, as the expiry of the stopped timer may already be under way.
+template <typename ItemT, typename ResultT>
+class batch_state : public std::enable_shared_from_this<batch_state<ItemT, ResultT>>
+{
+ public:
+  using items_type = std::vector<ItemT>;
+
+ private:
+  // ---- timer callback, forwards the expiry with the armed generation
+  class expiry : public impl::cb::timer
+  {
+   public:
+    expiry(const std::weak_ptr<batch_state>& state_)
+      : m_state(state_), m_generation(0)
+    { /* noop */ }
+
+    void expired() override
+    {
+      auto s = m_state.lock();
+      if (s)
+        s->expired(m_generation);
+    }
+
+   public:
+    std::weak_ptr<batch_state> m_state;
+    std::atomic<uint64_t>      m_generation;
+  };
+
+ public:
+  batch_state(const std::shared_ptr<task>& task_, std::size_t max_items_, uint64_t max_delay_)
+    : m_task(task_), m_max_items(max_items_), m_max_delay(max_delay_), m_generation(0)
+  { /* noop */ }
+
+  // complete the runs still waiting for the pending batch, they would never
+  // be completed otherwise
+  ~batch_state()
+  {
+    if (m_timer)
+      m_timer->shutdown();
+
+    auto err = cool::ng::error::make_error_code(cool::ng::error::errc::request_aborted);
+    for (auto& w : m_waiters)
+    {
+      try { w->complete(boost::any(), nullptr, err); } catch (...) { /* noop */ }
+    }
+  }
+
+  void add(const ItemT& item_, batch_waiter* waiter_)
+  {
+    items_type items;
+    batch_waiters waiters;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (m_items.empty())
+        arm_timer();
+
+      m_items.push_back(item_);
+      m_waiters.push_back(waiter_);
+      if (m_items.size() < m_max_items)
+        return;
+
+      retire_timer();
+      take(items, waiters);
+    }
+    run(items, waiters);
+  }
+
+  void expired(uint64_t generation_)
+  {
+    items_type items;
+    batch_waiters waiters;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (generation_ != m_generation || m_items.empty())
+        return;
+      take(items, waiters);
+    }
+    run(items, waiters);
+  }
+
+ private:
+  // must be called with the mutex locked
+  void arm_timer()
+  {
+    if (!m_timer)
+    {
+      auto r = m_task->get_runner().lock();
+      if (!r)
+        throw exception::runner_not_available();
+      auto e = std::make_shared<expiry>(this->shared_from_this());
+      m_timer = impl::create_timer(r, e, m_max_delay, m_max_delay / 10 == 0 ? 1 : m_max_delay / 10);
+      m_expiry = e;
+    }
+    m_expiry->m_generation = m_generation;
+    m_timer->start_once(m_max_delay);
+  }
+
+  // must be called with the mutex locked
+  void retire_timer()
+  {
+    m_timer->shutdown();
+    m_timer.reset();
+    m_expiry.reset();
+  }
+
+  // must be called with the mutex locked
+  void take(items_type& items_, batch_waiters& waiters_)
+  {
+    ++m_generation;
+    items_.swap(m_items);
+    waiters_.swap(m_waiters);
+    m_items.reserve(m_max_items);
+    m_waiters.reserve(m_max_items);
+  }
+
+  // must be called with the mutex unlocked
+  void run(items_type& items_, const batch_waiters& waiters_)
+  {
+    auto waiters = std::make_shared<batch_waiters>(waiters_);
+    auto stack = new default_task_stack();
+    try
+    {
+      auto ctx = m_task->create_context(stack, m_task, boost::any(std::move(items_)));
+      ctx->set_res_reporter(
+        [waiters] (const boost::any& res_)
+        {
+          batch_distributor<ResultT>::distribute(*waiters, res_);
+        });
+      ctx->set_exc_reporter(
+        [waiters] (const std::exception_ptr& e_)
+        {
+          for (auto& w : *waiters)
+            w->complete(boost::any(), e_, std::error_code());
+        });
+      ctx->set_err_reporter(
+        [waiters] (const std::error_code& e_)
+        {
+          for (auto& w : *waiters)
+            w->complete(boost::any(), nullptr, e_);
+        });
+      kickstart(stack);
+    }
+    catch (...)
+    {
+      delete stack;
+      auto e = std::current_exception();
+      for (auto& w : *waiters)
+        w->complete(boost::any(), e, std::error_code());
+    }
+  }
+
+ private:
+  std::mutex                          m_mutex;
+  std::shared_ptr<task>               m_task;
+  const std::size_t                   m_max_items;
+  const uint64_t                      m_max_delay;   // in microseconds
+  std::shared_ptr<itf::timer>         m_timer;
+  std::shared_ptr<expiry>             m_expiry;      // callback of m_timer
+  uint64_t                            m_generation;  // of the pending batch
+  items_type                          m_items;       // pending batch
+  batch_waiters                       m_waiters;     // runs waiting for pending batch
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Runtime task context
+// ----
+// ---- -----------------------------------------------------------------------
+template <typename InputT, typename ResultT>
+class task_context<tag::batch, default_runner_type, InputT, ResultT>
+  : public task_context_base
+  , public batch_waiter
+{
+ public:
+  using this_type  = task_context;
+  using base       = task_context_base;
+  using state_type = batch_state<InputT, ResultT>;
+
+ private:
+  inline task_context(
+      context_stack* st_
+    , const std::shared_ptr<task>& task_
+    , const std::shared_ptr<state_type>& state_)
+    : base(st_, task_), m_state(state_), m_done(false), m_suspended(false)
+  { /* noop */ }
+
+ public:
+  // NOTE: The context adds its item to the batch from its entry point, once
+  //       it runs, as the executor may delete the stack without running it.
+  inline static this_type* create(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , const std::shared_ptr<state_type>& state_
+    , const boost::any& input_)
+  {
+    auto aux = new this_type(stack_, task_, state_);
+    stack_->push(aux);
+    aux->set_input(input_);
+
+    return aux;
+  }
+
+  // context interface
+  inline std::weak_ptr<async::runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+  const char* name() const override
+  {
+    return "context::batch";
+  }
+  bool will_execute() const override
+  {
+    return true;
+  }
+
+  void entry_point(const std::shared_ptr<async::runner>&, context*) override
+  {
+    try
+    {
+      m_state->add(boost::any_cast<const InputT&>(m_input), this);
+    }
+    catch (...)
+    {
+      // not added to the batch, thus no one else knows of this context
+      m_exception = std::current_exception();
+      m_done = true;
+    }
+
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (!m_done)
+        return;  // wait for the batch to complete
+    }
+    finish();
+  }
+
+  bool suspend() override
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_done)
+      return false;
+    m_suspended = true;
+    return true;
+  }
+
+  // batch_waiter interface
+  void complete(const boost::any& res_, const std::exception_ptr& exc_, const std::error_code& err_) override
+  {
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      m_result = res_;
+      m_exception = exc_;
+      m_error = err_;
+      m_done = true;
+      if (!m_suspended)
+        return;
+    }
+
+    auto stack = m_stack;
+    finish();
+    resume(stack);
+  }
+
+ private:
+  void finish()
+  {
+    m_stack->pop();
+    if (m_exception)
+    {
+      if (m_exc_reporter)
+        m_exc_reporter(m_exception);
+    }
+    else if (m_error)
+      report_error(m_error);
+    else if (m_res_reporter)
+      m_res_reporter(m_result);
+    delete this;
+  }
+
+ private:
+  std::shared_ptr<state_type> m_state;
+  std::mutex                  m_mutex;
+  bool                        m_done;
+  bool                        m_suspended;
+  boost::any                  m_result;
+  std::exception_ptr          m_exception;
+  std::error_code             m_error;
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Static task information
+// ----
+// ---- -----------------------------------------------------------------------
+
+template <typename InputT, typename ResultT>
+class taskinfo<tag::batch, default_runner_type, InputT, ResultT> : public detail::task
+{
+ public:
+  using tag           = tag::batch;
+  using this_type     = taskinfo;
+  using runner_type   = default_runner_type;
+  using result_type   = ResultT;
+  using input_type    = InputT;
+  using context_type  = task_context<tag, runner_type, input_type, result_type>;
+  using state_type    = typename context_type::state_type;
+
+ public:
+  template <typename TaskT>
+  explicit inline taskinfo(const std::shared_ptr<TaskT>& task_, std::size_t max_items_, uint64_t max_delay_)
+      : m_task(task_), m_state(std::make_shared<state_type>(task_, max_items_, max_delay_))
+  { /* noop */ }
+
+  inline void run(const std::shared_ptr<this_type>& self_, const InputT& i_)
+  {
+    auto stack = new default_task_stack();
+    try
+    {
+      create_context(stack, self_, boost::any(i_));
+      kickstart(stack);
+    }
+    catch (...)
+    {
+      delete stack;
+      throw;
+    }
+  }
+
+  inline context* create_context(
+      context_stack* stack_
+    , const std::shared_ptr<task>& self_
+    , const boost::any& input_) const override
+  {
+    return context_type::create(stack_, self_, m_state, input_);
+  }
+
+  inline std::weak_ptr<runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+
+  inline std::size_t get_subtask_count() const override
+  {
+    return 1;
+  }
+
+  inline std::shared_ptr<task> get_subtask(std::size_t) const override
+  {
+    return m_task;
+  }
+
+ private:
+  std::shared_ptr<task>       m_task;
+  std::shared_ptr<state_type> m_state;
+};
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_6725a4df_91da_4a6e_b8e6_3ed6ab07d4d0)
+#define      cool_ng_6725a4df_91da_4a6e_b8e6_3ed6ab07d4d0
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/exception.h"
+#include "cool/ng/async/runner.h"
+#include "cool/ng/async/task.h"
+#include "mpsc_queue.h"
+
+namespace cool { namespace ng { namespace async {
+
+namespace detail {
+
+namespace itf {
+
+// ---- channel interface
+template <typename T>
+class channel
+{
+ public:
+  virtual ~channel() { /* noop */ }
+  virtual bool push(T&& v_) = 0;
+};
+
+} // namespace itf
+
+// --- ---------------------------------------------------------------------
+// ---
+// --- Channel implementation
+// ---
+// --- At most one drain context is scheduled with the runner at any time,
+// --- which makes it the single consumer of the queue. Producers schedule it
+// --- when they find the channel idle. The drain context hands up to batch
+// --- size items to the handler per dispatch and stays on its context stack,
+// --- to be requeued by the executor, for as long as there are items left.
+// ---
+// --- ---------------------------------------------------------------------
+template <typename RunnerT, typename T>
+class channel : public cool::ng::util::self_aware<channel<RunnerT, T>>
+              , public itf::channel<T>
+{
+ public:
+  using handler = std::function<void(const std::shared_ptr<RunnerT>&, std::vector<T>&)>;
+
+ private:
+  class drain_context : public context
+  {
+   public:
+    drain_context(context_stack* stack_, const std::shared_ptr<channel>& ch_)
+      : m_stack(stack_), m_channel(ch_)
+    { /* noop */ }
+
+    std::weak_ptr<async::runner> get_runner() const override
+    {
+      return m_channel->m_runner;
+    }
+    void entry_point(const std::shared_ptr<async::runner>& r_, context*) override
+    {
+      if (m_channel->drain(r_))
+        return;   // stay on the stack for the next batch
+
+      m_stack->pop();
+      delete this;
+    }
+    const char* name() const override
+    {
+      return "context::channel";
+    }
+    bool will_execute() const override
+    {
+      return true;
+    }
+    void set_input(const boost::any&) override
+    { /* noop */ }
+    void set_res_reporter(const result_reporter&) override
+    { /* noop */ }
+    void set_exc_reporter(const exception_reporter&) override
+    { /* noop */ }
+    void set_err_reporter(const error_reporter&) override
+    { /* noop */ }
+
+   private:
+    context_stack*           m_stack;
+    std::shared_ptr<channel> m_channel;
+  };
+
+ public:
+  channel(const std::weak_ptr<RunnerT>& r_, const handler& h_, std::size_t capacity_, std::size_t batch_)
+    : m_runner(r_)
+    , m_handler(h_)
+    , m_batch(batch_)
+    , m_scheduled(false)
+  {
+    if (!m_handler || m_batch == 0)
+      throw exception::illegal_argument();
+    if (!m_runner.lock())
+      throw exception::runner_not_available();
+
+    if (capacity_ == 0)
+      m_queue.reset(new mpsc_list<T>());
+    else
+      m_queue.reset(new mpsc_ring<T>(capacity_));
+  }
+
+  // itf::channel interface
+  bool push(T&& v_) override
+  {
+    if (!m_queue->push(std::move(v_)))
+      return false;
+
+    if (!m_scheduled.exchange(true))
+    {
+      auto stack = new default_task_stack();
+      stack->push(new drain_context(stack, this->shared_from_this()));
+      try
+      {
+        kickstart(stack);
+      }
+      catch (...)
+      {
+        delete stack;
+        m_scheduled = false;
+        throw;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // delivers one batch to the handler; returns true if the caller should
+  // come back for another batch
+  bool drain(const std::shared_ptr<async::runner>& r_)
+  {
+    std::vector<T> batch;
+    batch.reserve(m_batch);
+    while (batch.size() < m_batch && m_queue->pop(batch))
+      ;
+
+    if (!batch.empty())
+    {
+      auto r = std::dynamic_pointer_cast<RunnerT>(r_);
+      if (r)
+      {
+        try { m_handler(r, batch); } catch (...) { /* noop */ }
+      }
+    }
+
+    if (!m_queue->empty())
+      return true;
+
+    // a producer that found the channel scheduled relies on this second look
+    // to get its item delivered
+    m_scheduled.exchange(false);
+    return !m_queue->empty() && !m_scheduled.exchange(true);
+  }
+
+ private:
+  std::weak_ptr<RunnerT>          m_runner;
+  handler                         m_handler;
+  const std::size_t               m_batch;
+  std::unique_ptr<mpsc_queue<T>>  m_queue;
+  std::atomic<bool>               m_scheduled;
+};
+
+} } } } // namespace
+
+#endif
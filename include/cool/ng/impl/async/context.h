@@ -27,6 +27,7 @@
 #include <cstddef>
 #include <memory>
 #include <functional>
+#include <system_error>
 #include <boost/any.hpp>
 
 namespace cool { namespace ng {  namespace async {
@@ -72,6 +73,7 @@ class context
 public:
   using result_reporter    = std::function<void(const boost::any&)>;
   using exception_reporter = std::function<void(const std::exception_ptr&)>;
+  using error_reporter     = std::function<void(const std::error_code&)>;
 
 public:
   virtual ~context() { /* noop */ }
@@ -88,6 +90,12 @@ public:
   virtual void set_input(const boost::any&) = 0;
   virtual void set_res_reporter(const result_reporter& arg_) = 0;
   virtual void set_exc_reporter(const exception_reporter& arg_) = 0;
+  virtual void set_err_reporter(const error_reporter& arg_) = 0;
+  // called by the executor if the context remains on the top of the stack
+  // after its entry point returned; returns true if the context took over
+  // the stack and will resubmit it on its own, false if the executor should
+  // resubmit it
+  virtual bool suspend() { return false; }
 };
 
 // ---- execution context stack interface
@@ -109,6 +117,9 @@ class context_stack : public  work
   virtual context* pop() = 0;
   // returns true if stack is empty
   virtual bool empty() const = 0;
+  // returns true if the work on this stack was cancelled and the executor
+  // should delete the stack rather than run its top context
+  virtual bool cancelled() const { return false; }
 };
 
 
@@ -57,12 +57,11 @@ class timer : public cool::ng::util::self_aware<timer<RunnerT>>
 
   void initialize(uint64_t p_, uint64_t l_)
   {
-    if (p_ == 0 || !m_handler)
-      throw exception::illegal_argument();
-    auto r = m_runner.lock();
-    if (!r)
-      throw exception::runner_not_available();
-    m_impl = impl::create_timer(r, this->self(), p_, l_);
+    m_impl = impl::create_timer(check(p_), this->self(), p_, l_);
+  }
+  void initialize(uint64_t p_)
+  {
+    m_impl = impl::create_wheel_timer(check(p_), this->self(), p_);
   }
 
   // itf::timer interface
@@ -70,10 +69,18 @@ class timer : public cool::ng::util::self_aware<timer<RunnerT>>
   {
     m_impl->start();
   }
+  void start_once(uint64_t d_) override
+  {
+    m_impl->start_once(d_);
+  }
   void stop() override
   {
     m_impl->stop();
   }
+  void stats(async::timer_stats& s_) const override
+  {
+    m_impl->stats(s_);
+  }
   void period(uint64_t p_, uint64_t l_) override
   {
     m_impl->period(p_, l_);
@@ -96,12 +103,80 @@ class timer : public cool::ng::util::self_aware<timer<RunnerT>>
     }
   }
 
+ private:
+  std::shared_ptr<RunnerT> check(uint64_t p_) const
+  {
+    if (p_ == 0 || !m_handler)
+      throw exception::illegal_argument();
+    auto r = m_runner.lock();
+    if (!r)
+      throw exception::runner_not_available();
+    return r;
+  }
+
  private:
   std::shared_ptr<itf::timer> m_impl;
   std::weak_ptr<RunnerT>      m_runner;
   handler                     m_handler;
 };
 
+template <typename RunnerT>
+class signal_source : public cool::ng::util::self_aware<signal_source<RunnerT>>
+                    , public itf::signal
+                    , public impl::cb::signal
+{
+ public:
+  using handler = std::function<void(const std::shared_ptr<RunnerT>&, unsigned long)>;
+
+ public:
+  signal_source(const std::weak_ptr<RunnerT>& r_, const handler& h_)
+    : m_runner(r_), m_handler(h_)
+  { /* noop */ }
+
+  ~signal_source()
+  {
+    if (m_impl)
+      m_impl->shutdown();
+  }
+
+  void initialize(signal_merge m_)
+  {
+    if (!m_handler)
+      throw exception::illegal_argument();
+    auto r = m_runner.lock();
+    if (!r)
+      throw exception::runner_not_available();
+    m_impl = impl::create_signal(r, this->self(), m_);
+  }
+
+  // itf::signal interface
+  void trigger(unsigned long v_) override
+  {
+    m_impl->trigger(v_);
+  }
+  const std::string& name() const override
+  {
+    return m_impl->name();
+  }
+  void shutdown() override
+  { /* noop */ }
+
+  // impl::cb::signal interface
+  void signalled(unsigned long v_) override
+  {
+    auto r = m_runner.lock();
+    if (r)
+    {
+      try { m_handler(r, v_); } catch (...) { /* noop */ }
+    }
+  }
+
+ private:
+  std::shared_ptr<itf::signal> m_impl;
+  std::weak_ptr<RunnerT>       m_runner;
+  handler                      m_handler;
+};
+
 
 
 } } } } // namespace
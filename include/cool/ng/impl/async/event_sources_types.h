@@ -25,15 +25,101 @@
 #define      cool_ng_f36defb0_bb34_4ce1_b25a_943f5deed23a
 
 #include <memory>
+#include <string>
 #include <cstdint>
+#include <vector>
 #include <functional>
 #include <system_error>
 
 #include "cool/ng/ip_address.h"
+#include "cool/ng/async/timer_stats.h"
+#include "cool/ng/async/net/stream_stats.h"
 #include "cool/ng/async/runner.h"
 
 namespace cool { namespace ng { namespace async {
 
+/**
+ * Merge mode of the @ref signal_source.
+ */
+enum class signal_merge
+{
+  add,        //!< values of the triggers are added together
+  bitwise_or  //!< values of the triggers are combined using bitwise or
+};
+
+namespace net {
+
+/**
+ * Description of a buffer with data to write, for use with the gathering
+ * @ref stream::write "write".
+ */
+struct const_buffer
+{
+  const void* data;  //!< address of the data
+  std::size_t size;  //!< size of the data, in bytes
+};
+
+/**
+ * Tuning options of the network sockets, for use with the @ref server and
+ * @ref stream constructors.
+ *
+ * Each option left at its default value of -1 leaves the platform's default
+ * setting of the socket. The options not supported by the platform are
+ * silently ignored.
+ */
+struct socket_options
+{
+  socket_options()
+    : no_delay(-1), rcv_buf(-1), snd_buf(-1), keep_alive(-1), keep_idle(-1)
+    , keep_interval(-1), keep_count(-1), quick_ack(-1), busy_poll(-1), tos(-1)
+    , pass_handles(-1)
+  { /* noop */ }
+
+  int no_delay;       //!< @c TCP_NODELAY, set to 1 to disable the Nagle's algorithm
+  int rcv_buf;        //!< @c SO_RCVBUF, size of the receive buffer, in bytes
+  int snd_buf;        //!< @c SO_SNDBUF, size of the send buffer, in bytes
+  int keep_alive;     //!< @c SO_KEEPALIVE, set to 1 to enable the keep-alive probes
+  int keep_idle;      //!< @c TCP_KEEPIDLE, idle time before the first probe, in seconds
+  int keep_interval;  //!< @c TCP_KEEPINTVL, time between the probes, in seconds
+  int keep_count;     //!< @c TCP_KEEPCNT, number of failed probes to drop the connection
+  int quick_ack;      //!< @c TCP_QUICKACK, set to 1 to send acknowledgements immediately (Linux only);
+                      //!< Linux clears it as it sees fit, thus the @ref stream sets it again after each read
+  int busy_poll;      //!< @c SO_BUSY_POLL, time to busy poll the device, in microseconds (Linux only)
+  int tos;            //!< @c IP_TOS, or @c IPV6_TCLASS for IPv6 sockets
+  int pass_handles;   //!< set to 1 to accept the handles passed by the peer over the
+                      //!< @ref local_endpoint "local" stream (@ref stream only)
+};
+
+/**
+ * Address of the local, Unix domain, socket for use with the @ref server and
+ * @ref stream constructors.
+ *
+ * The endpoint is either a path in the file system or, on Linux only, a name
+ * in the abstract socket namespace which does not appear in the file system
+ * and disappears when the last socket bound to it is closed.
+ */
+struct local_endpoint
+{
+  explicit local_endpoint(const std::string& path_, bool abstract_ = false)
+    : path(path_), abstract(abstract_)
+  { /* noop */ }
+  std::string path;      //!< file system path, or the name in the abstract namespace
+  bool        abstract;  //!< true if the name is in the abstract namespace (Linux only)
+};
+
+/**
+ * Description of a single datagram received or to be sent by the
+ * @ref datagram event source.
+ */
+struct datagram_message
+{
+  const void*                       data;  //!< address of the datagram payload
+  std::size_t                       size;  //!< size of the payload, in bytes
+  cool::ng::net::ip::host_container peer;  //!< address of the sender or the recipient
+  uint16_t                          port;  //!< port of the sender or the recipient
+};
+
+} // namespace net
 
 namespace detail {
 
@@ -64,6 +150,20 @@ class timer : public startable
 {
  public:
   virtual void period(uint64_t, uint64_t) = 0;
+  // arms the timer to expire once after the delay, in microseconds, or after
+  // one period if the delay is 0; re-arming replaces the previous deadline
+  virtual void start_once(uint64_t) = 0;
+  // fills in the accuracy statistics; leaves them as they are if the timer
+  // is not instrumented
+  virtual void stats(async::timer_stats&) const = 0;
+};
+
+//--- signal event source interface
+class signal : public event_source
+{
+ public:
+  // merges the value into the value pending for the next handler call
+  virtual void trigger(unsigned long) = 0;
 };
 
 //--- writable event source interface
@@ -71,6 +171,10 @@ class writable : public event_source
 {
  public:
   virtual void write(const void* data, std::size_t sz) = 0;
+  // queues all buffers, to be written together if possible
+  virtual void write(const net::const_buffer* bufs, std::size_t count) = 0;
+  // queues the data, taking over its ownership
+  virtual void write(std::vector<uint8_t>&& data) = 0;
 };
 
 } }  // namespace detail::itf
@@ -86,6 +190,13 @@ class timer
   virtual void expired() = 0;
 };
 
+class signal
+{
+ public:
+  virtual ~signal() { /* noop */}
+  virtual void signalled(unsigned long) = 0;
+};
+
 
 } // namespace cb
 
@@ -101,6 +212,19 @@ dlldecl std::shared_ptr<detail::itf::timer> create_timer(
   , uint64_t l_
 );
 
+// timer using the timing wheel timer service rather than the platform timer
+dlldecl std::shared_ptr<detail::itf::timer> create_wheel_timer(
+    const std::shared_ptr<runner>& r_
+  , const std::weak_ptr<cb::timer>& t_
+  , uint64_t p_
+);
+
+dlldecl std::shared_ptr<detail::itf::signal> create_signal(
+    const std::shared_ptr<runner>& r_
+  , const std::weak_ptr<cb::signal>& s_
+  , signal_merge m_
+);
+
 } // namespace impl
 
 // --- ============================================
@@ -110,9 +234,15 @@ namespace net  {
 
 class stream;
 
+namespace impl {
+
+class stream_probe;
+
+} // namespace impl
+
 namespace detail {
 
-enum class oob_event { connect, disconnect, failure };
+enum class oob_event { connect, disconnect, failure, write_blocked, write_unblocked };
 
 namespace ip = cool::ng::net::ip;
 
@@ -131,7 +261,11 @@ class types
   using write_handler = std::function<void(const ptr&, const void*, std::size_t)>;
   using read_handler  = std::function<void(const ptr&, void*&, std::size_t&)>;
   using event_handler = std::function<void(const ptr&, oob_event, const std::error_code&)>;
+  // types required by framing
+  using frame_handler = std::function<void(const ptr&, const void*, std::size_t)>;
 
+  // types required by datagram
+  using datagram_handler = std::function<void(const ptr&, const datagram_message*, std::size_t)>;
 };
 
 namespace itf {
@@ -141,9 +275,40 @@ class connected_writable : public async::detail::itf::writable
 {
  public:
   virtual void connect(const ip::address&, uint16_t) = 0;
+  virtual void connect(const local_endpoint&) = 0;
   virtual void disconnect() = 0;
   virtual void set_handle(cool::ng::net::handle h_) = 0;
+  // limits the bytes and the number of reads per read event
+  virtual void read_budget(std::size_t bytes_, std::size_t reads_) = 0;
+  // queues the handle, which the stream takes over, to pass to the peer
+  virtual void write_handle(cool::ng::net::handle h_) = 0;
+  // returns the next handle received from the peer, or invalid_handle
+  virtual cool::ng::net::handle received_handle() = 0;
+  // sets the write queue watermarks, in bytes; high_ of 0 disables them
+  virtual void watermarks(std::size_t high_, std::size_t low_, bool pause_read_) = 0;
+  // fills in the input/output statistics
+  virtual void stats(stream_stats&) const = 0;
+  // adds the statistics of this stream also to the given probe; must be
+  // called before the stream starts reading or writing
+  virtual void aggregate(const std::shared_ptr<impl::stream_probe>& probe_) = 0;
+};
+
+//--- server event source interface
+class server : public async::detail::itf::startable
+{
+ public:
+  // fills in the aggregate statistics of the accepted streams
+  virtual void stats(stream_stats&) const = 0;
+};
 
+//--- datagram event source interface
+class datagram : public async::detail::itf::event_source
+{
+ public:
+  // sends as many datagrams as the socket accepts and returns their number
+  virtual std::size_t send(const datagram_message* msgs_, std::size_t count_) = 0;
+  virtual void join(const ip::address& group_) = 0;
+  virtual void leave(const ip::address& group_) = 0;
 };
 
 } // namespace itf
@@ -156,6 +321,10 @@ namespace impl {
 using cool::ng::net::handle;
 namespace ip = cool::ng::net::ip;
 
+// default read budget of the stream per read event
+const std::size_t default_read_budget_bytes = 256 * 1024;
+const std::size_t default_read_budget_reads = 16;
+
 // callback implementation interfaces
 namespace cb {
 
@@ -188,15 +357,38 @@ class stream
   virtual void on_event(detail::oob_event, const std::error_code&) = 0;
 };
 
+// --- callback interface required by the implementation of the UDP datagram
+class datagram
+{
+ public:
+  using weak_ptr = std::weak_ptr<datagram>;
+  using ptr = std::shared_ptr<datagram>;
+
+ public:
+  virtual ~datagram() { /* noop */ }
+  virtual void on_receive(const datagram_message*, std::size_t) = 0;
+};
+
 } // namespace cb
 
+// maximum number of datagrams moved per system call and the default size of
+// the receive buffer for a single datagram
+const std::size_t default_datagram_batch = 32;
+const std::size_t default_datagram_size = 2048;
+
 // factories for implementation classes
 
-dlldecl std::shared_ptr<async::detail::itf::startable> create_server(
+dlldecl std::shared_ptr<detail::itf::server> create_server(
     const std::shared_ptr<runner>& r_
   , const cool::ng::net::ip::address& addr_
   , uint16_t port_
-  , const cb::server::weak_ptr& cb_);
+  , const cb::server::weak_ptr& cb_
+  , const net::socket_options& opts_);
+dlldecl std::shared_ptr<detail::itf::server> create_server(
+    const std::shared_ptr<runner>& r_
+  , const net::local_endpoint& ep_
+  , const cb::server::weak_ptr& cb_
+  , const net::socket_options& opts_);
 
 dlldecl std::shared_ptr<detail::itf::connected_writable> create_stream(
     const std::shared_ptr<runner>& runner_
@@ -204,13 +396,30 @@ dlldecl std::shared_ptr<detail::itf::connected_writable> create_stream(
   , uint16_t port_
   , const cb::stream::weak_ptr& cb_
   , void* buf_
-  , std::size_t bufsz_);
+  , std::size_t bufsz_
+  , const net::socket_options& opts_);
+dlldecl std::shared_ptr<detail::itf::connected_writable> create_stream(
+    const std::shared_ptr<runner>& runner_
+  , const net::local_endpoint& ep_
+  , const cb::stream::weak_ptr& cb_
+  , void* buf_
+  , std::size_t bufsz_
+  , const net::socket_options& opts_);
 dlldecl std::shared_ptr<detail::itf::connected_writable> create_stream(
     const std::shared_ptr<runner>& runner_
   , const cb::stream::weak_ptr& cb_
   , void* buf_
-  , std::size_t bufsz_);
+  , std::size_t bufsz_
+  , const net::socket_options& opts_);
 
+dlldecl std::shared_ptr<detail::itf::datagram> create_datagram(
+    const std::shared_ptr<runner>& runner_
+  , const cool::ng::net::ip::address& addr_
+  , uint16_t port_
+  , const cb::datagram::weak_ptr& cb_
+  , std::size_t batch_
+  , std::size_t size_
+  , const net::socket_options& opts_);
 
 } // namespace impl
 
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(__COOL_INCLUDE_TASK_IMPL_FILES__)
+#error "This header file cannot be directly included in the application code."
+#endif
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Runtime task context
+// ----
+// ---- -----------------------------------------------------------------------
+
+// ---- Result collector, stores the subtask results at the index of their input
+template <typename ResultT>
+class fan_out_collector
+{
+ public:
+  void resize(std::size_t size_)
+  {
+    m_results.resize(size_);
+  }
+  void set(std::size_t index_, const boost::any& res_)
+  {
+    if (!res_.empty())
+      m_results[index_] = boost::any_cast<typename ResultT::value_type>(res_);
+  }
+  boost::any get() const
+  {
+    return m_results;
+  }
+
+ private:
+  ResultT m_results;
+};
+
+template <>
+class fan_out_collector<void>
+{
+ public:
+  void resize(std::size_t)
+  { /* noop */ }
+  void set(std::size_t, const boost::any&)
+  { /* noop */ }
+  boost::any get() const
+  {
+    return boost::any();
+  }
+};
+
+// The fan-out context runs each subtask instance in its own context stack.
+// While they run the context remains on the top of its own stack and takes
+// the stack over in suspend(); the stack is resumed by whoever completes the
+// fan-out, either the last subtask instance or, if all instances completed
+// before the executor called suspend(), the entry point on the next run.
+template <typename RunnerT, typename InputT, typename ResultT>
+class task_context<tag::fan_out, RunnerT, InputT, ResultT>
+  : public task_context_base
+{
+ public:
+  using this_type  = task_context;
+  using base       = task_context_base;
+  using start_vector_type = std::vector<std::pair<std::size_t, context_stack*>>;
+
+ private:
+  inline task_context(context_stack* st_, const std::shared_ptr<task>& t_, std::size_t limit_)
+    : base(st_, t_)
+    , m_limit(limit_)
+    , m_items(nullptr)
+    , m_next(0)
+    , m_pending(0)
+    , m_started(false)
+    , m_done(false)
+    , m_suspended(false)
+    , m_failed(false)
+  { /* noop */ }
+
+ public:
+  inline static this_type* create(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , std::size_t limit_
+    , const boost::any& input_)
+  {
+    auto aux = new this_type(stack_, task_, limit_);
+    stack_->push(aux);
+    aux->set_input(input_);
+
+    return aux;
+  }
+
+  // context interface
+  inline std::weak_ptr<async::runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+  const char* name() const override
+  {
+    return "context::fan_out";
+  }
+  bool will_execute() const override
+  {
+    return true;
+  }
+
+  void entry_point(const std::shared_ptr<async::runner>&, context*) override
+  {
+    if (m_started)
+    {
+      finish();
+      return;
+    }
+
+    m_started = true;
+    m_items = boost::any_cast<InputT>(&m_input);
+    m_results.resize(m_items->size());
+    if (m_items->empty())
+    {
+      finish();
+      return;
+    }
+
+    start_vector_type aux;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      prepare(aux);
+    }
+    start(aux);
+  }
+
+  bool suspend() override
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_done)
+      return false;
+    m_suspended = true;
+    return true;
+  }
+
+ private:
+  void result_report(std::size_t index_, const boost::any& res_)
+  {
+    complete(index_, res_, false, nullptr, std::error_code());
+  }
+
+  void exception_report(std::size_t index_, const std::exception_ptr& e_)
+  {
+    complete(index_, boost::any(), true, e_, std::error_code());
+  }
+
+  void error_report(std::size_t index_, const std::error_code& e_)
+  {
+    complete(index_, boost::any(), true, nullptr, e_);
+  }
+
+  void complete(
+      std::size_t index_
+    , const boost::any& res_
+    , bool failed_
+    , const std::exception_ptr& exc_
+    , const std::error_code& err_)
+  {
+    start_vector_type aux;
+    bool resume_stack = false;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      --m_pending;
+      // the first failure stops scheduling of further subtask instances
+      if (failed_)
+      {
+        if (!m_failed)
+        {
+          m_failed = true;
+          m_exception = exc_;
+          m_error = err_;
+        }
+      }
+      else
+        m_results.set(index_, res_);
+      if (!m_failed)
+        prepare(aux);
+      if (m_pending == 0)
+      {
+        m_done = true;
+        resume_stack = m_suspended;
+      }
+    }
+    start(aux);
+
+    if (resume_stack)
+    {
+      auto stack = m_stack;
+      finish();
+      resume(stack);
+    }
+  }
+
+  // Creates the subtask instances up to the concurrency limit. Must be called
+  // with the mutex locked; collects the stacks to start in start_.
+  void prepare(start_vector_type& start_)
+  {
+    auto t = m_task->get_subtask(0);
+    while (m_next < m_items->size() && (m_limit == 0 || m_pending < m_limit))
+    {
+      auto stack = new default_task_stack();
+      auto ctx = t->create_context(stack, t, boost::any((*m_items)[m_next]));
+      ctx->set_res_reporter(std::bind(&this_type::result_report, this, m_next, std::placeholders::_1));
+      ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, m_next, std::placeholders::_1));
+      ctx->set_err_reporter(std::bind(&this_type::error_report, this, m_next, std::placeholders::_1));
+      start_.push_back(std::make_pair(m_next, stack));
+      ++m_next;
+      ++m_pending;
+    }
+  }
+
+  // Schedules the prepared subtask instances for execution. Must be called
+  // with the mutex unlocked.
+  void start(const start_vector_type& start_)
+  {
+    for (auto& item : start_)
+    {
+      try
+      {
+        kickstart(item.second);
+      }
+      catch (...)
+      {
+        delete item.second;
+        exception_report(item.first, std::current_exception());
+      }
+    }
+  }
+
+  void finish()
+  {
+    m_stack->pop();
+    if (m_exception)
+    {
+      if (m_exc_reporter)
+        m_exc_reporter(m_exception);
+    }
+    else if (m_failed)
+    {
+      report_error(m_error);
+    }
+    else
+    {
+      if (m_res_reporter)
+        m_res_reporter(m_results.get());
+    }
+    delete this;
+  }
+
+ private:
+  const std::size_t           m_limit;      // max concurrent instances, 0 - no limit
+  const InputT*               m_items;      // points into m_input
+  fan_out_collector<ResultT>  m_results;
+  std::size_t                 m_next;       // index of the next item to start
+  std::size_t                 m_pending;    // number of running instances
+  bool                        m_started;
+  bool                        m_done;
+  bool                        m_suspended;
+  bool                        m_failed;     // m_exception or m_error is valid
+  std::exception_ptr          m_exception;
+  std::error_code             m_error;
+  std::mutex                  m_mutex;
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Static task information
+// ----
+// ---- -----------------------------------------------------------------------
+
+template <typename InputT, typename ResultT>
+class taskinfo<tag::fan_out, default_runner_type, InputT, ResultT> : public detail::task
+{
+ public:
+  using tag           = tag::fan_out;
+  using this_type     = taskinfo;
+  using runner_type   = default_runner_type;
+  using result_type   = ResultT;
+  using input_type    = InputT;
+  using context_type  = task_context<tag, runner_type, input_type, result_type>;
+
+ public:
+  template <typename TaskT>
+  explicit inline taskinfo(std::size_t limit_, const std::shared_ptr<TaskT>& task_)
+      : m_limit(limit_), m_task(task_)
+  { /* noop */ }
+
+  inline void run(const std::shared_ptr<this_type>& self_, const InputT& i_)
+  {
+    auto stack = new default_task_stack();
+    create_context(stack, self_, boost::any(i_));
+    kickstart(stack);
+  }
+
+  inline context* create_context(
+      context_stack* stack_
+    , const std::shared_ptr<task>& self_
+    , const boost::any& input_) const override
+  {
+    return context_type::create(stack_, self_, m_limit, input_);
+  }
+
+  inline std::weak_ptr<runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+
+  inline std::size_t get_subtask_count() const override
+  {
+    return 1;
+  }
+
+  inline std::shared_ptr<task> get_subtask(std::size_t) const override
+  {
+    return m_task;
+  }
+
+ private:
+  const std::size_t     m_limit;
+  std::shared_ptr<task> m_task;
+};
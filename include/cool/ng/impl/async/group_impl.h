@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(__COOL_INCLUDE_TASK_IMPL_FILES__)
+#error "This header file cannot be directly included in the application code."
+#endif
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Task group shared state
+// ----
+// ---- -----------------------------------------------------------------------
+//
+// The group, its member stacks and its join tasks share a single intrusive
+// reference count. The member stacks are allocated from the group's block
+// pool and each holds one reference to the group, released after its block
+// is returned to the pool, thus the last member to finish frees the group
+// and all its blocks in one step.
+
+// ---- interface of the contexts waiting for the group to complete
+class group_waiter
+{
+ public:
+  virtual ~group_waiter() { /* noop */ }
+  virtual void complete(const std::exception_ptr&, const std::error_code&) = 0;
+};
+
+class group
+{
+  // each block is prefixed with the pointer to its group
+  static constexpr std::size_t header_size = sizeof(std::max_align_t);
+  static constexpr std::size_t chunk_blocks = 64;
+
+ public:
+  group() : m_refs(1), m_pending(0), m_cancelled(false), m_block_size(0), m_free(nullptr)
+  { /* noop */ }
+
+  ~group()
+  {
+    for (auto c : m_chunks)
+      delete [] c;
+  }
+
+  void add_ref()
+  {
+    ++m_refs;
+  }
+  void release()
+  {
+    if (--m_refs == 0)
+      delete this;
+  }
+
+  // block pool; all blocks are of the same size
+  void* allocate(std::size_t size_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_free == nullptr)
+    {
+      if (m_block_size == 0)
+        m_block_size = (header_size + size_ + header_size - 1) / header_size * header_size;
+      auto chunk = new char[m_block_size * chunk_blocks];
+      m_chunks.push_back(chunk);
+      for (std::size_t i = 0; i < chunk_blocks; ++i)
+      {
+        auto block = chunk + i * m_block_size;
+        *reinterpret_cast<void**>(block) = m_free;
+        m_free = block;
+      }
+    }
+
+    auto block = static_cast<char*>(m_free);
+    m_free = *reinterpret_cast<void**>(block);
+    *reinterpret_cast<group**>(block) = this;
+    return block + header_size;
+  }
+  static void deallocate(void* p_)
+  {
+    auto block = static_cast<char*>(p_) - header_size;
+    auto self = *reinterpret_cast<group**>(block);
+    {
+      std::unique_lock<std::mutex> l(self->m_mutex);
+      *reinterpret_cast<void**>(block) = self->m_free;
+      self->m_free = block;
+    }
+    self->release();
+  }
+
+  void cancel()
+  {
+    m_cancelled = true;
+  }
+  bool cancelled() const
+  {
+    return m_cancelled;
+  }
+  std::size_t pending() const
+  {
+    return m_pending;
+  }
+
+  void member_started()
+  {
+    ++m_pending;
+  }
+  void member_finished()
+  {
+    std::vector<group_waiter*> waiters;
+    std::exception_ptr exc;
+    std::error_code err;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (--m_pending != 0)
+        return;
+      waiters.swap(m_waiters);
+      exc = m_exception;
+      err = m_error;
+      m_cv.notify_all();
+    }
+    for (auto w : waiters)
+      w->complete(exc, err);
+  }
+  void member_failed(const std::exception_ptr& e_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (!m_exception && !m_error)
+      m_exception = e_;
+  }
+  void member_failed(const std::error_code& e_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (!m_exception && !m_error)
+      m_error = e_;
+  }
+
+  // registers the waiter; returns false and does not register it if there
+  // are no pending members
+  bool add_waiter(group_waiter* w_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_pending == 0)
+      return false;
+    m_waiters.push_back(w_);
+    return true;
+  }
+
+  // blocks until there are no pending members or until timeout expires;
+  // returns false on timeout
+  bool wait(uint64_t timeout_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    auto pred = [this] () { return m_pending == 0; };
+    if (timeout_ == 0)
+      m_cv.wait(l, pred);
+    else if (!m_cv.wait_for(l, std::chrono::microseconds(timeout_), pred))
+      return false;
+
+    if (m_exception)
+      std::rethrow_exception(m_exception);
+    if (m_error)
+      throw std::system_error(m_error);
+    return true;
+  }
+
+  // failure of the first member to fail
+  void failure(std::exception_ptr& exc_, std::error_code& err_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    exc_ = m_exception;
+    err_ = m_error;
+  }
+
+ private:
+  std::atomic<std::size_t>   m_refs;
+  std::atomic<std::size_t>   m_pending;
+  std::atomic<bool>          m_cancelled;
+  std::mutex                 m_mutex;
+  std::condition_variable    m_cv;
+  std::vector<group_waiter*> m_waiters;
+  std::exception_ptr         m_exception;
+  std::error_code            m_error;
+  std::size_t                m_block_size;
+  void*                      m_free;
+  std::vector<char*>         m_chunks;
+};
+
+// ---- Context stack of the group member; allocated from the group's block
+// ---- pool and keeps the first few contexts inline
+class group_task_stack : public context_stack
+{
+  static constexpr std::size_t inline_depth = 6;
+
+ public:
+  explicit group_task_stack(group* g_) : m_group(g_), m_size(0)
+  {
+    m_group->member_started();
+  }
+  // the stack deleted with contexts still on it was not run to completion;
+  // in the cancelled group that is the cancellation of the member
+  ~group_task_stack()
+  {
+    if (!empty() && m_group->cancelled())
+      m_group->member_failed(cool::ng::error::make_error_code(cool::ng::error::errc::request_aborted));
+    while (!empty())
+      delete pop();
+    m_group->member_finished();
+  }
+
+  static void* operator new(std::size_t size_, group& g_)
+  {
+    g_.add_ref();
+    return g_.allocate(size_);
+  }
+  static void operator delete(void* p_, group&)
+  {
+    group::deallocate(p_);
+  }
+  static void operator delete(void* p_)
+  {
+    group::deallocate(p_);
+  }
+
+  void push(context* arg_) override
+  {
+    if (m_size < inline_depth)
+      m_inline[m_size] = arg_;
+    else
+      m_overflow.push_back(arg_);
+    ++m_size;
+  }
+  context* pop() override
+  {
+    auto aux = top();
+    --m_size;
+    if (m_size >= inline_depth)
+      m_overflow.pop_back();
+    return aux;
+  }
+  context* top() const override
+  {
+    return m_size <= inline_depth ? m_inline[m_size - 1] : m_overflow.back();
+  }
+  bool empty() const override
+  {
+    return m_size == 0;
+  }
+  bool cancelled() const override
+  {
+    return m_group->cancelled();
+  }
+
+ private:
+  group*                m_group;
+  std::size_t           m_size;
+  context*              m_inline[inline_depth];
+  std::vector<context*> m_overflow;
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Runtime task context of the join task
+// ----
+// ---- -----------------------------------------------------------------------
+template <typename InputT, typename ResultT>
+class task_context<tag::join, default_runner_type, InputT, ResultT>
+  : public task_context_base
+  , public group_waiter
+{
+ public:
+  using this_type  = task_context;
+  using base       = task_context_base;
+
+ private:
+  inline task_context(context_stack* st_, const std::shared_ptr<task>& task_, group* group_)
+    : base(st_, task_), m_group(group_), m_done(false), m_suspended(false)
+  { /* noop */ }
+
+ public:
+  // NOTE: The context registers with the group from its entry point, once it
+  //       runs, as the executor may delete the stack without running it.
+  inline static this_type* create(context_stack* stack_, const std::shared_ptr<task>& task_, group* group_)
+  {
+    auto aux = new this_type(stack_, task_, group_);
+    stack_->push(aux);
+    return aux;
+  }
+
+  // context interface
+  inline std::weak_ptr<async::runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+  const char* name() const override
+  {
+    return "context::join";
+  }
+  bool will_execute() const override
+  {
+    return true;
+  }
+
+  void entry_point(const std::shared_ptr<async::runner>&, context*) override
+  {
+    if (!m_group->add_waiter(this))
+    {
+      // not registered, thus no one else knows of this context
+      m_done = true;
+      m_group->failure(m_exception, m_error);
+    }
+
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (!m_done)
+        return;  // wait for the group members to finish
+    }
+    finish();
+  }
+
+  bool suspend() override
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_done)
+      return false;
+    m_suspended = true;
+    return true;
+  }
+
+  // group_waiter interface
+  void complete(const std::exception_ptr& exc_, const std::error_code& err_) override
+  {
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      m_exception = exc_;
+      m_error = err_;
+      m_done = true;
+      if (!m_suspended)
+        return;
+    }
+
+    auto stack = m_stack;
+    finish();
+    resume(stack);
+  }
+
+ private:
+  void finish()
+  {
+    m_stack->pop();
+    if (m_exception)
+    {
+      if (m_exc_reporter)
+        m_exc_reporter(m_exception);
+    }
+    else if (m_error)
+      report_error(m_error);
+    else if (m_res_reporter)
+      m_res_reporter(boost::any());
+    delete this;
+  }
+
+ private:
+  group*             m_group;   // kept alive by the join task
+  std::mutex         m_mutex;
+  bool               m_done;
+  bool               m_suspended;
+  std::exception_ptr m_exception;
+  std::error_code    m_error;
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Static task information of the join task
+// ----
+// ---- -----------------------------------------------------------------------
+template <>
+class taskinfo<tag::join, default_runner_type, void, void> : public detail::task
+{
+ public:
+  using tag           = tag::join;
+  using this_type     = taskinfo;
+  using runner_type   = default_runner_type;
+  using result_type   = void;
+  using input_type    = void;
+  using context_type  = task_context<tag, runner_type, input_type, result_type>;
+
+ public:
+  inline taskinfo(group* group_, const std::weak_ptr<async::runner>& r_)
+    : m_group(group_), m_runner(r_)
+  {
+    m_group->add_ref();
+  }
+  inline ~taskinfo()
+  {
+    m_group->release();
+  }
+
+  inline void run(const std::shared_ptr<this_type>& self_)
+  {
+    auto stack = new default_task_stack();
+    try
+    {
+      create_context(stack, self_, boost::any());
+      kickstart(stack);
+    }
+    catch (...)
+    {
+      delete stack;
+      throw;
+    }
+  }
+
+  inline context* create_context(
+      context_stack* stack_
+    , const std::shared_ptr<task>& self_
+    , const boost::any&) const override
+  {
+    return context_type::create(stack_, self_, m_group);
+  }
+
+  inline std::weak_ptr<runner> get_runner() const override
+  {
+    return m_runner;
+  }
+
+  inline std::size_t get_subtask_count() const override
+  {
+    return 0;
+  }
+
+  inline std::shared_ptr<task> get_subtask(std::size_t) const override
+  {
+    return std::shared_ptr<task>();
+  }
+
+ private:
+  group*                       m_group;
+  std::weak_ptr<async::runner> m_runner;
+};
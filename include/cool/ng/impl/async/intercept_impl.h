@@ -31,14 +31,138 @@
 // ----
 // ---- -----------------------------------------------------------------------
 
+// ---- Converts the error code into the input for the catch task accepting
+// ---- parameter of type E. The error code is caught by the catch tasks that
+// ---- accept std::error_code, or that would catch std::system_error exception
+// ---- carrying this error code.
+template <typename E, typename Enable = void>
+struct error_input
+{
+  static bool get(const std::error_code&, boost::any&)
+  {
+    return false;
+  }
+};
+
+template <>
+struct error_input<std::error_code>
+{
+  static bool get(const std::error_code& e_, boost::any& input_)
+  {
+    input_ = e_;
+    return true;
+  }
+};
+
+template <typename E>
+struct error_input<E, typename std::enable_if<std::is_base_of<E, std::system_error>::value>::type>
+{
+  static bool get(const std::error_code& e_, boost::any& input_)
+  {
+    input_ = static_cast<E>(std::system_error(e_));
+    return true;
+  }
+};
+
+// ---- Matches the exception against the input types of all catch tasks with a
+// ---- single rethrow. The exception is rethrown from within the nested try
+// ---- blocks, one for each catch task, with the try block of the first catch
+// ---- task innermost, thus the handlers are examined in the order of catch
+// ---- tasks. The std::exception_ptr input type denotes catch-all handler.
+template <typename E>
+struct exception_handler
+{
+  template <typename NextT>
+  static std::size_t match(const std::exception_ptr& e_, boost::any& input_, std::size_t index_)
+  {
+    try
+    {
+      return NextT::match(e_, input_);
+    }
+    catch (const E& ex)
+    {
+      input_ = ex;
+      return index_;
+    }
+  }
+};
+
+template <>
+struct exception_handler<std::exception_ptr>
+{
+  template <typename NextT>
+  static std::size_t match(const std::exception_ptr& e_, boost::any& input_, std::size_t index_)
+  {
+    try
+    {
+      return NextT::match(e_, input_);
+    }
+    catch (...)
+    {
+      input_ = e_;
+      return index_;
+    }
+  }
+};
+
+// handler for the catch task at index N-1, wrapping handlers of catch tasks
+// at indices 0 to N-2
+template <std::size_t N, typename... E>
+struct exception_matcher_step
+{
+  using type = typename std::tuple_element<N - 1, std::tuple<E...>>::type;
+
+  static std::size_t match(const std::exception_ptr& e_, boost::any& input_)
+  {
+    return exception_handler<type>::template match<exception_matcher_step<N - 1, E...>>(e_, input_, N - 1);
+  }
+};
+
+template <typename... E>
+struct exception_matcher_step<0, E...>
+{
+  static std::size_t match(const std::exception_ptr& e_, boost::any&)
+  {
+    std::rethrow_exception(e_);
+  }
+};
+
+template <typename... E>
+struct exception_matcher
+{
+  // returns index of the matching catch task and sets its input, or the
+  // number of catch tasks if none matches
+  static std::size_t match(const std::exception_ptr& e_, boost::any& input_)
+  {
+    try
+    {
+      return exception_matcher_step<sizeof...(E), E...>::match(e_, input_);
+    }
+    catch (...)
+    { /* noop */ }
+
+    return sizeof...(E);
+  }
+};
+
+using matcher_type = std::size_t (*)(const std::exception_ptr&, boost::any&);
+
 struct catcher
 {
   virtual ~catcher() { /* noop */ }
+  // creates the catch task context with the given input
+  virtual void run(
+      const boost::any& input_
+    , context_stack* stack_
+    , const context::result_reporter& res_
+    , const context::exception_reporter& exc_
+    , const context::error_reporter& err_) = 0;
   virtual bool try_catch(
-      const std::exception_ptr& e_
+      const std::error_code& e_
     , context_stack* stack_
     , const context::result_reporter& res_
-    , const context::exception_reporter& exc_) = 0;
+    , const context::exception_reporter& exc_
+    , const context::error_reporter& err_) = 0;
   virtual std::shared_ptr<task> get_task() const = 0;
 };
 
@@ -47,27 +171,31 @@ template <typename E> class catcher_impl : public catcher
  public:
   catcher_impl(const std::shared_ptr<task>& t_) : m_task(t_)
   { /* noop */ }
+  void run (
+      const boost::any& input_
+    , context_stack* stack_
+    , const context::result_reporter& res_
+    , const context::exception_reporter& exc_
+    , const context::error_reporter& err_) override
+  {
+    auto ctx = m_task->create_context(stack_, m_task, input_);
+    ctx->set_res_reporter(res_);
+    ctx->set_exc_reporter(exc_);
+    ctx->set_err_reporter(err_);
+  }
   bool try_catch (
-      const std::exception_ptr& e_
+      const std::error_code& e_
     , context_stack* stack_
     , const context::result_reporter& res_
-    , const context::exception_reporter& exc_) override
+    , const context::exception_reporter& exc_
+    , const context::error_reporter& err_) override
   {
-    try
-    {
-      std::rethrow_exception(e_);
-    }
-    catch ( const E& ex)
-    {
-      boost::any input = ex;
-      auto ctx = m_task->create_context(stack_, m_task, input);
-      ctx->set_res_reporter(res_);
-      ctx->set_exc_reporter(exc_);
-      return true;
-    }
-    catch ( ... )
-    { }
-    return false;
+    boost::any input;
+    if (!error_input<E>::get(e_, input))
+      return false;
+
+    run(input, stack_, res_, exc_, err_);
+    return true;
   }
 
   std::shared_ptr<task> get_task() const override
@@ -79,22 +207,33 @@ template <typename E> class catcher_impl : public catcher
   std::shared_ptr<task> m_task;
 };
 
-// std::exception_ptr type of parameter is a catch-all catcher
+// std::exception_ptr type of parameter is a catch-all catcher; it receives
+// the error code as std::system_error exception
 template <> class catcher_impl<std::exception_ptr> : public catcher
 {
  public:
   catcher_impl(const std::shared_ptr<task>& t_) : m_task(t_)
   { /* noop */ }
-  bool try_catch (
-      const std::exception_ptr& e_
+  void run (
+      const boost::any& input_
     , context_stack* stack_
     , const context::result_reporter& res_
-    , const context::exception_reporter& exc_) override
+    , const context::exception_reporter& exc_
+    , const context::error_reporter& err_) override
   {
-    boost::any input = e_;
-    auto ctx = m_task->create_context(stack_, m_task, input);
+    auto ctx = m_task->create_context(stack_, m_task, input_);
     ctx->set_res_reporter(res_);
     ctx->set_exc_reporter(exc_);
+    ctx->set_err_reporter(err_);
+  }
+  bool try_catch (
+      const std::error_code& e_
+    , context_stack* stack_
+    , const context::result_reporter& res_
+    , const context::exception_reporter& exc_
+    , const context::error_reporter& err_) override
+  {
+    run(std::make_exception_ptr(std::system_error(e_)), stack_, res_, exc_, err_);
     return true;
   }
   std::shared_ptr<task> get_task() const override
@@ -128,6 +267,7 @@ class taskinfo<tag::intercept, default_runner_type, InputT, ResultT> : public de
     , const std::shared_ptr<CatchT>&... catchers_)
         : m_subtask(task_)
         , m_catchers( { std::make_shared<catcher_impl<typename CatchT::input_type>>(catchers_)... } )
+        , m_matcher(&exception_matcher<typename CatchT::input_type...>::match)
   { /* noop */ }
 
   template <typename T = InputT>
@@ -145,7 +285,7 @@ class taskinfo<tag::intercept, default_runner_type, InputT, ResultT> : public de
   typename std::enable_if<std::is_same<T, void>::value, void>::type run(const std::shared_ptr<this_type>& self_)
   {
     auto stack = new default_task_stack();
-    auto aux = create_context(stack, self_);
+    create_context(stack, self_, boost::any());
     kickstart(stack);
   }
 
@@ -154,7 +294,7 @@ class taskinfo<tag::intercept, default_runner_type, InputT, ResultT> : public de
     , const std::shared_ptr<task>& self_
     , const boost::any& input_) const override
   {
-    auto aux = context_type::create(stack_, self_, m_subtask, m_catchers, input_);
+    auto aux = context_type::create(stack_, self_, m_subtask, m_catchers, m_matcher, input_);
     return aux;
   }
 
@@ -176,6 +316,7 @@ class taskinfo<tag::intercept, default_runner_type, InputT, ResultT> : public de
  private:
   std::shared_ptr<task> m_subtask;
   catch_vector_type     m_catchers;
+  matcher_type          m_matcher;
 };
 
 // ---- -----------------------------------------------------------------------
@@ -196,8 +337,9 @@ class task_context<tag::intercept, RunnerT, InputT, ResultT>
   inline task_context(
       context_stack* st_
     , const std::shared_ptr<task>& t_
-    , const typename task_type::catch_vector_type& catchers_)
-        : base(st_, t_), m_catchers(catchers_)
+    , const typename task_type::catch_vector_type& catchers_
+    , matcher_type matcher_)
+        : base(st_, t_), m_catchers(catchers_), m_matcher(matcher_)
   { /* noop */ }
 
  public:
@@ -206,15 +348,17 @@ class task_context<tag::intercept, RunnerT, InputT, ResultT>
     , const std::shared_ptr<task>& task_
     , const std::shared_ptr<task>& subtask_
     , const typename task_type::catch_vector_type& catchers_
+    , matcher_type matcher_
     , const boost::any& input_)
   {
-    auto aux = new this_type(stack_, task_, catchers_);
+    auto aux = new this_type(stack_, task_, catchers_, matcher_);
     stack_->push(aux);
 
     aux->set_input(input_);
     auto sub_ctx = subtask_->create_context(stack_, subtask_, input_);
     sub_ctx->set_res_reporter(std::bind(&this_type::result_report, aux, std::placeholders::_1));
     sub_ctx->set_exc_reporter(std::bind(&this_type::exception_report, aux, std::placeholders::_1));
+    sub_ctx->set_err_reporter(std::bind(&this_type::error_report, aux, std::placeholders::_1));
 
     return aux;
   }
@@ -249,27 +393,57 @@ class task_context<tag::intercept, RunnerT, InputT, ResultT>
     delete this;
   }
 
+  void final_error_report(const std::error_code& e_)
+  {
+    m_stack->pop();
+    report_error(e_);
+    delete this;
+  }
+
   void exception_report(const std::exception_ptr& e_)
   {
-    // first go through catch testers to see if any subtask would catch exception
+    // find the catch task that would catch the exception, if any, and push
+    // its context to execution stack
+    boost::any input;
+    auto index = m_matcher(e_, input);
+    if (index < m_catchers.size())
+    {
+      m_catchers[index]->run(
+          input
+        , m_stack
+        , std::bind(&this_type::result_report, this, std::placeholders::_1)
+        , std::bind(&this_type::final_exception_report, this, std::placeholders::_1)
+        , std::bind(&this_type::final_error_report, this, std::placeholders::_1));
+      return;
+    }
+
+    // no catcher found, propagate exception upwards if possible
+    final_exception_report(e_);
+  }
+
+  void error_report(const std::error_code& e_)
+  {
+    // same as with exceptions, but the catchers match the error code without
+    // throwing it
     for (std::size_t i = 0; i < m_catchers.size(); ++i)
     {
       if (m_catchers[i]->try_catch(
           e_
         , m_stack
         , std::bind(&this_type::result_report, this, std::placeholders::_1)
-        , std::bind(&this_type::final_exception_report, this, std::placeholders::_1)))
+        , std::bind(&this_type::final_exception_report, this, std::placeholders::_1)
+        , std::bind(&this_type::final_error_report, this, std::placeholders::_1)))
       {
-        // exception was caught and it's processing pushed to execution stack
         return;
       }
     }
 
-    // no catcher found, propagate exception upwards if possible
-    final_exception_report(e_);
+    // no catcher found, propagate error upwards if possible
+    final_error_report(e_);
   }
 
  private:
   const typename task_type::catch_vector_type& m_catchers;
+  matcher_type                                 m_matcher;
 };
 
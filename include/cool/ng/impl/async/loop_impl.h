@@ -189,6 +189,13 @@ class task_context<tag::loop, default_runner_type, InputT, ResultT>
     delete this;
   }
 
+  void error_report(const std::error_code& e)
+  {
+    m_stack->pop();
+    report_error(e);
+    delete this;
+  }
+
   bool prepare_body_task()
   {
     auto t_ = m_task->get_subtask(1);
@@ -198,6 +205,7 @@ class task_context<tag::loop, default_runner_type, InputT, ResultT>
     auto ctx = t_->create_context(m_stack, t_, m_input);
     ctx->set_res_reporter(std::bind(&this_type::body_result_report, this, std::placeholders::_1));
     ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_err_reporter(std::bind(&this_type::error_report, this, std::placeholders::_1));
     return true;
   }
 
@@ -207,6 +215,7 @@ class task_context<tag::loop, default_runner_type, InputT, ResultT>
     auto ctx = t_->create_context(m_stack, t_, m_input);
     ctx->set_res_reporter(std::bind(&this_type::predicate_result_report, this, std::placeholders::_1));
     ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_err_reporter(std::bind(&this_type::error_report, this, std::placeholders::_1));
   }
 
  private:
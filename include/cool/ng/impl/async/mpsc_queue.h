@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_7c529517_b470_4c66_a09f_0bd0f1e23ab1)
+#define      cool_ng_7c529517_b470_4c66_a09f_0bd0f1e23ab1
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <new>
+#include <type_traits>
+
+namespace cool { namespace ng { namespace async { namespace detail {
+
+// --- ---------------------------------------------------------------------
+// ---
+// --- Lock-free multi-producer single-consumer queues
+// ---
+// --- push() may be called concurrently from any number of threads. pop()
+// --- and empty() may only be called from a single consumer at the time.
+// ---
+// --- ---------------------------------------------------------------------
+template <typename T>
+class mpsc_queue
+{
+ public:
+  virtual ~mpsc_queue() { /* noop */ }
+  // returns false if the queue is full
+  virtual bool push(T&& v_) = 0;
+  // moves the oldest item to the back of out_; returns false if empty
+  virtual bool pop(std::vector<T>& out_) = 0;
+  virtual bool empty() const = 0;
+};
+
+// ---- Bounded ring of cells, each with the sequence number that tells whether
+// ---- the cell is free for the producer at position pos (seq == pos) or holds
+// ---- an item for the consumer at position pos (seq == pos + 1)
+template <typename T>
+class mpsc_ring : public mpsc_queue<T>
+{
+  struct cell
+  {
+    std::atomic<std::size_t> seq;
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+
+    T* item() { return reinterpret_cast<T*>(&storage); }
+  };
+
+ public:
+  // capacity is rounded up to the next power of two
+  explicit mpsc_ring(std::size_t capacity_)
+    : m_mask(round_up(capacity_) - 1)
+    , m_cells(new cell[m_mask + 1])
+    , m_head(0)
+    , m_tail(0)
+  {
+    for (std::size_t i = 0; i <= m_mask; ++i)
+      m_cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  ~mpsc_ring()
+  {
+    for ( ; m_cells[m_tail & m_mask].seq.load(std::memory_order_acquire) == m_tail + 1; ++m_tail)
+      m_cells[m_tail & m_mask].item()->~T();
+  }
+
+  bool push(T&& v_) override
+  {
+    cell* c;
+    auto pos = m_head.load(std::memory_order_relaxed);
+    for ( ; ; )
+    {
+      c = &m_cells[pos & m_mask];
+      auto seq = c->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+      if (diff == 0)
+      {
+        if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+        return false;  // the consumer did not free this cell yet, ring is full
+      else
+        pos = m_head.load(std::memory_order_relaxed);
+    }
+
+    new (c->item()) T(std::move(v_));
+    c->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(std::vector<T>& out_) override
+  {
+    auto& c = m_cells[m_tail & m_mask];
+    if (c.seq.load(std::memory_order_acquire) != m_tail + 1)
+      return false;
+
+    out_.push_back(std::move(*c.item()));
+    c.item()->~T();
+    c.seq.store(m_tail + m_mask + 1, std::memory_order_release);
+    ++m_tail;
+    return true;
+  }
+
+  bool empty() const override
+  {
+    return m_cells[m_tail & m_mask].seq.load(std::memory_order_acquire) != m_tail + 1;
+  }
+
+ private:
+  static std::size_t round_up(std::size_t n_)
+  {
+    std::size_t ret = 1;
+    while (ret < n_)
+      ret <<= 1;
+    return ret;
+  }
+
+ private:
+  const std::size_t        m_mask;
+  std::unique_ptr<cell[]>  m_cells;
+  char                     m_pad_1[64];  // keep producers and consumer apart
+  std::atomic<std::size_t> m_head;       // next position to push
+  char                     m_pad_2[64];
+  std::size_t              m_tail;       // next position to pop, consumer only
+};
+
+// ---- Unbounded linked list with the stub node; producers swing the head and
+// ---- then link the previous head to the new node
+template <typename T>
+class mpsc_list : public mpsc_queue<T>
+{
+  struct node
+  {
+    node() : next(nullptr) { /* noop */ }
+
+    std::atomic<node*> next;
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+
+    T* item() { return reinterpret_cast<T*>(&storage); }
+  };
+
+ public:
+  mpsc_list() : m_head(new node), m_tail(m_head.load())
+  { /* noop */ }
+
+  ~mpsc_list()
+  {
+    for (auto next = m_tail->next.load(); next != nullptr; next = m_tail->next.load())
+    {
+      next->item()->~T();
+      delete m_tail;
+      m_tail = next;
+    }
+    delete m_tail;
+  }
+
+  bool push(T&& v_) override
+  {
+    auto n = new node;
+    new (n->item()) T(std::move(v_));
+    auto prev = m_head.exchange(n, std::memory_order_acq_rel);
+    prev->next.store(n, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(std::vector<T>& out_) override
+  {
+    auto next = m_tail->next.load(std::memory_order_acquire);
+    if (next == nullptr)
+      return false;
+
+    // next becomes the new stub node
+    out_.push_back(std::move(*next->item()));
+    next->item()->~T();
+    delete m_tail;
+    m_tail = next;
+    return true;
+  }
+
+  // moves the oldest item into out_; returns false if empty
+  bool pop(T& out_)
+  {
+    auto next = m_tail->next.load(std::memory_order_acquire);
+    if (next == nullptr)
+      return false;
+
+    out_ = std::move(*next->item());
+    next->item()->~T();
+    delete m_tail;
+    m_tail = next;
+    return true;
+  }
+
+  bool empty() const override
+  {
+    return m_tail->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  std::atomic<node*> m_head;     // most recently pushed node
+  char               m_pad[64];  // keep producers and consumer apart
+  node*              m_tail;     // stub node, consumer only
+};
+
+} } } } // namespace
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_5e1d7c38_a2f4_4c61_9b07_d3e8f6a4b291)
+#define      cool_ng_5e1d7c38_a2f4_4c61_9b07_d3e8f6a4b291
+
+#include <memory>
+#include <functional>
+
+#include "cool/ng/ip_address.h"
+#include "cool/ng/bases.h"
+#include "cool/ng/impl/platform.h"
+#include "cool/ng/async/runner.h"
+
+#include "event_sources_types.h"
+
+namespace cool { namespace ng { namespace async { namespace net {
+
+namespace detail {
+
+// --- template wrapper around platform dependent datagram implementation -
+//     template parameter preserves actual runner type that is passed to
+//     the user callback
+template <typename RunnerT>
+class datagram : public itf::datagram
+               , public impl::cb::datagram
+               , public cool::ng::util::self_aware<datagram<RunnerT>>
+{
+ public:
+  using handler = typename detail::types<RunnerT>::datagram_handler;
+
+ public:
+  datagram(const std::weak_ptr<RunnerT>& runner_, const handler& h_)
+      : m_runner(runner_), m_handler(h_)
+  { /* noop */ }
+
+  void initialize(const cool::ng::net::ip::address& addr_
+                , uint16_t port_
+                , std::size_t batch_
+                , std::size_t size_
+                , const socket_options& opts_)
+  {
+    if (!m_handler)
+      throw cool::ng::exception::illegal_argument();
+
+    auto r = m_runner.lock();
+    if (r)
+      m_impl = impl::create_datagram(r, addr_, port_, this->self(), batch_, size_, opts_);
+    else
+      throw cool::ng::exception::runner_not_available();
+  }
+
+  ~datagram()
+  {
+    if (m_impl)
+      m_impl->shutdown();
+  }
+
+  //--- datagram interface
+  void shutdown() override
+  {
+    m_impl->shutdown();
+  }
+  const std::string& name() const override
+  {
+    return m_impl->name();
+  }
+  inline std::size_t send(const datagram_message* msgs_, std::size_t count_) override
+  {
+    return m_impl->send(msgs_, count_);
+  }
+  inline void join(const cool::ng::net::ip::address& group_) override
+  {
+    m_impl->join(group_);
+  }
+  inline void leave(const cool::ng::net::ip::address& group_) override
+  {
+    m_impl->leave(group_);
+  }
+
+  //--- cb::datagram interface
+  void on_receive(const datagram_message* msgs_, std::size_t count_) override
+  {
+    auto r = m_runner.lock();
+    if (r)
+      try { m_handler(r, msgs_, count_); } catch (...) { /* noop */ }
+  }
+
+ private:
+  std::shared_ptr<itf::datagram> m_impl;
+  std::weak_ptr<RunnerT>         m_runner;
+  handler                        m_handler;
+};
+
+} } } } } // namespace
+
+#endif
@@ -48,7 +48,7 @@ namespace detail {
 //     template parameter preserves actual runner type that is passed to
 //     the user callback
 template <typename RunnerT>
-class server : public async::detail::itf::startable
+class server : public detail::itf::server
              , public impl::cb::server
              , public cool::ng::util::self_aware<server<RunnerT>>
 {
@@ -67,11 +67,20 @@ class server : public async::detail::itf::startable
     : m_runner(runner_), m_factory(sf_), m_handler(hc_), m_err_handler(he_)
   { /* noop */ }
 
-  void initialize(const cool::ng::net::ip::address& addr_, uint16_t port_)
+  void initialize(const cool::ng::net::ip::address& addr_, uint16_t port_, const socket_options& opts_)
   {
     auto r = m_runner.lock();
     if (r)
-      m_impl = impl::create_server(r, addr_, port_, this->self());
+      m_impl = impl::create_server(r, addr_, port_, this->self(), opts_);
+    else
+      throw cool::ng::exception::runner_not_available();
+  }
+
+  void initialize(const local_endpoint& ep_, const socket_options& opts_)
+  {
+    auto r = m_runner.lock();
+    if (r)
+      m_impl = impl::create_server(r, ep_, this->self(), opts_);
     else
       throw cool::ng::exception::runner_not_available();
   }
@@ -97,6 +106,7 @@ class server : public async::detail::itf::startable
   void stop() override                     { m_impl->stop();  }
   void shutdown() override                 { m_impl->stop();  }
   const std::string& name() const override { return m_impl->name(); }
+  void stats(stream_stats& s_) const override { m_impl->stats(s_); }
 
   //--- cb::server interface
   void on_connect(const cool::ng::async::net::stream& s_) override
@@ -136,7 +146,7 @@ class server : public async::detail::itf::startable
   stream_factory         m_factory;
   connect_handler        m_handler;
   error_handler          m_err_handler;
-  std::shared_ptr<async::detail::itf::startable> m_impl;
+  std::shared_ptr<detail::itf::server> m_impl;
 };
 
 
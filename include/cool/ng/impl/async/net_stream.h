@@ -59,23 +59,34 @@ class stream : public itf::connected_writable
        , const event_handler& eh_)
       : m_runner(runner_), m_rhandler(rh_), m_whandler(wh_), m_oob(eh_)
   { /* noop */ }
-  void initialize(const cool::ng::net::ip::address& addr_, uint16_t port_, void* buf_, std::size_t bufsz_)
+  void initialize(const cool::ng::net::ip::address& addr_, uint16_t port_, void* buf_, std::size_t bufsz_, const socket_options& opts_)
   {
     auto r = m_runner.lock();
     if (r)
     {
-      m_impl = impl::create_stream(r, addr_, port_, this->self(), buf_, bufsz_);
+      m_impl = impl::create_stream(r, addr_, port_, this->self(), buf_, bufsz_, opts_);
     }
     else
       throw cool::ng::exception::runner_not_available();
   }
- 
-  void initialize(void* buf_, std::size_t bufsz_)
+
+  void initialize(const local_endpoint& ep_, void* buf_, std::size_t bufsz_, const socket_options& opts_)
+  {
+    auto r = m_runner.lock();
+    if (r)
+    {
+      m_impl = impl::create_stream(r, ep_, this->self(), buf_, bufsz_, opts_);
+    }
+    else
+      throw cool::ng::exception::runner_not_available();
+  }
+
+  void initialize(void* buf_, std::size_t bufsz_, const socket_options& opts_)
   {
     auto r = m_runner.lock();
     if (r)
     {
-      m_impl = impl::create_stream(r, this->self(), buf_, bufsz_);
+      m_impl = impl::create_stream(r, this->self(), buf_, bufsz_, opts_);
     }
     else
       throw cool::ng::exception::runner_not_available();
@@ -102,10 +113,22 @@ class stream : public itf::connected_writable
   {
     m_impl->write(data, size);
   }
+  inline void write(const const_buffer* bufs, std::size_t count) override
+  {
+    m_impl->write(bufs, count);
+  }
+  inline void write(std::vector<uint8_t>&& data) override
+  {
+    m_impl->write(std::move(data));
+  }
   inline void connect(const cool::ng::net::ip::address& addr_, uint16_t port_) override
   {
     m_impl->connect(addr_, port_);
   }
+  inline void connect(const local_endpoint& ep_) override
+  {
+    m_impl->connect(ep_);
+  }
   inline void disconnect() override
   {
     m_impl->disconnect();
@@ -114,6 +137,30 @@ class stream : public itf::connected_writable
   {
     m_impl->set_handle(h_);
   }
+  inline void read_budget(std::size_t bytes_, std::size_t reads_) override
+  {
+    m_impl->read_budget(bytes_, reads_);
+  }
+  inline void write_handle(cool::ng::net::handle h_) override
+  {
+    m_impl->write_handle(h_);
+  }
+  inline cool::ng::net::handle received_handle() override
+  {
+    return m_impl->received_handle();
+  }
+  inline void watermarks(std::size_t high_, std::size_t low_, bool pause_read_) override
+  {
+    m_impl->watermarks(high_, low_, pause_read_);
+  }
+  inline void stats(stream_stats& s_) const override
+  {
+    m_impl->stats(s_);
+  }
+  inline void aggregate(const std::shared_ptr<impl::stream_probe>& probe_) override
+  {
+    m_impl->aggregate(probe_);
+  }
   //--- cb::stream interface
   void on_read(void*& buf_, std::size_t& size_) override
   {
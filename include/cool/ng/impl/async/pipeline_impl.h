@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(__COOL_INCLUDE_TASK_IMPL_FILES__)
+#error "This header file cannot be directly included in the application code."
+#endif
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Pipeline runtime state, shared by all run() calls
+// ----
+// ---- -----------------------------------------------------------------------
+//
+// Each stage owns a bounded queue of inputs waiting to be processed and
+// processes at most one item at the time. When a stage completes an item and
+// the queue of the next stage is full, the result is kept in the stage and
+// the stage stalls until the downstream stage makes room. Since every stage
+// takes items from its queue in FIFO order and never processes two items
+// concurrently, the order of items is preserved across the pipeline.
+//
+// The items that fail in a stage are dropped. They are counted, and reported
+// to the failure handler, if set, with the index of the stage and the
+// exception, or the error code wrapped into std::system_error.
+class pipeline_state : public std::enable_shared_from_this<pipeline_state>
+{
+  using subtasks_vector_type = std::vector<std::shared_ptr<detail::task>>;
+  using start_vector_type    = std::vector<std::pair<std::size_t, boost::any>>;
+
+  struct stage
+  {
+    stage(const std::shared_ptr<detail::task>& t_)
+        : m_task(t_), m_busy(false), m_stalled(false)
+    { /* noop */ }
+
+    std::shared_ptr<detail::task> m_task;   // subtask implementing this stage
+    std::deque<boost::any>        m_queue;  // inputs waiting for this stage
+    boost::any                    m_output; // result waiting for room downstream
+    bool                          m_busy;   // subtask is running
+    bool                          m_stalled;// m_output is valid
+  };
+
+ public:
+  using failure_handler = std::function<void(std::size_t, const std::exception_ptr&)>;
+
+ public:
+  pipeline_state(std::size_t capacity_, const subtasks_vector_type& subtasks_)
+      : m_capacity(capacity_), m_dropped(0)
+  {
+    for (auto& t : subtasks_)
+      m_stages.push_back(stage(t));
+  }
+
+  std::weak_ptr<runner> get_runner() const
+  {
+    return m_stages[0].m_task->get_runner();
+  }
+  std::size_t get_subtask_count() const
+  {
+    return m_stages.size();
+  }
+  std::shared_ptr<task> get_subtask(std::size_t index_) const
+  {
+    return m_stages[index_].m_task;
+  }
+
+  void set_failure_handler(const failure_handler& h_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    m_on_failure = h_;
+  }
+  std::size_t dropped() const
+  {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+  // Accepts the input into the queue of the first stage. Throws
+  // operation_failed(resource_busy) if the queue of the first stage is full.
+  void feed(const boost::any& input_)
+  {
+    start_vector_type aux;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (m_stages[0].m_queue.size() >= m_capacity)
+        throw exception::operation_failed(error::errc::resource_busy);
+
+      m_stages[0].m_queue.push_back(input_);
+      pump(aux);
+    }
+    start(aux);
+  }
+
+ private:
+  void result_report(std::size_t stage_, const boost::any& res_)
+  {
+    start_vector_type aux;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      m_stages[stage_].m_busy = false;
+      // result of the last stage is dropped
+      if (stage_ + 1 < m_stages.size())
+      {
+        m_stages[stage_].m_output = res_;
+        m_stages[stage_].m_stalled = true;
+      }
+      pump(aux);
+    }
+    start(aux);
+  }
+
+  // the item that failed in the stage, with either exception or error code,
+  // is dropped and reported; the stage continues with the next item in its
+  // queue
+  void exception_report(std::size_t stage_, const std::exception_ptr& e_)
+  {
+    start_vector_type aux;
+    failure_handler handler;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      m_stages[stage_].m_busy = false;
+      handler = m_on_failure;
+      pump(aux);
+    }
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    if (handler)
+      try { handler(stage_, e_); } catch (...) { /* noop */ }
+    start(aux);
+  }
+
+  void error_report(std::size_t stage_, const std::error_code& e_)
+  {
+    exception_report(stage_, std::make_exception_ptr(std::system_error(e_)));
+  }
+
+  // Moves stalled results downstream and starts idle stages with queued
+  // inputs. Working from the last stage towards the first frees the room
+  // downstream before the upstream stages try to use it. Must be called with
+  // the mutex locked; collects the stages to start in start_.
+  void pump(start_vector_type& start_)
+  {
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      for (std::size_t i = m_stages.size(); i-- > 0; )
+      {
+        auto& s = m_stages[i];
+        if (s.m_stalled && m_stages[i + 1].m_queue.size() < m_capacity)
+        {
+          m_stages[i + 1].m_queue.push_back(s.m_output);
+          s.m_output = boost::any();
+          s.m_stalled = false;
+          changed = true;
+        }
+        if (!s.m_busy && !s.m_stalled && !s.m_queue.empty())
+        {
+          start_.push_back(std::make_pair(i, s.m_queue.front()));
+          s.m_queue.pop_front();
+          s.m_busy = true;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // Schedules subtasks for execution, each in its own context stack. Must be
+  // called with the mutex unlocked.
+  void start(const start_vector_type& start_)
+  {
+    for (auto& item : start_)
+    {
+      auto t = m_stages[item.first].m_task;
+      auto stack = new default_task_stack();
+      auto ctx = t->create_context(stack, t, item.second);
+      ctx->set_res_reporter(std::bind(
+          &pipeline_state::result_report
+        , shared_from_this()
+        , item.first
+        , std::placeholders::_1));
+      ctx->set_exc_reporter(std::bind(
+          &pipeline_state::exception_report
+        , shared_from_this()
+        , item.first
+        , std::placeholders::_1));
+      ctx->set_err_reporter(std::bind(
+          &pipeline_state::error_report
+        , shared_from_this()
+        , item.first
+        , std::placeholders::_1));
+
+      try
+      {
+        kickstart(stack);
+      }
+      catch (...)
+      {
+        delete stack;
+        exception_report(item.first, std::current_exception());
+      }
+    }
+  }
+
+ private:
+  const std::size_t        m_capacity;
+  std::vector<stage>       m_stages;
+  std::mutex               m_mutex;
+  failure_handler          m_on_failure;
+  std::atomic<std::size_t> m_dropped;  // items that failed in any stage
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Static task information
+// ----
+// ---- -----------------------------------------------------------------------
+
+template <typename InputT, typename ResultT>
+class taskinfo<tag::pipeline, default_runner_type, InputT, ResultT> : public detail::task
+{
+ public:
+  using tag           = tag::pipeline;
+  using this_type     = taskinfo;
+  using runner_type   = default_runner_type;
+  using result_type   = ResultT;
+  using input_type    = InputT;
+  using context_type  = task_context<tag, runner_type, input_type, result_type>;
+
+  using subtasks_vector_type = std::vector<std::shared_ptr<detail::task>>;
+
+ public:
+  template <typename... TaskT>
+  explicit inline taskinfo(std::size_t capacity_, const std::shared_ptr<TaskT>&... tasks_)
+      : m_state(std::make_shared<pipeline_state>(capacity_, subtasks_vector_type({ tasks_ ... })))
+  { /* noop */ }
+
+  template <typename T = InputT>
+  inline void run(
+      const std::shared_ptr<this_type>& self_
+    , const typename std::enable_if<!std::is_same<T, void>::value, T>::type& i_)
+  {
+    m_state->feed(boost::any(i_));
+  }
+
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run(const std::shared_ptr<this_type>& self_)
+  {
+    m_state->feed(boost::any());
+  }
+
+  inline context* create_context(
+      context_stack* stack_
+    , const std::shared_ptr<task>& self_
+    , const boost::any& input_) const override
+  {
+    return context_type::create(stack_, self_, m_state, input_);
+  }
+
+  inline void set_failure_handler(const pipeline_state::failure_handler& h_)
+  {
+    m_state->set_failure_handler(h_);
+  }
+
+  inline std::size_t dropped() const
+  {
+    return m_state->dropped();
+  }
+
+  inline std::weak_ptr<runner> get_runner() const override
+  {
+    return m_state->get_runner();
+  }
+
+  inline std::size_t get_subtask_count() const override
+  {
+    return m_state->get_subtask_count();
+  }
+
+  inline std::shared_ptr<task> get_subtask(std::size_t index) const override
+  {
+    return m_state->get_subtask(index);
+  }
+
+ private:
+  std::shared_ptr<pipeline_state> m_state;
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Runtime task context
+// ----
+// ---- -----------------------------------------------------------------------
+//
+// The context is only used when the pipeline is an element of another compound
+// task. It runs on the runner of the first stage, feeds its input into the
+// pipeline and completes as soon as the input is accepted; the later failures
+// of the item go to the pipeline's failure handler.
+template <typename RunnerT, typename InputT, typename ResultT>
+class task_context<tag::pipeline, RunnerT, InputT, ResultT>
+  : public task_context_base
+{
+ public:
+  using this_type  = task_context;
+  using base       = task_context_base;
+
+ private:
+  inline task_context(
+        context_stack* st_
+      , const std::shared_ptr<task>& t_
+      , const std::shared_ptr<pipeline_state>& s_)
+    : base(st_, t_), m_state(s_)
+  { /* noop */ }
+
+ public:
+  inline static this_type* create(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , const std::shared_ptr<pipeline_state>& state_
+    , const boost::any& input_)
+  {
+    auto aux = new this_type(stack_, task_, state_);
+    stack_->push(aux);
+    aux->set_input(input_);
+
+    return aux;
+  }
+
+  // context interface
+  inline std::weak_ptr<async::runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+  const char* name() const override
+  {
+    return "context::pipeline";
+  }
+  bool will_execute() const override
+  {
+    return true;
+  }
+
+  void entry_point(const std::shared_ptr<async::runner>&, context*) override
+  {
+    m_stack->pop();
+    try
+    {
+      m_state->feed(m_input);
+      if (m_res_reporter)
+        m_res_reporter(boost::any());
+    }
+    catch (...)
+    {
+      if (m_exc_reporter)
+        m_exc_reporter(std::current_exception());
+    }
+    delete this;
+  }
+
+ private:
+  std::shared_ptr<pipeline_state> m_state;
+};
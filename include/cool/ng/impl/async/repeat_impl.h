@@ -127,11 +127,19 @@ class task_context<tag::repeat, default_runner_type, std::size_t, ResultT>
     delete this;
   }
 
+  void error_report(const std::error_code& e)
+  {
+    m_stack->pop();
+    report_error(e);
+    delete this;
+  }
+
   void prepare_next_task(const std::shared_ptr<task>& t_)
   {
     auto ctx = t_->create_context(m_stack, t_, m_counter);
     ctx->set_res_reporter(std::bind(&this_type::result_report, this, std::placeholders::_1));
     ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_err_reporter(std::bind(&this_type::error_report, this, std::placeholders::_1));
   }
 
 private:
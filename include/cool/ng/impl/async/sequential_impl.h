@@ -168,6 +168,13 @@ class task_context<tag::sequential, RunnerT, InputT, ResultT>
     delete this;
   }
 
+  void error_report(const std::error_code& e)
+  {
+    m_stack->pop();
+    report_error(e);
+    delete this;
+  }
+
   bool prepare_next_task()
   {
     if (m_next_task < m_num_tasks)
@@ -176,6 +183,7 @@ class task_context<tag::sequential, RunnerT, InputT, ResultT>
       auto ctx = t_->create_context(m_stack, t_, m_input);
       ctx->set_res_reporter(std::bind(&this_type::result_report, this, std::placeholders::_1));
       ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+      ctx->set_err_reporter(std::bind(&this_type::error_report, this, std::placeholders::_1));
       m_next_task++;
       return true;
     }
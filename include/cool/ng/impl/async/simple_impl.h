@@ -41,12 +41,19 @@ class taskinfo<tag::simple, RunnerT, InputT, ResultT> : public detail::task
   using result_type   = ResultT;
   using input_type    = InputT;
   using function_type = typename traits::run_signature<runner_type, input_type, result_type>::type;
+  using expected_function_type = typename traits::run_signature<runner_type, input_type, expected<result_type>>::type;
   using context_type  = task_context<type, runner_type, input_type, result_type>;
 
  public:
-  explicit inline taskinfo(const std::weak_ptr<runner_type>& r_, const function_type& f_)
-      : m_runner(r_), m_user_func(f_)
-  { /* noop */ }
+  // User Callables returning expected<T> are stored separately so that only
+  // they pay for the error channel, all other user Callables are stored and
+  // invoked as they are.
+  template <typename CallableT>
+  explicit inline taskinfo(const std::weak_ptr<runner_type>& r_, const CallableT& f_)
+      : m_runner(r_)
+  {
+    set_callable(f_, traits::is_expected<typename ::cool::ng::traits::functional<CallableT>::result_type>());
+  }
 
   template <typename T = InputT>
   inline void run(
@@ -69,7 +76,7 @@ class taskinfo<tag::simple, RunnerT, InputT, ResultT> : public detail::task
     , const std::shared_ptr<task>& self_
     , const boost::any& input_) const override
   {
-    return context_type::create(stack_, self_, m_user_func, input_);
+    return context_type::create(stack_, self_, m_user_func, m_expected_func, input_);
   }
 
   inline std::weak_ptr<runner> get_runner() const override
@@ -82,9 +89,62 @@ class taskinfo<tag::simple, RunnerT, InputT, ResultT> : public detail::task
     return m_user_func;
   }
 
+  inline expected_function_type& expected_callable()
+  {
+    return m_expected_func;
+  }
+
+ protected:
+  explicit inline taskinfo(const std::weak_ptr<runner_type>& r_) : m_runner(r_)
+  { /* noop */ }
+
+  template <typename CallableT>
+  inline void set_callable(const CallableT& f_, std::false_type)
+  {
+    m_user_func = f_;
+  }
+
+  template <typename CallableT>
+  inline void set_callable(const CallableT& f_, std::true_type)
+  {
+    m_expected_func = f_;
+  }
+
  private:
   std::weak_ptr<runner_type> m_runner;
-  function_type              m_user_func;    // user Callable
+  function_type              m_user_func;      // user Callable
+  expected_function_type     m_expected_func;  // user Callable returning expected<T>
+};
+
+// ---- Simple task information of the simple task that carries the type of
+// ---- its user Callable. The user Callable is stored by its concrete type and
+// ---- the std::function of the base only refers to it, which lets compound
+// ---- tasks that know its type, like static sequence, call it directly.
+template <typename RunnerT, typename InputT, typename ResultT, typename CallableT>
+class taskinfo<tag::simple, RunnerT, InputT, ResultT, CallableT>
+  : public taskinfo<tag::simple, RunnerT, InputT, ResultT>
+{
+ public:
+  using this_type     = taskinfo;
+  using base          = taskinfo<tag::simple, RunnerT, InputT, ResultT>;
+  using callable_type = CallableT;
+
+ public:
+  explicit inline taskinfo(const std::weak_ptr<RunnerT>& r_, const CallableT& f_)
+      : base(r_), m_callable(f_)
+  {
+    base::set_callable(
+        std::ref(m_callable)
+      , traits::is_expected<typename ::cool::ng::traits::functional<CallableT>::result_type>());
+  }
+
+  inline callable_type& callable()
+  {
+    return m_callable;
+  }
+
+ private:
+  callable_type m_callable;    // user Callable
 };
 
 
@@ -105,8 +165,12 @@ class task_context<tag::simple, RunnerT, InputT, ResultT>
   using base       = task_context_base;
 
  private:
-  inline task_context(context_stack* st_, const std::shared_ptr<task>& t_, const typename task_type::function_type& f_)
-      : base(st_, t_), m_user_func(f_)
+  inline task_context(
+      context_stack* st_
+    , const std::shared_ptr<task>& t_
+    , const typename task_type::function_type& f_
+    , const typename task_type::expected_function_type& ef_)
+      : base(st_, t_), m_user_func(f_), m_expected_func(ef_)
   {
     //    REP("++++++ context::simple::context void");
     /* noop */
@@ -117,9 +181,10 @@ class task_context<tag::simple, RunnerT, InputT, ResultT>
       context_stack* stack_
     , const std::shared_ptr<task>& task_
     , const typename task_type::function_type& f_
+    , const typename task_type::expected_function_type& ef_
     , const boost::any& i_)
   {
-    auto aux = new this_type(stack_, task_, f_);
+    auto aux = new this_type(stack_, task_, f_, ef_);
     aux->set_input(i_);
     if (stack_ != nullptr)
       stack_->push(aux);
@@ -158,7 +223,8 @@ class task_context<tag::simple, RunnerT, InputT, ResultT>
   }
 
  private:
-  const typename task_type::function_type&  m_user_func;
+  const typename task_type::function_type&           m_user_func;
+  const typename task_type::expected_function_type&  m_expected_func;
 };
 
 
@@ -220,6 +286,96 @@ struct invoker<void, void>
 };
 
 
+// --- Expected invokers call user Callable returning expected result with or
+// --- without input parameter and report the result to the result reporter.
+// --- If the user Callable returned failed expected result, invokers return
+// --- false and set err_ instead.
+template <typename InputT, typename ResultT>
+struct expected_invoker
+{
+  template<typename EntryPointT, typename RunnerT, typename ReporterT>
+  static bool invoke(const EntryPointT& ep_,
+              const std::shared_ptr<RunnerT>& r_,
+              const boost::any& i_,
+              const ReporterT& rep_,
+              std::error_code& err_)
+  {
+    auto res = ep_(r_, boost::any_cast<InputT>(i_));
+    if (!res)
+    {
+      err_ = res.error();
+      return false;
+    }
+    if (rep_)
+      rep_(boost::any(std::move(res.value())));
+    return true;
+  }
+};
+template <typename ResultT>
+struct expected_invoker<void, ResultT>
+{
+  template<typename EntryPointT, typename RunnerT, typename ReporterT>
+  static bool invoke(const EntryPointT& ep_,
+              const std::shared_ptr<RunnerT>& r_,
+              const boost::any& i_,
+              const ReporterT& rep_,
+              std::error_code& err_)
+  {
+    auto res = ep_(r_);
+    if (!res)
+    {
+      err_ = res.error();
+      return false;
+    }
+    if (rep_)
+      rep_(boost::any(std::move(res.value())));
+    return true;
+  }
+};
+template <typename InputT>
+struct expected_invoker<InputT, void>
+{
+  template<typename EntryPointT, typename RunnerT, typename ReporterT>
+  static bool invoke(const EntryPointT& ep_,
+                     const std::shared_ptr<RunnerT>& r_,
+                     const boost::any& i_,
+                     const ReporterT& rep_,
+                     std::error_code& err_)
+  {
+    auto res = ep_(r_, boost::any_cast<InputT>(i_));
+    if (!res)
+    {
+      err_ = res.error();
+      return false;
+    }
+    if (rep_)
+      rep_(boost::any());
+    return true;
+  }
+};
+template <>
+struct expected_invoker<void, void>
+{
+  template<typename EntryPointT, typename RunnerT, typename ReporterT>
+  static bool invoke(const EntryPointT& ep_,
+                     const std::shared_ptr<RunnerT>& r_,
+                     const boost::any& i_,
+                     const ReporterT& rep_,
+                     std::error_code& err_)
+  {
+    auto res = ep_(r_);
+    if (!res)
+    {
+      err_ = res.error();
+      return false;
+    }
+    if (rep_)
+      rep_(boost::any());
+    return true;
+  }
+};
+
+
 // --- entry point implementation
 template <typename RunnerT, typename InputT, typename ResultT>
 void task_context<tag::simple, RunnerT, InputT, ResultT>::entry_point(
@@ -240,7 +396,14 @@ void task_context<tag::simple, RunnerT, InputT, ResultT>::entry_point(
     if (!r)
       throw exception::bad_runner_cast();
 
-    invoker<InputT, ResultT>::invoke(m_user_func, r, m_input, m_res_reporter);
+    if (m_expected_func)
+    {
+      std::error_code err;
+      if (!expected_invoker<InputT, ResultT>::invoke(m_expected_func, r, m_input, m_res_reporter, err))
+        report_error(err);
+    }
+    else
+      invoker<InputT, ResultT>::invoke(m_user_func, r, m_input, m_res_reporter);
   }
   catch (...)
   {
@@ -0,0 +1,455 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(__COOL_INCLUDE_TASK_IMPL_FILES__)
+#error "This header file cannot be directly included in the application code."
+#endif
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Typed stage execution helpers
+// ----
+// ---- -----------------------------------------------------------------------
+
+// ---- Conversions between expected results, typed values passed between
+// ---- stages and boost::any used to pass values across runners
+template <typename T>
+struct static_value
+{
+  static any_value<T> from_expected(expected<T>& e_)
+  {
+    return any_value<T>(std::move(e_.value()));
+  }
+  static any_value<T> from_any(const boost::any& a_)
+  {
+    return any_value<T>(boost::any_cast<T>(a_));
+  }
+  static boost::any to_any(any_value<T>& v_)
+  {
+    return boost::any(std::move(v_.value));
+  }
+};
+
+template <>
+struct static_value<void>
+{
+  static any_value<void> from_expected(expected<void>&)
+  {
+    return any_value<void>();
+  }
+  static any_value<void> from_any(const boost::any&)
+  {
+    return any_value<void>();
+  }
+  static boost::any to_any(any_value<void>&)
+  {
+    return boost::any();
+  }
+};
+
+// ---- Calls user Callable with or without input parameter
+template <typename InputT>
+struct static_call
+{
+  template <typename FunctionT, typename RunnerT>
+  static auto call(FunctionT& f_, const std::shared_ptr<RunnerT>& r_, const any_value<InputT>& i_)
+    -> decltype(f_(r_, i_.value))
+  {
+    return f_(r_, i_.value);
+  }
+};
+
+template <>
+struct static_call<void>
+{
+  template <typename FunctionT, typename RunnerT>
+  static auto call(FunctionT& f_, const std::shared_ptr<RunnerT>& r_, const any_value<void>&)
+    -> decltype(f_(r_))
+  {
+    return f_(r_);
+  }
+};
+
+// ---- Calls user Callable of the stage that does not return expected result
+// ---- and returns its result as typed value to pass to the next stage
+template <typename InputT, typename ResultT>
+struct static_invoke
+{
+  template <typename CallableT, typename RunnerT>
+  static any_value<ResultT> call(CallableT& f_, const std::shared_ptr<RunnerT>& r_, const any_value<InputT>& i_)
+  {
+    return any_value<ResultT>(static_call<InputT>::call(f_, r_, i_));
+  }
+};
+
+template <typename InputT>
+struct static_invoke<InputT, void>
+{
+  template <typename CallableT, typename RunnerT>
+  static any_value<void> call(CallableT& f_, const std::shared_ptr<RunnerT>& r_, const any_value<InputT>& i_)
+  {
+    static_call<InputT>::call(f_, r_, i_);
+    return any_value<void>();
+  }
+};
+
+// ---- Converts the runner of the previous stage to the runner type of the
+// ---- stage. Stages that share the runner and its type, which is the common
+// ---- case, pass the same shared_ptr on without a copy.
+template <typename RunnerT>
+struct static_runner
+{
+  static const std::shared_ptr<RunnerT>& cast(const std::shared_ptr<RunnerT>& r_)
+  {
+    return r_;
+  }
+
+  // the runner is known to be of the stage runner type, either because
+  // the executor runs the context on the runner of the stage, or because
+  // the stage was found to share the runner with the previous stage when the
+  // sequence was built
+  template <typename OtherT>
+  static std::shared_ptr<RunnerT> cast(const std::shared_ptr<OtherT>& r_)
+  {
+    return std::static_pointer_cast<RunnerT>(std::static_pointer_cast<async::runner>(r_));
+  }
+};
+
+// ---- Executes stage I of the sequence and, as long as the following stages
+// ---- use the same runner, the following stages with it, passing the typed
+// ---- results directly from one stage to the next. Returns the index of the
+// ---- next stage to run on another runner, with its input stored in out_, or
+// ---- N if all stages completed, with the result stored in out_. If the stage
+// ---- fails with an error code returns N + 1 and sets err_. Whether the stage
+// ---- shares the runner with the previous stage is resolved once, when the
+// ---- sequence is built, and passed in inline_.
+template <std::size_t I, std::size_t N, typename TupleT>
+struct static_stage
+{
+  using task_type   = typename std::tuple_element<I, TupleT>::type::element_type;
+  using runner_type = typename task_type::runner_type;
+  using input_type  = typename task_type::input_type;
+  using result_type = typename task_type::result_type;
+  using callable_type = typename task_type::callable_type;
+  using next_type   = static_stage<I + 1, N, TupleT>;
+  using inline_type = std::array<bool, N>;
+
+  template <typename RunnerT>
+  static std::size_t run(
+      const TupleT& tasks_
+    , const inline_type& inline_
+    , const std::shared_ptr<RunnerT>& r_
+    , const any_value<input_type>& in_
+    , boost::any& out_
+    , std::error_code& err_)
+  {
+    return invoke(
+        tasks_
+      , inline_
+      , static_runner<runner_type>::cast(r_)
+      , in_
+      , out_
+      , err_
+      , traits::is_expected<typename ::cool::ng::traits::functional<callable_type>::result_type>());
+  }
+
+  // user Callable that does not return expected result cannot fail with an
+  // error code
+  static std::size_t invoke(
+      const TupleT& tasks_
+    , const inline_type& inline_
+    , const std::shared_ptr<runner_type>& r_
+    , const any_value<input_type>& in_
+    , boost::any& out_
+    , std::error_code& err_
+    , std::false_type)
+  {
+    auto value = static_invoke<input_type, result_type>::call(std::get<I>(tasks_)->callable(), r_, in_);
+    return next_type::proceed(tasks_, inline_, r_, value, out_, err_);
+  }
+
+  static std::size_t invoke(
+      const TupleT& tasks_
+    , const inline_type& inline_
+    , const std::shared_ptr<runner_type>& r_
+    , const any_value<input_type>& in_
+    , boost::any& out_
+    , std::error_code& err_
+    , std::true_type)
+  {
+    auto res = static_call<input_type>::call(std::get<I>(tasks_)->callable(), r_, in_);
+    if (!res)
+    {
+      err_ = res.error();
+      return N + 1;
+    }
+
+    auto value = static_value<result_type>::from_expected(res);
+    return next_type::proceed(tasks_, inline_, r_, value, out_, err_);
+  }
+
+  // continue with this stage inline if it uses the same runner as the previous
+  // stage, otherwise leave it to the executor
+  template <typename RunnerT>
+  static std::size_t proceed(
+      const TupleT& tasks_
+    , const inline_type& inline_
+    , const std::shared_ptr<RunnerT>& r_
+    , any_value<input_type>& in_
+    , boost::any& out_
+    , std::error_code& err_)
+  {
+    if (inline_[I])
+      return run(tasks_, inline_, r_, in_, out_, err_);
+
+    out_ = static_value<input_type>::to_any(in_);
+    return I;
+  }
+
+  // resume the sequence at the stage index_, with the input in in_
+  static std::size_t resume(
+      std::size_t index_
+    , const TupleT& tasks_
+    , const inline_type& inline_
+    , const std::shared_ptr<async::runner>& r_
+    , const boost::any& in_
+    , boost::any& out_
+    , std::error_code& err_)
+  {
+    if (index_ != I)
+      return next_type::resume(index_, tasks_, inline_, r_, in_, out_, err_);
+
+    return run(tasks_, inline_, r_, static_value<input_type>::from_any(in_), out_, err_);
+  }
+};
+
+template <std::size_t N, typename TupleT>
+struct static_stage<N, N, TupleT>
+{
+  using inline_type = std::array<bool, N>;
+
+  template <typename RunnerT, typename T>
+  static std::size_t proceed(
+      const TupleT&
+    , const inline_type&
+    , const std::shared_ptr<RunnerT>&
+    , any_value<T>& in_
+    , boost::any& out_
+    , std::error_code&)
+  {
+    out_ = static_value<T>::to_any(in_);
+    return N;
+  }
+
+  static std::size_t resume(
+      std::size_t
+    , const TupleT&
+    , const inline_type&
+    , const std::shared_ptr<async::runner>&
+    , const boost::any&
+    , boost::any&
+    , std::error_code&)
+  {
+    return N;
+  }
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Static task information
+// ----
+// ---- -----------------------------------------------------------------------
+
+template <typename InputT, typename ResultT, typename... TaskT>
+class taskinfo<tag::static_sequential, default_runner_type, InputT, ResultT, TaskT...> : public detail::task
+{
+ public:
+  using tag           = tag::static_sequential;
+  using this_type     = taskinfo;
+  using runner_type   = default_runner_type;
+  using result_type   = ResultT;
+  using input_type    = InputT;
+  using context_type  = task_context<tag, runner_type, input_type, result_type, TaskT...>;
+  using tuple_type    = std::tuple<std::shared_ptr<TaskT>...>;
+  using inline_type   = std::array<bool, sizeof...(TaskT)>;
+
+  using subtasks_vector_type = std::vector<std::shared_ptr<detail::task>>;
+
+ public:
+  explicit inline taskinfo(const std::shared_ptr<TaskT>&... tasks_)
+      : m_tasks(tasks_...), m_subtasks( { tasks_ ... } )
+  {
+    // resolve once which stages share the runner with the preceding stage
+    // and can run inline, without the executor
+    m_inline[0] = false;
+    for (std::size_t i = 1; i < m_subtasks.size(); ++i)
+    {
+      auto prev = m_subtasks[i - 1]->get_runner();
+      auto cur = m_subtasks[i]->get_runner();
+      m_inline[i] = !prev.owner_before(cur) && !cur.owner_before(prev);
+    }
+  }
+
+  template <typename T = InputT>
+  inline void run(
+      const std::shared_ptr<this_type>& self_
+    , const typename std::enable_if<!std::is_same<T, void>::value, T>::type& i_)
+  {
+    auto stack = new default_task_stack();
+    create_context(stack, self_, boost::any(i_));
+    kickstart(stack);
+  }
+
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run(const std::shared_ptr<this_type>& self_)
+  {
+    auto stack = new default_task_stack();
+    create_context(stack, self_, boost::any());
+    kickstart(stack);
+  }
+
+  inline context* create_context(
+      context_stack* stack_
+    , const std::shared_ptr<task>& self_
+    , const boost::any& input_) const override
+  {
+    return context_type::create(stack_, self_, m_tasks, m_inline, input_);
+  }
+
+  inline std::weak_ptr<runner> get_runner() const override
+  {
+    return m_subtasks[0]->get_runner();
+  }
+
+  inline std::size_t get_subtask_count() const override
+  {
+    return m_subtasks.size();
+  }
+
+  inline std::shared_ptr<task> get_subtask(std::size_t index) const override
+  {
+    return m_subtasks[index];
+  }
+
+ private:
+  tuple_type           m_tasks;
+  subtasks_vector_type m_subtasks;
+  inline_type          m_inline;   // stage shares runner with previous stage
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Runtime task context
+// ----
+// ---- -----------------------------------------------------------------------
+//
+// A single context runs all stages of the sequence. It remains on the stack
+// until the last stage completes and its runner is the runner of the next
+// stage to run, thus the executor only gets involved when the sequence moves
+// to another runner.
+template <typename RunnerT, typename InputT, typename ResultT, typename... TaskT>
+class task_context<tag::static_sequential, RunnerT, InputT, ResultT, TaskT...>
+  : public task_context_base
+{
+ public:
+  using this_type  = task_context;
+  using base       = task_context_base;
+  using tuple_type  = std::tuple<std::shared_ptr<TaskT>...>;
+  using inline_type = std::array<bool, sizeof...(TaskT)>;
+  using first_type  = static_stage<0, sizeof...(TaskT), tuple_type>;
+
+ private:
+  inline task_context(
+      context_stack* st_
+    , const std::shared_ptr<task>& t_
+    , const tuple_type& tasks_
+    , const inline_type& inline_)
+    : base(st_, t_), m_tasks(tasks_), m_inline(inline_), m_next(0)
+  { /* noop */ }
+
+ public:
+  inline static this_type* create(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , const tuple_type& tasks_
+    , const inline_type& inline_
+    , const boost::any& input_)
+  {
+    auto aux = new this_type(stack_, task_, tasks_, inline_);
+    stack_->push(aux);
+    aux->set_input(input_);
+
+    return aux;
+  }
+
+  // context interface
+  inline std::weak_ptr<async::runner> get_runner() const override
+  {
+    return m_task->get_subtask(m_next)->get_runner();
+  }
+  const char* name() const override
+  {
+    return "context::static_sequential";
+  }
+  bool will_execute() const override
+  {
+    return m_next < sizeof...(TaskT);
+  }
+
+  void entry_point(const std::shared_ptr<async::runner>& r_, context*) override
+  {
+    std::error_code err;
+    try
+    {
+      boost::any out;
+      m_next = first_type::resume(m_next, m_tasks, m_inline, r_, m_input, out, err);
+      if (m_next < sizeof...(TaskT))
+      {
+        // continue on another runner
+        m_input = out;
+        return;
+      }
+
+      m_stack->pop();
+      if (m_next == sizeof...(TaskT))
+      {
+        if (m_res_reporter)
+          m_res_reporter(out);
+      }
+      else
+        report_error(err);
+    }
+    catch (...)
+    {
+      m_stack->pop();
+      if (m_exc_reporter)
+        m_exc_reporter(std::current_exception());
+    }
+    delete this;
+  }
+
+ private:
+  const tuple_type&  m_tasks;
+  const inline_type& m_inline;
+  std::size_t        m_next;   // index of the next stage to run
+};
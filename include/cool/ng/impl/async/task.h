@@ -29,10 +29,22 @@
 #include <type_traits>
 #include <vector>
 #include <stack>
+#include <deque>
+#include <mutex>
+#include <tuple>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <condition_variable>
 #include <boost/any.hpp>
 
+#include "cool/ng/traits.h"
 #include "cool/ng/async/runner.h"
+#include "cool/ng/async/expected.h"
+#include "event_sources_types.h"
 #include "context.h"
+#include "mpsc_queue.h"
 #include "task_traits.h"
 
 namespace cool { namespace ng { namespace async { namespace detail {
@@ -49,6 +61,12 @@ namespace tag
   struct loop        { }; // compound task that iterates the subtask
   struct repeat      { }; // compound task that repeats the subtask n times
   struct intercept   { }; // compound task with exception catchers
+  struct pipeline    { }; // compound task with overlapped stages fed by stream of items
+  struct fan_out     { }; // compound task running subtask for each element of input vector
+  struct static_sequential { }; // sequence of simple tasks composed at compile time
+  struct throttle    { }; // compound task limiting the number of concurrent subtask runs
+  struct batch       { }; // compound task collecting inputs of many runs into one subtask run
+  struct join        { }; // task completing when all members of the task group complete
 
 } // namespace
 
@@ -176,6 +194,14 @@ class taskinfo { };
 template <typename TagT, typename RunnerT, typename InputT, typename ResultT, typename... TaskT>
 class task_context : public context { };
 
+// ---- carries the type of the user Callable of the simple task in the task
+// ---- type, in place of the subtask types of compound tasks
+template <typename CallableT>
+struct typed_callable
+{
+  using impl_type = CallableT;
+};
+
 class task_context_base : public context
 {
  public:
@@ -194,6 +220,10 @@ class task_context_base : public context
   {
     m_exc_reporter = arg_;
   }
+  void set_err_reporter(const error_reporter& arg_) override
+  {
+    m_err_reporter = arg_;
+  }
   void set_input(const boost::any& input_) override
   {
     m_input = input_;
@@ -204,17 +234,85 @@ class task_context_base : public context
   void entry_point(const std::shared_ptr<async::runner>& r_, context* ctx_) override
   { /* noop */ }
 
+ protected:
+  // reports the error code through the error reporter; if the error reporter
+  // is not set, the error is reported as std::system_error exception
+  void report_error(const std::error_code& e_)
+  {
+    if (m_err_reporter)
+      m_err_reporter(e_);
+    else if (m_exc_reporter)
+      m_exc_reporter(std::make_exception_ptr(std::system_error(e_)));
+  }
+
  protected:
   std::shared_ptr<task> m_task;         // Reference to static task data
   context_stack*        m_stack;        // Reference to context stack
   boost::any            m_input;        // Input to pass to task
   result_reporter       m_res_reporter; // result reporter if set
   exception_reporter    m_exc_reporter; // exception reporter if set
+  error_reporter        m_err_reporter; // error reporter if set
 };
 
 // ---- Task execution kick-starter
 dlldecl void kickstart(context_stack*);
 
+// ---- Deferred run of the context stack, shared by the platform timer and the
+// ---- cancel token. Whichever of take() and cancel() comes first wins; the
+// ---- loser is a noop. The record owns the stack until then, thus cancel()
+// ---- frees the stack and its input right away and the timer only finds the
+// ---- empty record when its time comes.
+class deferred
+{
+  enum state { pending, fired, cancelled };
+
+ public:
+  explicit deferred(context_stack* stack_) : m_state(pending), m_stack(stack_)
+  { /* noop */ }
+  ~deferred()
+  {
+    delete m_stack;
+  }
+
+  // moves the deferred run out of pending state and hands over the stack;
+  // returns nullptr if it was cancelled
+  context_stack* take()
+  {
+    int expect = pending;
+    if (!m_state.compare_exchange_strong(expect, fired))
+      return nullptr;
+    auto aux = m_stack;
+    m_stack = nullptr;
+    return aux;
+  }
+  bool cancel()
+  {
+    int expect = pending;
+    if (!m_state.compare_exchange_strong(expect, cancelled))
+      return false;
+    delete m_stack;
+    m_stack = nullptr;
+    return true;
+  }
+  bool is_pending() const
+  {
+    return m_state == pending;
+  }
+  // top context of the stack; to be used before the run is scheduled
+  context* top() const
+  {
+    return m_stack == nullptr || m_stack->empty() ? nullptr : m_stack->top();
+  }
+
+ private:
+  std::atomic<int> m_state;
+  context_stack*   m_stack;   // accessed only by the winner of the state change
+};
+
+// ---- Arranges for the stack of the deferred run to run on the executor of
+// ---- the runner of its top context after the specified delay, in microseconds
+dlldecl void kickstart_after(const std::shared_ptr<deferred>&, uint64_t delay_);
+
 // ---- Default implementation of task stack
 class default_task_stack : public context_stack
 {
@@ -233,6 +331,26 @@ private:
   std::stack<context*> m_stack;
 };
 
+// ---- Resubmits the context stack the context took over in suspend(); deletes
+// ---- the stack if there is nothing left to run or the runner is gone
+inline void resume(context_stack* stack_)
+{
+  if (stack_->empty())
+  {
+    delete stack_;
+    return;
+  }
+
+  try
+  {
+    kickstart(stack_);
+  }
+  catch (...)
+  {
+    delete stack_;
+  }
+}
+
 #define __COOL_INCLUDE_TASK_IMPL_FILES__
 
 #include "simple_impl.h"
@@ -241,6 +359,12 @@ private:
 #include "conditional_impl.h"
 #include "repeat_impl.h"
 #include "loop_impl.h"
+#include "pipeline_impl.h"
+#include "fan_out_impl.h"
+#include "static_sequential_impl.h"
+#include "throttle_impl.h"
+#include "batch_impl.h"
+#include "group_impl.h"
 
 #undef __COOL_INCLUDE_TASK_IMPL_FILES__
 
@@ -27,6 +27,9 @@
 #include <cstddef>
 #include <type_traits>
 #include <tuple>
+#include <vector>
+
+#include "cool/ng/async/expected.h"
 
 namespace cool { namespace ng {  namespace async {
 
@@ -101,6 +104,75 @@ struct get_sequence_result_type
 };
 
 
+// --------
+// result type of the simple task whose user Callable returns expected<T> is T
+template <typename T>
+struct unwrap_expected
+{
+  using type = T;
+};
+
+template <typename T>
+struct unwrap_expected<expected<T>>
+{
+  using type = T;
+};
+
+// --------
+// is_expected::value is true if the type is expected<T> and false if not
+template <typename T>
+struct is_expected : public std::false_type
+{ };
+
+template <typename T>
+struct is_expected<expected<T>> : public std::true_type
+{ };
+
+// --------
+// result type of fan-out tasks is a vector of subtask results or void if the
+// subtask does not return value
+template <typename ResultT>
+struct get_fan_out_result_type
+{
+  using type = std::vector<ResultT>;
+};
+
+template <>
+struct get_fan_out_result_type<void>
+{
+  using type = void;
+};
+
+// --------
+// batch tasks accept an item of the batch subtask's input vector and return
+// an item of its result vector, or void if the batch subtask does not return
+// value
+template <typename InputT>
+struct get_batch_input_type
+{ };
+
+template <typename ItemT>
+struct get_batch_input_type<std::vector<ItemT>>
+{
+  using type = ItemT;
+};
+
+template <typename ResultT>
+struct get_batch_result_type
+{ };
+
+template <typename ItemT>
+struct get_batch_result_type<std::vector<ItemT>>
+{
+  using type = ItemT;
+};
+
+template <>
+struct get_batch_result_type<void>
+{
+  using type = void;
+};
+
 // --------
 // all_same::value is true if all types in paramter pack are the same
 // type (after std::decay) and false if not
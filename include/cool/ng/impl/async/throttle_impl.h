@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(__COOL_INCLUDE_TASK_IMPL_FILES__)
+#error "This header file cannot be directly included in the application code."
+#endif
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Throttle state shared by all runs of the throttle task
+// ----
+// ---- -----------------------------------------------------------------------
+//
+// The runs that could not obtain the in-flight slot park their context stacks
+// in the lock-free wait queue. The runs that complete release their slot and
+// resume as many parked stacks as there are free slots. The wait queue has a
+// single consumer at the time - whoever holds the m_draining flag - and the
+// others leave the draining to it.
+//
+// The slot is owned by the throttle context that acquired it, or on whose
+// behalf it was acquired, and is released when the context completes or is
+// deleted with its stack without ever running.
+class throttle_state
+{
+ public:
+  explicit throttle_state(std::size_t limit_)
+    : m_limit(limit_), m_in_flight(0), m_parked(0), m_draining(false)
+  { /* noop */ }
+
+  bool try_acquire()
+  {
+    auto aux = m_in_flight.load();
+    while (aux < m_limit)
+    {
+      if (m_in_flight.compare_exchange_weak(aux, aux + 1))
+        return true;
+    }
+    return false;
+  }
+
+  void release()
+  {
+    --m_in_flight;
+    dispatch();
+  }
+
+  // the parked stack must not be touched by the caller after this call; the
+  // holds_ flag is set when the slot is acquired on behalf of the stack
+  void park(context_stack* stack_, bool* holds_)
+  {
+    ++m_parked;
+    m_waiting.push(parked(stack_, holds_));
+    dispatch();
+  }
+
+ private:
+  void dispatch()
+  {
+    do
+    {
+      if (m_draining.exchange(true))
+        return;   // whoever holds the flag will check again after release
+
+      parked aux;
+      while (try_acquire())
+      {
+        if (!m_waiting.pop(aux))
+        {
+          --m_in_flight;
+          break;
+        }
+        --m_parked;
+
+        // the slot now belongs to the parked throttle context; if the stack
+        // cannot be resumed it is deleted and its context releases the slot,
+        // which is then handed over to the next parked stack by this loop
+        *aux.second = true;
+        resume(aux.first);
+      }
+
+      m_draining = false;
+    }
+    while (m_parked.load() > 0 && m_in_flight.load() < m_limit);
+  }
+
+ private:
+  using parked = std::pair<context_stack*, bool*>;
+
+  const std::size_t               m_limit;
+  std::atomic<std::size_t>        m_in_flight;
+  std::atomic<std::size_t>        m_parked;
+  std::atomic<bool>               m_draining;
+  mpsc_list<parked>               m_waiting;
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Runtime task context
+// ----
+// ---- -----------------------------------------------------------------------
+template <typename InputT, typename ResultT>
+class task_context<tag::throttle, default_runner_type, InputT, ResultT>
+  : public task_context_base
+{
+ public:
+  using this_type  = task_context;
+  using base       = task_context_base;
+
+ private:
+  inline task_context(
+      context_stack* st_
+    , const std::shared_ptr<task>& task_
+    , const std::shared_ptr<throttle_state>& state_)
+    : base(st_, task_), m_state(state_), m_parked(false), m_holds_slot(false)
+  { /* noop */ }
+
+ public:
+  ~task_context()
+  {
+    // the stack got deleted without this context reporting completion
+    release_slot();
+  }
+
+ public:
+  inline static this_type* create(
+      context_stack* stack_
+    , const std::shared_ptr<task>& task_
+    , const std::shared_ptr<throttle_state>& state_
+    , const boost::any& input_)
+  {
+    auto aux = new this_type(stack_, task_, state_);
+    stack_->push(aux);
+    aux->set_input(input_);
+
+    // if no slot is available the context remains on the top of the stack
+    // and parks it from its entry point
+    if (state_->try_acquire())
+    {
+      aux->m_holds_slot = true;
+      aux->prepare_task();
+    }
+
+    return aux;
+  }
+
+  // context interface
+  inline std::weak_ptr<async::runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+  const char* name() const override
+  {
+    return "context::throttle";
+  }
+  bool will_execute() const override
+  {
+    return true;
+  }
+
+  void entry_point(const std::shared_ptr<async::runner>&, context*) override
+  {
+    // resumed stacks already hold the slot acquired on their behalf
+    if (m_holds_slot || m_state->try_acquire())
+    {
+      m_parked = false;
+      m_holds_slot = true;
+      prepare_task();
+    }
+    else
+      m_parked = true;
+  }
+
+  bool suspend() override
+  {
+    if (!m_parked)
+      return false;
+
+    // the stack may get resumed and this context deleted before park returns
+    auto state = m_state;
+    state->park(m_stack, &m_holds_slot);
+    return true;
+  }
+
+  void result_report(const boost::any& res_)
+  {
+    m_stack->pop();
+    release_slot();
+    if (m_res_reporter)
+      m_res_reporter(res_);
+    delete this;
+  }
+
+  void exception_report(const std::exception_ptr& e_)
+  {
+    m_stack->pop();
+    release_slot();
+    if (m_exc_reporter)
+      m_exc_reporter(e_);
+    delete this;
+  }
+
+  void error_report(const std::error_code& e_)
+  {
+    m_stack->pop();
+    release_slot();
+    report_error(e_);
+    delete this;
+  }
+
+ private:
+  void release_slot()
+  {
+    if (m_holds_slot)
+    {
+      m_holds_slot = false;
+      m_state->release();
+    }
+  }
+
+  void prepare_task()
+  {
+    auto t = m_task->get_subtask(0);
+    auto ctx = t->create_context(m_stack, t, m_input);
+    ctx->set_res_reporter(std::bind(&this_type::result_report, this, std::placeholders::_1));
+    ctx->set_exc_reporter(std::bind(&this_type::exception_report, this, std::placeholders::_1));
+    ctx->set_err_reporter(std::bind(&this_type::error_report, this, std::placeholders::_1));
+  }
+
+ private:
+  std::shared_ptr<throttle_state> m_state;
+  bool                            m_parked;
+  bool                            m_holds_slot;   // set by throttle_state when resumed
+};
+
+// ---- -----------------------------------------------------------------------
+// ----
+// ---- Static task information
+// ----
+// ---- -----------------------------------------------------------------------
+
+template <typename InputT, typename ResultT>
+class taskinfo<tag::throttle, default_runner_type, InputT, ResultT> : public detail::task
+{
+ public:
+  using tag           = tag::throttle;
+  using this_type     = taskinfo;
+  using runner_type   = default_runner_type;
+  using result_type   = ResultT;
+  using input_type    = InputT;
+  using context_type  = task_context<tag, runner_type, input_type, result_type>;
+
+ public:
+  template <typename TaskT>
+  explicit inline taskinfo(std::size_t limit_, const std::shared_ptr<TaskT>& task_)
+      : m_task(task_), m_state(std::make_shared<throttle_state>(limit_))
+  { /* noop */ }
+
+  template <typename T = InputT>
+  inline void run(
+      const std::shared_ptr<this_type>& self_
+    , const typename std::enable_if<!std::is_same<T, void>::value, T>::type& i_)
+  {
+    auto stack = new default_task_stack();
+    try
+    {
+      create_context(stack, self_, boost::any(i_));
+      kickstart(stack);
+    }
+    catch (...)
+    {
+      delete stack;   // releases the slot if the context took one
+      throw;
+    }
+  }
+
+  template <typename T = InputT>
+  typename std::enable_if<std::is_same<T, void>::value, void>::type run(const std::shared_ptr<this_type>& self_)
+  {
+    auto stack = new default_task_stack();
+    try
+    {
+      create_context(stack, self_, boost::any());
+      kickstart(stack);
+    }
+    catch (...)
+    {
+      delete stack;   // releases the slot if the context took one
+      throw;
+    }
+  }
+
+  inline context* create_context(
+      context_stack* stack_
+    , const std::shared_ptr<task>& self_
+    , const boost::any& input_) const override
+  {
+    return context_type::create(stack_, self_, m_state, input_);
+  }
+
+  inline std::weak_ptr<runner> get_runner() const override
+  {
+    return m_task->get_runner();
+  }
+
+  inline std::size_t get_subtask_count() const override
+  {
+    return 1;
+  }
+
+  inline std::shared_ptr<task> get_subtask(std::size_t) const override
+  {
+    return m_task;
+  }
+
+ private:
+  std::shared_ptr<task>           m_task;
+  std::shared_ptr<throttle_state> m_state;
+};
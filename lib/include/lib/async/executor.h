@@ -25,11 +25,11 @@
 #define      cool_ng_a8ed9ec1_c086_4866_8e9c_4de137df0daf
 
 
-#if defined(COOL_ASYNC_PLATFORM_GCD)
+#if defined(COOL_ASYNC_PLATFORM_SIM)
+#include "src/async/sim/executor.h"
+#elif defined(COOL_ASYNC_PLATFORM_GCD)
 #include "src/async/gcd/executor.h"
-#endif
-
-#if defined(COOL_ASYNC_PLATFORM_WINCP)
+#elif defined(COOL_ASYNC_PLATFORM_WINCP)
 #include "src/async/wincp/executor.h"
 #endif
 
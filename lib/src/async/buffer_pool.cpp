@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "buffer_pool.h"
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+namespace {
+
+thread_local const buffer_pool::buffer* t_current = nullptr;
+
+} // anonymous namespace
+
+const std::size_t buffer_pool::min_size;
+const std::size_t buffer_pool::max_idle;
+
+buffer_pool::buffer_pool()
+{ /* noop */ }
+
+buffer_pool::~buffer_pool()
+{
+  for (auto& list : m_free)
+    for (auto p : list)
+      delete [] p;
+}
+
+// size class 0 is min_size, each next class doubles the size
+std::size_t buffer_pool::size_class(std::size_t size_)
+{
+  std::size_t ret = 0;
+  for (std::size_t sz = min_size; sz < size_; sz <<= 1)
+    ++ret;
+  return ret;
+}
+
+buffer_pool::buffer buffer_pool::acquire(std::size_t size_)
+{
+  auto cls = size_class(size_);
+  uint8_t* p = nullptr;
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (cls < m_free.size() && !m_free[cls].empty())
+    {
+      p = m_free[cls].back();
+      m_free[cls].pop_back();
+    }
+  }
+  if (p == nullptr)
+    p = new uint8_t[min_size << cls];
+
+  // the buffers released after the pool is gone are simply deleted
+  std::weak_ptr<buffer_pool> pool = shared_from_this();
+  return buffer(p,
+    [pool, cls] (uint8_t* p_)
+    {
+      auto self = pool.lock();
+      if (self)
+        self->release(p_, cls);
+      else
+        delete [] p_;
+    });
+}
+
+void buffer_pool::release(uint8_t* p_, std::size_t class_)
+{
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_free.size() <= class_)
+      m_free.resize(class_ + 1);
+    if (m_free[class_].size() < max_idle)
+    {
+      m_free[class_].push_back(p_);
+      return;
+    }
+  }
+  delete [] p_;
+}
+
+std::size_t buffer_pool::idle() const
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  std::size_t ret = 0;
+  for (auto& list : m_free)
+    ret += list.size();
+  return ret;
+}
+
+void buffer_pool::current(const buffer* b_)
+{
+  t_current = b_;
+}
+
+buffer_pool::buffer buffer_pool::retain_current()
+{
+  return t_current == nullptr ? buffer() : *t_current;
+}
+
+} } } } } // namespace
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_8f3b2d61_47ac_4e19_b0d5_6a1c9e2f7b30)
+#define      cool_ng_8f3b2d61_47ac_4e19_b0d5_6a1c9e2f7b30
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+// Pool of reference counted read buffers, shared by all streams of the
+// runner. The streams take a buffer only when the data is ready to be read
+// and release it after the read handler returns, so that idle connections
+// do not hold any buffer. The buffers are returned to the pool when the
+// last reference is released, which may be from any thread; the read handler
+// may keep the buffer for as long as it needs via retain_current().
+//
+// The buffer sizes are rounded up to the power of two, with separate free
+// list for each size; each free list keeps at most max_idle buffers.
+class buffer_pool : public std::enable_shared_from_this<buffer_pool>
+{
+ public:
+  using ptr = std::shared_ptr<buffer_pool>;
+  using buffer = std::shared_ptr<uint8_t>;
+
+  static const std::size_t min_size = 4096;
+  static const std::size_t max_idle = 64;
+
+ public:
+  buffer_pool();
+  ~buffer_pool();
+
+  // returns buffer of at least size_ bytes
+  buffer acquire(std::size_t size_);
+  // number of idle buffers in the pool
+  std::size_t idle() const;
+
+  // the buffer passed to the read handler running on this thread; set by
+  // the stream for the duration of the read handler call
+  static void current(const buffer* b_);
+  // returns another reference to the current buffer, or nullptr if the
+  // read handler does not read into a pooled buffer
+  static buffer retain_current();
+
+ private:
+  static std::size_t size_class(std::size_t size_);
+  void release(uint8_t* p_, std::size_t class_);
+
+ private:
+  mutable std::mutex                 m_mutex;
+  std::vector<std::vector<uint8_t*>> m_free;  // free lists by size class
+};
+
+} } } } } // namespace
+
+#endif
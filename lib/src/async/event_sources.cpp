@@ -27,13 +27,18 @@
 #include "cool/ng/impl/async/event_sources_types.h"
 #include "cool/ng/async/event_sources.h"
 
-#if defined(COOL_ASYNC_PLATFORM_GCD)
+#if defined(COOL_ASYNC_PLATFORM_SIM)
+# include "sim/event_sources.h"
+#elif defined(COOL_ASYNC_PLATFORM_GCD)
 # include "gcd/event_sources.h"
 #elif defined(COOL_ASYNC_PLATFORM_WINCP)
 # include "wincp/event_sources.h"
 #else
 # error "unknown asynchronous platform - only supported are GCD and Windows completion ports"
 #endif
+#include "timer_wheel.h"
+#include "timer_stats.h"
+#include "buffer_pool.h"
 
 // ==========================================================================
 // ======
@@ -59,6 +64,43 @@ void timer::start()
   m_impl->start();
 }
 
+void timer::start_once()
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->start_once(0);
+}
+
+void timer::start_once(uint64_t d_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  if (d_ == 0)
+    throw cool::ng::exception::illegal_argument();
+  m_impl->start_once(d_);
+}
+
+timer_stats timer::stats() const
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  timer_stats ret;
+  m_impl->stats(ret);
+  return ret;
+}
+
+void timer::instrument(bool enable_)
+{
+  impl::timer_probe::enable(enable_);
+}
+
+timer_stats timer::aggregate_stats()
+{
+  timer_stats ret;
+  impl::timer_probe::aggregate().snapshot(ret);
+  return ret;
+}
+
 void timer::stop()
 {
   if (!*this)
@@ -85,6 +127,26 @@ timer::operator bool() const
   return !!m_impl;
 }
 
+void signal_source::trigger(unsigned long v_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  if (v_ != 0)
+    m_impl->trigger(v_);
+}
+
+const std::string& signal_source::name() const
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  return m_impl->name();
+}
+
+signal_source::operator bool() const
+{
+  return !!m_impl;
+}
+
 namespace impl {
 // --------------------------------------------------------------------------
 // -----
@@ -102,6 +164,26 @@ dlldecl std::shared_ptr<detail::itf::timer> create_timer(
   return ret;
 }
 
+dlldecl std::shared_ptr<detail::itf::timer> create_wheel_timer(
+    const std::shared_ptr<runner>& r_
+  , const std::weak_ptr<cb::timer>& t_
+  , uint64_t p_)
+{
+  auto ret = cool::ng::util::shared_new<wheel_timer>(t_, p_);
+  ret->initialize(r_->impl());
+  return ret;
+}
+
+dlldecl std::shared_ptr<detail::itf::signal> create_signal(
+    const std::shared_ptr<runner>& r_
+  , const std::weak_ptr<cb::signal>& s_
+  , signal_merge m_)
+{
+  auto ret = cool::ng::util::shared_new<signal>(s_, m_);
+  ret->initialize(r_->impl());
+  return ret;
+}
+
 } // namespace impl
 
 // --------------------------------------------------------------------------
@@ -133,6 +215,15 @@ const std::string& server::name() const
   return m_impl->name();
 }
 
+stream_stats server::stats() const
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  stream_stats ret;
+  m_impl->stats(ret);
+  return ret;
+}
+
 server::operator bool() const
 {
   return !!m_impl;
@@ -153,6 +244,27 @@ void stream::write(const void* data_, std::size_t size_)
   m_impl->write(data_, size_);
 }
 
+void stream::write(std::initializer_list<const_buffer> bufs_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->write(bufs_.begin(), bufs_.size());
+}
+
+void stream::write(const std::vector<const_buffer>& bufs_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->write(bufs_.data(), bufs_.size());
+}
+
+void stream::write(std::vector<uint8_t>&& data_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->write(std::move(data_));
+}
+
 void stream::connect(const cool::ng::net::ip::address& addr_, uint16_t port_)
 {
   if (!*this)
@@ -160,6 +272,13 @@ void stream::connect(const cool::ng::net::ip::address& addr_, uint16_t port_)
   m_impl->connect(addr_, port_);
 }
 
+void stream::connect(const local_endpoint& ep_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->connect(ep_);
+}
+
 void stream::disconnect()
 {
   if (!*this)
@@ -167,11 +286,99 @@ void stream::disconnect()
   m_impl->disconnect();
 }
 
+void stream::read_budget(std::size_t bytes_, std::size_t reads_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->read_budget(bytes_, reads_);
+}
+
+void stream::watermarks(std::size_t high_, std::size_t low_, bool pause_read_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->watermarks(high_, low_, pause_read_);
+}
+
+std::shared_ptr<uint8_t> stream::retain_read_buffer()
+{
+  return net::impl::buffer_pool::retain_current();
+}
+
+void stream::write_handle(cool::ng::net::handle h_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->write_handle(h_);
+}
+
+cool::ng::net::handle stream::received_handle()
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  return m_impl->received_handle();
+}
+
+stream_stats stream::stats() const
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  stream_stats ret;
+  m_impl->stats(ret);
+  return ret;
+}
+
 stream::operator bool() const
 {
   return !!m_impl;
 }
 
+const std::string& datagram::name() const
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  return m_impl->name();
+}
+
+bool datagram::send(const cool::ng::net::ip::address& addr_, uint16_t port_, const void* data_, std::size_t size_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+
+  datagram_message msg;
+  msg.data = data_;
+  msg.size = size_;
+  msg.peer = addr_;
+  msg.port = port_;
+  return m_impl->send(&msg, 1) == 1;
+}
+
+std::size_t datagram::send(const std::vector<datagram_message>& msgs_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  return msgs_.empty() ? 0 : m_impl->send(msgs_.data(), msgs_.size());
+}
+
+void datagram::join(const cool::ng::net::ip::address& group_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->join(group_);
+}
+
+void datagram::leave(const cool::ng::net::ip::address& group_)
+{
+  if (!*this)
+    throw cool::ng::exception::empty_object();
+  m_impl->leave(group_);
+}
+
+datagram::operator bool() const
+{
+  return !!m_impl;
+}
+
 namespace impl {
 
 // --------------------------------------------------------------------------
@@ -179,14 +386,26 @@ namespace impl {
 // ----- Factory methods
 // ------
 
-std::shared_ptr<async::detail::itf::startable> create_server(
+std::shared_ptr<detail::itf::server> create_server(
     const std::shared_ptr<runner>& r_
   , const ip::address& addr_
   , uint16_t port_
-  , const cb::server::weak_ptr& cb_)
+  , const cb::server::weak_ptr& cb_
+  , const net::socket_options& opts_)
 {
   auto ret = cool::ng::util::shared_new<server>(r_->impl(), cb_);
-  ret->initialize(addr_, port_);
+  ret->initialize(addr_, port_, opts_);
+  return ret;
+}
+
+std::shared_ptr<detail::itf::server> create_server(
+    const std::shared_ptr<runner>& r_
+  , const net::local_endpoint& ep_
+  , const cb::server::weak_ptr& cb_
+  , const net::socket_options& opts_)
+{
+  auto ret = cool::ng::util::shared_new<server>(r_->impl(), cb_);
+  ret->initialize(ep_, opts_);
   return ret;
 }
 
@@ -196,21 +415,50 @@ std::shared_ptr<detail::itf::connected_writable> create_stream(
   , uint16_t port_
   , const cb::stream::weak_ptr& cb_
   , void* buf_
-  , std::size_t bufsz_)
+  , std::size_t bufsz_
+  , const net::socket_options& opts_)
 {
   auto ret = cool::ng::util::shared_new<stream>(r_->impl(), cb_);
-  ret->initialize(addr_, port_, buf_, bufsz_);
+  ret->initialize(addr_, port_, buf_, bufsz_, opts_);
   return ret;
 }
 
 std::shared_ptr<detail::itf::connected_writable> create_stream(
     const std::shared_ptr<runner>& r_
+  , const net::local_endpoint& ep_
   , const cb::stream::weak_ptr& cb_
   , void* buf_
-  , std::size_t bufsz_)
+  , std::size_t bufsz_
+  , const net::socket_options& opts_)
 {
   auto ret = cool::ng::util::shared_new<stream>(r_->impl(), cb_);
-  ret->initialize(buf_, bufsz_);
+  ret->initialize(ep_, buf_, bufsz_, opts_);
+  return ret;
+}
+
+std::shared_ptr<detail::itf::connected_writable> create_stream(
+    const std::shared_ptr<runner>& r_
+  , const cb::stream::weak_ptr& cb_
+  , void* buf_
+  , std::size_t bufsz_
+  , const net::socket_options& opts_)
+{
+  auto ret = cool::ng::util::shared_new<stream>(r_->impl(), cb_);
+  ret->initialize(buf_, bufsz_, opts_);
+  return ret;
+}
+
+std::shared_ptr<detail::itf::datagram> create_datagram(
+    const std::shared_ptr<runner>& r_
+  , const cool::ng::net::ip::address& addr_
+  , uint16_t port_
+  , const cb::datagram::weak_ptr& cb_
+  , std::size_t batch_
+  , std::size_t size_
+  , const net::socket_options& opts_)
+{
+  auto ret = cool::ng::util::shared_new<datagram>(r_->impl(), cb_);
+  ret->initialize(addr_, port_, batch_, size_, opts_);
   return ret;
 }
 
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "cool/ng/exception.h"
+#include "cool/ng/async/net/framing.h"
+
+namespace cool { namespace ng { namespace async { namespace net {
+
+namespace exc = cool::ng::exception;
+
+const std::size_t framer::default_max_size;
+
+framer::framer(kind kind_, std::size_t size_, byte_order order_, const std::string& delimiter_, std::size_t max_)
+  : m_kind(kind_), m_size(size_), m_order(order_), m_delimiter(delimiter_), m_max(max_)
+{ /* noop */ }
+
+framer framer::length_prefixed(std::size_t prefix_, byte_order order_, std::size_t max_size_)
+{
+  if ((prefix_ != 1 && prefix_ != 2 && prefix_ != 4 && prefix_ != 8) || max_size_ == 0)
+    throw exc::illegal_argument();
+  return framer(kind::length, prefix_, order_, std::string(), max_size_);
+}
+
+framer framer::delimited(const std::string& delimiter_, std::size_t max_size_)
+{
+  if (delimiter_.empty() || max_size_ == 0)
+    throw exc::illegal_argument();
+  return framer(kind::delimiter, 0, byte_order::big_endian, delimiter_, max_size_);
+}
+
+framer framer::fixed(std::size_t size_)
+{
+  if (size_ == 0)
+    throw exc::illegal_argument();
+  return framer(kind::fixed, size_, byte_order::big_endian, std::string(), size_);
+}
+
+void framer::reset()
+{
+  m_partial.clear();
+}
+
+std::size_t framer::pending() const
+{
+  return m_partial.size();
+}
+
+// Returns the size of the frame at the start of the data, including the
+// length prefix or the delimiter, or 0 if the size cannot be determined yet.
+// The returned size of the length prefixed frame may exceed the data size.
+std::size_t framer::frame_size(const uint8_t* data_, std::size_t size_) const
+{
+  switch (m_kind)
+  {
+    case kind::length:
+    {
+      if (size_ < m_size)
+        return 0;
+
+      uint64_t length = 0;
+      for (std::size_t i = 0; i < m_size; ++i)
+      {
+        if (m_order == byte_order::big_endian)
+          length = (length << 8) | data_[i];
+        else
+          length |= static_cast<uint64_t>(data_[i]) << (8 * i);
+      }
+      if (length > m_max)
+        throw exc::parsing_error();
+      return m_size + static_cast<std::size_t>(length);
+    }
+
+    case kind::delimiter:
+    {
+      auto delim = reinterpret_cast<const uint8_t*>(m_delimiter.data());
+      auto end = data_ + size_;
+      auto pos = std::search(data_, end, delim, delim + m_delimiter.size());
+      if (pos == end)
+      {
+        if (size_ >= m_max + m_delimiter.size())
+          throw exc::parsing_error();
+        return 0;
+      }
+      if (static_cast<std::size_t>(pos - data_) > m_max)
+        throw exc::parsing_error();
+      return pos - data_ + m_delimiter.size();
+    }
+
+    case kind::fixed:
+      break;
+  }
+  return m_size;
+}
+
+// Moves the data of the frame kept from the previous reads into the partial
+// frame buffer and returns true if the frame is complete. The data pointer
+// and size are advanced past the consumed data.
+bool framer::complete(const uint8_t*& data_, std::size_t& size_)
+{
+  auto append = [this, &data_, &size_] (std::size_t n_)
+  {
+    m_partial.insert(m_partial.end(), data_, data_ + n_);
+    data_ += n_;
+    size_ -= n_;
+  };
+
+  if (m_kind == kind::delimiter)
+  {
+    auto delim = reinterpret_cast<const uint8_t*>(m_delimiter.data());
+    auto d = m_delimiter.size();
+
+    // the delimiter may start in the kept data and end in the new data; the
+    // more of it is kept the earlier it starts
+    for (std::size_t k = std::min(m_partial.size(), d - 1); k > 0; --k)
+    {
+      if (size_ < d - k)
+        continue;
+      if (std::memcmp(m_partial.data() + m_partial.size() - k, delim, k) == 0
+          && std::memcmp(data_, delim + k, d - k) == 0)
+      {
+        append(d - k);
+        if (m_partial.size() - d > m_max)
+          throw exc::parsing_error();
+        return true;
+      }
+    }
+
+    auto end = data_ + size_;
+    auto pos = std::search(data_, end, delim, delim + d);
+    if (pos == end)
+    {
+      append(size_);
+      if (m_partial.size() >= m_max + d)
+        throw exc::parsing_error();
+      return false;
+    }
+    append(pos - data_ + d);
+    if (m_partial.size() - d > m_max)
+      throw exc::parsing_error();
+    return true;
+  }
+
+  // complete the length prefix first
+  std::size_t header = m_kind == kind::length ? m_size : 0;
+  if (m_partial.size() < header)
+  {
+    append(std::min(header - m_partial.size(), size_));
+    if (m_partial.size() < header)
+      return false;
+  }
+
+  auto total = frame_size(m_partial.data(), m_partial.size());
+  m_partial.reserve(total);
+  append(std::min(total - m_partial.size(), size_));
+  return m_partial.size() == total;
+}
+
+void framer::deliver(const uint8_t* frame_, std::size_t size_, const frame_callback& cb_) const
+{
+  switch (m_kind)
+  {
+    case kind::length:
+      cb_(frame_ + m_size, size_ - m_size);
+      break;
+
+    case kind::delimiter:
+      cb_(frame_, size_ - m_delimiter.size());
+      break;
+
+    case kind::fixed:
+      cb_(frame_, size_);
+      break;
+  }
+}
+
+// The frames contained in the data are passed in place; only the frame that
+// spans the end of the data is copied and completed by the next call.
+void framer::feed(const void* data_, std::size_t size_, const frame_callback& cb_)
+{
+  auto data = static_cast<const uint8_t*>(data_);
+
+  try
+  {
+    if (!m_partial.empty())
+    {
+      if (!complete(data, size_))
+        return;
+      deliver(m_partial.data(), m_partial.size(), cb_);
+      m_partial.clear();
+    }
+
+    while (size_ > 0)
+    {
+      auto n = frame_size(data, size_);
+      if (n == 0 || n > size_)
+        break;
+      deliver(data, n, cb_);
+      data += n;
+      size_ -= n;
+    }
+
+    m_partial.assign(data, data + size_);
+  }
+  catch (...)
+  {
+    m_partial.clear();
+    throw;
+  }
+}
+
+} } } } // namespace
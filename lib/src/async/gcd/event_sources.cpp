@@ -21,6 +21,9 @@
  * IN THE SOFTWARE.
  */
 
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
 #include <unistd.h>
 #include <fcntl.h>
 #if defined(OSX_TARGET)
@@ -28,6 +31,8 @@
 #endif
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <errno.h>
 #include "cool/ng/error.h"
@@ -61,7 +66,13 @@ namespace impl {
 timer::context::context(const timer::ptr& t_, const std::shared_ptr<async::impl::executor>& ex_)
     : m_timer(t_)
 {
-  m_source = ::dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0 , ex_->queue());
+  // instrumented timers fire on the global queue and submit the callback to
+  // the runner, to separate the timer delay from the runner delay
+  m_source = ::dispatch_source_create(
+      DISPATCH_SOURCE_TYPE_TIMER
+    , 0
+    , 0
+    , t_->m_probe ? ::dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0) : ex_->queue());
   m_source.cancel_handler(on_cancel);
   m_source.event_handler(on_event);
   m_source.context(this);
@@ -87,6 +98,32 @@ void timer::context::on_cancel(void* ctx)
 void timer::context::on_event(void *ctx)
 {
   auto self = static_cast<context*>(ctx);
+
+  // start(), start_once() and period() may run on a different queue; take
+  // one snapshot of the mode and the schedule and use only that. The deadline
+  // is stored last and loaded first, thus the mode and the next expiration
+  // are at least as recent as the deadline.
+  auto deadline = self->m_timer->m_deadline.load();
+  auto oneshot = self->m_timer->m_oneshot.load();
+  auto next = self->m_timer->m_next.load();
+
+  if (oneshot)
+  {
+    // ignore events of the superseded deadlines - the source never fires
+    // early so an event before the current deadline belongs to an earlier
+    // arming; the exchange makes sure the expiration is reported only once
+    if (deadline == 0 || ::dispatch_time(DISPATCH_TIME_NOW, 0) < deadline)
+      return;
+    if (!self->m_timer->m_deadline.compare_exchange_strong(deadline, 0))
+      return;
+  }
+
+  if (self->m_timer->m_probe)
+  {
+    self->m_timer->instrumented_expired(self->m_source.get_data(), oneshot, next);
+    return;
+  }
+
   auto cb = self->m_timer->m_callback.lock();
   if (cb)
     cb->expired();
@@ -100,6 +137,10 @@ timer::timer(const std::weak_ptr<cb::timer>& t_
   , m_context(nullptr)
   , m_period(p_ * 1000)
   , m_leeway(l_ * 1000)
+  , m_deadline(0)
+  , m_oneshot(false)
+  , m_probe(timer_probe::create())
+  , m_next(0)
 {
 }
 
@@ -109,6 +150,7 @@ timer::~timer()
 
 void timer::initialize(const std::shared_ptr<async::impl::executor>& ex_)
 {
+  m_executor = ex_;
   m_context = new context(self().lock(), ex_);
 }
 
@@ -121,25 +163,147 @@ void timer::period(uint64_t p_, uint64_t l_)
 
 }
 
+void timer::stats(async::timer_stats& s_) const
+{
+  if (m_probe)
+    m_probe->snapshot(s_);
+}
+
+// fired_ is the number of expirations since the last event; oneshot_ and
+// next_ are the handler's snapshot of the mode and the scheduled expiration
+void timer::instrumented_expired(unsigned long fired_, bool oneshot_, uint64_t next_)
+{
+  auto now = clock_us();
+  uint64_t missed = 0;
+  auto scheduled = next_;
+  if (!oneshot_)
+  {
+    if (fired_ > 1)
+    {
+      missed = fired_ - 1;
+      scheduled += missed * (m_period / 1000);
+    }
+    // leave alone the schedule set by the restart since the snapshot
+    m_next.compare_exchange_strong(next_, scheduled + m_period / 1000);
+  }
+  m_probe->fired(scheduled, now, missed);
+
+  auto ex = m_executor.lock();
+  if (!ex)
+    return;
+
+  std::weak_ptr<cb::timer> cb_ = m_callback;
+  auto probe = m_probe;
+  ex->post(
+    [cb_, probe, now] ()
+    {
+      auto cb = cb_.lock();
+      if (cb)
+      {
+        probe->dispatched(now, clock_us());
+        cb->expired();
+      }
+    });
+}
+
 void timer::shutdown()
 {
   m_context->shutdown();
 }
 
+// Setting the timer of the active source replaces its previous settings and
+// clears the pending expirations, thus neither start() nor start_once() need
+// to suspend the source first.
 void timer::start()
 {
-  if (m_context->m_source)
-    m_context->m_source.suspend();
-
+  m_oneshot = false;
+  m_next = clock_us() + m_period / 1000;
+  m_deadline = 0;
   ::dispatch_source_set_timer(m_context->m_source.source(), ::dispatch_time(DISPATCH_TIME_NOW, m_period), m_period, m_leeway);
   m_context->m_source.resume();
 }
 
+void timer::start_once(uint64_t d_)
+{
+  auto deadline = ::dispatch_time(DISPATCH_TIME_NOW, d_ == 0 ? m_period : d_ * 1000);
+  m_oneshot = true;
+  m_next = clock_us() + (d_ == 0 ? m_period / 1000 : d_);
+  m_deadline = deadline;
+  ::dispatch_source_set_timer(m_context->m_source.source(), deadline, DISPATCH_TIME_FOREVER, m_leeway);
+  m_context->m_source.resume();
+}
+
 void timer::stop()
 {
+  m_deadline = 0;
   m_context->m_source.suspend();
 }
 
+// ==========================================================================
+// ======
+// ======
+// ====== Signal event source
+// ======
+// ======
+// ==========================================================================
+
+signal::context::context(const signal::ptr& s_, const std::shared_ptr<async::impl::executor>& ex_)
+    : m_signal(s_)
+{
+  m_source = ::dispatch_source_create(
+      s_->m_merge == signal_merge::add ? DISPATCH_SOURCE_TYPE_DATA_ADD : DISPATCH_SOURCE_TYPE_DATA_OR
+    , 0
+    , 0
+    , ex_->queue());
+  m_source.cancel_handler(on_cancel);
+  m_source.event_handler(on_event);
+  m_source.context(this);
+}
+
+void signal::context::shutdown()
+{
+  m_source.cancel();
+}
+
+void signal::context::on_cancel(void* ctx)
+{
+  auto self = static_cast<context*>(ctx);
+  self->m_source.release();
+
+  delete self;
+}
+
+void signal::context::on_event(void* ctx)
+{
+  auto self = static_cast<context*>(ctx);
+  auto cb = self->m_signal->m_callback.lock();
+  if (cb)
+    cb->signalled(self->m_source.get_data());
+}
+
+signal::signal(const std::weak_ptr<cb::signal>& s_, signal_merge m_)
+  : named("si.digiverse.ng.cool.signal")
+  , m_callback(s_)
+  , m_merge(m_)
+  , m_context(nullptr)
+{ /* noop */ }
+
+void signal::initialize(const std::shared_ptr<async::impl::executor>& ex_)
+{
+  m_context = new context(self().lock(), ex_);
+  m_context->m_source.resume();
+}
+
+void signal::trigger(unsigned long v_)
+{
+  ::dispatch_source_merge_data(m_context->m_source.source(), v_);
+}
+
+void signal::shutdown()
+{
+  m_context->shutdown();
+}
+
 } // namespace impl
 
 
@@ -154,6 +318,62 @@ void timer::stop()
 // ==========================================================================
 namespace net { namespace impl {
 
+namespace {
+
+// maximum number of handles accepted with a single read
+const std::size_t max_passed_handles = 16;
+
+// fills in the address of the local endpoint and returns its size
+socklen_t to_sockaddr(const local_endpoint& ep_, sockaddr_un& addr_)
+{
+  if (ep_.path.empty() || ep_.path.size() >= sizeof(addr_.sun_path))
+    throw exc::illegal_argument();
+
+  std::memset(&addr_, 0, sizeof(addr_));
+  addr_.sun_family = AF_UNIX;
+  if (ep_.abstract)
+  {
+#if defined(LINUX_TARGET)
+    // the abstract name follows the leading zero byte and is not terminated
+    std::memcpy(addr_.sun_path + 1, ep_.path.data(), ep_.path.size());
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + ep_.path.size());
+#else
+    throw exc::operation_failed(error::errc::not_available);
+#endif
+  }
+
+  std::memcpy(addr_.sun_path, ep_.path.data(), ep_.path.size());
+  return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + ep_.path.size() + 1);
+}
+
+// sends the data with the handle attached as SCM_RIGHTS control message
+ssize_t send_handle(handle s_, ::iovec& data_, handle h_)
+{
+  union
+  {
+    ::cmsghdr m_align;
+    char      m_buf[CMSG_SPACE(sizeof(int))];
+  } control;
+  std::memset(&control, 0, sizeof(control));
+
+  ::msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &data_;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.m_buf;
+  msg.msg_controllen = sizeof(control.m_buf);
+
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &h_, sizeof(int));
+
+  return ::sendmsg(s_, &msg, 0);
+}
+
+} // anonymous namespace
+
 // --------------------------------------------------------------------------
 // --------------------------------------------------------------------------
 // --------------------------------------------------------------------------
@@ -170,7 +390,8 @@ namespace net { namespace impl {
 server::context::context(const server::ptr& s_
                        , const std::shared_ptr<async::impl::executor>& ex_
                        , const ip::address& addr_
-                       , uint16_t port_)
+                       , uint16_t port_
+                       , const socket_options& opts_)
   : m_server(s_), m_handle(invalid_handle)
 {
   try
@@ -183,6 +404,8 @@ server::context::context(const server::ptr& s_
       if (::setsockopt(m_handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&enable), sizeof(enable)) != 0)
         throw exc::socket_failure();
     }
+    // buffer sizes must be set before listen to affect the window scaling
+    apply_options(m_handle, opts_);
     {
       struct sockaddr* addr;
       std::size_t sz;
@@ -212,23 +435,62 @@ server::context::context(const server::ptr& s_
         throw exc::socket_failure();
     }
 
-    if (::listen(m_handle, 10) != 0)
+    listen(ex_);
+  }
+  catch (...)
+  {
+    m_source.destroy();
+    if (m_handle != invalid_handle)
+      ::close(m_handle);
+    throw;
+  }
+}
+
+server::context::context(const server::ptr& s_
+                       , const std::shared_ptr<async::impl::executor>& ex_
+                       , const local_endpoint& ep_
+                       , const socket_options& opts_)
+  : m_server(s_), m_handle(invalid_handle)
+{
+  sockaddr_un addr;
+  auto size = to_sockaddr(ep_, addr);
+
+  try
+  {
+    m_handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_handle == ::cool::ng::net::invalid_handle)
+      throw exc::socket_failure();
+
+    apply_options(m_handle, opts_);
+    if (::bind(m_handle, reinterpret_cast<sockaddr*>(&addr), size) != 0)
       throw exc::socket_failure();
+    if (!ep_.abstract)
+      m_path = ep_.path;
 
-    m_source = ::dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, m_handle, 0 , ex_->queue());
-    m_source.cancel_handler(on_cancel);
-    m_source.event_handler(on_event);
-    m_source.context(this);
+    listen(ex_);
   }
   catch (...)
   {
     m_source.destroy();
     if (m_handle != invalid_handle)
       ::close(m_handle);
+    if (!m_path.empty())
+      ::unlink(m_path.c_str());
     throw;
   }
 }
 
+void server::context::listen(const std::shared_ptr<async::impl::executor>& ex_)
+{
+  if (::listen(m_handle, 10) != 0)
+    throw exc::socket_failure();
+
+  m_source = ::dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, m_handle, 0 , ex_->queue());
+  m_source.cancel_handler(on_cancel);
+  m_source.event_handler(on_event);
+  m_source.context(this);
+}
+
 void server::context::start_accept()
 {
   m_source.resume();
@@ -251,6 +513,8 @@ void server::context::on_cancel(void* ctx)
   self->m_source.release();
 
   ::close(self->m_handle);
+  if (!self->m_path.empty())
+    ::unlink(self->m_path.c_str());
 
   delete self;
 }
@@ -268,10 +532,13 @@ void server::context::on_event(void* ctx)
 
     if (clt != invalid_handle)
     {
+      // the local peers have no address and are reported as unspecified
       ip::host_container address(addr);
-      uint16_t port = (static_cast<const ip::address&>(address).version() == ip::version::ipv4)
-         ? ntohs(reinterpret_cast<sockaddr_in*>(&addr)->sin_port)
-         : ntohs(reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port);
+      uint16_t port = 0;
+      if (addr.ss_family == AF_INET)
+        port = ntohs(reinterpret_cast<sockaddr_in*>(&addr)->sin_port);
+      else if (addr.ss_family == AF_INET6)
+        port = ntohs(reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port);
 
       self->m_server->process_accept(clt, address, port);
     }
@@ -292,18 +559,32 @@ server::server(const std::shared_ptr<async::impl::executor>& ex_
   , m_context(nullptr)
   , m_handler(cb_)
   , m_exec(ex_)
+  , m_probe(std::make_shared<stream_probe>())
 { /* noop */ }
 
 server::~server()
 { /* noop */ }
 
-void server::initialize(const cool::ng::net::ip::address& addr_, uint16_t port_)
+void server::initialize(const cool::ng::net::ip::address& addr_
+                      , uint16_t port_
+                      , const socket_options& opts_)
 {
   auto e = m_exec.lock();
   if (!e)
     throw exc::runner_not_available();
 
-  m_context = new context(self().lock(), e, addr_, port_);
+  m_options = opts_;
+  m_context = new context(self().lock(), e, addr_, port_, opts_);
+}
+
+void server::initialize(const local_endpoint& ep_, const socket_options& opts_)
+{
+  auto e = m_exec.lock();
+  if (!e)
+    throw exc::runner_not_available();
+
+  m_options = opts_;
+  m_context = new context(self().lock(), e, ep_, opts_);
 }
 
 
@@ -363,7 +644,10 @@ void server::process_accept(cool::ng::net::handle h_
 
   try
   {
+    // not all platforms pass the listen socket options to accepted sockets
+    apply_options(h_, m_options);
     auto stream = cb->manufacture(addr_, port_);
+    stream.m_impl->aggregate(m_probe);
     stream.m_impl->set_handle(h_);
     try { cb->on_connect(stream); } catch (...) { /* noop */ }
   }
@@ -374,6 +658,11 @@ void server::process_accept(cool::ng::net::handle h_
 
 }
 
+void server::stats(stream_stats& s_) const
+{
+  m_probe->snapshot(s_);
+}
+
 // --------------------------------------------------------------------------
 // --------------------------------------------------------------------------
 // --------------------------------------------------------------------------
@@ -395,28 +684,52 @@ stream::stream(const std::weak_ptr<async::impl::executor>& ex_
     , m_executor(ex_)
     , m_handler(cb_)
     , m_reader(nullptr)
+    , m_rd_budget_bytes(default_read_budget_bytes)
+    , m_rd_budget_reads(default_read_budget_reads)
     , m_writer(nullptr)
-    , m_wr_busy(false)
-{ /* noop */ }
+    , m_pause_read(false)
+    , m_probe(std::make_shared<stream_probe>())
+    , m_connect_start(0)
+{
+  m_wr_queue.close();
+}
 
 stream::~stream()
-{ /* noop */ }
+{
+  for (auto h : m_rcv_handles)
+    ::close(h);
+}
 
 void stream::initialize(const cool::ng::net::ip::address& addr_
                       , uint16_t port_
                       , void* buf_
-                      , std::size_t bufsz_)
+                      , std::size_t bufsz_
+                      , const socket_options& opts_)
 {
   m_size = bufsz_;
   m_buf = buf_;
+  m_options = opts_;
 
   connect(addr_, port_);
 }
 
-void stream::set_handle(cool::ng::net::handle h_)
+void stream::initialize(const local_endpoint& ep_
+                      , void* buf_
+                      , std::size_t bufsz_
+                      , const socket_options& opts_)
 {
+  m_size = bufsz_;
+  m_buf = buf_;
+  m_options = opts_;
+
+  connect(ep_);
+}
 
+void stream::set_handle(cool::ng::net::handle h_)
+{
+  m_wr_queue.open();
   m_state = state::connected;
+  m_probe->accepted();
 
 #if defined(OSX_TARGET)
   // on OSX accepted socket does not preserve non-blocking properties of the listen socket
@@ -425,28 +738,34 @@ void stream::set_handle(cool::ng::net::handle h_)
     throw exc::socket_failure();
 #endif
 
-  auto rh = ::dup(h_);
-  if (rh == cool::ng::net::invalid_handle)
-    throw exc::socket_failure();
+  apply_options(h_, m_options);
 
-  create_write_source(h_, false);
-  create_read_source(rh, m_buf, m_size);
+  auto sock = std::make_shared<shared_handle>(h_);
+  create_write_source(sock, false);
+  create_read_source(sock, m_buf, m_size);
 }
 
-void stream::initialize(void* buf_, std::size_t bufsz_)
+void stream::initialize(void* buf_, std::size_t bufsz_, const socket_options& opts_)
 {
   m_size = bufsz_;
   m_buf = buf_;
+  m_options = opts_;
+}
+
+stream::shared_handle::~shared_handle()
+{
+  ::close(m_handle);
 }
 
-void stream::create_write_source(cool::ng::net::handle h_, bool  start_)
+void stream::create_write_source(const std::shared_ptr<shared_handle>& h_, bool  start_)
 {
   auto ex_ = m_executor.lock();
   if (!ex_)
     throw exc::runner_not_available();
 
   auto writer = new context;
-  writer->m_handle = h_;
+  writer->m_handle = h_->m_handle;
+  writer->m_socket = h_;
   writer->m_stream = self().lock();
 
   // prepare write event source
@@ -461,7 +780,7 @@ void stream::create_write_source(cool::ng::net::handle h_, bool  start_)
     writer->m_source.resume();
 }
 
-void stream::create_read_source(cool::ng::net::handle h_, void* buf_, std::size_t bufsz_)
+void stream::create_read_source(const std::shared_ptr<shared_handle>& h_, void* buf_, std::size_t bufsz_)
 {
   auto ex_ = m_executor.lock();
   if (!ex_)
@@ -469,17 +788,15 @@ void stream::create_read_source(cool::ng::net::handle h_, void* buf_, std::size_
 
   auto reader = new rd_context;
 
-  // prepare read buffer
+  // prepare read buffer; without user buffer the pooled buffers are used
   reader->m_rd_data = buf_;
   reader->m_rd_size = bufsz_;
-  reader->m_rd_is_mine = false;
-  if (buf_ == nullptr)
-  {
-    reader->m_rd_data = new uint8_t[bufsz_];
-    reader->m_rd_is_mine = true;
-  }
+  reader->m_rd_pool = ex_->read_pool();
+  reader->m_rd_handles = m_options.pass_handles == 1;
+  reader->m_quick_ack = m_options.quick_ack == 1;
 
-  reader->m_handle = h_;
+  reader->m_handle = h_->m_handle;
+  reader->m_socket = h_;
   reader->m_stream = self().lock();
 
   // prepare read event source
@@ -547,6 +864,7 @@ void stream::disconnect()
     }
   }
 
+  m_wr_queue.close();
   {
     rd_context* aux;
     if (!cancel_read_source(aux))
@@ -563,12 +881,40 @@ void stream::disconnect()
 }
 
 void stream::connect(const cool::ng::net::ip::address& addr_, uint16_t port_)
+{
+  sockaddr_in addr4;
+  sockaddr_in6 addr6;
+  if (addr_.version() == ip::version::ipv4)
+  {
+    addr4.sin_family = AF_INET;
+    addr4.sin_addr = static_cast<in_addr>(addr_);
+    addr4.sin_port = htons(port_);
+    connect(AF_INET, reinterpret_cast<sockaddr*>(&addr4), sizeof(addr4));
+  }
+  else
+  {
+    addr6.sin6_family = AF_INET6;
+    addr6.sin6_addr = static_cast<in6_addr>(addr_);
+    addr6.sin6_port = htons(port_);
+    connect(AF_INET6, reinterpret_cast<sockaddr*>(&addr6), sizeof(addr6));
+  }
+}
+
+void stream::connect(const local_endpoint& ep_)
+{
+  sockaddr_un addr;
+  auto size = to_sockaddr(ep_, addr);
+  connect(AF_UNIX, reinterpret_cast<sockaddr*>(&addr), size);
+}
+
+void stream::connect(int family_, const sockaddr* addr_, socklen_t size_)
 {
   if (m_size == 0)
     throw exc::illegal_argument();
 
 
   cool::ng::net::handle handle = cool::ng::net::invalid_handle;
+  std::shared_ptr<shared_handle> sock;
 
   if (m_state != state::disconnected)
     throw exc::invalid_state();
@@ -576,51 +922,31 @@ void stream::connect(const cool::ng::net::ip::address& addr_, uint16_t port_)
   try
   {
 #if defined(LINUX_TARGET)
-    handle = addr_.version() == ip::version::ipv6 ?
-          ::socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, 0)
-        : ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    handle = ::socket(family_, SOCK_STREAM | SOCK_NONBLOCK, 0);
 #else
-    handle = addr_.version() == ip::version::ipv6 ?
-        ::socket(AF_INET6, SOCK_STREAM, 0)
-      : ::socket(AF_INET, SOCK_STREAM, 0);
+    handle = ::socket(family_, SOCK_STREAM, 0);
 #endif
     if (handle == cool::ng::net::invalid_handle)
       throw exc::socket_failure();
+    sock = std::make_shared<shared_handle>(handle);
 
 #if !defined(LINUX_TARGET)
     int option = 1;
     if (ioctl(handle, FIONBIO, &option) != 0)
       throw exc::socket_failure();
 #endif
+    apply_options(handle, m_options);
 
-    create_write_source(handle);
-
-    sockaddr* p;
-    std::size_t size;
-    sockaddr_in addr4;
-    sockaddr_in6 addr6;
-    if (addr_.version() == ip::version::ipv4)
-    {
-      addr4.sin_family = AF_INET;
-      addr4.sin_addr = static_cast<in_addr>(addr_);
-      addr4.sin_port = htons(port_);
-      p = reinterpret_cast<sockaddr*>(&addr4);
-      size = sizeof(addr4);
-    }
-    else
-    {
-      addr6.sin6_family = AF_INET6;
-      addr6.sin6_addr = static_cast<in6_addr>(addr_);
-      addr6.sin6_port = htons(port_);
-      p = reinterpret_cast<sockaddr*>(&addr6);
-      size = sizeof(addr6);
-    }
+    create_write_source(sock);
 
     // Linux may sometimes do immediate connect with connect returning 0.
     // Nevertheless, we will consider this as async connect and let the
-    // on_write event handler handle this in an usual way.
+    // on_write event handler handle this in an usual way. The local
+    // connects complete immediately or fail with EAGAIN if the server's
+    // backlog is full.
     m_state = state::connecting;
-    if (::connect(handle, p, size) == -1)
+    m_connect_start = async::impl::clock_us();
+    if (::connect(handle, addr_, size_) == -1)
     {
       if (errno != EINPROGRESS)
         throw exc::socket_failure();
@@ -628,15 +954,13 @@ void stream::connect(const cool::ng::net::ip::address& addr_, uint16_t port_)
   }
   catch (...)
   {
-    context* prev;
-    if (cancel_write_source(prev))
     {
-      if (prev == nullptr)
-      {
-        if (handle != cool::ng::net::invalid_handle)
-          ::close(handle);
-      }
+      context* prev;
+      cancel_write_source(prev);
     }
+    // once owned by shared_handle the socket closes with its last reference
+    if (!sock && handle != cool::ng::net::invalid_handle)
+      ::close(handle);
 
     m_state = state::disconnected;
 
@@ -650,9 +974,15 @@ void stream::on_wr_cancel(void* ctx)
 {
   auto self = static_cast<context*>(ctx);
   self->m_source.release();
-  ::close(self->m_handle);
 
-  self->m_stream->m_writer = nullptr;
+  // the data not yet written is dropped, unless the stream connected again
+  // in the meantime; this runs on the same queue as the write events, thus
+  // no write is in progress
+  self->m_stream->m_wr_queue.discard();
+  {
+    auto expect = self;
+    self->m_stream->m_writer.compare_exchange_strong(expect, nullptr);
+  }
 
   state expect = state::connecting;
   if (self->m_stream->m_state.compare_exchange_strong(expect, state::disconnected))
@@ -669,59 +999,182 @@ void stream::on_rd_cancel(void* ctx)
   auto self = static_cast<rd_context*>(ctx);
   self->m_source.release();
 
-  ::close(self->m_handle);
-
-  if (self->m_rd_is_mine)
-    delete [] static_cast<uint8_t*>(self->m_rd_data);
   self->m_stream->m_reader = nullptr;
 
   delete self;
 }
 
+// Reads until the socket is drained or the read budget is used up; the
+// budget keeps a busy connection from monopolizing the runner. A read shorter
+// than the buffer means the socket was drained and saves the extra call that
+// would only return EAGAIN. The reads use MSG_DONTWAIT as the accepted
+// sockets are not necessarily in non-blocking mode.
+//
+// Streams without the user buffer take the buffer from the runner's pool
+// only when there is data to read and return it when the event is handled.
+// The same buffer is reused for consecutive reads unless the read handler
+// retained it, in which case the next read takes another one.
+//
+// TCP_QUICKACK, if requested, is set again after the reads as Linux does not
+// keep it on permanently.
 void stream::on_rd_event(void* ctx)
 {
   auto self = static_cast<rd_context*>(ctx);
-  std::size_t size = self->m_source.get_data();
+  auto stream = self->m_stream;
 
-  if (size == 0)   // indicates disconnect of peer
+  stream->m_probe->read_event();
+  if (self->m_source.get_data() == 0)   // indicates disconnect of peer
   {
-    self->m_stream->process_disconnect_event();
+    stream->process_disconnect_event();
     return;
   }
 
-  size = ::read(self->m_handle, self->m_rd_data, self->m_rd_size);
-  auto buf = self->m_rd_data;
+  const std::size_t max_bytes = stream->m_rd_budget_bytes;
+  const std::size_t max_reads = stream->m_rd_budget_reads;
+  std::size_t total = 0;
+
+  for (std::size_t n = 0; n < max_reads && total < max_bytes; ++n)
+  {
+    void* buf = self->m_rd_data;
+    if (buf == nullptr)
+    {
+      if (!self->m_rd_pooled || self->m_rd_pooled.use_count() > 1)
+        self->m_rd_pooled = self->m_rd_pool->acquire(self->m_rd_size);
+      buf = self->m_rd_pooled.get();
+    }
+
+    auto res = self->m_rd_handles
+      ? stream->receive(self, buf, self->m_rd_size)
+      : ::recv(self->m_handle, buf, self->m_rd_size, MSG_DONTWAIT);
+    if (res < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        stream->m_probe->read_again();
+      stream->m_probe->read(0);
+      break;  // EAGAIN, or an error reported by the next event
+    }
+    stream->m_probe->read(static_cast<std::size_t>(res));
+    if (res == 0)
+    {
+      stream->process_disconnect_event();
+      break;
+    }
+
+    auto size = static_cast<std::size_t>(res);
+    total += size;
+    bool drained = size < self->m_rd_size;
+    stream->process_read(self, buf, size);
+
+    // stop if the read handler disconnected the stream
+    if (drained || stream->m_reader.load() != self)
+      break;
+  }
+
+  if (self->m_quick_ack && total > 0)
+    self->m_quick_ack = rearm_quick_ack(self->m_handle);
+  self->m_rd_pooled.reset();
+}
+
+// Reads the data and keeps the handles passed along by the peer until the
+// user takes them. The handles that did not fit into the control buffer are
+// closed by the kernel.
+ssize_t stream::receive(rd_context* ctx, void* buf_, std::size_t size_)
+{
+  union
+  {
+    ::cmsghdr m_align;
+    char      m_buf[CMSG_SPACE(max_passed_handles * sizeof(int))];
+  } control;
+
+  ::iovec iov;
+  iov.iov_base = buf_;
+  iov.iov_len = size_;
+
+  ::msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.m_buf;
+  msg.msg_controllen = sizeof(control.m_buf);
+
+#if defined(LINUX_TARGET)
+  auto res = ::recvmsg(ctx->m_handle, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+#else
+  auto res = ::recvmsg(ctx->m_handle, &msg, MSG_DONTWAIT);
+#endif
+  if (res < 0)
+    return res;
+
+  for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+  {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    std::unique_lock<std::mutex> l(m_rcv_mutex);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      int h;
+      std::memcpy(&h, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+      m_rcv_handles.push_back(h);
+    }
+  }
+  return res;
+}
+
+cool::ng::net::handle stream::received_handle()
+{
+  std::unique_lock<std::mutex> l(m_rcv_mutex);
+  if (m_rcv_handles.empty())
+    return invalid_handle;
+
+  auto h = m_rcv_handles.front();
+  m_rcv_handles.pop_front();
+  return h;
+}
+
+void stream::stats(stream_stats& s_) const
+{
+  m_probe->snapshot(s_);
+}
+
+void stream::aggregate(const stream_probe::ptr& probe_)
+{
+  m_probe->parent(probe_);
+}
+
+void stream::process_read(rd_context* self, void* buf_, std::size_t size)
+{
+  auto buf = buf_;
   try
   {
-    auto aux = self->m_stream->m_handler.lock();
+    auto aux = m_handler.lock();
     if (aux)
     {
+      buffer_pool::current(self->m_rd_data == nullptr ? &self->m_rd_pooled : nullptr);
       try { aux->on_read(buf, size); } catch (...) { /* noop */ }
+      buffer_pool::current(nullptr);
 
-      // check if callback modified buffer or size parameters
-      if (buf != self->m_rd_data || size != self->m_rd_size)
+      // check if callback modified buffer or size parameters; the size on
+      // input is the number of bytes read, which for short reads differs
+      // from the buffer size, thus only the change of the buffer address
+      // or the size of zero mean the buffer is to be replaced
+      if (buf != buf_ || size == 0)
       {
-        // release current buffer if allocated by me
-        if (self->m_rd_is_mine)
-          delete [] static_cast<uint8_t*>(self->m_rd_data);
-
         // there are some special values that requeire different considerations
         //  - if size is zero revert to bufffer specified at the creation
-        //  - if buf is nullptr allocate buffer of specified size
+        //  - if buf is nullptr use pooled buffers of specified size
         if (size == 0)
         {
-          self->m_rd_size = self->m_stream->m_size;
-          self->m_rd_data = self->m_stream->m_buf;
+          self->m_rd_size = m_size;
+          self->m_rd_data = m_buf;
         }
         else
         {
           self->m_rd_data = buf;
           self->m_rd_size = size;
         }
-        self->m_rd_is_mine = self->m_rd_data == nullptr;
-
-        if (self->m_rd_is_mine)
-          self->m_rd_data = new uint8_t[self->m_rd_size];
+        self->m_rd_pooled.reset();
       }
     }
   }
@@ -729,6 +1182,14 @@ void stream::on_rd_event(void* ctx)
   { /* noop */ }
 }
 
+void stream::read_budget(std::size_t bytes_, std::size_t reads_)
+{
+  if (bytes_ == 0 || reads_ == 0)
+    throw exc::illegal_argument();
+  m_rd_budget_bytes = bytes_;
+  m_rd_budget_reads = reads_;
+}
+
 void stream::on_wr_event(void* ctx)
 {
   auto self = static_cast<context*>(ctx);
@@ -752,33 +1213,176 @@ void stream::on_wr_event(void* ctx)
 
 void stream::write(const void* data, std::size_t size)
 {
-  if (m_state != state::connected)
+  start_write(m_wr_queue.push(data, size));
+}
+
+void stream::write(const const_buffer* bufs, std::size_t count)
+{
+  start_write(m_wr_queue.push(bufs, count));
+}
+
+void stream::write(std::vector<uint8_t>&& data)
+{
+  start_write(m_wr_queue.push(std::move(data)));
+}
+
+void stream::write_handle(cool::ng::net::handle h_)
+{
+  auto writer = m_writer.load();
+  if (writer == nullptr)
     throw exc::invalid_state();
 
-  bool expected = false;
-  if (!m_wr_busy.compare_exchange_strong(expected, true))
-    throw exc::operation_failed(cool::ng::error::errc::resource_busy);
+  {
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (::getsockname(writer->m_handle, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+      throw exc::socket_failure();
+    if (addr.ss_family != AF_UNIX)
+      throw exc::operation_failed(error::errc::not_available);
+  }
+
+  auto h = ::dup(h_);
+  if (h == invalid_handle)
+    throw exc::socket_failure();
+
+  start_write(m_wr_queue.push(h));
+}
 
-  m_wr_data = static_cast<const uint8_t*>(data);
-  m_wr_size = size;
-  m_wr_pos = 0;
-  m_writer.load()->m_source.resume();
+// The flow control changes are detected by the writers, possibly outside of
+// the runner's context, thus their processing is posted to the runner. The
+// write queue reports them under its lock, keeping them in order.
+void stream::watermarks(std::size_t high_, std::size_t low_, bool pause_read_)
+{
+  if (high_ != 0 && low_ >= high_)
+    throw exc::illegal_argument();
+
+  m_pause_read = pause_read_;
+
+  std::weak_ptr<stream> self_ = self();
+  auto exec = m_executor;
+  m_wr_queue.watermarks(
+      high_
+    , low_
+    , [self_, exec] (bool blocked_)
+      {
+        auto ex = exec.lock();
+        if (!ex)
+          return;
+        ex->post(
+          [self_, blocked_] ()
+          {
+            auto s = self_.lock();
+            if (s)
+              s->process_flow(blocked_);
+          });
+      });
 }
 
-void stream::process_write_event(context* ctx, std::size_t size)
+void stream::process_flow(bool blocked_)
 {
-  std::size_t res = ::write(ctx->m_handle, m_wr_data + m_wr_pos, m_wr_size - m_wr_pos);
-  m_wr_pos += res;
+  // resume also if the pause was disabled in the meantime
+  auto reader = m_reader.load();
+  if (reader != nullptr)
+  {
+    if (!blocked_)
+      reader->m_source.resume();
+    else if (m_pause_read)
+      reader->m_source.suspend();
+  }
 
-  if (m_wr_pos >= m_wr_size)
+  auto aux = m_handler.lock();
+  if (aux)
+    try
+    {
+      aux->on_event(
+          blocked_ ? detail::oob_event::write_blocked : detail::oob_event::write_unblocked
+        , no_error());
+    }
+    catch (...)
+    { /* noop */ }
+}
+
+void stream::start_write(bool was_empty_)
+{
+  if (!was_empty_)
+    return;   // write source is already active
+  auto writer = m_writer.load();
+  if (writer != nullptr)
+    writer->m_source.resume();
+}
+
+// Gathers as much of the queued data as possible into a single writev call.
+// The write source is suspended when the queue drains; the queue is checked
+// once more after the suspend because a concurrent write may have found the
+// queue empty just before the suspend and its resume would then be lost.
+// The passed handle goes out alone, with its byte of data, using sendmsg.
+void stream::process_write_event(context* ctx, std::size_t)
+{
+  const std::size_t max_segments = 64;
+  ::iovec segments[max_segments];
+  handle passed;
+
+  auto count = m_wr_queue.gather(
+      max_segments
+    , [&segments] (std::size_t i_, const uint8_t* data_, std::size_t size_)
+      {
+        segments[i_].iov_base = const_cast<uint8_t*>(data_);
+        segments[i_].iov_len = size_;
+      }
+    , passed);
+  if (count == 0)
   {
     ctx->m_source.suspend();
-    m_wr_busy = false;
-    auto aux = m_handler.lock();
-    if (aux)
+    if (!m_wr_queue.empty())
+      ctx->m_source.resume();
+    return;
+  }
+
+  auto res = passed == invalid_handle
+    ? ::writev(ctx->m_handle, segments, static_cast<int>(count))
+    : send_handle(ctx->m_handle, segments[0], passed);
+  if (res < 0)
+  {
+    auto err = errno;
+    m_probe->write(0);
+    if (err == EAGAIN || err == EWOULDBLOCK)
     {
-      try { aux->on_write(m_wr_data, m_wr_size); } catch (...) { }
+      m_probe->write_again();
+      return;
     }
+    // the write failed for good; stop the write source, drop the data not
+    // yet written and report the disconnect
+    ctx->m_source.suspend();
+    m_wr_queue.close();
+    m_wr_queue.clear();
+    process_disconnect_event(std::error_code(err, std::system_category()));
+    return;
+  }
+  m_probe->write(static_cast<std::size_t>(res));
+
+  std::vector<write_queue::entry> done;
+  if (m_wr_queue.consume(static_cast<std::size_t>(res), done))
+  {
+    ctx->m_source.suspend();
+    if (!m_wr_queue.empty())
+      ctx->m_source.resume();
+  }
+
+  if (done.empty())
+    return;
+  auto now = async::impl::clock_us();
+  auto aux = m_handler.lock();
+  for (auto& e : done)
+  {
+    // the peer received its own copy of the passed handle
+    if (e.m_handle != invalid_handle)
+    {
+      write_queue::release(e);
+      continue;
+    }
+    m_probe->written(now > e.m_queued ? now - e.m_queued : 0);
+    if (aux)
+      try { aux->on_write(e.m_data, e.m_size); } catch (...) { }
   }
 }
 
@@ -823,14 +1427,13 @@ void stream::process_connecting_event(context* ctx, std::size_t size)
       throw exc::runtime_fault(error::errc::request_failed);
     }
 
-    // connect succeeded - create reader context and start reader
-    // !! must dup because Linux wouldn't have read/write on same fd
-    auto aux_h = ::dup(ctx->m_handle);
-    if (aux_h == cool::ng::net::invalid_handle)
-      throw exc::socket_failure();
-
-    create_read_source(aux_h, m_buf, m_size);
+    // connect succeeded - create reader context and start reader on the
+    // same socket as the writer
+    create_read_source(ctx->m_socket, m_buf, m_size);
+    m_wr_queue.open();
     m_state = state::connected;
+    auto now = async::impl::clock_us();
+    m_probe->connected(now > m_connect_start ? now - m_connect_start : 0);
 
     auto aux = m_handler.lock();
     if (aux)
@@ -850,12 +1453,13 @@ void stream::process_connecting_event(context* ctx, std::size_t size)
   }
 }
 
-void stream::process_disconnect_event()
+void stream::process_disconnect_event(const std::error_code& err_)
 {
   state expect = state::connected;
   if (!m_state.compare_exchange_strong(expect, state::disconnected))
     return; // TODO: should we assert here?
 
+  m_wr_queue.close();
   {
     context* aux;
     cancel_write_source(aux);
@@ -867,7 +1471,7 @@ void stream::process_disconnect_event()
 
   auto aux = m_handler.lock();
   if (aux)
-    try { aux->on_event(detail::oob_event::disconnect, no_error()); } catch (...) { }
+    try { aux->on_event(detail::oob_event::disconnect, err_); } catch (...) { }
 }
 
 void stream::shutdown()
@@ -882,6 +1486,329 @@ void stream::shutdown()
   }
 }
 
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+// -----
+// ----- datagram class  implementation
+// -----
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+// --------------------------------------------------------------------------
+
+namespace {
+
+socklen_t to_sockaddr(const ip::address& addr_, uint16_t port_, sockaddr_storage& sa_)
+{
+  std::memset(&sa_, 0, sizeof(sa_));
+  if (addr_.version() == ip::version::ipv4)
+  {
+    auto p = reinterpret_cast<sockaddr_in*>(&sa_);
+    p->sin_family = AF_INET;
+    p->sin_addr = static_cast<in_addr>(addr_);
+    p->sin_port = htons(port_);
+    return sizeof(sockaddr_in);
+  }
+
+  auto p = reinterpret_cast<sockaddr_in6*>(&sa_);
+  p->sin6_family = AF_INET6;
+  p->sin6_addr = static_cast<in6_addr>(addr_);
+  p->sin6_port = htons(port_);
+  return sizeof(sockaddr_in6);
+}
+
+uint16_t port_of(const sockaddr_storage& sa_)
+{
+  return sa_.ss_family == AF_INET
+    ? ntohs(reinterpret_cast<const sockaddr_in*>(&sa_)->sin_port)
+    : ntohs(reinterpret_cast<const sockaddr_in6*>(&sa_)->sin6_port);
+}
+
+} // anonymous namespace
+
+datagram::context::context(const datagram::ptr& d_
+                         , const std::shared_ptr<async::impl::executor>& ex_
+                         , ::cool::ng::net::handle h_)
+  : m_datagram(d_)
+  , m_handle(h_)
+  , m_buffer(d_->m_batch * d_->m_size)
+  , m_msgs(d_->m_batch)
+#if defined(LINUX_TARGET)
+  , m_hdrs(d_->m_batch)
+  , m_iovs(d_->m_batch)
+  , m_addrs(d_->m_batch)
+#endif
+{
+  for (std::size_t i = 0; i < d_->m_batch; ++i)
+  {
+    m_msgs[i].data = m_buffer.data() + i * d_->m_size;
+#if defined(LINUX_TARGET)
+    m_iovs[i].iov_base = m_buffer.data() + i * d_->m_size;
+    m_iovs[i].iov_len = d_->m_size;
+    std::memset(&m_hdrs[i], 0, sizeof(m_hdrs[i]));
+    m_hdrs[i].msg_hdr.msg_name = &m_addrs[i];
+    m_hdrs[i].msg_hdr.msg_iov = &m_iovs[i];
+    m_hdrs[i].msg_hdr.msg_iovlen = 1;
+#endif
+  }
+
+  m_source = ::dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, m_handle, 0 , ex_->queue());
+  m_source.cancel_handler(on_cancel);
+  m_source.event_handler(on_event);
+  m_source.context(this);
+}
+
+void datagram::context::on_cancel(void* ctx)
+{
+  auto self = static_cast<context*>(ctx);
+  self->m_source.release();
+
+  ::close(self->m_handle);
+
+  delete self;
+}
+
+// Receives the datagrams in batches until the socket is drained or the read
+// budget is used up.
+void datagram::context::on_event(void* ctx)
+{
+  auto self = static_cast<context*>(ctx);
+  auto cb = self->m_datagram->m_handler.lock();
+
+  for (std::size_t n = 0; n < default_read_budget_reads; ++n)
+  {
+    std::size_t count;
+    auto received = self->receive(count);
+    if (received == 0)
+      return;
+
+    if (cb && count > 0)
+      try { cb->on_receive(self->m_msgs.data(), count); } catch (...) { /* noop */ }
+
+    if (received < self->m_datagram->m_batch)
+      return;
+  }
+}
+
+// Receives up to one batch of datagrams and returns their number, 0 if none
+// was available. The datagrams longer than the receive size are dropped and
+// count_ is set to the number of the remaining ones, which are moved to the
+// front of the message array. Linux receives the whole batch with a single
+// system call.
+std::size_t datagram::context::receive(std::size_t& count_)
+{
+  const auto batch = m_datagram->m_batch;
+  count_ = 0;
+
+#if defined(LINUX_TARGET)
+  for (std::size_t i = 0; i < batch; ++i)
+    m_hdrs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+
+  auto res = ::recvmmsg(m_handle, m_hdrs.data(), static_cast<unsigned int>(batch), MSG_DONTWAIT, nullptr);
+  if (res <= 0)
+    return 0;
+
+  for (int i = 0; i < res; ++i)
+  {
+    if (m_hdrs[i].msg_hdr.msg_flags & MSG_TRUNC)
+      continue;
+    m_msgs[count_].data = m_iovs[i].iov_base;
+    m_msgs[count_].size = m_hdrs[i].msg_len;
+    m_msgs[count_].peer = m_addrs[i];
+    m_msgs[count_].port = port_of(m_addrs[i]);
+    ++count_;
+  }
+  return static_cast<std::size_t>(res);
+#else
+  const auto size = m_datagram->m_size;
+  std::size_t received = 0;
+  for ( ; received < batch; ++received)
+  {
+    sockaddr_storage addr;
+    ::iovec iov;
+    iov.iov_base = const_cast<void*>(m_msgs[count_].data);
+    iov.iov_len = size;
+    ::msghdr hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_name = &addr;
+    hdr.msg_namelen = sizeof(addr);
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+
+    auto res = ::recvmsg(m_handle, &hdr, MSG_DONTWAIT);
+    if (res < 0)
+      break;
+    if (hdr.msg_flags & MSG_TRUNC)
+      continue;
+
+    m_msgs[count_].size = static_cast<std::size_t>(res);
+    m_msgs[count_].peer = addr;
+    m_msgs[count_].port = port_of(addr);
+    ++count_;
+  }
+  return received;
+#endif
+}
+
+datagram::datagram(const std::shared_ptr<async::impl::executor>& ex_
+                 , const cb::datagram::weak_ptr& cb_)
+  : named("si.digiverse.ng.cool.datagram")
+  , m_context(nullptr)
+  , m_handle(invalid_handle)
+  , m_batch(0)
+  , m_size(0)
+  , m_handler(cb_)
+  , m_exec(ex_)
+{ /* noop */ }
+
+datagram::~datagram()
+{ /* noop */ }
+
+void datagram::initialize(const cool::ng::net::ip::address& addr_
+                        , uint16_t port_
+                        , std::size_t batch_
+                        , std::size_t size_
+                        , const socket_options& opts_)
+{
+  if (batch_ == 0 || size_ == 0)
+    throw exc::illegal_argument();
+
+  auto e = m_exec.lock();
+  if (!e)
+    throw exc::runner_not_available();
+
+  m_batch = batch_;
+  m_size = size_;
+
+  auto h = ::socket(addr_.version() == ip::version::ipv4 ? AF_INET : AF_INET6, SOCK_DGRAM, 0);
+  if (h == invalid_handle)
+    throw exc::socket_failure();
+
+  try
+  {
+    apply_options(h, opts_);
+
+    sockaddr_storage addr;
+    auto len = to_sockaddr(addr_, port_, addr);
+    if (::bind(h, reinterpret_cast<sockaddr*>(&addr), len) != 0)
+      throw exc::socket_failure();
+
+    m_handle = h;
+    m_context = new context(self().lock(), e, h);
+  }
+  catch (...)
+  {
+    ::close(h);
+    m_handle = invalid_handle;
+    throw;
+  }
+
+  m_context.load()->m_source.resume();
+}
+
+// Sends the datagrams until the send buffer fills up. Linux sends up to one
+// batch of datagrams with a single system call, using the message headers
+// on the stack as the send may be called from several threads at once.
+std::size_t datagram::send(const datagram_message* msgs_, std::size_t count_)
+{
+  std::size_t sent = 0;
+
+#if defined(LINUX_TARGET)
+  const std::size_t max_chunk = 32;
+  const auto chunk = std::min(std::min(count_, m_batch), max_chunk);
+  ::mmsghdr hdrs[max_chunk];
+  ::iovec iovs[max_chunk];
+  sockaddr_storage addrs[max_chunk];
+
+  while (sent < count_)
+  {
+    auto n = std::min(count_ - sent, chunk);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      auto& msg = msgs_[sent + i];
+      iovs[i].iov_base = const_cast<void*>(msg.data);
+      iovs[i].iov_len = msg.size;
+      std::memset(&hdrs[i], 0, sizeof(hdrs[i]));
+      hdrs[i].msg_hdr.msg_name = &addrs[i];
+      hdrs[i].msg_hdr.msg_namelen = to_sockaddr(msg.peer, msg.port, addrs[i]);
+      hdrs[i].msg_hdr.msg_iov = &iovs[i];
+      hdrs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    auto res = ::sendmmsg(m_handle, hdrs, static_cast<unsigned int>(n), MSG_DONTWAIT);
+    if (res < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      throw exc::socket_failure();
+    }
+
+    sent += static_cast<std::size_t>(res);
+    if (static_cast<std::size_t>(res) < n)
+      break;
+  }
+#else
+  for ( ; sent < count_; ++sent)
+  {
+    auto& msg = msgs_[sent];
+    sockaddr_storage addr;
+    auto len = to_sockaddr(msg.peer, msg.port, addr);
+    if (::sendto(m_handle, msg.data, msg.size, MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&addr), len) < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      throw exc::socket_failure();
+    }
+  }
+#endif
+
+  return sent;
+}
+
+void datagram::join(const cool::ng::net::ip::address& group_)
+{
+  membership(group_, true);
+}
+
+void datagram::leave(const cool::ng::net::ip::address& group_)
+{
+  membership(group_, false);
+}
+
+// joins to or leaves the multicast group on the default interface
+void datagram::membership(const cool::ng::net::ip::address& group_, bool join_)
+{
+  int res;
+  if (group_.version() == ip::version::ipv4)
+  {
+    ip_mreq req;
+    req.imr_multiaddr = static_cast<in_addr>(group_);
+    req.imr_interface.s_addr = htonl(INADDR_ANY);
+    res = ::setsockopt(m_handle, IPPROTO_IP, join_ ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &req, sizeof(req));
+  }
+  else
+  {
+    ipv6_mreq req;
+    req.ipv6mr_multiaddr = static_cast<in6_addr>(group_);
+    req.ipv6mr_interface = 0;
+    res = ::setsockopt(m_handle, IPPROTO_IPV6, join_ ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP, &req, sizeof(req));
+  }
+
+  if (res != 0)
+    throw exc::socket_failure();
+}
+
+void datagram::shutdown()
+{
+  auto ctx = m_context.exchange(nullptr);
+  if (ctx != nullptr)
+    ctx->m_source.cancel();
+}
+
 } } } } }
 
 
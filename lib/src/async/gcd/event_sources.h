@@ -26,15 +26,27 @@
 
 #include <atomic>
 #include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <string>
 #include <functional>
 
 #include <dispatch/dispatch.h>
+#if defined(LINUX_TARGET)
+# include <sys/socket.h>
+#endif
 #include "cool/ng/bases.h"
 #include "cool/ng/ip_address.h"
 #include "cool/ng/impl/async/event_sources_types.h"
 #include "cool/ng/impl/async/event_sources.h"
 
 #include "executor.h"
+#include "src/async/timer_stats.h"
+#include "src/async/write_queue.h"
+#include "src/async/buffer_pool.h"
+#include "src/async/socket_options.h"
+#include "src/async/stream_stats.h"
 
 namespace cool { namespace ng { namespace async {
 
@@ -166,19 +178,81 @@ class timer : public cool::ng::util::named
   void initialize(const std::shared_ptr<async::impl::executor>& ex_);
   // detail::itf::timer
   void start() override;
+  void start_once(uint64_t d_) override;
   void stop() override;
   void period(uint64_t p_, uint64_t l_) override;
+  void stats(async::timer_stats& s_) const override;
   void shutdown() override;
   const std::string& name() const override
   {
     return named::name();
   }
 
+ private:
+  void instrumented_expired(unsigned long fired_, bool oneshot_, uint64_t next_);
+
  private:
   const std::weak_ptr<cb::timer> m_callback;
   context*                       m_context;
   uint64_t m_period;
   uint64_t m_leeway;
+  // deadline of the one-shot timer as dispatch_time_t, 0 if not armed or
+  // if the timer is periodic
+  std::atomic<uint64_t> m_deadline;
+  std::atomic<bool>     m_oneshot;
+  // instrumentation; the next scheduled expiration is in clock_us() units
+  const timer_probe::ptr               m_probe;
+  std::weak_ptr<async::impl::executor> m_executor;
+  std::atomic<uint64_t>                m_next;
+};
+
+} // namespace impl
+
+// ==========================================================================
+// ======
+// ======
+// ====== Signal event source
+// ======
+// ======
+// ==========================================================================
+
+namespace impl {
+
+// Signal uses the data dispatch source on the runner's queue; libdispatch
+// merges the data of the triggers until the event handler runs.
+class signal : public cool::ng::util::named
+             , public detail::itf::signal
+             , public cool::ng::util::self_aware<signal>
+{
+  struct context
+  {
+    context(const signal::ptr& s_
+          , const std::shared_ptr<async::impl::executor>& ex_);
+
+    static void on_event(void* ctx);
+    static void on_cancel(void* ctx);
+    void shutdown();
+
+    signal::ptr     m_signal;
+    dispatch_source m_source;
+  };
+
+ public:
+  signal(const std::weak_ptr<cb::signal>& s_, signal_merge m_);
+
+  void initialize(const std::shared_ptr<async::impl::executor>& ex_);
+  // detail::itf::signal
+  void trigger(unsigned long v_) override;
+  void shutdown() override;
+  const std::string& name() const override
+  {
+    return named::name();
+  }
+
+ private:
+  const std::weak_ptr<cb::signal> m_callback;
+  const signal_merge              m_merge;
+  context*                        m_context;
 };
 
 } // namespace impl
@@ -192,7 +266,7 @@ class timer : public cool::ng::util::named
 // ==========================================================================
 namespace net { namespace impl {
 
-class server : public async::detail::itf::startable
+class server : public detail::itf::server
              , public cool::ng::util::named
              , public cool::ng::util::self_aware<server>
 {
@@ -203,8 +277,14 @@ class server : public async::detail::itf::startable
     context(const server::ptr& s_
           , const std::shared_ptr<async::impl::executor>& ex_
           , const cool::ng::net::ip::address& addr_
-          , uint16_t port_);
+          , uint16_t port_
+          , const socket_options& opts_);
+    context(const server::ptr& s_
+          , const std::shared_ptr<async::impl::executor>& ex_
+          , const local_endpoint& ep_
+          , const socket_options& opts_);
 
+    void listen(const std::shared_ptr<async::impl::executor>& ex_);
     void start_accept();
     void stop_accept();
     void shutdown();
@@ -215,6 +295,7 @@ class server : public async::detail::itf::startable
     server::ptr             m_server;
     dispatch_source         m_source;
     ::cool::ng::net::handle m_handle;
+    std::string             m_path;    // file system path to remove on close, if any
   };
 
  public:
@@ -223,13 +304,16 @@ class server : public async::detail::itf::startable
   ~server();
 
   void initialize(const cool::ng::net::ip::address& addr_
-                , uint16_t port_);
+                , uint16_t port_
+                , const socket_options& opts_);
+  void initialize(const local_endpoint& ep_, const socket_options& opts_);
 
   // startable interface
   void start() override;
   void stop() override;
   void shutdown() override;
   const std::string& name() const override { return named::name(); }
+  void stats(stream_stats& s_) const override;
 
  private:
   void process_accept(cool::ng::net::handle h_
@@ -241,6 +325,8 @@ class server : public async::detail::itf::startable
   context*             m_context;
   cb::server::weak_ptr m_handler;
   std::weak_ptr<async::impl::executor> m_exec;
+  socket_options       m_options;  // inherited by accepted connections
+  const stream_probe::ptr m_probe; // aggregate of accepted connections
 };
 
 /*
@@ -258,17 +344,29 @@ class stream : public detail::itf::connected_writable
 {
   enum class state { disconnected, connecting, connected, disconnecting };
 
-  struct context
+  // The read and the write event sources share the same socket, which is
+  // closed when the context of the last of them is deleted.
+  struct shared_handle
   {
+    explicit shared_handle(::cool::ng::net::handle h_) : m_handle(h_) { /* noop */ }
+    ~shared_handle();
     ::cool::ng::net::handle m_handle;
-    dispatch_source         m_source;
-    stream::ptr             m_stream;
+  };
+  struct context
+  {
+    ::cool::ng::net::handle        m_handle;
+    std::shared_ptr<shared_handle> m_socket;
+    dispatch_source                m_source;
+    stream::ptr                    m_stream;
   };
   struct rd_context : public context
   {
-    void*                   m_rd_data;
+    void*                   m_rd_data;    // nullptr if reading into pooled buffers
     std::size_t             m_rd_size;
-    bool                    m_rd_is_mine;
+    buffer_pool::ptr        m_rd_pool;
+    buffer_pool::buffer     m_rd_pooled;  // pooled buffer in use, if any
+    bool                    m_rd_handles; // receives the passed handles
+    bool                    m_quick_ack;  // sets TCP_QUICKACK after each read
   };
 
  public:
@@ -279,16 +377,30 @@ class stream : public detail::itf::connected_writable
   void initialize(const cool::ng::net::ip::address& addr_
                 , uint16_t port_
                 , void* buf_
-                , std::size_t bufsz_);
+                , std::size_t bufsz_
+                , const socket_options& opts_);
+  void initialize(const local_endpoint& ep_
+                , void* buf_
+                , std::size_t bufsz_
+                , const socket_options& opts_);
   void initialize(cool::ng::net::handle h_);
-  void initialize(void* buf_, std::size_t bufsz_);
+  void initialize(void* buf_, std::size_t bufsz_, const socket_options& opts_);
   void set_handle(cool::ng::net::handle h_) override;
   void shutdown() override;
   const std::string& name() const override { return named::name(); }
 
   void write(const void* data, std::size_t size) override;
+  void write(const const_buffer* bufs, std::size_t count) override;
+  void write(std::vector<uint8_t>&& data) override;
   void connect(const cool::ng::net::ip::address& addr_, uint16_t port_) override;
+  void connect(const local_endpoint& ep_) override;
   void disconnect() override;
+  void read_budget(std::size_t bytes_, std::size_t reads_) override;
+  void write_handle(cool::ng::net::handle h_) override;
+  cool::ng::net::handle received_handle() override;
+  void watermarks(std::size_t high_, std::size_t low_, bool pause_read_) override;
+  void stats(stream_stats& s_) const override;
+  void aggregate(const stream_probe::ptr& probe_) override;
 
  private:
   static void on_rd_cancel(void* ctx);
@@ -296,32 +408,107 @@ class stream : public detail::itf::connected_writable
   static void on_rd_event(void* ctx);
   static void on_wr_event(void* ctx);
 
-  void create_write_source(cool::ng::net::handle h_, bool start_ = true);
+  void create_write_source(const std::shared_ptr<shared_handle>& h_, bool start_ = true);
   bool cancel_write_source(context*&);
   bool cancel_read_source(rd_context*&);
 
-  void create_read_source(cool::ng::net::handle h_, void* buf_, std::size_t bufsz_);
+  void connect(int family_, const sockaddr* addr_, socklen_t size_);
+  void create_read_source(const std::shared_ptr<shared_handle>& h_, void* buf_, std::size_t bufsz_);
+  ssize_t receive(rd_context* ctx, void* buf_, std::size_t size_);
   void process_connecting_event(context* ctx, std::size_t size);
-  void process_disconnect_event();
+  void process_disconnect_event(const std::error_code& err_ = cool::ng::error::no_error());
   void process_write_event(context* ctx, std::size_t size);
+  void process_read(rd_context* ctx, void* buf, std::size_t size);
+  void start_write(bool was_empty_);
+  void process_flow(bool blocked_);
 
  private:
   std::atomic<state>                   m_state;
   std::weak_ptr<async::impl::executor> m_executor; // to get the diapatch queue
   cb::stream::weak_ptr                 m_handler;  // handler for user events
+  socket_options                       m_options;
 
   // reader part
   std::atomic<rd_context*> m_reader;
   void*                    m_buf;       // temp store for read buffer
   std::size_t              m_size;      // temp store for read buffer size
+  std::atomic<std::size_t> m_rd_budget_bytes;  // max bytes read per read event
+  std::atomic<std::size_t> m_rd_budget_reads;  // max reads per read event
+  std::mutex               m_rcv_mutex;
+  std::deque<cool::ng::net::handle> m_rcv_handles;  // passed handles not yet taken
 
   // writer part
   std::atomic<context*> m_writer;
-  std::atomic<bool>     m_wr_busy;
-  const uint8_t*        m_wr_data;
-  std::size_t           m_wr_size;
-  std::size_t           m_wr_pos;
+  write_queue           m_wr_queue;
+  std::atomic<bool>     m_pause_read;  // suspend reader while write queue is blocked
+
+  // statistics
+  const stream_probe::ptr m_probe;
+  uint64_t                m_connect_start;  // clock_us() at the start of connect
+};
+
+
+/*
+ * The datagram implementation class is kept alive by its parent, the
+ * detail::datagram class template, and by the context of the dispatch read
+ * event source, which is deleted in the cancel callback.
+ */
+class datagram : public detail::itf::datagram
+               , public cool::ng::util::named
+               , public cool::ng::util::self_aware<datagram>
+{
+  struct context
+  {
+    context(const datagram::ptr& d_
+          , const std::shared_ptr<async::impl::executor>& ex_
+          , ::cool::ng::net::handle h_);
+
+    static void on_cancel(void* ctx);
+    static void on_event(void* ctx);
+    std::size_t receive(std::size_t& count_);
+
+    datagram::ptr                 m_datagram;
+    dispatch_source               m_source;
+    ::cool::ng::net::handle       m_handle;
+
+    // receive buffers and descriptors, reused for all batches
+    std::vector<uint8_t>          m_buffer;
+    std::vector<datagram_message> m_msgs;
+#if defined(LINUX_TARGET)
+    std::vector<::mmsghdr>        m_hdrs;
+    std::vector<::iovec>          m_iovs;
+    std::vector<sockaddr_storage> m_addrs;
+#endif
+  };
+
+ public:
+  datagram(const std::shared_ptr<async::impl::executor>& ex_
+         , const cb::datagram::weak_ptr& cb_);
+  ~datagram();
 
+  void initialize(const cool::ng::net::ip::address& addr_
+                , uint16_t port_
+                , std::size_t batch_
+                , std::size_t size_
+                , const socket_options& opts_);
+
+  // datagram interface
+  std::size_t send(const datagram_message* msgs_, std::size_t count_) override;
+  void join(const cool::ng::net::ip::address& group_) override;
+  void leave(const cool::ng::net::ip::address& group_) override;
+  void shutdown() override;
+  const std::string& name() const override { return named::name(); }
+
+ private:
+  void membership(const cool::ng::net::ip::address& group_, bool join_);
+
+ private:
+  std::atomic<context*>   m_context;
+  ::cool::ng::net::handle m_handle;
+  std::size_t             m_batch;     // max datagrams per system call
+  std::size_t             m_size;      // max size of received datagram
+  cb::datagram::weak_ptr  m_handler;
+  std::weak_ptr<async::impl::executor> m_exec;
 };
 
 } } } } } // namespace
@@ -23,7 +23,9 @@
 
 #include "cool/ng/async/runner.h"
 #include "cool/ng/exception.h"
+#include "cool/ng/impl/async/task.h"
 #include "executor.h"
+#include "src/async/buffer_pool.h"
 
 namespace cool { namespace ng { namespace async { namespace impl {
 
@@ -31,6 +33,7 @@ executor::executor(RunPolicy policy_)
     : named("si.digiverse.ng.cool.runner")
     , m_is_system(false)
     , m_active(true)
+    , m_read_pool(std::make_shared<net::impl::buffer_pool>())
 {
 #if defined(OSX_TARGET)
   if (policy_ == RunPolicy::CONCURRENT)
@@ -51,10 +54,58 @@ void executor::run(detail::context_stack* ctx_)
   ::dispatch_async_f(m_queue, ctx_, task_executor);
 }
 
+// the deferred run hands its stack to the task executor when the delay
+// expires, unless it was cancelled in the meantime
+void executor::run_after(uint64_t delay_, const std::shared_ptr<detail::deferred>& d_)
+{
+  ::dispatch_after_f(
+      ::dispatch_time(DISPATCH_TIME_NOW, static_cast<int64_t>(delay_ * 1000))
+    , m_queue
+    , new std::shared_ptr<detail::deferred>(d_)
+    , deferred_executor);
+}
+
+// executor for task::run_after() and task::run_at()
+void executor::deferred_executor(void* arg_)
+{
+  auto d = static_cast<std::shared_ptr<detail::deferred>*>(arg_);
+  auto stack = (*d)->take();
+  delete d;
+  if (stack != nullptr)
+    task_executor(stack);
+}
+
+void executor::post(const std::function<void()>& f_)
+{
+  ::dispatch_async_f(m_queue, new std::function<void()>(f_), function_executor);
+}
+
+void executor::post_after(uint64_t delay_, const std::function<void()>& f_)
+{
+  ::dispatch_after_f(
+      ::dispatch_time(DISPATCH_TIME_NOW, static_cast<int64_t>(delay_ * 1000))
+    , m_queue
+    , new std::function<void()>(f_)
+    , function_executor);
+}
+
+// executor for work posted by the library internals
+void executor::function_executor(void* arg_)
+{
+  auto f = static_cast<std::function<void()>*>(arg_);
+  try { (*f)(); } catch (...) { /* noop */ }
+  delete f;
+}
+
 // executor for task::run()
 void executor::task_executor(void* arg_)
 {
   auto ctx = static_cast<detail::context_stack*>(arg_);
+  if (ctx->cancelled())
+  {
+    delete ctx;
+    return;
+  }
 
   auto r = ctx->top()->get_runner().lock();
   if (r)
@@ -62,8 +113,15 @@ void executor::task_executor(void* arg_)
     ctx->top()->entry_point(r, ctx->top());
     if (ctx->empty())
       delete ctx;
-    else
-      r->impl()->run(ctx);
+    else if (!ctx->top()->suspend())
+    {
+      // the next context may belong to a different runner
+      r = ctx->top()->get_runner().lock();
+      if (r)
+        r->impl()->run(ctx);
+      else
+        delete ctx;
+    }
   }
   else
     delete ctx;
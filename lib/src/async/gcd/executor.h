@@ -26,12 +26,18 @@
 
 #include <atomic>
 #include <memory>
+#include <functional>
 #include <dispatch/dispatch.h>
 #include "cool/ng/bases.h"
 #include "cool/ng/async/runner.h"
 #include "cool/ng/impl/async/context.h"
 
-namespace cool { namespace ng { namespace async { namespace impl {
+namespace cool { namespace ng { namespace async {
+
+namespace detail { class deferred; }
+namespace net { namespace impl { class buffer_pool; } }
+
+namespace impl {
 
 class executor : public ::cool::ng::util::named
 {
@@ -40,15 +46,22 @@ class executor : public ::cool::ng::util::named
   ~executor();
 
   void run(detail::context_stack*);
+  void run_after(uint64_t delay_, const std::shared_ptr<detail::deferred>&);
+  void post(const std::function<void()>&);
+  void post_after(uint64_t delay_, const std::function<void()>&);
   dispatch_queue_t queue() const { return m_queue; }
+  const std::shared_ptr<net::impl::buffer_pool>& read_pool() const { return m_read_pool; }
   
  private:
   static void task_executor(void*);
+  static void deferred_executor(void*);
+  static void function_executor(void*);
 
  private:
   const bool        m_is_system;
   std::atomic<bool> m_active;
   dispatch_queue_t  m_queue;
+  std::shared_ptr<net::impl::buffer_pool> m_read_pool;
 };
 
 } } } }// namespace
@@ -65,5 +65,18 @@ void kickstart(context_stack* ctx_)
   aux->impl()->run(ctx_);
 }
 
+void kickstart_after(const std::shared_ptr<deferred>& d_, uint64_t delay_)
+{
+  auto ctx = d_->top();
+  if (!ctx)
+    throw exception::no_context();
+
+  auto aux = ctx->get_runner().lock();
+  if (!aux)
+    throw exception::runner_not_available();
+
+  aux->impl()->run_after(delay_, d_);
+}
+
 }
 } } } // namespace
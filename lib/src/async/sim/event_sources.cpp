@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "cool/ng/error.h"
+#include "cool/ng/exception.h"
+
+#include "event_sources.h"
+
+namespace cool { namespace ng { namespace async {
+
+namespace exc = cool::ng::exception;
+
+// ==========================================================================
+// ======
+// ======
+// ====== Timer event source
+// ======
+// ======
+// ==========================================================================
+
+namespace impl {
+
+timer::timer(const std::weak_ptr<cb::timer>& t_
+           , uint64_t p_
+           , uint64_t)
+  : named("si.digiverse.ng.cool.timer")
+  , m_callback(t_)
+  , m_id(0)
+  , m_deadline(0)
+  , m_period(p_)
+  , m_oneshot(false)
+  , m_probe(timer_probe::create())
+{ /* noop */ }
+
+timer::~timer()
+{
+  disarm();
+}
+
+void timer::initialize(const std::shared_ptr<async::impl::executor>& ex_)
+{
+  m_executor = ex_;
+}
+
+void timer::period(uint64_t p_, uint64_t)
+{
+  if (p_ == 0)
+    throw exc::illegal_argument();
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_period = p_;
+}
+
+void timer::stats(async::timer_stats& s_) const
+{
+  if (m_probe)
+    m_probe->snapshot(s_);
+}
+
+void timer::shutdown()
+{
+  disarm();
+}
+
+void timer::start()
+{
+  disarm();
+  m_oneshot = false;
+  arm(sim::scheduler::instance().now() + m_period);
+}
+
+void timer::start_once(uint64_t d_)
+{
+  disarm();
+  m_oneshot = true;
+  arm(sim::scheduler::instance().now() + (d_ == 0 ? m_period : d_));
+}
+
+void timer::stop()
+{
+  disarm();
+}
+
+void timer::arm(uint64_t deadline_)
+{
+  std::weak_ptr<timer> self_ = self();
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_deadline = deadline_;
+  m_id = sim::scheduler::instance().arm(
+      deadline_
+    , [self_] ()
+      {
+        auto t = self_.lock();
+        if (t)
+          t->on_expired();
+      });
+}
+
+void timer::disarm()
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  if (m_id != 0)
+    sim::scheduler::instance().disarm(m_id);
+  m_id = 0;
+}
+
+// The scheduler calls this when the virtual clock reaches the deadline. The
+// next expiration is scheduled relative to the deadline, not the current
+// time, so the timer does not drift.
+void timer::on_expired()
+{
+  uint64_t next;
+  auto now = sim::scheduler::instance().now();
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    if (m_id == 0)
+      return;
+    if (m_probe)
+      m_probe->fired(m_deadline, now);
+    next = m_deadline + m_period;
+    if (m_oneshot)
+      m_id = 0;
+  }
+  if (!m_oneshot)
+    arm(next);
+
+  auto ex = m_executor.lock();
+  if (!ex)
+    return;
+  std::weak_ptr<cb::timer> cb_ = m_callback;
+  auto probe = m_probe;
+  ex->post(
+    [cb_, probe, now] ()
+    {
+      auto cb = cb_.lock();
+      if (cb)
+      {
+        if (probe)
+          probe->dispatched(now, sim::scheduler::instance().now());
+        cb->expired();
+      }
+    });
+}
+
+} // namespace impl
+
+// ==========================================================================
+// ======
+// ======
+// ====== Signal event source
+// ======
+// ======
+// ==========================================================================
+
+namespace impl {
+
+signal::signal(const std::weak_ptr<cb::signal>& s_, signal_merge m_)
+  : named("si.digiverse.ng.cool.signal")
+  , m_callback(s_)
+  , m_merge(m_)
+  , m_pending(0)
+  , m_posted(false)
+{ /* noop */ }
+
+void signal::initialize(const std::shared_ptr<async::impl::executor>& ex_)
+{
+  m_executor = ex_;
+}
+
+void signal::trigger(unsigned long v_)
+{
+  if (m_merge == signal_merge::add)
+    m_pending.fetch_add(v_);
+  else
+    m_pending.fetch_or(v_);
+
+  // only the first trigger after the delivery posts another one
+  bool expected = false;
+  if (!m_posted.compare_exchange_strong(expected, true))
+    return;
+
+  auto ex = m_executor.lock();
+  if (!ex)
+    return;
+  signal::weak_ptr self_ = self();
+  ex->post(
+    [self_] ()
+    {
+      auto self = self_.lock();
+      if (self)
+        self->deliver();
+    });
+}
+
+// The posted flag is cleared before the pending value is taken, thus a
+// trigger racing with the delivery either lands in this delivery or posts
+// the next one.
+void signal::deliver()
+{
+  m_posted = false;
+  auto value = m_pending.exchange(0);
+  if (value == 0)
+    return;
+  auto cb = m_callback.lock();
+  if (cb)
+    cb->signalled(value);
+}
+
+void signal::shutdown()
+{ /* noop */ }
+
+} // namespace impl
+
+// ==========================================================================
+// ======
+// ======
+// ====== Network event sources
+// ======
+// ======
+// ==========================================================================
+namespace net { namespace impl {
+
+server::server(const std::shared_ptr<async::impl::executor>&
+             , const cb::server::weak_ptr&)
+    : named("si.digiverse.ng.cool.server")
+{ /* noop */ }
+
+void server::initialize(const cool::ng::net::ip::address&, uint16_t, const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void server::initialize(const local_endpoint&, const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void server::start()
+{ /* noop */ }
+
+void server::stop()
+{ /* noop */ }
+
+void server::shutdown()
+{ /* noop */ }
+
+void server::stats(stream_stats&) const
+{ /* noop */ }
+
+stream::stream(const std::weak_ptr<async::impl::executor>&
+             , const cb::stream::weak_ptr&)
+    : named("si.digiverse.ng.cool.stream")
+{ /* noop */ }
+
+void stream::initialize(const cool::ng::net::ip::address&
+                      , uint16_t
+                      , void*
+                      , std::size_t
+                      , const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::initialize(const local_endpoint&
+                      , void*
+                      , std::size_t
+                      , const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::initialize(cool::ng::net::handle)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::initialize(void*, std::size_t, const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::set_handle(cool::ng::net::handle)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::shutdown()
+{ /* noop */ }
+
+void stream::write(const void*, std::size_t)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::write(const const_buffer*, std::size_t)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::write(std::vector<uint8_t>&&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::read_budget(std::size_t, std::size_t)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::connect(const cool::ng::net::ip::address&, uint16_t)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::connect(const local_endpoint&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::write_handle(cool::ng::net::handle)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+cool::ng::net::handle stream::received_handle()
+{
+  return cool::ng::net::invalid_handle;
+}
+
+void stream::watermarks(std::size_t, std::size_t, bool)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::stats(stream_stats&) const
+{ /* noop */ }
+
+void stream::aggregate(const std::shared_ptr<stream_probe>&)
+{ /* noop */ }
+
+void stream::disconnect()
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+datagram::datagram(const std::shared_ptr<async::impl::executor>&
+                 , const cb::datagram::weak_ptr&)
+    : named("si.digiverse.ng.cool.datagram")
+{ /* noop */ }
+
+void datagram::initialize(const cool::ng::net::ip::address&
+                        , uint16_t
+                        , std::size_t
+                        , std::size_t
+                        , const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+std::size_t datagram::send(const datagram_message*, std::size_t)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void datagram::join(const cool::ng::net::ip::address&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void datagram::leave(const cool::ng::net::ip::address&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void datagram::shutdown()
+{ /* noop */ }
+
+} } } } } // namespace
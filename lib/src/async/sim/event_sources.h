@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_0b90af15_ae0c_42a4_8d3d_ec999e8fe7f9)
+#define      cool_ng_0b90af15_ae0c_42a4_8d3d_ec999e8fe7f9
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/ip_address.h"
+#include "cool/ng/impl/async/event_sources_types.h"
+
+#include "executor.h"
+#include "src/async/timer_stats.h"
+
+namespace cool { namespace ng { namespace async {
+
+// ==========================================================================
+// ======
+// ======
+// ====== Timer event source
+// ======
+// ======
+// ==========================================================================
+
+namespace impl {
+
+// Timer of the simulation platform. Expirations are scheduled on the virtual
+// clock of the simulation scheduler and the expired() callback is posted
+// to the timer's executor.
+class timer : public cool::ng::util::named
+            , public detail::itf::timer
+            , public cool::ng::util::self_aware<timer>
+{
+ public:
+  timer(const std::weak_ptr<cb::timer>& t_
+      , uint64_t p_
+      , uint64_t l_);
+  ~timer();
+
+  void initialize(const std::shared_ptr<async::impl::executor>& ex_);
+  // detail::itf::timer
+  void start() override;
+  void start_once(uint64_t d_) override;
+  void stop() override;
+  void period(uint64_t p_, uint64_t l_) override;
+  void stats(async::timer_stats& s_) const override;
+  void shutdown() override;
+  const std::string& name() const override
+  {
+    return named::name();
+  }
+
+ private:
+  void arm(uint64_t deadline_);
+  void disarm();
+  void on_expired();
+
+ private:
+  const std::weak_ptr<cb::timer>       m_callback;
+  std::weak_ptr<async::impl::executor> m_executor;
+  std::mutex                           m_mutex;
+  uint64_t                             m_id;      // 0 when not armed
+  uint64_t                             m_deadline;
+  uint64_t                             m_period;
+  bool                                 m_oneshot;
+  const timer_probe::ptr               m_probe;
+};
+
+} // namespace impl
+
+// ==========================================================================
+// ======
+// ======
+// ====== Signal event source
+// ======
+// ======
+// ==========================================================================
+
+namespace impl {
+
+// Signal of the simulation platform. The triggers merge their values into
+// the pending value and the first trigger after the delivery posts the
+// delivery to the signal's executor.
+class signal : public cool::ng::util::named
+             , public detail::itf::signal
+             , public cool::ng::util::self_aware<signal>
+{
+ public:
+  signal(const std::weak_ptr<cb::signal>& s_, signal_merge m_);
+
+  void initialize(const std::shared_ptr<async::impl::executor>& ex_);
+  // detail::itf::signal
+  void trigger(unsigned long v_) override;
+  void shutdown() override;
+  const std::string& name() const override
+  {
+    return named::name();
+  }
+
+ private:
+  void deliver();
+
+ private:
+  const std::weak_ptr<cb::signal>      m_callback;
+  const signal_merge                   m_merge;
+  std::weak_ptr<async::impl::executor> m_executor;
+  std::atomic<unsigned long>           m_pending;
+  std::atomic<bool>                    m_posted;
+};
+
+} // namespace impl
+
+// ==========================================================================
+// ======
+// ======
+// ====== Network event sources
+// ======
+// ======
+// ==========================================================================
+namespace net { namespace impl {
+
+// Network event sources are not available on the simulation platform. The
+// classes exist to satisfy the common factory methods; their initialization
+// throws operation_failed with not_available error code.
+class server : public detail::itf::server
+             , public cool::ng::util::named
+             , public cool::ng::util::self_aware<server>
+{
+ public:
+  server(const std::shared_ptr<async::impl::executor>& ex_
+       , const cb::server::weak_ptr& cb_);
+
+  void initialize(const cool::ng::net::ip::address& addr_
+                , uint16_t port_
+                , const socket_options& opts_);
+  void initialize(const local_endpoint& ep_, const socket_options& opts_);
+
+  // startable interface
+  void start() override;
+  void stop() override;
+  void shutdown() override;
+  const std::string& name() const override { return named::name(); }
+  void stats(stream_stats& s_) const override;
+};
+
+class stream : public detail::itf::connected_writable
+             , public cool::ng::util::named
+             , public cool::ng::util::self_aware<stream>
+{
+ public:
+  stream(const std::weak_ptr<async::impl::executor>& ex_
+       , const cb::stream::weak_ptr& cb_);
+
+  void initialize(const cool::ng::net::ip::address& addr_
+                , uint16_t port_
+                , void* buf_
+                , std::size_t bufsz_
+                , const socket_options& opts_);
+  void initialize(const local_endpoint& ep_
+                , void* buf_
+                , std::size_t bufsz_
+                , const socket_options& opts_);
+  void initialize(cool::ng::net::handle h_);
+  void initialize(void* buf_, std::size_t bufsz_, const socket_options& opts_);
+  void set_handle(cool::ng::net::handle h_) override;
+  void shutdown() override;
+  const std::string& name() const override { return named::name(); }
+
+  void write(const void* data, std::size_t size) override;
+  void write(const const_buffer* bufs, std::size_t count) override;
+  void write(std::vector<uint8_t>&& data) override;
+  void connect(const cool::ng::net::ip::address& addr_, uint16_t port_) override;
+  void connect(const local_endpoint& ep_) override;
+  void disconnect() override;
+  void read_budget(std::size_t bytes_, std::size_t reads_) override;
+  void write_handle(cool::ng::net::handle h_) override;
+  cool::ng::net::handle received_handle() override;
+  void watermarks(std::size_t high_, std::size_t low_, bool pause_read_) override;
+  void stats(stream_stats& s_) const override;
+  void aggregate(const std::shared_ptr<stream_probe>& probe_) override;
+};
+
+
+class datagram : public detail::itf::datagram
+               , public cool::ng::util::named
+               , public cool::ng::util::self_aware<datagram>
+{
+ public:
+  datagram(const std::shared_ptr<async::impl::executor>& ex_
+         , const cb::datagram::weak_ptr& cb_);
+
+  void initialize(const cool::ng::net::ip::address& addr_
+                , uint16_t port_
+                , std::size_t batch_
+                , std::size_t size_
+                , const socket_options& opts_);
+
+  std::size_t send(const datagram_message* msgs_, std::size_t count_) override;
+  void join(const cool::ng::net::ip::address& group_) override;
+  void leave(const cool::ng::net::ip::address& group_) override;
+  void shutdown() override;
+  const std::string& name() const override { return named::name(); }
+};
+
+} } } } } // namespace
+
+#endif
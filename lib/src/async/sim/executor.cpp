@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "cool/ng/async/runner.h"
+#include "cool/ng/async/simulation.h"
+#include "cool/ng/exception.h"
+#include "cool/ng/impl/async/task.h"
+#include "executor.h"
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+executor::executor(RunPolicy)
+    : named("si.digiverse.ng.cool.runner")
+{
+  sim::scheduler::instance().attach(this);
+}
+
+executor::~executor()
+{
+  sim::scheduler::instance().detach(this);
+}
+
+void executor::run(detail::context_stack* ctx_)
+{
+  sim::scheduler::instance().post(this, ctx_);
+}
+
+void executor::post(const std::function<void()>& cb_)
+{
+  sim::scheduler::instance().post(this, cb_);
+}
+
+void executor::post_after(uint64_t delay_, const std::function<void()>& cb_)
+{
+  auto& s = sim::scheduler::instance();
+  s.arm(s.now() + delay_, cb_);
+}
+
+void executor::run_after(uint64_t delay_, const std::shared_ptr<detail::deferred>& d_)
+{
+  auto& s = sim::scheduler::instance();
+  s.arm(
+      s.now() + delay_
+    , [d_] ()
+      {
+        auto stack = d_->take();
+        if (stack != nullptr)
+          detail::resume(stack);
+      });
+}
+
+// executor for task::run()
+void executor::task_executor(detail::context_stack* ctx_)
+{
+  if (ctx_->cancelled())
+  {
+    delete ctx_;
+    return;
+  }
+
+  auto r = ctx_->top()->get_runner().lock();
+  if (r)
+  {
+    try { ctx_->top()->entry_point(r, ctx_->top()); } catch (...) { /* noop */ }
+    if (ctx_->empty())
+      delete ctx_;
+    else if (!ctx_->top()->suspend())
+    {
+      // the next context may belong to a different runner
+      r = ctx_->top()->get_runner().lock();
+      if (r)
+        r->impl()->run(ctx_);
+      else
+        delete ctx_;
+    }
+  }
+  else
+    delete ctx_;
+}
+
+namespace sim {
+
+scheduler& scheduler::instance()
+{
+  static scheduler the_scheduler;
+  return the_scheduler;
+}
+
+scheduler::scheduler() : m_now(0), m_next_id(1)
+{ /* noop */ }
+
+void scheduler::attach(executor* ex_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_queues.push_back(queue{ ex_, std::deque<work>() });
+}
+
+void scheduler::detach(executor* ex_)
+{
+  std::deque<work> orphans;
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    for (auto it = m_queues.begin(); it != m_queues.end(); ++it)
+    {
+      if (it->m_executor == ex_)
+      {
+        orphans.swap(it->m_work);
+        m_queues.erase(it);
+        break;
+      }
+    }
+  }
+  for (auto& w : orphans)
+    delete w.m_stack;
+}
+
+void scheduler::post(executor* ex_, detail::context_stack* stack_)
+{
+  post(ex_, work{ stack_, std::function<void()>() });
+}
+
+void scheduler::post(executor* ex_, const std::function<void()>& cb_)
+{
+  post(ex_, work{ nullptr, cb_ });
+}
+
+void scheduler::post(executor* ex_, const work& w_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  for (auto& q : m_queues)
+  {
+    if (q.m_executor == ex_)
+    {
+      q.m_work.push_back(w_);
+      return;
+    }
+  }
+  l.unlock();
+  delete w_.m_stack;
+}
+
+uint64_t scheduler::arm(uint64_t deadline_, const std::function<void()>& fire_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  auto id = m_next_id++;
+  m_timers[timer_key(deadline_, id)] = fire_;
+  m_deadlines[id] = deadline_;
+  return id;
+}
+
+void scheduler::disarm(uint64_t id_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  auto it = m_deadlines.find(id_);
+  if (it == m_deadlines.end())
+    return;
+  m_timers.erase(timer_key(it->second, id_));
+  m_deadlines.erase(it);
+}
+
+uint64_t scheduler::now() const
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  return m_now;
+}
+
+void scheduler::seed(uint64_t seed_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_rng.seed(seed_);
+}
+
+// Runs one work item of one of the executors with pending work. The executor
+// is chosen by the seeded random generator, thus the order in which the work
+// of different executors interleaves is reproducible for the given seed.
+bool scheduler::step()
+{
+  work w;
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    std::vector<std::size_t> ready;
+    for (std::size_t i = 0; i < m_queues.size(); ++i)
+      if (!m_queues[i].m_work.empty())
+        ready.push_back(i);
+    if (ready.empty())
+      return false;
+
+    auto& q = m_queues[ready[m_rng() % ready.size()]];
+    w = q.m_work.front();
+    q.m_work.pop_front();
+  }
+
+  if (w.m_stack != nullptr)
+    executor::task_executor(w.m_stack);
+  else
+  {
+    try { w.m_callback(); } catch (...) { /* noop */ }
+  }
+  return true;
+}
+
+std::size_t scheduler::run()
+{
+  std::size_t count = 0;
+  while (step())
+    ++count;
+  return count;
+}
+
+std::size_t scheduler::advance(uint64_t interval_)
+{
+  uint64_t target;
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    target = m_now + interval_;
+  }
+
+  auto count = run();
+  for ( ; ; )
+  {
+    std::function<void()> fire;
+    {
+      std::unique_lock<std::mutex> l(m_mutex);
+      if (m_timers.empty() || m_timers.begin()->first.first > target)
+      {
+        m_now = target;
+        break;
+      }
+      auto it = m_timers.begin();
+      m_now = it->first.first;
+      fire = it->second;
+      m_deadlines.erase(it->first.second);
+      m_timers.erase(it);
+    }
+    try { fire(); } catch (...) { /* noop */ }
+    count += run();
+  }
+  return count;
+}
+
+} // namespace sim
+
+} // namespace impl
+
+namespace simulation {
+
+void seed(uint64_t seed_)
+{
+  impl::sim::scheduler::instance().seed(seed_);
+}
+
+uint64_t now()
+{
+  return impl::sim::scheduler::instance().now();
+}
+
+std::size_t run()
+{
+  return impl::sim::scheduler::instance().run();
+}
+
+std::size_t advance(uint64_t interval_)
+{
+  return impl::sim::scheduler::instance().advance(interval_);
+}
+
+} // namespace simulation
+
+} } } // namespace
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_f49d5284_6faf_4537_afde_edc28e315f1b)
+#define      cool_ng_f49d5284_6faf_4537_afde_edc28e315f1b
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <map>
+#include <random>
+#include <functional>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/async/runner.h"
+#include "cool/ng/impl/async/context.h"
+
+namespace cool { namespace ng { namespace async {
+
+namespace detail { class deferred; }
+
+namespace impl {
+
+namespace sim { class scheduler; }
+
+// Executor of the simulation platform. All executors share the single
+// scheduler which runs their work on the thread that drives the simulation,
+// against the virtual clock.
+class executor : public ::cool::ng::util::named
+{
+ public:
+  executor(RunPolicy policy_);
+  ~executor();
+
+  void run(detail::context_stack*);
+  void post(const std::function<void()>&);
+  void post_after(uint64_t delay_, const std::function<void()>&);
+  void run_after(uint64_t delay_, const std::shared_ptr<detail::deferred>&);
+
+ private:
+  friend class sim::scheduler;
+  static void task_executor(detail::context_stack*);
+};
+
+namespace sim {
+
+class scheduler
+{
+  struct work
+  {
+    detail::context_stack* m_stack;
+    std::function<void()>  m_callback;
+  };
+  struct queue
+  {
+    executor*        m_executor;
+    std::deque<work> m_work;
+  };
+  using timer_key = std::pair<uint64_t, uint64_t>;   // deadline, id
+
+ public:
+  static scheduler& instance();
+
+  void attach(executor* ex_);
+  void detach(executor* ex_);
+  void post(executor* ex_, detail::context_stack* stack_);
+  void post(executor* ex_, const std::function<void()>& cb_);
+
+  // one-shot timer firing at the virtual time deadline_; returns timer id
+  uint64_t arm(uint64_t deadline_, const std::function<void()>& fire_);
+  void disarm(uint64_t id_);
+
+  uint64_t now() const;
+  void seed(uint64_t seed_);
+  std::size_t run();
+  std::size_t advance(uint64_t interval_);
+
+ private:
+  scheduler();
+  void post(executor* ex_, const work& w_);
+  bool step();
+
+ private:
+  mutable std::mutex                         m_mutex;
+  std::vector<queue>                         m_queues;  // in order of creation
+  std::mt19937_64                            m_rng;
+  uint64_t                                   m_now;
+  uint64_t                                   m_next_id;
+  std::map<timer_key, std::function<void()>> m_timers;
+  std::map<uint64_t, uint64_t>               m_deadlines;  // id -> deadline
+};
+
+} // namespace sim
+
+} } } }// namespace
+
+#endif
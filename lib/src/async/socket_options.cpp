@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if defined(WINDOWS_TARGET)
+# include <winsock2.h>
+# include <ws2tcpip.h>
+# include <mstcpip.h>
+#else
+# include <sys/types.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <netinet/ip.h>
+# include <netinet/tcp.h>
+#endif
+
+#include "cool/ng/exception.h"
+#include "socket_options.h"
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+namespace exc = cool::ng::exception;
+
+namespace {
+
+void set_option(cool::ng::net::handle h_, int level_, int name_, int value_)
+{
+  if (value_ < 0)
+    return;
+
+  if (::setsockopt(h_, level_, name_, reinterpret_cast<const char*>(&value_), sizeof(value_)) != 0)
+    throw exc::socket_failure();
+}
+
+} // anonymous namespace
+
+void apply_options(cool::ng::net::handle h_, const socket_options& opts_)
+{
+  set_option(h_, SOL_SOCKET, SO_RCVBUF, opts_.rcv_buf);
+  set_option(h_, SOL_SOCKET, SO_SNDBUF, opts_.snd_buf);
+  set_option(h_, SOL_SOCKET, SO_KEEPALIVE, opts_.keep_alive);
+#if defined(SO_BUSY_POLL)
+  set_option(h_, SOL_SOCKET, SO_BUSY_POLL, opts_.busy_poll);
+#endif
+
+  if (opts_.no_delay < 0 && opts_.keep_idle < 0 && opts_.keep_interval < 0
+      && opts_.keep_count < 0 && opts_.quick_ack < 0 && opts_.tos < 0)
+    return;
+
+  // the protocol options depend on the address family of the socket and
+  // do not apply to the local, Unix domain, sockets
+  sockaddr_storage addr;
+  socklen_t len = sizeof(addr);
+  if (::getsockname(h_, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+    throw exc::socket_failure();
+  if (addr.ss_family != AF_INET && addr.ss_family != AF_INET6)
+    return;
+
+  set_option(h_, IPPROTO_TCP, TCP_NODELAY, opts_.no_delay);
+#if defined(TCP_KEEPIDLE)
+  set_option(h_, IPPROTO_TCP, TCP_KEEPIDLE, opts_.keep_idle);
+#elif defined(TCP_KEEPALIVE)   // OSX name for the same option
+  set_option(h_, IPPROTO_TCP, TCP_KEEPALIVE, opts_.keep_idle);
+#endif
+#if defined(TCP_KEEPINTVL)
+  set_option(h_, IPPROTO_TCP, TCP_KEEPINTVL, opts_.keep_interval);
+#endif
+#if defined(TCP_KEEPCNT)
+  set_option(h_, IPPROTO_TCP, TCP_KEEPCNT, opts_.keep_count);
+#endif
+#if defined(TCP_QUICKACK)
+  set_option(h_, IPPROTO_TCP, TCP_QUICKACK, opts_.quick_ack);
+#endif
+
+  if (addr.ss_family == AF_INET6)
+  {
+#if defined(IPV6_TCLASS)
+    set_option(h_, IPPROTO_IPV6, IPV6_TCLASS, opts_.tos);
+#endif
+  }
+  else
+  {
+    set_option(h_, IPPROTO_IP, IP_TOS, opts_.tos);
+  }
+}
+
+bool rearm_quick_ack(cool::ng::net::handle h_)
+{
+#if defined(TCP_QUICKACK)
+  int value = 1;
+  return ::setsockopt(h_, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value)) == 0;
+#else
+  (void) h_;
+  return false;
+#endif
+}
+
+} } } } } // namespace
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_2c7e95a4_d1f3_4b08_8e6a_5b90c3f1a7d2)
+#define      cool_ng_2c7e95a4_d1f3_4b08_8e6a_5b90c3f1a7d2
+
+#include "cool/ng/ip_address.h"
+#include "cool/ng/impl/async/event_sources_types.h"
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+// Sets the socket options that are not left at their default values; the
+// TCP and IP options are skipped for the local sockets. Throws socket_failure
+// if the platform rejects the option value.
+void apply_options(cool::ng::net::handle h_, const socket_options& opts_);
+
+// Sets TCP_QUICKACK again. Linux clears the option once the connection
+// leaves its quick acknowledgement mode, thus the streams that asked for it
+// set it after each read. Returns false if the option does not apply to the
+// socket or the platform, in which case there is no need to call it again.
+bool rearm_quick_ack(cool::ng::net::handle h_);
+
+} } } } } // namespace
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "stream_stats.h"
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+namespace {
+
+void add(timer_histogram& to_, const timer_histogram& from_)
+{
+  to_.count += from_.count;
+  to_.sum += from_.sum;
+  if (from_.max > to_.max)
+    to_.max = from_.max;
+  for (std::size_t i = 0; i < timer_histogram::size; ++i)
+    to_.buckets[i] += from_.buckets[i];
+}
+
+void add(stream_stats& to_, const stream_stats& from_)
+{
+  to_.connections += from_.connections;
+  to_.bytes_in += from_.bytes_in;
+  to_.bytes_out += from_.bytes_out;
+  to_.reads += from_.reads;
+  to_.writes += from_.writes;
+  to_.read_again += from_.read_again;
+  to_.write_again += from_.write_again;
+  to_.read_events += from_.read_events;
+  add(to_.connect_latency, from_.connect_latency);
+  add(to_.write_latency, from_.write_latency);
+}
+
+} // anonymous namespace
+
+stream_probe::stream_probe()
+  : m_connections(0)
+  , m_bytes_in(0)
+  , m_bytes_out(0)
+  , m_reads(0)
+  , m_writes(0)
+  , m_read_again(0)
+  , m_write_again(0)
+  , m_read_events(0)
+{ /* noop */ }
+
+stream_probe::~stream_probe()
+{
+  if (!m_parent)
+    return;
+
+  // moving the counters under the parent's lock keeps its snapshot from
+  // counting the stream twice or missing it
+  std::unique_lock<std::mutex> l(m_parent->m_mutex);
+  stream_stats s;
+  own_snapshot(s);
+  m_parent->add(s);
+  m_parent->m_children.erase(this);
+}
+
+void stream_probe::parent(const ptr& parent_)
+{
+  m_parent = parent_;
+  std::unique_lock<std::mutex> l(m_parent->m_mutex);
+  m_parent->m_children.insert(this);
+}
+
+void stream_probe::connected(uint64_t latency_)
+{
+  m_connections.fetch_add(1, std::memory_order_relaxed);
+  m_connect.record(latency_);
+}
+
+void stream_probe::accepted()
+{
+  m_connections.fetch_add(1, std::memory_order_relaxed);
+}
+
+void stream_probe::read(std::size_t size_)
+{
+  m_reads.fetch_add(1, std::memory_order_relaxed);
+  m_bytes_in.fetch_add(size_, std::memory_order_relaxed);
+}
+
+void stream_probe::read_again()
+{
+  m_read_again.fetch_add(1, std::memory_order_relaxed);
+}
+
+void stream_probe::read_event()
+{
+  m_read_events.fetch_add(1, std::memory_order_relaxed);
+}
+
+void stream_probe::write(std::size_t size_)
+{
+  m_writes.fetch_add(1, std::memory_order_relaxed);
+  m_bytes_out.fetch_add(size_, std::memory_order_relaxed);
+}
+
+void stream_probe::write_again()
+{
+  m_write_again.fetch_add(1, std::memory_order_relaxed);
+}
+
+void stream_probe::written(uint64_t latency_)
+{
+  m_written.record(latency_);
+}
+
+void stream_probe::snapshot(stream_stats& s_) const
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  own_snapshot(s_);
+  for (auto child : m_children)
+  {
+    stream_stats s;
+    child->own_snapshot(s);
+    impl::add(s_, s);
+  }
+}
+
+// must be called with the parent's mutex locked
+void stream_probe::add(const stream_stats& s_)
+{
+  m_connections.fetch_add(s_.connections, std::memory_order_relaxed);
+  m_bytes_in.fetch_add(s_.bytes_in, std::memory_order_relaxed);
+  m_bytes_out.fetch_add(s_.bytes_out, std::memory_order_relaxed);
+  m_reads.fetch_add(s_.reads, std::memory_order_relaxed);
+  m_writes.fetch_add(s_.writes, std::memory_order_relaxed);
+  m_read_again.fetch_add(s_.read_again, std::memory_order_relaxed);
+  m_write_again.fetch_add(s_.write_again, std::memory_order_relaxed);
+  m_read_events.fetch_add(s_.read_events, std::memory_order_relaxed);
+  m_connect.add(s_.connect_latency);
+  m_written.add(s_.write_latency);
+}
+
+void stream_probe::own_snapshot(stream_stats& s_) const
+{
+  s_.connections = m_connections.load(std::memory_order_relaxed);
+  s_.bytes_in = m_bytes_in.load(std::memory_order_relaxed);
+  s_.bytes_out = m_bytes_out.load(std::memory_order_relaxed);
+  s_.reads = m_reads.load(std::memory_order_relaxed);
+  s_.writes = m_writes.load(std::memory_order_relaxed);
+  s_.read_again = m_read_again.load(std::memory_order_relaxed);
+  s_.write_again = m_write_again.load(std::memory_order_relaxed);
+  s_.read_events = m_read_events.load(std::memory_order_relaxed);
+  m_connect.snapshot(s_.connect_latency);
+  m_written.snapshot(s_.write_latency);
+}
+
+} } } } } // namespace
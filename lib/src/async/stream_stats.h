@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_4d7a1c85_e36b_4f92_8b0d_a5c9e2f17b63)
+#define      cool_ng_4d7a1c85_e36b_4f92_8b0d_a5c9e2f17b63
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+#include "cool/ng/async/net/stream_stats.h"
+#include "timer_stats.h"
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+// Lock free recorder of the stream input/output statistics. The probe of
+// the server that accepted the stream is the parent probe and aggregates
+// its streams without taking part in their recordings: the snapshot of the
+// parent adds up the probes of the open streams, and the stream's probe
+// adds its counters to the parent when it is destroyed.
+class stream_probe
+{
+ public:
+  using ptr = std::shared_ptr<stream_probe>;
+
+ public:
+  stream_probe();
+  ~stream_probe();
+
+  // sets the parent probe; may only be called once
+  void parent(const ptr& parent_);
+
+  // the stream connected to its peer after latency_ microseconds
+  void connected(uint64_t latency_);
+  // the stream was accepted by the server
+  void accepted();
+  // a read system call returned size_ bytes, or failed if size_ is 0
+  void read(std::size_t size_);
+  // a read system call returned EAGAIN; counts in addition to read()
+  void read_again();
+  // the stream was woken up to read
+  void read_event();
+  // a write system call wrote size_ bytes, or failed if size_ is 0
+  void write(std::size_t size_);
+  // a write system call returned EAGAIN; counts in addition to write()
+  void write_again();
+  // the data queued latency_ microseconds ago was written
+  void written(uint64_t latency_);
+  void snapshot(stream_stats& s_) const;
+
+ private:
+  void add(const stream_stats& s_);
+  void own_snapshot(stream_stats& s_) const;
+
+ private:
+  ptr                   m_parent;
+  mutable std::mutex    m_mutex;     // guards the children
+  std::unordered_set<stream_probe*> m_children;
+  std::atomic<uint64_t> m_connections;
+  std::atomic<uint64_t> m_bytes_in;
+  std::atomic<uint64_t> m_bytes_out;
+  std::atomic<uint64_t> m_reads;
+  std::atomic<uint64_t> m_writes;
+  std::atomic<uint64_t> m_read_again;
+  std::atomic<uint64_t> m_write_again;
+  std::atomic<uint64_t> m_read_events;
+  async::impl::histogram_recorder m_connect;
+  async::impl::histogram_recorder m_written;
+};
+
+} } } } } // namespace
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <chrono>
+
+#include "lib/async/executor.h"
+#include "timer_stats.h"
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+uint64_t clock_us()
+{
+#if defined(COOL_ASYNC_PLATFORM_SIM)
+  return sim::scheduler::instance().now();
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// --------------------------------------------------------------------------
+// -----
+// ----- histogram_recorder
+// ------
+
+histogram_recorder::histogram_recorder() : m_count(0), m_sum(0), m_max(0)
+{
+  for (auto& b : m_buckets)
+    b = 0;
+}
+
+void histogram_recorder::record(uint64_t delay_)
+{
+  std::size_t index = 0;
+  for (auto d = delay_; d != 0 && index < timer_histogram::size - 1; d >>= 1)
+    ++index;
+
+  m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(delay_, std::memory_order_relaxed);
+
+  auto max = m_max.load(std::memory_order_relaxed);
+  while (delay_ > max && !m_max.compare_exchange_weak(max, delay_, std::memory_order_relaxed))
+    ;
+}
+
+void histogram_recorder::add(const timer_histogram& h_)
+{
+  for (std::size_t i = 0; i < timer_histogram::size; ++i)
+    m_buckets[i].fetch_add(h_.buckets[i], std::memory_order_relaxed);
+  m_count.fetch_add(h_.count, std::memory_order_relaxed);
+  m_sum.fetch_add(h_.sum, std::memory_order_relaxed);
+
+  auto max = m_max.load(std::memory_order_relaxed);
+  while (h_.max > max && !m_max.compare_exchange_weak(max, h_.max, std::memory_order_relaxed))
+    ;
+}
+
+void histogram_recorder::snapshot(timer_histogram& h_) const
+{
+  h_.count = m_count.load(std::memory_order_relaxed);
+  h_.sum = m_sum.load(std::memory_order_relaxed);
+  h_.max = m_max.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < timer_histogram::size; ++i)
+    h_.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------------------------
+// -----
+// ----- timer_probe
+// ------
+
+std::atomic<bool> timer_probe::m_enabled(false);
+
+timer_probe::ptr timer_probe::create()
+{
+  if (!m_enabled)
+    return ptr();
+  return std::make_shared<timer_probe>();
+}
+
+void timer_probe::enable(bool enable_)
+{
+  m_enabled = enable_;
+}
+
+timer_probe& timer_probe::aggregate()
+{
+  // never destroyed, timers may still fire at the exit
+  static timer_probe* the_aggregate = new timer_probe();
+  return *the_aggregate;
+}
+
+void timer_probe::fired(uint64_t scheduled_, uint64_t fired_, uint64_t missed_)
+{
+  auto delay = fired_ > scheduled_ ? fired_ - scheduled_ : 0;
+  m_fire.record(delay);
+  aggregate().m_fire.record(delay);
+  if (missed_ != 0)
+  {
+    m_missed.fetch_add(missed_, std::memory_order_relaxed);
+    aggregate().m_missed.fetch_add(missed_, std::memory_order_relaxed);
+  }
+}
+
+void timer_probe::dispatched(uint64_t fired_, uint64_t now_)
+{
+  auto delay = now_ > fired_ ? now_ - fired_ : 0;
+  m_dispatch.record(delay);
+  aggregate().m_dispatch.record(delay);
+}
+
+void timer_probe::snapshot(timer_stats& s_) const
+{
+  m_fire.snapshot(s_.fire_delay);
+  m_dispatch.snapshot(s_.dispatch_delay);
+  s_.missed = m_missed.load(std::memory_order_relaxed);
+}
+
+} } } } // namespace
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_2e8b4c17_9a6d_4f35_a0c1_d74e5b9f8a26)
+#define      cool_ng_2e8b4c17_9a6d_4f35_a0c1_d74e5b9f8a26
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+#include "cool/ng/async/timer_stats.h"
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+// Monotonic clock used by timer services and instrumentation, in
+// microseconds. Virtual time on the simulation platform.
+uint64_t clock_us();
+
+// Lock free counterpart of timer_histogram, with multiple writers
+class histogram_recorder
+{
+ public:
+  histogram_recorder();
+  void record(uint64_t delay_);
+  // adds the recordings of another histogram
+  void add(const timer_histogram& h_);
+  void snapshot(timer_histogram& h_) const;
+
+ private:
+  std::atomic<uint64_t> m_count;
+  std::atomic<uint64_t> m_sum;
+  std::atomic<uint64_t> m_max;
+  std::atomic<uint64_t> m_buckets[timer_histogram::size];
+};
+
+// Per-timer recorder of timer accuracy. Each recording also goes into the
+// process wide aggregate.
+class timer_probe
+{
+ public:
+  using ptr = std::shared_ptr<timer_probe>;
+
+ public:
+  timer_probe() : m_missed(0)
+  { /* noop */ }
+
+  // returns new probe if the instrumentation is enabled, empty ptr otherwise
+  static ptr create();
+  static void enable(bool enable_);
+  static timer_probe& aggregate();
+
+  // the platform timer scheduled to expire at scheduled_ fired at fired_ and
+  // coalesced missed_ earlier expirations
+  void fired(uint64_t scheduled_, uint64_t fired_, uint64_t missed_ = 0);
+  // the runner started the user Callable at now_ for the timer fired at fired_
+  void dispatched(uint64_t fired_, uint64_t now_);
+  void snapshot(timer_stats& s_) const;
+
+ private:
+  histogram_recorder    m_fire;
+  histogram_recorder    m_dispatch;
+  std::atomic<uint64_t> m_missed;
+  static std::atomic<bool> m_enabled;
+};
+
+} } } }// namespace
+
+#endif
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <map>
+#include <vector>
+#include <chrono>
+
+#include "cool/ng/exception.h"
+#include "cool/ng/impl/async/task.h"
+#include "timer_wheel.h"
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+// --------------------------------------------------------------------------
+// -----
+// ----- timer_wheel
+// ------
+
+timer_wheel::timer_wheel(uint64_t now_) : m_now(now_), m_size(0)
+{
+  for (auto& level : m_slots)
+    for (auto& head : level)
+      head.m_prev = head.m_next = &head;
+  for (auto& level : m_occupied)
+    for (auto& word : level)
+      word = 0;
+}
+
+void timer_wheel::insert(wheel_entry* e_)
+{
+  if (e_->m_expires <= m_now)
+    e_->m_expires = m_now + 1;
+  place(e_);
+  ++m_size;
+}
+
+void timer_wheel::remove(wheel_entry* e_)
+{
+  if (e_->linked())
+    unlink(e_);
+}
+
+void timer_wheel::skip(uint64_t now_)
+{
+  if (m_size != 0)
+    throw exception::invalid_state();
+  if (now_ > m_now)
+    m_now = now_;
+}
+
+void timer_wheel::unlink(wheel_entry* e_)
+{
+  // the only node left in the list is the list head of the slot
+  if (e_->m_prev == e_->m_next)
+  {
+    auto index = static_cast<std::size_t>(e_->m_next - &m_slots[0][0]);
+    m_occupied[index / slots][(index % slots) / 64] &= ~(static_cast<uint64_t>(1) << (index % 64));
+  }
+
+  e_->m_prev->m_next = e_->m_next;
+  e_->m_next->m_prev = e_->m_prev;
+  e_->m_prev = e_->m_next = nullptr;
+  --m_size;
+}
+
+unsigned timer_wheel::next_occupied(unsigned level_, unsigned from_) const
+{
+  for (unsigned d = 0; d < slots; )
+  {
+    auto slot = (from_ + d) & (slots - 1);
+    auto word = m_occupied[level_][slot / 64] >> (slot % 64);
+    if (word == 0)
+    {
+      d += 64 - slot % 64;   // to the start of the next word
+      continue;
+    }
+
+    while ((word & 1) == 0)
+    {
+      word >>= 1;
+      ++d;
+    }
+    return d < slots ? d : slots;
+  }
+  return slots;
+}
+
+uint64_t timer_wheel::next_due() const
+{
+  uint64_t due = 0;
+  for (unsigned l = 0; l < levels; ++l)
+  {
+    // the slot of the level becomes due on the tick its index in the level
+    // comes around with all lower level indices at zero
+    auto shift = bits * l;
+    auto base = m_now >> shift;
+    auto d = next_occupied(l, static_cast<unsigned>((base + 1) & (slots - 1)));
+    if (d == slots)
+      continue;
+
+    auto at = (base + 1 + d) << shift;
+    if (due == 0 || at < due)
+      due = at;
+  }
+  return due;
+}
+
+void timer_wheel::place(wheel_entry* e_)
+{
+  const uint64_t range = static_cast<uint64_t>(1) << (bits * levels);
+
+  auto at = e_->m_expires;
+  auto distance = at - m_now;
+  if (distance >= range)
+  {
+    at = m_now + range - 1;   // park in the top level
+    distance = range - 1;
+  }
+
+  unsigned level = 0;
+  while (level < levels - 1 && distance >= (static_cast<uint64_t>(1) << (bits * (level + 1))))
+    ++level;
+
+  auto slot = (at >> (bits * level)) & (slots - 1);
+  m_occupied[level][slot / 64] |= static_cast<uint64_t>(1) << (slot % 64);
+  auto head = &m_slots[level][slot];
+  e_->m_next = head;
+  e_->m_prev = head->m_prev;
+  head->m_prev->m_next = e_;
+  head->m_prev = e_;
+}
+
+void timer_wheel::cascade(unsigned level_)
+{
+  auto head = &m_slots[level_][(m_now >> (bits * level_)) & (slots - 1)];
+  if (head->m_next == head)
+    return;
+
+  // detach the whole slot list, then re-place the entries
+  auto slot = (m_now >> (bits * level_)) & (slots - 1);
+  m_occupied[level_][slot / 64] &= ~(static_cast<uint64_t>(1) << (slot % 64));
+  auto e = head->m_next;
+  head->m_prev->m_next = nullptr;
+  head->m_prev = head->m_next = head;
+
+  while (e != nullptr)
+  {
+    auto next = e->m_next;
+    place(e);
+    e = next;
+  }
+}
+
+// --------------------------------------------------------------------------
+// -----
+// ----- timer_service
+// ------
+
+timer_service& timer_service::instance()
+{
+  // never destroyed, ticks may still be in flight at the exit
+  static timer_service* the_service = new timer_service();
+  return *the_service;
+}
+
+timer_service::timer_service()
+    : m_wheel(clock() / tick)
+    , m_ticking(false)
+    , m_executor(std::make_shared<async::impl::executor>(RunPolicy::SEQUENTIAL))
+{ /* noop */ }
+
+uint64_t timer_service::clock()
+{
+  return clock_us();
+}
+
+uint64_t timer_service::to_ticks(uint64_t us_)
+{
+  auto ret = (us_ + tick - 1) / tick;
+  return ret == 0 ? 1 : ret;
+}
+
+// delay_ is in ticks
+void timer_service::start(wheel_timer* t_, bool oneshot_, uint64_t delay_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_wheel.remove(&t_->m_entry);
+  if (!m_ticking)
+    m_wheel.skip(clock() / tick);
+
+  t_->m_oneshot = oneshot_;
+  t_->m_entry.m_expires = m_wheel.now() + (delay_ == 0 ? t_->m_period : delay_);
+  m_wheel.insert(&t_->m_entry);
+  if (!m_ticking)
+  {
+    m_ticking = true;
+    schedule();
+  }
+}
+
+void timer_service::stop(wheel_timer* t_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_wheel.remove(&t_->m_entry);
+}
+
+void timer_service::period(wheel_timer* t_, uint64_t p_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  t_->m_period = to_ticks(p_);
+}
+
+void timer_service::schedule()
+{
+  m_executor->post_after(tick, [this] () { on_tick(); });
+}
+
+void timer_service::on_tick()
+{
+  using callbacks = std::vector<std::pair<std::weak_ptr<cb::timer>, timer_probe::ptr>>;
+  std::map<async::impl::executor*, std::pair<std::shared_ptr<async::impl::executor>, callbacks>> batches;
+
+  auto now = clock();
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    m_wheel.advance(
+        now / tick
+      , [this, now, &batches] (wheel_entry* e_)
+        {
+          auto t = static_cast<wheel_timer*>(e_->m_owner);
+          uint64_t missed = 0;
+          auto deadline = e_->m_expires;
+
+          if (!t->m_oneshot)
+          {
+            // periodic re-arm relative to the deadline; skip the missed periods
+            e_->m_expires += t->m_period;
+            if (e_->m_expires <= m_wheel.now())
+            {
+              missed = (m_wheel.now() - deadline) / t->m_period;
+              e_->m_expires = m_wheel.now() + t->m_period;
+            }
+            m_wheel.insert(e_);
+          }
+
+          if (t->m_probe)
+            t->m_probe->fired(deadline * tick, now, missed);
+
+          auto ex = t->m_executor.lock();
+          if (ex)
+          {
+            auto& batch = batches[ex.get()];
+            batch.first = ex;
+            batch.second.push_back(std::make_pair(t->m_callback, t->m_probe));
+          }
+        });
+
+    if (m_wheel.size() == 0)
+      m_ticking = false;
+    else
+      schedule();
+  }
+
+  for (auto& item : batches)
+  {
+    auto& cbs = item.second.second;
+    item.second.first->post(
+      [cbs, now] ()
+      {
+        for (auto& c : cbs)
+        {
+          auto cb = c.first.lock();
+          if (cb)
+          {
+            if (c.second)
+              c.second->dispatched(now, clock());
+            try { cb->expired(); } catch (...) { /* noop */ }
+          }
+        }
+      });
+  }
+}
+
+// --------------------------------------------------------------------------
+// -----
+// ----- wheel_timer
+// ------
+
+wheel_timer::wheel_timer(const std::weak_ptr<cb::timer>& t_, uint64_t p_)
+    : named("si.digiverse.ng.cool.timer")
+    , m_entry(this)
+    , m_callback(t_)
+    , m_period(timer_service::to_ticks(p_))
+    , m_oneshot(false)
+    , m_probe(timer_probe::create())
+{ /* noop */ }
+
+wheel_timer::~wheel_timer()
+{
+  timer_service::instance().stop(this);
+}
+
+void wheel_timer::initialize(const std::shared_ptr<async::impl::executor>& ex_)
+{
+  m_executor = ex_;
+}
+
+void wheel_timer::start()
+{
+  timer_service::instance().start(this, false, 0);
+}
+
+void wheel_timer::start_once(uint64_t d_)
+{
+  timer_service::instance().start(this, true, d_ == 0 ? 0 : timer_service::to_ticks(d_));
+}
+
+void wheel_timer::stop()
+{
+  timer_service::instance().stop(this);
+}
+
+void wheel_timer::period(uint64_t p_, uint64_t)
+{
+  if (p_ == 0)
+    throw exception::illegal_argument();
+  timer_service::instance().period(this, p_);
+}
+
+void wheel_timer::stats(async::timer_stats& s_) const
+{
+  if (m_probe)
+    m_probe->snapshot(s_);
+}
+
+void wheel_timer::shutdown()
+{
+  stop();
+}
+
+} } } } // namespace
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_5c1e0b7a_3f42_4d7e_9a61_2b8f0d4c6e19)
+#define      cool_ng_5c1e0b7a_3f42_4d7e_9a61_2b8f0d4c6e19
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/impl/async/event_sources_types.h"
+#include "lib/async/executor.h"
+#include "timer_stats.h"
+
+namespace cool { namespace ng { namespace async { namespace impl {
+
+// ==========================================================================
+// ======
+// ======
+// ====== Hierarchical timing wheel
+// ======
+// ======
+// ==========================================================================
+
+// Timer entry, intrusively linked into one of the timing wheel slots. The
+// expiration time is expressed in wheel ticks.
+struct wheel_entry
+{
+  wheel_entry(void* owner_ = nullptr)
+      : m_prev(nullptr), m_next(nullptr), m_expires(0), m_owner(owner_)
+  { /* noop */ }
+  bool linked() const { return m_next != nullptr; }
+
+  wheel_entry* m_prev;
+  wheel_entry* m_next;
+  uint64_t     m_expires;
+  void*        m_owner;
+};
+
+// Four levels of 256 slots each. An entry is placed into the lowest level
+// that covers its distance from the current tick and is cascaded to the
+// level below when the wheel reaches its slot. Both insert and remove are
+// O(1). Each level keeps a bitmap of its occupied slots, which lets advance
+// jump over the ticks where no slot is due, thus advance is O(levels) per
+// due slot, regardless of the distance, plus the work of cascading and
+// expiring. Entries further away than the wheel covers are parked in the
+// top level and re-cascaded until they come into the range. Not thread safe.
+class timer_wheel
+{
+ public:
+  static const unsigned bits   = 8;
+  static const unsigned slots  = 1 << bits;
+  static const unsigned levels = 4;
+
+ public:
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator =(const timer_wheel&) = delete;
+
+  explicit timer_wheel(uint64_t now_);
+
+  // inserts entry; entries that expire in the past expire on the next tick
+  void insert(wheel_entry* e_);
+  void remove(wheel_entry* e_);
+  // moves the empty wheel forward to the tick now_ in a single step
+  void skip(uint64_t now_);
+  // advances the wheel to the tick now_ and calls expired_ for each expired
+  // entry; the entry is unlinked before the call and may be reinserted
+  template <typename CallbackT>
+  void advance(uint64_t now_, const CallbackT& expired_)
+  {
+    while (m_now < now_)
+    {
+      auto due = next_due();
+      if (due == 0 || due > now_)
+      {
+        m_now = now_;
+        break;
+      }
+
+      m_now = due;
+      for (unsigned l = 1; l < levels; ++l)
+      {
+        if (((m_now >> (bits * (l - 1))) & (slots - 1)) != 0)
+          break;
+        cascade(l);
+      }
+
+      auto head = &m_slots[0][m_now & (slots - 1)];
+      while (head->m_next != head)
+      {
+        auto e = head->m_next;
+        unlink(e);
+        expired_(e);
+      }
+    }
+  }
+  uint64_t now() const     { return m_now; }
+  std::size_t size() const { return m_size; }
+
+ private:
+  void place(wheel_entry* e_);
+  void cascade(unsigned level_);
+  void unlink(wheel_entry* e_);
+  // the first tick after now at which a slot of any level is due, either to
+  // expire or to cascade its entries; 0 if all slots are empty
+  uint64_t next_due() const;
+  // distance from from_ to the first occupied slot of the level at or after
+  // from_, wrapping around; slots if there are none
+  unsigned next_occupied(unsigned level_, unsigned from_) const;
+
+ private:
+  static const unsigned words = slots / 64;
+
+  uint64_t    m_now;
+  std::size_t m_size;
+  wheel_entry m_slots[levels][slots];      // list heads
+  uint64_t    m_occupied[levels][words];   // bitmaps of non-empty slots
+};
+
+// ==========================================================================
+// ======
+// ======
+// ====== Timer service
+// ======
+// ======
+// ==========================================================================
+
+class timer_service;
+
+// Timer event source using the timer service instead of the platform timer.
+class wheel_timer : public cool::ng::util::named
+                  , public detail::itf::timer
+                  , public cool::ng::util::self_aware<wheel_timer>
+{
+ public:
+  wheel_timer(const std::weak_ptr<cb::timer>& t_, uint64_t p_);
+  ~wheel_timer();
+
+  void initialize(const std::shared_ptr<async::impl::executor>& ex_);
+  // detail::itf::timer
+  void start() override;
+  void start_once(uint64_t d_) override;
+  void stop() override;
+  void period(uint64_t p_, uint64_t l_) override;
+  void stats(async::timer_stats& s_) const override;
+  void shutdown() override;
+  const std::string& name() const override
+  {
+    return named::name();
+  }
+
+ private:
+  friend class timer_service;
+
+  wheel_entry                          m_entry;
+  const std::weak_ptr<cb::timer>       m_callback;
+  std::weak_ptr<async::impl::executor> m_executor;
+  uint64_t                             m_period;  // in ticks
+  bool                                 m_oneshot;
+  const timer_probe::ptr               m_probe;
+};
+
+// Process wide timer service driving the timing wheel. The service ticks
+// only while there are active timers. On each tick the expired timers are
+// grouped by their executor and delivered to each executor as a single
+// batch.
+class timer_service
+{
+ public:
+  static const uint64_t tick = 1000;   // wheel resolution in microseconds
+
+ public:
+  static timer_service& instance();
+
+  void start(wheel_timer* t_, bool oneshot_, uint64_t delay_);
+  void stop(wheel_timer* t_);
+  void period(wheel_timer* t_, uint64_t p_);
+  static uint64_t to_ticks(uint64_t us_);
+
+ private:
+  timer_service();
+  static uint64_t clock();
+  void schedule();
+  void on_tick();
+
+ private:
+  std::mutex     m_mutex;
+  timer_wheel    m_wheel;
+  bool           m_ticking;
+  std::shared_ptr<async::impl::executor> m_executor;
+};
+
+} } } }// namespace
+
+#endif
@@ -90,7 +90,14 @@ VOID CALLBACK timer::context::on_event(PTP_CALLBACK_INSTANCE i_, PVOID ctx_, PTP
       return;
 
     case state::running:
-      if (self->m_active.load())
+      if (self->m_timer->m_oneshot)
+      {
+        // report the one-shot expiration only once
+        bool expect = true;
+        if (self->m_active.compare_exchange_strong(expect, false))
+          self->m_timer->expired();
+      }
+      else if (self->m_active.load())
         self->m_timer->expired();
       break;
   }
@@ -105,6 +112,9 @@ timer::timer(const std::weak_ptr<cb::timer>& t_
   , m_context(nullptr)
   , m_period((p_ + 500) / 1000)
   , m_leeway((l_ + 500) / 1000)
+  , m_oneshot(false)
+  , m_probe(timer_probe::create())
+  , m_next(0)
 {
   if (m_period == 0)
     m_period = 1;
@@ -151,10 +161,34 @@ void timer::start()
   fdt.dwHighDateTime = dt.HighPart;
   fdt.dwLowDateTime = dt.LowPart;
 
+  m_oneshot = false;
+  m_next = clock_us() + m_period * 1000;
   m_context->m_active = true;
   SetThreadpoolTimer(m_context->m_source, &fdt, static_cast<DWORD>(m_period), static_cast<DWORD>(m_leeway));
 }
 
+void timer::start_once(uint64_t d_)
+{
+  FILETIME fdt;
+  ULARGE_INTEGER dt;
+
+  uint64_t delay = d_ == 0 ? m_period : (d_ + 500) / 1000;
+  if (delay == 0)
+    delay = 1;
+
+  // set timer to fire once in delay msec (NOTE: negative number), the
+  // zero period makes it a one-shot timer
+#pragma warning( suppress: 4146 )
+  dt.QuadPart = -static_cast<ULONGLONG>(delay * 1000 * 10);
+  fdt.dwHighDateTime = dt.HighPart;
+  fdt.dwLowDateTime = dt.LowPart;
+
+  m_oneshot = true;
+  m_next = clock_us() + delay * 1000;
+  m_context->m_active = true;
+  SetThreadpoolTimer(m_context->m_source, &fdt, 0, static_cast<DWORD>(m_leeway));
+}
+
 void timer::stop()
 {
   m_context->m_active = false;
@@ -173,16 +207,25 @@ void timer::stop()
 class exec_for_timer : public cool::ng::async::detail::event_context
 {
  public:
-  exec_for_timer(PTP_CALLBACK_ENVIRON env, const std::weak_ptr<cb::timer>& cb_)
+  exec_for_timer(PTP_CALLBACK_ENVIRON env
+               , const std::weak_ptr<cb::timer>& cb_
+               , const timer_probe::ptr& probe_
+               , uint64_t fired_)
     : m_handler(cb_)
     , m_environ(env)
+    , m_probe(probe_)
+    , m_fired(fired_)
   { /* noop */ }
 
   void entry_point() override
   {
     auto cb = static_cast<exec_for_timer*>(static_cast<void*>(this))->m_handler.lock();
     if (cb)
+    {
+      if (m_probe)
+        m_probe->dispatched(m_fired, clock_us());
       cb->expired();
+    }
   }
 
   void* environment() override { return m_environ; }
@@ -190,20 +233,113 @@ class exec_for_timer : public cool::ng::async::detail::event_context
  private:
   std::weak_ptr<cb::timer> m_handler;
   PTP_CALLBACK_ENVIRON m_environ;
+  timer_probe::ptr     m_probe;
+  uint64_t             m_fired;
 };
 
 void timer::expired()
 {
+  uint64_t now = 0;
+  if (m_probe)
+  {
+    // one snapshot of the schedule and the mode, start() and start_once()
+    // may run concurrently; leave alone the schedule set by the restart
+    now = clock_us();
+    auto scheduled = m_next.load();
+    auto oneshot = m_oneshot.load();
+    if (!oneshot)
+    {
+      auto expected = scheduled;
+      m_next.compare_exchange_strong(expected, scheduled + m_period * 1000);
+    }
+    m_probe->fired(scheduled, now);
+  }
+
   try
   {
     auto r = m_executor.lock();
     if (r)
-      r->run(new exec_for_timer(m_context->m_pool->get_environ(), m_callback));
+      r->run(new exec_for_timer(m_context->m_pool->get_environ(), m_callback, m_probe, now));
   }
   catch (...)
   { /* noop */ }
 }
 
+void timer::stats(async::timer_stats& s_) const
+{
+  if (m_probe)
+    m_probe->snapshot(s_);
+}
+
+// ==========================================================================
+// ======
+// ======
+// ====== Signal
+// ======
+// ======
+// ==========================================================================
+
+signal::signal(const std::weak_ptr<cb::signal>& s_, signal_merge m_)
+  : named("si.digiverse.ng.cool.signal")
+  , m_callback(s_)
+  , m_merge(m_)
+  , m_pending(0)
+  , m_posted(false)
+{ /* noop */ }
+
+void signal::initialize(const std::shared_ptr<async::impl::executor>& ex_)
+{
+  m_executor = ex_;
+}
+
+void signal::trigger(unsigned long v_)
+{
+  if (m_merge == signal_merge::add)
+    m_pending.fetch_add(v_);
+  else
+    m_pending.fetch_or(v_);
+
+  // only the first trigger after the delivery posts another one
+  bool expected = false;
+  if (!m_posted.compare_exchange_strong(expected, true))
+    return;
+
+  signal::weak_ptr self_ = self();
+  try
+  {
+    auto r = m_executor.lock();
+    if (r)
+      r->post(
+        [self_] ()
+        {
+          auto self = self_.lock();
+          if (self)
+            self->deliver();
+        });
+  }
+  catch (...)
+  {
+    m_posted = false;
+  }
+}
+
+// The posted flag is cleared before the pending value is taken, thus a
+// trigger racing with the delivery either lands in this delivery or posts
+// the next one.
+void signal::deliver()
+{
+  m_posted = false;
+  auto value = m_pending.exchange(0);
+  if (value == 0)
+    return;
+  auto cb = m_callback.lock();
+  if (cb)
+    cb->signalled(value);
+}
+
+void signal::shutdown()
+{ /* noop */ }
+
 } // namespace impl
 
 // ==========================================================================
@@ -271,6 +407,7 @@ server::server(const std::shared_ptr<async::impl::executor>& ex_
     , m_get_sock_addrs(nullptr)
     , m_tpio(nullptr)
     , m_context(nullptr)
+    , m_probe(std::make_shared<stream_probe>())
 { /* noop */ }
 
 server::~server()
@@ -289,9 +426,10 @@ server::~server()
   TRACE("server", "server deleted");
 }
 
-void server::initialize(const cool::ng::net::ip::address& addr_, uint16_t port_)
+void server::initialize(const cool::ng::net::ip::address& addr_, uint16_t port_, const socket_options& opts_)
 {
   m_sock_type = addr_.version() == ip::version::ipv6 ? AF_INET6 : AF_INET;
+  m_options = opts_;
   m_context = new ptr(self().lock());
 
   try
@@ -316,6 +454,9 @@ void server::initialize(const cool::ng::net::ip::address& addr_, uint16_t port_)
           throw exc::socket_failure();
       }
 
+      // buffer sizes must be set before listen to affect the window scaling
+      apply_options(m_handle, opts_);
+
       sockaddr_in addr4;
       sockaddr_in6 addr6;
       sockaddr* p;
@@ -403,6 +544,13 @@ void server::initialize(const cool::ng::net::ip::address& addr_, uint16_t port_)
   }
 }
 
+// The accept completion of the Unix domain sockets is not reliable through
+// the completion port, thus the local endpoints are not supported.
+void server::initialize(const local_endpoint&, const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
 void server::start_accept()
 {
   m_client_handle = ::WSASocketW(m_sock_type, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
@@ -526,12 +674,14 @@ class exec_for_accept : public cool::ng::async::detail::event_context
                 , const cb::server::weak_ptr& cb_
                 , handle h_
                 , const ip::host_container& addr_
-                , uint16_t port_)
+                , uint16_t port_
+                , const stream_probe::ptr& probe_)
       : m_addr(addr_)
       , m_port(port_)
       , m_handle(h_)
       , m_handler(cb_)
       , m_environ(env_)
+      , m_probe(probe_)
   { /* noop */ }
 
   void entry_point() override
@@ -546,7 +696,7 @@ class exec_for_accept : public cool::ng::async::detail::event_context
         // use factory to get new stream instance, install client handle
         // and do final on_connect callback
         auto s = cb->manufacture(self->m_addr, self->m_port);
-        server::install_handle(s, self->m_handle);
+        server::install_handle(s, self->m_handle, self->m_probe);
         try { cb->on_connect(s); } catch (...) { }
       }
       catch (...)
@@ -570,6 +720,7 @@ private:
   handle               m_handle;
   cb::server::weak_ptr m_handler;
   PTP_CALLBACK_ENVIRON m_environ;
+  stream_probe::ptr    m_probe;
 };
 
 
@@ -644,6 +795,8 @@ void server::process_accept()
   {
     // TODO: error handling
   }
+  // AcceptEx sockets do not inherit the listen socket options
+  try { apply_options(m_client_handle, m_options); } catch (...) { /* TODO: error handling */ }
 
   ip::host_container addr = *remote;
   uint16_t port = ntohs(remote->ss_family == AF_INET
@@ -658,7 +811,7 @@ void server::process_accept()
 
     auto aux = m_client_handle;
     m_client_handle = invalid_handle;
-    ctx = new exec_for_accept(m_pool->get_environ(), m_handler, aux, addr, port);
+    ctx = new exec_for_accept(m_pool->get_environ(), m_handler, aux, addr, port, m_probe);
 
     if (ctx != nullptr)
       r->run(ctx);
@@ -675,10 +828,16 @@ void server::process_accept()
   start_accept();
 }
 
-void server::install_handle(cool::ng::async::net::stream& s_, cool::ng::net::handle h_)
+void server::install_handle(cool::ng::async::net::stream& s_, cool::ng::net::handle h_, const stream_probe::ptr& probe_)
 {
+  s_.m_impl->aggregate(probe_);
   s_.m_impl->set_handle(h_);
 }
+
+void server::stats(stream_stats& s_) const
+{
+  m_probe->snapshot(s_);
+}
 // --------------------------------------------------------------------------
 // --------------------------------------------------------------------------
 // --------------------------------------------------------------------------
@@ -757,8 +916,6 @@ stream::context::context(async::impl::poolmgr::ptr p_, const stream::ptr& s_, vo
   , m_tpio(nullptr)
   , m_rd_data(buf_)
   , m_rd_size(sz_)
-  , m_rd_is_mine(buf_ == nullptr)
-  , m_wr_busy(false)
   , m_cleanup(nullptr)
 {
   TRACE(s_->name(), "to create context");
@@ -767,9 +924,6 @@ stream::context::context(async::impl::poolmgr::ptr p_, const stream::ptr& s_, vo
     if (sz_ == 0)
       throw exc::illegal_argument();
 
-    if (m_rd_is_mine)
-      m_rd_data = new uint8_t[m_rd_size];
-
     // initialize callback environment, associate it with thread pool and
     // create a cleanup group for this environment
     InitializeThreadpoolEnvironment(&m_environ);
@@ -784,8 +938,6 @@ stream::context::context(async::impl::poolmgr::ptr p_, const stream::ptr& s_, vo
   catch (...)  // cleanup on exception
   {
     TRACE(s_->name(), "context failed to create");
-    if (m_rd_is_mine && m_rd_data != nullptr)
-      delete [] static_cast<uint8_t*>(m_rd_data);
     throw;
   }
 }
@@ -821,9 +973,6 @@ stream::context::~context()
     DestroyThreadpoolEnvironment(&m_environ);
   }
 
-  if (m_rd_is_mine && m_rd_data != nullptr)
-    delete [] static_cast<uint8_t*>(m_rd_data);
-
   TRACE(m_stream->name(), "context deleted");
 }
 
@@ -852,7 +1001,14 @@ stream::stream(const std::weak_ptr<async::impl::executor>& ex_
     , m_connect_ex(nullptr)
     , m_rd_size(32768)
     , m_rd_data(nullptr)
-{ /* noop */ }
+    , m_probe(std::make_shared<stream_probe>())
+    , m_connect_start(0)
+{
+  auto ex = ex_.lock();
+  if (!ex)
+    throw exc::runner_not_available();
+  m_rd_pool = ex->read_pool();
+}
 
 stream::~stream()
 {
@@ -879,18 +1035,26 @@ stream::state stream::set_state(state e_, state s_)
 void stream::initialize(const cool::ng::net::ip::address& addr_
                       , uint16_t port_
                       , void* buf_
-                      , std::size_t bufsz_)
+                      , std::size_t bufsz_
+                      , const socket_options& opts_)
 {
   m_rd_size = bufsz_;
   m_rd_data = buf_;
+  m_options = opts_;
 
   connect(addr_, port_);
 }
 
-void stream::initialize(void* buf_, std::size_t bufsz_)
+void stream::initialize(void* buf_, std::size_t bufsz_, const socket_options& opts_)
 {
   m_rd_size = bufsz_;
   m_rd_data = buf_;
+  m_options = opts_;
+}
+
+void stream::initialize(const local_endpoint&, void*, std::size_t, const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
 }
 
 void stream::set_handle(handle h_)
@@ -898,6 +1062,7 @@ void stream::set_handle(handle h_)
   TRACE(name(), "setting handle");
   try
   {
+    apply_options(h_, m_options);
     auto cp = new context::sptr(new context(m_pool, self().lock(), m_rd_data, m_rd_size));
 
     (*cp)->set_handle(cp, h_);
@@ -914,6 +1079,7 @@ void stream::set_handle(handle h_)
       TRACE(name(), "inexplicably failed to set 'connected' state");
       throw exc::invalid_state();
     }
+    m_probe->accepted();
 
     start_read_source(cp);
     TRACE(name(), "set_handle completed");
@@ -967,6 +1133,7 @@ void stream::connect(const ip::address& addr_, uint16_t port_)
       if (setsockopt((*cp)->m_handle, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&ipv6only), sizeof(ipv6only)) == SOCKET_ERROR)
         throw exc::socket_failure();
     }
+    apply_options((*cp)->m_handle, m_options);
 
     // get address of ConnectEx function (argh!)
     {
@@ -1010,6 +1177,8 @@ void stream::connect(const ip::address& addr_, uint16_t port_)
     else
       set_address(addr6, addr_, port_, pointer, size);
 
+    m_connect_start = async::impl::clock_us();
+
     if (!m_connect_ex(
           (*cp)->m_handle
         , pointer
@@ -1180,26 +1349,91 @@ void stream::write(const void* data, std::size_t size)
   if (get_state() != state::connected)
     throw exc::invalid_state();
 
-  bool expected = false;
-  if (!(*cp)->m_wr_busy.compare_exchange_strong(expected, true))
-    throw exc::operation_failed(cool::ng::error::errc::resource_busy);
+  if ((*cp)->m_wr_queue.push(data, size))
+    start_write_source(cp);
+}
 
-  (*cp)->m_wr_data = static_cast<const uint8_t*>(data);
-  (*cp)->m_wr_size = size;
-  (*cp)->m_wr_pos = 0;
-  start_write_source(cp);
+void stream::write(const const_buffer* bufs, std::size_t count)
+{
+  auto cp = m_context.load();
+  if (get_state() != state::connected)
+    throw exc::invalid_state();
+
+  if ((*cp)->m_wr_queue.push(bufs, count))
+    start_write_source(cp);
+}
+
+void stream::write(std::vector<uint8_t>&& data)
+{
+  auto cp = m_context.load();
+  if (get_state() != state::connected)
+    throw exc::invalid_state();
+
+  if ((*cp)->m_wr_queue.push(std::move(data)))
+    start_write_source(cp);
+}
+
+void stream::connect(const local_endpoint&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+// Windows has no equivalent of the SCM_RIGHTS message
+void stream::write_handle(cool::ng::net::handle)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+cool::ng::net::handle stream::received_handle()
+{
+  return cool::ng::net::invalid_handle;
+}
+
+// The write queue is recreated with each connection and the read is issued
+// anew after each completion; the flow control is not yet supported.
+void stream::watermarks(std::size_t, std::size_t, bool)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void stream::stats(stream_stats& s_) const
+{
+  m_probe->snapshot(s_);
+}
+
+void stream::aggregate(const stream_probe::ptr& probe_)
+{
+  m_probe->parent(probe_);
 }
 
+// The completion port delivers one buffer per read completion, thus there
+// is nothing to limit.
+void stream::read_budget(std::size_t bytes_, std::size_t reads_)
+{
+  if (bytes_ == 0 || reads_ == 0)
+    throw exc::illegal_argument();
+}
 
+
+// Without the user buffer the read is issued into the buffer taken from the
+// runner's pool. Unlike on GCD, where the buffer is taken only when the data
+// is ready, the overlapped read needs the buffer while the read is pending.
 void stream::start_read_source(context::sptr* cp)
 {
   memset(&(*cp)->m_rd_overlapped, 0, sizeof((*cp)->m_rd_overlapped));
   DWORD size = static_cast<DWORD>((*cp)->m_rd_size);
   TRACE((*cp)->m_stream->name(), "starting read source: " << size);
 
+  void* buf = (*cp)->m_rd_data;
+  if (buf == nullptr)
+  {
+    (*cp)->m_rd_pooled = m_rd_pool->acquire((*cp)->m_rd_size);
+    buf = (*cp)->m_rd_pooled.get();
+  }
+
   StartThreadpoolIo((*cp)->m_tpio);
   if (!ReadFile(reinterpret_cast<HANDLE>((*cp)->m_handle)
-    , (*cp)->m_rd_data
+    , buf
     , size
     , nullptr
     , &(*cp)->m_rd_overlapped))
@@ -1233,27 +1467,40 @@ void stream::start_read_source(context::sptr* cp)
   }
 }
 
+// Gathers as much of the queued data as possible into a single WSASend
+// call. Only the data buffers must remain valid until the completion, the
+// WSABUF array may be released once WSASend returns.
 void stream::start_write_source(context::sptr* cp)
 {
+  const std::size_t max_segments = 64;
+  WSABUF segments[max_segments];
+
   memset(&(*cp)->m_wr_overlapped, 0, sizeof((*cp)->m_wr_overlapped));
 
-  // note really necessary. still ... internal sizes are std::size_t (64 bits)
-  // while WriteFile works with 32 bits ... just in case somebody really
-  // wanted to do write > 2G
-  std::size_t full_size = (*cp)->m_wr_size - (*cp)->m_wr_pos;
-  DWORD size = full_size > INT32_MAX ? INT32_MAX : static_cast<DWORD>(full_size);
-  TRACE((*cp)->m_stream->name(), "starting write source: " << size);
+  // internal sizes are std::size_t (64 bits) while WSABUF works with 32 bits
+  auto count = (*cp)->m_wr_queue.gather(
+      max_segments
+    , [&segments] (std::size_t i_, const uint8_t* data_, std::size_t size_)
+      {
+        segments[i_].buf = reinterpret_cast<CHAR*>(const_cast<uint8_t*>(data_));
+        segments[i_].len = size_ > INT32_MAX ? INT32_MAX : static_cast<ULONG>(size_);
+      });
+  if (count == 0)
+    return;
+  TRACE((*cp)->m_stream->name(), "starting write source: " << count << " segments");
 
   StartThreadpoolIo((*cp)->m_tpio);
-  if (!WriteFile(
-      reinterpret_cast<HANDLE>((*cp)->m_handle)
-    , (*cp)->m_wr_data + (*cp)->m_wr_pos
-    , size
+  if (WSASend(
+      (*cp)->m_handle
+    , segments
+    , static_cast<DWORD>(count)
     , nullptr
-    , &(*cp)->m_wr_overlapped))
+    , 0
+    , &(*cp)->m_wr_overlapped
+    , nullptr) == SOCKET_ERROR)
   {
-    auto err = GetLastError();
-    if (err != ERROR_IO_PENDING)
+    auto err = WSAGetLastError();
+    if (err != WSA_IO_PENDING)
     {
       CancelThreadpoolIo((*cp)->m_tpio);
       return;
@@ -1429,6 +1676,9 @@ void stream::process_event_connecting(context::sptr* cp_, ULONG_PTR num_transfer
         // might have happened in the mean time for some other reason, like shutdown
         if (set_state(state::connecting, state::connected) == state::connecting)
         {
+          auto now = async::impl::clock_us();
+          m_probe->connected(now > m_connect_start ? now - m_connect_start : 0);
+
           auto handler = m_handler;
           context::wptr wself = *cp_;
           auto exe_ctx = new exec_for_io(&(*cp_)->m_environ,
@@ -1465,6 +1715,8 @@ void stream::process_event_connecting(context::sptr* cp_, ULONG_PTR num_transfer
 void stream::process_event_read(context::sptr* cp_, ULONG_PTR num_transferred_, ULONG io_result_)
 {
   TRACE(name(), "process read event, count: " << num_transferred_ << " result: " << io_result_);
+  m_probe->read_event();
+  m_probe->read(io_result_ == NO_ERROR ? static_cast<std::size_t>(num_transferred_) : 0);
 
   auto ex = m_executor.lock();
   if (!ex)  //
@@ -1493,11 +1745,15 @@ void stream::process_event_read(context::sptr* cp_, ULONG_PTR num_transferred_,
   }
 
 
+  // the pooled buffer travels with the task and is returned to the pool
+  // after the read handler, unless the handler retained it
   auto handler = m_handler;
-  auto capture_data = (*cp_)->m_rd_data;
+  auto pooled = (*cp_)->m_rd_pooled;
+  (*cp_)->m_rd_pooled.reset();
+  void* capture_data = pooled ? pooled.get() : (*cp_)->m_rd_data;
   context::wptr wctx = *cp_;
   auto exe_ctx = new exec_for_io(&(*cp_)->m_environ,
-    [handler, capture_data, num_transferred_, wctx, cp_]()
+    [handler, capture_data, pooled, num_transferred_, wctx, cp_]() mutable
     {
       void* data = capture_data;
       std::size_t size = num_transferred_;
@@ -1511,24 +1767,17 @@ void stream::process_event_read(context::sptr* cp_, ULONG_PTR num_transferred_,
         // TODO: this is serious stuff, need to close the stream
         return;
       }
+      buffer_pool::current(pooled ? &pooled : nullptr);
       try { cb->on_read(data, size); } catch (...) { }
+      buffer_pool::current(nullptr);
+      pooled.reset();
 
       // check if user changed the buffere and restart read operation
-      if (data != ctx->m_rd_data || size > ctx->m_rd_size)
+      if (data != capture_data || size > ctx->m_rd_size)
       {
-        // release current buffer if allocated by me
-        if (ctx->m_rd_is_mine)
-        {
-          // if "data" points to our internal buffer, make sure it is invalidated,
-          // so that it will be properly reallocated
-          if (data == ctx->m_rd_data)
-            data = nullptr;
-          delete [] static_cast<uint8_t*>(ctx->m_rd_data);
-        }
-
         // there are some special values that requeire different considerations
         //  - if size is zero revert to bufffer specified at the creation
-        //  - if buf is nullptr allocate buffer of specified size
+        //  - if buf is nullptr use pooled buffers of specified size
         if (size == 0)
         {
           ctx->m_rd_size = ctx->m_stream->m_rd_size;
@@ -1539,17 +1788,14 @@ void stream::process_event_read(context::sptr* cp_, ULONG_PTR num_transferred_,
           ctx->m_rd_data = data;
           ctx->m_rd_size = size;
         }
-        ctx->m_rd_is_mine = ctx->m_rd_data == nullptr;
+      }
 
-        try
-        {
-          if (ctx->m_rd_is_mine)
-            ctx->m_rd_data = new uint8_t[ctx->m_rd_size];
-        }
-        catch (...)   // TODO: out-of-memory, shutdown the stream
-        { }
+      try
+      {
+        ctx->m_stream->start_read_source(cp_);
       }
-      ctx->m_stream->start_read_source(cp_);
+      catch (...)   // TODO: out-of-memory, shutdown the stream
+      { }
     }
   );
   ex->run(exe_ctx);
@@ -1558,6 +1804,7 @@ void stream::process_event_read(context::sptr* cp_, ULONG_PTR num_transferred_,
 void stream::process_event_write(context::sptr* cp_, ULONG_PTR num_transferred_, ULONG io_result_)
 {
   TRACE(name(), "process write event, count: " << num_transferred_ << " result: " << io_result_);
+  m_probe->write(io_result_ == NO_ERROR ? static_cast<std::size_t>(num_transferred_) : 0);
   if (io_result_ != NO_ERROR)
   {
     return; // TODO: do we report error here???
@@ -1565,35 +1812,40 @@ void stream::process_event_write(context::sptr* cp_, ULONG_PTR num_transferred_,
 
   assert(num_transferred_ > 0);
 
-  (*cp_)->m_wr_pos += num_transferred_;
-  if ((*cp_)->m_wr_pos >= (*cp_)->m_wr_size)  // write complete, remove busy flag and notify user
+  std::vector<write_queue::entry> aux;
+  bool drained = (*cp_)->m_wr_queue.consume(num_transferred_, aux);
+  if (!aux.empty())  // some buffers were fully written, notify user
   {
-    (*cp_)->m_wr_busy = false;
     auto ex = m_executor.lock();
     if (ex)
     {
       auto handler = m_handler;
-      auto data = (*cp_)->m_wr_data;
-      auto size = (*cp_)->m_wr_size;
+      auto probe = m_probe;
+      auto done = std::make_shared<std::vector<write_queue::entry>>(std::move(aux));
       auto exe_ctx = new exec_for_io(&(*cp_)->m_environ,
-        [handler, data, size]()
+        [handler, probe, done]()
         {
+          auto now = async::impl::clock_us();
+          for (auto& e : *done)
+            probe->written(now > e.m_queued ? now - e.m_queued : 0);
+
           auto cb = handler.lock();
-          if (cb) try { cb->on_write(data, size); } catch (...) { }
+          if (cb)
+          {
+            for (auto& e : *done)
+              try { cb->on_write(e.m_data, e.m_size); } catch (...) { }
+          }
         }
       );
       ex->run(exe_ctx);
     }
   }
-  else  // there's still some data to write, start write operation
-  {
+  if (!drained)  // there's still some data to write, start write operation
     start_write_source(cp_);
-  }
 }
 
 
 
-
 #if 0
 void stream::on_event(PVOID overlapped_, ULONG io_result_, ULONG_PTR num_transferred_)
 {
@@ -1663,6 +1915,39 @@ void stream::on_event(PVOID overlapped_, ULONG io_result_, ULONG_PTR num_transfe
 }
 #endif
 
+// The datagram event source is not yet available on Windows platform.
+datagram::datagram(const std::shared_ptr<async::impl::executor>&
+                 , const cb::datagram::weak_ptr&)
+    : named("si.digiverse.ng.cool.datagram")
+{ /* noop */ }
+
+void datagram::initialize(const cool::ng::net::ip::address&
+                        , uint16_t
+                        , std::size_t
+                        , std::size_t
+                        , const socket_options&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+std::size_t datagram::send(const datagram_message*, std::size_t)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void datagram::join(const cool::ng::net::ip::address&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void datagram::leave(const cool::ng::net::ip::address&)
+{
+  throw exc::operation_failed(error::errc::not_available);
+}
+
+void datagram::shutdown()
+{ /* noop */ }
+
 } } } } }
 
 
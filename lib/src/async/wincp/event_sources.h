@@ -40,6 +40,11 @@
 
 #include "executor.h"
 #include "critical_section.h"
+#include "src/async/timer_stats.h"
+#include "src/async/write_queue.h"
+#include "src/async/buffer_pool.h"
+#include "src/async/socket_options.h"
+#include "src/async/stream_stats.h"
 
 namespace cool { namespace ng { namespace async { namespace impl {
 
@@ -81,8 +86,10 @@ class timer : public cool::ng::util::named
   void initialize(const std::shared_ptr<async::impl::executor>& ex_);
   // detail::itf::timer
   void start() override;
+  void start_once(uint64_t d_) override;
   void stop() override;
   void period(uint64_t p_, uint64_t l_) override;
+  void stats(async::timer_stats& s_) const override;
   void shutdown() override;
   const std::string& name() const override
   {
@@ -100,6 +107,48 @@ class timer : public cool::ng::util::named
 
   uint64_t m_period;
   uint64_t m_leeway;
+  std::atomic<bool> m_oneshot;
+  // instrumentation; the next scheduled expiration is in clock_us() units
+  const timer_probe::ptr m_probe;
+  std::atomic<uint64_t>  m_next;
+};
+
+// ==========================================================================
+// ======
+// ======
+// ====== Signal event source
+// ======
+// ======
+// ==========================================================================
+
+// The triggers merge their values into the pending value and the first
+// trigger after the delivery posts the delivery to the completion port of
+// the signal's executor.
+class signal : public cool::ng::util::named
+             , public detail::itf::signal
+             , public cool::ng::util::self_aware<signal>
+{
+ public:
+  signal(const std::weak_ptr<cb::signal>& s_, signal_merge m_);
+
+  void initialize(const std::shared_ptr<async::impl::executor>& ex_);
+  // detail::itf::signal
+  void trigger(unsigned long v_) override;
+  void shutdown() override;
+  const std::string& name() const override
+  {
+    return named::name();
+  }
+
+ private:
+  void deliver();
+
+ private:
+  const std::weak_ptr<cb::signal>      m_callback;
+  const signal_merge                   m_merge;
+  std::weak_ptr<async::impl::executor> m_executor;
+  std::atomic<unsigned long>           m_pending;
+  std::atomic<bool>                    m_posted;
 };
 
 } // namespace impl
@@ -116,7 +165,7 @@ class timer : public cool::ng::util::named
 
 namespace net { namespace impl {
 
-class server : public async::detail::itf::startable
+class server : public detail::itf::server
              , public cool::ng::util::named
              , public cool::ng::util::self_aware<server>
 {
@@ -138,13 +187,15 @@ class server : public async::detail::itf::startable
        , const cb::server::weak_ptr& cb_);
   ~server();
 
-  void initialize(const cool::ng::net::ip::address& addr_, uint16_t port_);
+  void initialize(const cool::ng::net::ip::address& addr_, uint16_t port_, const socket_options& opts_);
+  void initialize(const local_endpoint& ep_, const socket_options& opts_);
   const std::string& name() const { return named::name(); }
   void start() override;
   void stop() override;
   void shutdown() override;
+  void stats(stream_stats& s_) const override;
 
-  static void install_handle(cool::ng::async::net::stream& s_, cool::ng::net::handle h_);
+  static void install_handle(cool::ng::async::net::stream& s_, cool::ng::net::handle h_, const stream_probe::ptr& probe_);
 
  private:
   void start_accept();
@@ -167,6 +218,8 @@ class server : public async::detail::itf::startable
   ::cool::ng::net::handle   m_handle;              // listen socket
   ::cool::ng::net::handle   m_client_handle;       // client soocket for accept
   int                       m_sock_type;           // socket type flag to create client socket
+  socket_options            m_options;             // inherited by accepted connections
+  const stream_probe::ptr   m_probe;               // aggregate of accepted connections
 
   // function pointers of inaccessbile Winsock2 symbols
   LPFN_ACCEPTEX             m_accept_ex;      // f. pointer to AcceptEx
@@ -224,16 +277,13 @@ class stream : public detail::itf::connected_writable
 
     // reader part
     std::size_t m_rd_size;
-    bool        m_rd_is_mine;
-    void*       m_rd_data;
+    void*       m_rd_data;     // nullptr if reading into pooled buffers
+    buffer_pool::buffer m_rd_pooled;  // pooled buffer of the pending read
     DWORD       m_read_bytes;
 
     // writer part
-    std::atomic<bool> m_wr_busy;
-    const uint8_t*    m_wr_data;
-    std::size_t       m_wr_size;
-    std::size_t       m_wr_pos;
-    DWORD             m_written_bytes;
+    write_queue m_wr_queue;
+    DWORD                  m_written_bytes;
 
     // threadpool stuff
     TP_CALLBACK_ENVIRON m_environ;
@@ -248,8 +298,13 @@ class stream : public detail::itf::connected_writable
   void initialize(const cool::ng::net::ip::address& addr_
                 , uint16_t port_
                 , void* buf_
-                , std::size_t bufsz_);
-  void initialize(void* buf_, std::size_t bufsz_);
+                , std::size_t bufsz_
+                , const socket_options& opts_);
+  void initialize(const local_endpoint& ep_
+                , void* buf_
+                , std::size_t bufsz_
+                , const socket_options& opts_);
+  void initialize(void* buf_, std::size_t bufsz_, const socket_options& opts_);
 
   // event_source interface
   void shutdown() override;
@@ -257,9 +312,18 @@ class stream : public detail::itf::connected_writable
 
   // connected writable interface
   void write(const void* data, std::size_t size) override;
+  void write(const const_buffer* bufs, std::size_t count) override;
+  void write(std::vector<uint8_t>&& data) override;
   void connect(const cool::ng::net::ip::address& addr_, uint16_t port_) override;
+  void connect(const local_endpoint& ep_) override;
   void disconnect() override;
+  void read_budget(std::size_t bytes_, std::size_t reads_) override;
   void set_handle(cool::ng::net::handle h_) override;
+  void write_handle(cool::ng::net::handle h_) override;
+  cool::ng::net::handle received_handle() override;
+  void watermarks(std::size_t high_, std::size_t low_, bool pause_read_) override;
+  void stats(stream_stats& s_) const override;
+  void aggregate(const stream_probe::ptr& probe_) override;
 
  private:
   friend class exec_for_io;
@@ -301,6 +365,34 @@ private:
   // reader part - original parameters
   std::size_t                          m_rd_size;
   void*                                m_rd_data;
+  buffer_pool::ptr                     m_rd_pool;
+  socket_options                       m_options;
+
+  // statistics
+  const stream_probe::ptr              m_probe;
+  uint64_t                             m_connect_start; // clock_us() at the start of connect
+};
+
+
+class datagram : public detail::itf::datagram
+               , public cool::ng::util::named
+               , public cool::ng::util::self_aware<datagram>
+{
+ public:
+  datagram(const std::shared_ptr<async::impl::executor>& ex_
+         , const cb::datagram::weak_ptr& cb_);
+
+  void initialize(const cool::ng::net::ip::address& addr_
+                , uint16_t port_
+                , std::size_t batch_
+                , std::size_t size_
+                , const socket_options& opts_);
+
+  std::size_t send(const datagram_message* msgs_, std::size_t count_) override;
+  void join(const cool::ng::net::ip::address& group_) override;
+  void leave(const cool::ng::net::ip::address& group_) override;
+  void shutdown() override;
+  const std::string& name() const override { return named::name(); }
 };
 
 } } } } } // namespace
@@ -21,11 +21,13 @@
  * IN THE SOFTWARE.
  */
 #include "executor.h"
+#include "src/async/buffer_pool.h"
 
 #include <mutex>
 #include <iostream>
 #include "cool/ng/async/runner.h"
 #include "cool/ng/exception.h"
+#include "cool/ng/impl/async/task.h"
 
 #define DO_TRACE 0
 // #define DO_TRACE 1
@@ -117,6 +119,7 @@ executor::executor(RunPolicy policy_)
     , m_work_in_progress(false)
     , m_active(true)
     , m_lock(SRWLOCK_INIT)
+    , m_read_pool(std::make_shared<net::impl::buffer_pool>())
 {
   TRACE(name(), "new " << this);
 
@@ -281,6 +284,11 @@ void executor::task_executor(PTP_WORK w_)
     case cool::ng::async::detail::work_type::task_work:
     {
       auto stack = static_cast<cool::ng::async::detail::context_stack*>(static_cast<void*>(aux));
+      if (stack->cancelled())
+      {
+        delete stack;
+        break;
+      }
       auto context = stack->top();
       auto r = context->get_runner().lock();
 
@@ -290,8 +298,15 @@ void executor::task_executor(PTP_WORK w_)
         try { context->entry_point(r, context); } catch (...) { /* noop */ }
         if (stack->empty())
           delete stack;
-        else
-          r->impl()->run(stack);
+        else if (!stack->top()->suspend())
+        {
+          // the next context may belong to a different runner
+          r = stack->top()->get_runner().lock();
+          if (r)
+            r->impl()->run(stack);
+          else
+            delete stack;
+        }
       }
       else
         delete stack;
@@ -323,5 +338,95 @@ void executor::run(cool::ng::async::detail::work* ctx_)
   }
 }
 
+class exec_for_function : public cool::ng::async::detail::event_context
+{
+ public:
+  exec_for_function(PTP_CALLBACK_ENVIRON env_, const std::function<void()>& f_)
+    : m_func(f_)
+    , m_environ(env_)
+  { /* noop */ }
+
+  void entry_point() override
+  {
+    m_func();
+  }
+
+  void* environment() override { return m_environ; }
+
+ private:
+  std::function<void()> m_func;
+  PTP_CALLBACK_ENVIRON  m_environ;
+};
+
+void executor::post(const std::function<void()>& f_)
+{
+  run(new exec_for_function(m_pool->get_environ(), f_));
+}
+
+void executor::post_after(uint64_t delay_, const std::function<void()>& f_)
+{
+  TRACE(name(), "post_after: " << delay_);
+
+  auto ctx = new std::function<void()>(f_);
+  auto timer = CreateThreadpoolTimer(function_cb, ctx, m_pool->get_environ());
+  if (timer == NULL)
+  {
+    delete ctx;
+    throw exception::threadpool_failure();
+  }
+
+  // negative due time is relative, in 100 ns units
+  ULARGE_INTEGER due;
+  due.QuadPart = static_cast<ULONGLONG>(-static_cast<LONGLONG>(delay_ * 10));
+  FILETIME ft;
+  ft.dwLowDateTime = due.LowPart;
+  ft.dwHighDateTime = due.HighPart;
+  SetThreadpoolTimer(timer, &ft, 0, 0);
+}
+
+void executor::run_after(uint64_t delay_, const std::shared_ptr<detail::deferred>& d_)
+{
+  TRACE(name(), "run_after: " << delay_);
+
+  auto ctx = new std::shared_ptr<detail::deferred>(d_);
+  auto timer = CreateThreadpoolTimer(deferred_task_cb, ctx, m_pool->get_environ());
+  if (timer == NULL)
+  {
+    delete ctx;
+    throw exception::threadpool_failure();
+  }
+
+  // negative due time is relative, in 100 ns units
+  ULARGE_INTEGER due;
+  due.QuadPart = static_cast<ULONGLONG>(-static_cast<LONGLONG>(delay_ * 10));
+  FILETIME ft;
+  ft.dwLowDateTime = due.LowPart;
+  ft.dwHighDateTime = due.HighPart;
+  SetThreadpoolTimer(timer, &ft, 0, 0);
+}
+
+// executor for the delayed work of the library internals
+VOID CALLBACK executor::function_cb(PTP_CALLBACK_INSTANCE instance_, PVOID pv_, PTP_TIMER timer_)
+{
+  auto f = static_cast<std::function<void()>*>(static_cast<void*>(pv_));
+  try { (*f)(); } catch (...) { /* noop */ }
+  delete f;
+
+  CloseThreadpoolTimer(timer_);
+}
+
+// executor for task::run_after() and task::run_at(); the timer callback does
+// not run in the sequence of the runner thus the stack is queued to it,
+// unless the delayed run was cancelled in the meantime
+VOID CALLBACK executor::deferred_task_cb(PTP_CALLBACK_INSTANCE instance_, PVOID pv_, PTP_TIMER timer_)
+{
+  auto d = static_cast<std::shared_ptr<detail::deferred>*>(static_cast<void*>(pv_));
+  auto stack = (*d)->take();
+  delete d;
+  if (stack != nullptr)
+    detail::resume(stack);
+
+  CloseThreadpoolTimer(timer_);
+}
 
 } } } } // namespace
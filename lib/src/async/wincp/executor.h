@@ -29,6 +29,7 @@
 
 #include <atomic>
 #include <memory>
+#include <functional>
 #include <unordered_set>
 
 #include "cool/ng/bases.h"
@@ -37,7 +38,12 @@
 #include "critical_section.h"
 
 
-namespace cool { namespace ng { namespace async { namespace impl {
+namespace cool { namespace ng { namespace async {
+
+namespace detail { class deferred; }
+namespace net { namespace impl { class buffer_pool; } }
+
+namespace impl {
 
 class poolmgr
 {
@@ -69,12 +75,18 @@ class executor : public ::cool::ng::util::named
   ~executor();
 
   void run(detail::work*);
+  void run_after(uint64_t delay_, const std::shared_ptr<detail::deferred>&);
+  void post(const std::function<void()>&);
+  void post_after(uint64_t delay_, const std::function<void()>&);
   bool is_system() const { return false; }
+  const std::shared_ptr<net::impl::buffer_pool>& read_pool() const { return m_read_pool; }
 
  private:
   static VOID CALLBACK task_executor(PTP_CALLBACK_INSTANCE instance_, PVOID pv_, PTP_WORK work_);
   void task_executor(PTP_WORK w_);
   static VOID CALLBACK event_cb(PTP_CALLBACK_INSTANCE instance_, PVOID pv_, PTP_WORK work_);
+  static VOID CALLBACK function_cb(PTP_CALLBACK_INSTANCE instance_, PVOID pv_, PTP_TIMER timer_);
+  static VOID CALLBACK deferred_task_cb(PTP_CALLBACK_INSTANCE instance_, PVOID pv_, PTP_TIMER timer_);
   static VOID CALLBACK cleanup_cb(PTP_CALLBACK_INSTANCE instance_, PVOID pv_, PTP_WORK work_);
 
  private:
@@ -87,6 +99,7 @@ class executor : public ::cool::ng::util::named
 
   SRWLOCK m_lock;
   std::unordered_set<void*> m_cleanup_environments;
+  std::shared_ptr<net::impl::buffer_pool> m_read_pool;
 };
 
 } } } }// namespace
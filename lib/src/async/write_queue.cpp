@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(WINDOWS_TARGET)
+#include <unistd.h>
+#endif
+
+#include "cool/ng/exception.h"
+
+#include "write_queue.h"
+#include "timer_stats.h"
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+write_queue::write_queue()
+  : m_pos(0), m_bytes(0), m_high(0), m_low(0), m_blocked(false), m_open(true)
+{ /* noop */ }
+
+bool write_queue::push(const void* data_, std::size_t size_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  if (!m_open)
+    throw cool::ng::exception::invalid_state();
+  bool was_empty = m_queue.empty();
+  m_queue.push_back(entry { static_cast<const uint8_t*>(data_), size_, std::vector<uint8_t>(), cool::ng::net::invalid_handle, async::impl::clock_us() });
+  m_bytes += size_;
+  check_flow();
+  return was_empty;
+}
+
+bool write_queue::push(const const_buffer* bufs_, std::size_t count_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  if (!m_open)
+    throw cool::ng::exception::invalid_state();
+  bool was_empty = m_queue.empty();
+  auto now = async::impl::clock_us();
+  for (std::size_t i = 0; i < count_; ++i)
+  {
+    m_queue.push_back(entry { static_cast<const uint8_t*>(bufs_[i].data), bufs_[i].size, std::vector<uint8_t>(), cool::ng::net::invalid_handle, now });
+    m_bytes += bufs_[i].size;
+  }
+  check_flow();
+  return was_empty && count_ > 0;
+}
+
+bool write_queue::push(std::vector<uint8_t>&& data_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  if (!m_open)
+    throw cool::ng::exception::invalid_state();
+  bool was_empty = m_queue.empty();
+  m_queue.push_back(entry { nullptr, data_.size(), std::move(data_), cool::ng::net::invalid_handle, async::impl::clock_us() });
+  m_queue.back().m_data = m_queue.back().m_owned.data();
+  m_bytes += m_queue.back().m_size;
+  check_flow();
+  return was_empty;
+}
+
+bool write_queue::push(cool::ng::net::handle h_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  if (!m_open)
+  {
+    entry aux { nullptr, 0, std::vector<uint8_t>(), h_, 0 };
+    release(aux);
+    throw cool::ng::exception::invalid_state();
+  }
+  bool was_empty = m_queue.empty();
+  m_queue.push_back(entry { nullptr, 1, std::vector<uint8_t>(1, 0), h_, async::impl::clock_us() });
+  m_queue.back().m_data = m_queue.back().m_owned.data();
+  ++m_bytes;
+  check_flow();
+  return was_empty;
+}
+
+bool write_queue::consume(std::size_t size_, std::vector<entry>& done_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_bytes -= size_;
+  m_pos += size_;
+  while (!m_queue.empty() && m_pos >= m_queue.front().m_size)
+  {
+    m_pos -= m_queue.front().m_size;
+    done_.push_back(std::move(m_queue.front()));
+    m_queue.pop_front();
+  }
+  if (m_queue.empty())
+    m_pos = 0;
+  check_flow();
+  return m_queue.empty();
+}
+
+bool write_queue::empty() const
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  return m_queue.empty();
+}
+
+void write_queue::clear()
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  drop();
+}
+
+void write_queue::open()
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  drop();
+  m_open = true;
+}
+
+void write_queue::close()
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_open = false;
+}
+
+void write_queue::discard()
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  if (!m_open)
+    drop();
+}
+
+void write_queue::watermarks(std::size_t high_, std::size_t low_, const flow_callback& flow_)
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  m_high = high_;
+  m_low = low_;
+  m_flow = flow_;
+  check_flow();
+}
+
+std::size_t write_queue::pending() const
+{
+  std::unique_lock<std::mutex> l(m_mutex);
+  return m_bytes;
+}
+
+// must be called with the queue locked
+void write_queue::drop()
+{
+  for (auto& e : m_queue)
+    release(e);
+  m_queue.clear();
+  m_pos = 0;
+  m_bytes = 0;
+  if (m_blocked)
+  {
+    m_blocked = false;
+    if (m_flow)
+      m_flow(false);
+  }
+}
+
+// must be called with the queue locked
+void write_queue::check_flow()
+{
+  bool blocked = m_blocked;
+  if (m_high == 0)
+    blocked = false;
+  else if (m_bytes >= m_high)
+    blocked = true;
+  else if (m_bytes <= m_low)
+    blocked = false;
+
+  if (blocked == m_blocked)
+    return;
+  m_blocked = blocked;
+  if (m_flow)
+    m_flow(blocked);
+}
+
+void write_queue::release(entry& e_)
+{
+  if (e_.m_handle == cool::ng::net::invalid_handle)
+    return;
+#if defined(WINDOWS_TARGET)
+  ::closesocket(e_.m_handle);
+#else
+  ::close(e_.m_handle);
+#endif
+  e_.m_handle = cool::ng::net::invalid_handle;
+}
+
+} } } } } // namespace
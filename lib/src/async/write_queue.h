@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if !defined(cool_ng_5c1e7a93_b24d_4f08_9e6a_3f7d20c8b1e4)
+#define      cool_ng_5c1e7a93_b24d_4f08_9e6a_3f7d20c8b1e4
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+#include "cool/ng/impl/async/event_sources_types.h"
+
+namespace cool { namespace ng { namespace async { namespace net { namespace impl {
+
+// Outgoing data queue of the stream. The buffers are queued from any thread
+// and consumed by the stream's write event handling, which gathers as many of
+// them as possible into a single vectored write. The queue is not empty for
+// as long as there is a write in progress.
+//
+// With the watermarks set the queue reports when the unwritten data reaches
+// the high watermark and when it drops back to the low watermark. The flow
+// callback is called with the queue locked, so that the changes are reported
+// in order, and must not call back into the queue.
+//
+// The queue only accepts data while open; the pushes to the closed queue
+// throw invalid_state. This lets the stream check its state and queue the
+// data atomically, as the stream closes the queue when it disconnects and
+// reopens it when connected again.
+class write_queue
+{
+ public:
+  using flow_callback = std::function<void(bool)>;
+
+  struct entry
+  {
+    const uint8_t*       m_data;
+    std::size_t          m_size;
+    std::vector<uint8_t> m_owned;  // data the queue took ownership of
+    cool::ng::net::handle m_handle;  // handle to pass along, owned by the queue
+    uint64_t             m_queued;   // clock_us() at the time of the push
+  };
+
+ public:
+  write_queue();
+
+  // all push variants return true if the queue was empty, meaning that the
+  // caller must start the write, and throw invalid_state if the queue is
+  // closed
+  bool push(const void* data_, std::size_t size_);
+  bool push(const const_buffer* bufs_, std::size_t count_);
+  bool push(std::vector<uint8_t>&& data_);
+  // queues a single byte of data carrying the handle, which the queue takes
+  // over and closes when it is no longer needed, or at once if the queue is
+  // closed
+  bool push(cool::ng::net::handle h_);
+
+  // calls fill_(index, data, size) for up to max_ leading unwritten segments
+  // and returns the number of segments; the entry carrying the handle is
+  // always gathered alone, as its handle must go out with its own message,
+  // and h_ is set to its handle or to invalid_handle for the ordinary data
+  template <typename FillT>
+  std::size_t gather(std::size_t max_, FillT fill_, cool::ng::net::handle& h_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    std::size_t n = 0;
+    std::size_t offset = m_pos;
+    h_ = cool::ng::net::invalid_handle;
+    for (auto it = m_queue.begin(); it != m_queue.end() && n < max_; ++it, ++n)
+    {
+      if (it->m_handle != cool::ng::net::invalid_handle)
+      {
+        if (n > 0)
+          break;
+        h_ = it->m_handle;
+        fill_(n++, it->m_data + offset, it->m_size - offset);
+        break;
+      }
+      fill_(n, it->m_data + offset, it->m_size - offset);
+      offset = 0;
+    }
+    return n;
+  }
+  template <typename FillT>
+  std::size_t gather(std::size_t max_, FillT fill_)
+  {
+    cool::ng::net::handle h;
+    return gather(max_, fill_, h);
+  }
+
+  // marks size_ bytes as written and moves the fully written entries into
+  // done_; returns true if the queue became empty
+  bool consume(std::size_t size_, std::vector<entry>& done_);
+  bool empty() const;
+  // drops all queued entries and closes the handles they carry; the blocked
+  // queue becomes unblocked and reports it through the flow callback
+  void clear();
+  // drops the entries left over from the previous connection and starts
+  // accepting the data
+  void open();
+  // stops accepting the data; the queued entries remain until cleared
+  void close();
+  // clears the queue unless it was opened again in the meantime
+  void discard();
+  // sets the watermarks, in bytes, and the callback called with true when
+  // the queue becomes blocked and with false when unblocked; high_ of 0
+  // disables the flow control
+  void watermarks(std::size_t high_, std::size_t low_, const flow_callback& flow_);
+  // returns the number of bytes not yet written
+  std::size_t pending() const;
+  // closes the handle carried by the written entry, if any
+  static void release(entry& e_);
+
+ private:
+  mutable std::mutex m_mutex;
+  std::deque<entry>  m_queue;
+  std::size_t        m_pos;    // bytes of the head entry already written
+  std::size_t        m_bytes;  // bytes not yet written
+  std::size_t        m_high;
+  std::size_t        m_low;
+  bool               m_blocked;
+  bool               m_open;
+  flow_callback      m_flow;
+
+ private:
+  void drop();
+  void check_flow();
+};
+
+} } } } } // namespace
+
+#endif
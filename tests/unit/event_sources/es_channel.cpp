@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+
+#define BOOST_TEST_MODULE ChannelEventSources
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+BOOST_AUTO_TEST_SUITE(channel_sources)
+
+namespace async = cool::ng::async;
+
+class test_runner : public cool::ng::async::runner
+{ };
+
+struct item
+{
+  int producer;
+  int seq;
+};
+
+BOOST_AUTO_TEST_CASE(multiple_producers)
+{
+  const int producers = 4;
+  const int count = 10000;
+
+  auto r = std::make_shared<test_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<int> next(producers, 0);
+  bool in_order = true;
+  int received = 0;
+  int batches = 0;
+  std::size_t max_batch = 0;
+
+  async::channel<item> ch(
+      std::weak_ptr<test_runner>(r)
+    , [&] (const std::shared_ptr<test_runner>&, std::vector<item>& batch)
+      {
+        lock l(m);
+        for (auto& i : batch)
+        {
+          if (i.seq != next[i.producer])
+            in_order = false;
+          next[i.producer] = i.seq + 1;
+        }
+        received += static_cast<int>(batch.size());
+        max_batch = std::max(max_batch, batch.size());
+        ++batches;
+        cv.notify_one();
+      }
+    , 0
+    , 32);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.emplace_back([&ch, p, count] ()
+    {
+      for (int i = 0; i < count; ++i)
+        ch.send(item{ p, i });
+    });
+  for (auto& t : threads)
+    t.join();
+
+  {
+    lock l(m);
+    cv.wait_for(l, ms(2000), [&] () { return received == producers * count; });
+  }
+
+  BOOST_CHECK_EQUAL(producers * count, received);
+  BOOST_CHECK(in_order);
+  BOOST_CHECK(max_batch <= 32);
+  BOOST_CHECK(batches < received);
+}
+
+BOOST_AUTO_TEST_CASE(bounded)
+{
+  auto r = std::make_shared<test_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool blocked = true;
+  bool started = false;
+  std::vector<int> result;
+
+  // keep the runner busy until all items are sent
+  auto blocker = async::factory::create(
+      r
+    , [&m, &cv, &blocked, &started] (const std::shared_ptr<test_runner>&)
+      {
+        lock l(m);
+        started = true;
+        cv.notify_all();
+        cv.wait(l, [&blocked] () { return !blocked; });
+      }
+  );
+
+  async::channel<int> ch(
+      std::weak_ptr<test_runner>(r)
+    , [&m, &cv, &result] (const std::shared_ptr<test_runner>&, std::vector<int>& batch)
+      {
+        lock l(m);
+        result.insert(result.end(), batch.begin(), batch.end());
+        cv.notify_all();
+      }
+    , 4);
+
+  {
+    lock l(m);
+    blocker.run();
+    cv.wait_for(l, ms(500), [&started] () { return started; });
+  }
+  BOOST_REQUIRE(started);
+
+  for (int i = 0; i < 4; ++i)
+    BOOST_CHECK(ch.try_send(i));
+  BOOST_CHECK(!ch.try_send(4));
+  BOOST_CHECK_THROW(ch.send(4), cool::ng::exception::operation_failed);
+
+  {
+    lock l(m);
+    blocked = false;
+    cv.notify_all();
+    cv.wait_for(l, ms(500), [&result] () { return result.size() == 4; });
+  }
+
+  BOOST_REQUIRE_EQUAL(4, result.size());
+  for (int i = 0; i < 4; ++i)
+    BOOST_CHECK_EQUAL(i, result[i]);
+
+  // room again after delivery
+  ch.send(4);
+  {
+    lock l(m);
+    cv.wait_for(l, ms(500), [&result] () { return result.size() == 5; });
+  }
+  BOOST_REQUIRE_EQUAL(5, result.size());
+  BOOST_CHECK_EQUAL(4, result[4]);
+}
+
+BOOST_AUTO_TEST_CASE(illegal_use)
+{
+  auto r = std::make_shared<test_runner>();
+  std::function<void(const std::shared_ptr<test_runner>&, std::vector<int>&)> empty;
+  auto handler = [] (const std::shared_ptr<test_runner>&, std::vector<int>&) { };
+
+  BOOST_CHECK_THROW(
+      async::channel<int>(std::weak_ptr<test_runner>(r), empty)
+    , cool::ng::exception::illegal_argument);
+  BOOST_CHECK_THROW(
+      async::channel<int>(std::weak_ptr<test_runner>(r), handler, 0, 0)
+    , cool::ng::exception::illegal_argument);
+
+  async::channel<int> ch;
+  BOOST_CHECK(!ch);
+  BOOST_CHECK_THROW(ch.send(1), cool::ng::exception::empty_object);
+
+  ch = async::channel<int>(std::weak_ptr<test_runner>(r), handler);
+  BOOST_CHECK(static_cast<bool>(ch));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+
+#define BOOST_TEST_MODULE DatagramEventSources
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+
+BOOST_AUTO_TEST_SUITE(datagram_sources)
+
+namespace async = cool::ng::async;
+namespace exc = cool::ng::exception;
+namespace ipv4 = cool::ng::net::ipv4;
+namespace ip = cool::ng::net::ip;
+
+class test_runner : public cool::ng::async::runner
+{ };
+
+void spin_wait(unsigned int msec, const std::function<bool()>& lambda)
+{
+  auto start = std::chrono::system_clock::now();
+  while (!lambda())
+  {
+    auto now = std::chrono::system_clock::now();
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() >= msec)
+      return;
+    std::this_thread::sleep_for(ms(1));
+  }
+}
+
+struct collector
+{
+  void operator ()(const std::shared_ptr<test_runner>&, const async::net::datagram_message* msgs_, std::size_t count_)
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    ++m_batches;
+    for (std::size_t i = 0; i < count_; ++i)
+    {
+      m_data.push_back(std::string(static_cast<const char*>(msgs_[i].data), msgs_[i].size));
+      m_ports.push_back(msgs_[i].port);
+      m_peers.push_back(msgs_[i].peer);
+    }
+  }
+  std::size_t size()
+  {
+    std::unique_lock<std::mutex> l(m_mutex);
+    return m_data.size();
+  }
+
+  std::mutex               m_mutex;
+  std::size_t              m_batches = 0;
+  std::vector<std::string> m_data;
+  std::vector<uint16_t>    m_ports;
+  std::vector<ip::host_container> m_peers;
+};
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+  auto r = std::make_shared<test_runner>();
+  auto rcv = std::make_shared<collector>();
+  auto snd = std::make_shared<collector>();
+
+  async::net::datagram receiver(
+      std::weak_ptr<test_runner>(r)
+    , ipv4::loopback
+    , 12141
+    , [rcv] (const std::shared_ptr<test_runner>& r_, const async::net::datagram_message* m_, std::size_t c_)
+      { (*rcv)(r_, m_, c_); });
+  async::net::datagram sender(
+      std::weak_ptr<test_runner>(r)
+    , ipv4::loopback
+    , 12142
+    , [snd] (const std::shared_ptr<test_runner>& r_, const async::net::datagram_message* m_, std::size_t c_)
+      { (*snd)(r_, m_, c_); }
+    , 8);
+
+  std::vector<std::string> payloads;
+  for (int i = 0; i < 100; ++i)
+    payloads.push_back("datagram " + std::to_string(i));
+
+  std::vector<async::net::datagram_message> msgs(payloads.size());
+  for (std::size_t i = 0; i < payloads.size(); ++i)
+  {
+    msgs[i].data = payloads[i].data();
+    msgs[i].size = payloads[i].size();
+    msgs[i].peer = ipv4::loopback;
+    msgs[i].port = 12141;
+  }
+  BOOST_CHECK_EQUAL(100, sender.send(msgs));
+  BOOST_CHECK(sender.send(ipv4::loopback, 12141, "last", 4));
+
+  spin_wait(2000, [rcv]() { return rcv->size() >= 101; });
+  std::unique_lock<std::mutex> l(rcv->m_mutex);
+  BOOST_REQUIRE_EQUAL(101, rcv->m_data.size());
+  for (std::size_t i = 0; i < payloads.size(); ++i)
+    BOOST_CHECK_EQUAL(payloads[i], rcv->m_data[i]);
+  BOOST_CHECK_EQUAL("last", rcv->m_data[100]);
+  for (std::size_t i = 0; i < rcv->m_data.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(12142, rcv->m_ports[i]);
+    BOOST_CHECK(static_cast<const ip::address&>(rcv->m_peers[i]) == ipv4::loopback);
+  }
+  // with several datagrams queued the handler receives them in batches
+  BOOST_CHECK(rcv->m_batches <= rcv->m_data.size());
+}
+
+// The datagrams longer than the receive size are dropped, also when they
+// fill the whole batch, while the others are delivered intact.
+BOOST_AUTO_TEST_CASE(truncated)
+{
+  auto r = std::make_shared<test_runner>();
+  auto rcv = std::make_shared<collector>();
+  auto handler = [rcv] (const std::shared_ptr<test_runner>& r_, const async::net::datagram_message* m_, std::size_t c_)
+    { (*rcv)(r_, m_, c_); };
+
+  async::net::datagram receiver(std::weak_ptr<test_runner>(r), ipv4::loopback, 12146, handler, 4, 8);
+  async::net::datagram sender(std::weak_ptr<test_runner>(r), ipv4::loopback, 12147, handler);
+
+  BOOST_CHECK(sender.send(ipv4::loopback, 12146, "first", 5));
+  BOOST_CHECK(sender.send(ipv4::loopback, 12146, "much too long", 13));
+  BOOST_CHECK(sender.send(ipv4::loopback, 12146, "12345678", 8));
+  for (int i = 0; i < 10; ++i)
+    BOOST_CHECK(sender.send(ipv4::loopback, 12146, "too long as well", 16));
+  BOOST_CHECK(sender.send(ipv4::loopback, 12146, "last", 4));
+
+  spin_wait(2000, [rcv]() { return rcv->size() >= 3; });
+  std::this_thread::sleep_for(ms(50));
+  std::unique_lock<std::mutex> l(rcv->m_mutex);
+  BOOST_REQUIRE_EQUAL(3, rcv->m_data.size());
+  BOOST_CHECK_EQUAL("first", rcv->m_data[0]);
+  BOOST_CHECK_EQUAL("12345678", rcv->m_data[1]);
+  BOOST_CHECK_EQUAL("last", rcv->m_data[2]);
+}
+
+BOOST_AUTO_TEST_CASE(multicast)
+{
+  auto r = std::make_shared<test_runner>();
+  auto rcv = std::make_shared<collector>();
+  auto handler = [rcv] (const std::shared_ptr<test_runner>& r_, const async::net::datagram_message* m_, std::size_t c_)
+    { (*rcv)(r_, m_, c_); };
+
+  ipv4::host group("239.255.12.143");
+  async::net::datagram receiver(std::weak_ptr<test_runner>(r), ipv4::any, 12143, handler);
+  async::net::datagram sender(std::weak_ptr<test_runner>(r), ipv4::any, 12144, handler);
+
+  receiver.join(group);
+  BOOST_CHECK(sender.send(group, 12143, "hello group", 11));
+
+  spin_wait(2000, [rcv]() { return rcv->size() >= 1; });
+  {
+    std::unique_lock<std::mutex> l(rcv->m_mutex);
+    BOOST_REQUIRE_EQUAL(1, rcv->m_data.size());
+    BOOST_CHECK_EQUAL("hello group", rcv->m_data[0]);
+  }
+
+  receiver.leave(group);
+  BOOST_CHECK_THROW(receiver.leave(group), exc::socket_failure);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+  auto r = std::make_shared<test_runner>();
+  auto handler = [] (const std::shared_ptr<test_runner>&, const async::net::datagram_message*, std::size_t)
+    { };
+
+  async::net::datagram empty;
+  BOOST_CHECK(!empty);
+  BOOST_CHECK_THROW(empty.send(ipv4::loopback, 12145, "x", 1), exc::empty_object);
+  BOOST_CHECK_THROW(empty.join(ipv4::host("239.255.12.145")), exc::empty_object);
+
+  BOOST_CHECK_THROW(
+      async::net::datagram(std::weak_ptr<test_runner>(r), ipv4::loopback, 12145, handler, 0)
+    , exc::illegal_argument);
+  BOOST_CHECK_THROW(
+      async::net::datagram(std::weak_ptr<test_runner>(r), ipv4::loopback, 12145, handler, 8, 0)
+    , exc::illegal_argument);
+
+  async::net::datagram first(std::weak_ptr<test_runner>(r), ipv4::loopback, 12145, handler);
+  BOOST_CHECK(!!first);
+  BOOST_CHECK_THROW(
+      async::net::datagram(std::weak_ptr<test_runner>(r), ipv4::loopback, 12145, handler)
+    , exc::socket_failure);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
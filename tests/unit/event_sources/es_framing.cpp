@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <system_error>
+
+#define BOOST_TEST_MODULE FramingEventSources
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/async.h"
+
+BOOST_AUTO_TEST_SUITE(framing)
+
+namespace async = cool::ng::async;
+namespace net = cool::ng::async::net;
+namespace exc = cool::ng::exception;
+
+class test_runner : public cool::ng::async::runner
+{ };
+
+struct collector
+{
+  void operator()(const void* data_, std::size_t size_)
+  {
+    auto p = static_cast<const char*>(data_);
+    frames.push_back(std::string(p, size_));
+    addresses.push_back(p);
+  }
+
+  std::vector<std::string> frames;
+  std::vector<const char*> addresses;
+};
+
+std::string length_frame(const std::string& payload_, std::size_t prefix_, net::byte_order order_)
+{
+  std::string result(prefix_, '\0');
+  uint64_t size = payload_.size();
+  for (std::size_t i = 0; i < prefix_; ++i)
+  {
+    auto shift = order_ == net::byte_order::big_endian ? 8 * (prefix_ - 1 - i) : 8 * i;
+    result[i] = static_cast<char>((size >> shift) & 0xff);
+  }
+  return result + payload_;
+}
+
+BOOST_AUTO_TEST_CASE(factories)
+{
+  BOOST_CHECK_THROW(net::framer::length_prefixed(3), exc::illegal_argument);
+  BOOST_CHECK_THROW(net::framer::length_prefixed(0), exc::illegal_argument);
+  BOOST_CHECK_THROW(net::framer::length_prefixed(4, net::byte_order::big_endian, 0), exc::illegal_argument);
+  BOOST_CHECK_THROW(net::framer::delimited(""), exc::illegal_argument);
+  BOOST_CHECK_THROW(net::framer::delimited("\n", 0), exc::illegal_argument);
+  BOOST_CHECK_THROW(net::framer::fixed(0), exc::illegal_argument);
+
+  BOOST_CHECK_NO_THROW(net::framer::length_prefixed(1));
+  BOOST_CHECK_NO_THROW(net::framer::length_prefixed(8, net::byte_order::little_endian));
+  BOOST_CHECK_NO_THROW(net::framer::delimited("\r\n"));
+  BOOST_CHECK_NO_THROW(net::framer::fixed(16));
+}
+
+BOOST_AUTO_TEST_CASE(length_prefixed)
+{
+  std::vector<std::string> payloads = { "one", "", std::string(300, 'x'), "four" };
+
+  for (auto order : { net::byte_order::big_endian, net::byte_order::little_endian })
+  {
+    for (std::size_t prefix : { 2, 4, 8 })
+    {
+      auto f = net::framer::length_prefixed(prefix, order);
+      std::string data;
+      for (auto& p : payloads)
+        data += length_frame(p, prefix, order);
+
+      collector c;
+      f.feed(data.data(), data.size(), std::ref(c));
+      BOOST_CHECK(c.frames == payloads);
+      BOOST_CHECK_EQUAL(0, f.pending());
+
+      // all frames were passed in place
+      for (auto addr : c.addresses)
+      {
+        BOOST_CHECK(addr >= data.data());
+        BOOST_CHECK(addr <= data.data() + data.size());
+      }
+    }
+  }
+
+  {
+    auto f = net::framer::length_prefixed(1);
+    auto data = length_frame("short", 1, net::byte_order::big_endian);
+    collector c;
+    f.feed(data.data(), data.size(), std::ref(c));
+    BOOST_REQUIRE_EQUAL(1, c.frames.size());
+    BOOST_CHECK_EQUAL("short", c.frames[0]);
+    BOOST_CHECK(c.addresses[0] == data.data() + 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(split_frames)
+{
+  std::vector<std::string> payloads = { "alpha", "beta", std::string(1000, 'g'), "delta" };
+
+  {
+    auto f = net::framer::length_prefixed(4);
+    std::string data;
+    for (auto& p : payloads)
+      data += length_frame(p, 4, net::byte_order::big_endian);
+
+    collector c;
+    for (std::size_t i = 0; i < data.size(); ++i)
+      f.feed(data.data() + i, 1, std::ref(c));
+    BOOST_CHECK(c.frames == payloads);
+    BOOST_CHECK_EQUAL(0, f.pending());
+  }
+
+  {
+    auto f = net::framer::length_prefixed(2, net::byte_order::little_endian);
+    std::string data;
+    for (auto& p : payloads)
+      data += length_frame(p, 2, net::byte_order::little_endian);
+
+    // feed in chunks that split both the prefixes and the payloads
+    collector c;
+    for (std::size_t i = 0; i < data.size(); i += 7)
+      f.feed(data.data() + i, std::min<std::size_t>(7, data.size() - i), std::ref(c));
+    BOOST_CHECK(c.frames == payloads);
+    BOOST_CHECK_EQUAL(0, f.pending());
+  }
+
+  {
+    auto f = net::framer::length_prefixed(4);
+    auto data = length_frame("incomplete", 4, net::byte_order::big_endian);
+    collector c;
+    f.feed(data.data(), 6, std::ref(c));
+    BOOST_CHECK(c.frames.empty());
+    BOOST_CHECK_EQUAL(6, f.pending());
+    f.reset();
+    BOOST_CHECK_EQUAL(0, f.pending());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(delimited)
+{
+  {
+    auto f = net::framer::delimited("\r\n");
+    std::string data = "GET / HTTP/1.1\r\nHost: x\r\n\r\nrest";
+    collector c;
+    f.feed(data.data(), data.size(), std::ref(c));
+    BOOST_REQUIRE_EQUAL(3, c.frames.size());
+    BOOST_CHECK_EQUAL("GET / HTTP/1.1", c.frames[0]);
+    BOOST_CHECK_EQUAL("Host: x", c.frames[1]);
+    BOOST_CHECK_EQUAL("", c.frames[2]);
+    BOOST_CHECK(c.addresses[0] == data.data());
+    BOOST_CHECK_EQUAL(4, f.pending());
+
+    std::string more = "\r\n";
+    f.feed(more.data(), more.size(), std::ref(c));
+    BOOST_REQUIRE_EQUAL(4, c.frames.size());
+    BOOST_CHECK_EQUAL("rest", c.frames[3]);
+    BOOST_CHECK_EQUAL(0, f.pending());
+  }
+
+  // delimiter spanning the boundary between the feeds
+  {
+    auto f = net::framer::delimited("<|>");
+    std::string data = "first<|>second<|>third<|>";
+    for (std::size_t split = 1; split < data.size(); ++split)
+    {
+      collector c;
+      f.feed(data.data(), split, std::ref(c));
+      f.feed(data.data() + split, data.size() - split, std::ref(c));
+      BOOST_REQUIRE_EQUAL(3, c.frames.size());
+      BOOST_CHECK_EQUAL("first", c.frames[0]);
+      BOOST_CHECK_EQUAL("second", c.frames[1]);
+      BOOST_CHECK_EQUAL("third", c.frames[2]);
+      BOOST_CHECK_EQUAL(0, f.pending());
+    }
+  }
+
+  // byte by byte, with a delimiter prefix repeated in the payload
+  {
+    auto f = net::framer::delimited("ab");
+    std::string data = "aaab" "b" "aab";
+    collector c;
+    for (std::size_t i = 0; i < data.size(); ++i)
+      f.feed(data.data() + i, 1, std::ref(c));
+    BOOST_REQUIRE_EQUAL(2, c.frames.size());
+    BOOST_CHECK_EQUAL("aa", c.frames[0]);
+    BOOST_CHECK_EQUAL("ba", c.frames[1]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(fixed)
+{
+  auto f = net::framer::fixed(4);
+  std::string data = "abcdefghijkl";
+
+  {
+    collector c;
+    f.feed(data.data(), 10, std::ref(c));
+    BOOST_REQUIRE_EQUAL(2, c.frames.size());
+    BOOST_CHECK_EQUAL("abcd", c.frames[0]);
+    BOOST_CHECK_EQUAL("efgh", c.frames[1]);
+    BOOST_CHECK(c.addresses[1] == data.data() + 4);
+    BOOST_CHECK_EQUAL(2, f.pending());
+
+    f.feed(data.data() + 10, 1, std::ref(c));
+    BOOST_CHECK_EQUAL(2, c.frames.size());
+    f.feed(data.data() + 11, 1, std::ref(c));
+    BOOST_REQUIRE_EQUAL(3, c.frames.size());
+    BOOST_CHECK_EQUAL("ijkl", c.frames[2]);
+    BOOST_CHECK_EQUAL(0, f.pending());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(oversize)
+{
+  {
+    auto f = net::framer::length_prefixed(4, net::byte_order::big_endian, 100);
+    auto data = length_frame(std::string(101, 'x'), 4, net::byte_order::big_endian);
+    collector c;
+    BOOST_CHECK_THROW(f.feed(data.data(), data.size(), std::ref(c)), exc::parsing_error);
+    BOOST_CHECK(c.frames.empty());
+    BOOST_CHECK_EQUAL(0, f.pending());
+
+    // rejected as soon as the prefix is complete
+    BOOST_CHECK_NO_THROW(f.feed(data.data(), 3, std::ref(c)));
+    BOOST_CHECK_THROW(f.feed(data.data() + 3, 1, std::ref(c)), exc::parsing_error);
+    BOOST_CHECK_EQUAL(0, f.pending());
+
+    auto ok = length_frame(std::string(100, 'y'), 4, net::byte_order::big_endian);
+    f.feed(ok.data(), ok.size(), std::ref(c));
+    BOOST_REQUIRE_EQUAL(1, c.frames.size());
+    BOOST_CHECK_EQUAL(100, c.frames[0].size());
+  }
+
+  {
+    auto f = net::framer::delimited("\n", 8);
+    collector c;
+    std::string data = "12345678\n";
+    f.feed(data.data(), data.size(), std::ref(c));
+    BOOST_REQUIRE_EQUAL(1, c.frames.size());
+
+    data = "123456789\n";
+    BOOST_CHECK_THROW(f.feed(data.data(), data.size(), std::ref(c)), exc::parsing_error);
+    for (std::size_t i = 0; i < 8; ++i)
+      f.feed(data.data() + i, 1, std::ref(c));
+    BOOST_CHECK_THROW(f.feed(data.data() + 8, 1, std::ref(c)), exc::parsing_error);
+    BOOST_CHECK_EQUAL(0, f.pending());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(read_handler)
+{
+  auto r = std::make_shared<test_runner>();
+  std::vector<std::string> frames;
+  std::error_code error;
+
+  auto handler = net::framed<test_runner>(
+      net::framer::length_prefixed(2)
+    , [&frames] (const std::shared_ptr<test_runner>&, const void* data_, std::size_t size_)
+      {
+        frames.push_back(std::string(static_cast<const char*>(data_), size_));
+      }
+    , [&error] (const std::shared_ptr<test_runner>&, const std::error_code& e_)
+      {
+        error = e_;
+      });
+
+  std::string data = length_frame("hello", 2, net::byte_order::big_endian)
+                   + length_frame("world", 2, net::byte_order::big_endian);
+  void* buf = &data[0];
+  std::size_t size = 9;
+
+  handler(r, buf, size);
+  BOOST_REQUIRE_EQUAL(1, frames.size());
+  BOOST_CHECK_EQUAL("hello", frames[0]);
+  BOOST_CHECK(buf == &data[0]);
+  BOOST_CHECK_EQUAL(9, size);
+
+  buf = &data[9];
+  size = data.size() - 9;
+  handler(r, buf, size);
+  BOOST_REQUIRE_EQUAL(2, frames.size());
+  BOOST_CHECK_EQUAL("world", frames[1]);
+  BOOST_CHECK(!error);
+
+  std::string bad("\xff\xff", 2);
+  buf = &bad[0];
+  size = bad.size();
+  auto limited = net::framed<test_runner>(
+      net::framer::length_prefixed(2, net::byte_order::big_endian, 10)
+    , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t) { }
+    , [&error] (const std::shared_ptr<test_runner>&, const std::error_code& e_)
+      {
+        error = e_;
+      });
+  limited(r, buf, size);
+  BOOST_CHECK(error == cool::ng::error::errc::parsing_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
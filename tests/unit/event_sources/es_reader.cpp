@@ -30,6 +30,10 @@
 #else
 # include <sys/types.h>
 # include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <dirent.h>
+# include <unistd.h>
 #endif
 
 #include <iostream>
@@ -42,7 +46,11 @@
 #include <mutex>
 #include <thread>
 #include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <cstdlib>
 #include <condition_variable>
 #include <exception>
@@ -68,6 +76,15 @@
 #define TEST10 1
 #define TEST11 1
 #define TEST12 0  // this test may require shutting  down network interfaces
+#define TEST13 1
+#define TEST14 1
+#define TEST15 1
+#define TEST16 1
+#define TEST17 1
+#define TEST18 1
+#define TEST19 1
+#define TEST20 1
+#define TEST21 1
 
 using ms = std::chrono::milliseconds;
 using std::placeholders::_1;
@@ -823,6 +840,7 @@ BOOST_AUTO_TEST_CASE(connect_disconnect_connect_disconnect_test)
 
     std::cout << "client's name is " << client.name() << "\n";
 
+    BOOST_CHECK_THROW(client.write("x", 1), cool::ng::exception::invalid_state);
     client.connect(cool::ng::net::ipv6::loopback, 22229);
 
     spin_wait(500, [&clt_connected, &srv_connected] () { return clt_connected && srv_connected; } );
@@ -836,6 +854,7 @@ BOOST_AUTO_TEST_CASE(connect_disconnect_connect_disconnect_test)
     BOOST_CHECK_EQUAL(true, clt_connected);
     BOOST_CHECK_EQUAL(false, srv_connected);
     BOOST_CHECK_EQUAL(false, !!srv_stream);
+    BOOST_CHECK_THROW(client.write("x", 1), cool::ng::exception::invalid_state);
 
     clt_connected = false;
     client.connect(cool::ng::net::ipv4::loopback, 22229);
@@ -843,6 +862,7 @@ BOOST_AUTO_TEST_CASE(connect_disconnect_connect_disconnect_test)
     BOOST_CHECK_EQUAL(true, clt_connected);
     BOOST_CHECK_EQUAL(true, srv_connected);
     BOOST_CHECK_EQUAL(true, !!srv_stream);
+    BOOST_CHECK_NO_THROW(client.write("x", 1));
 
     client.disconnect();
     std::this_thread::sleep_for(ms(100));  // make sure scoped variables remain in life for server's lambda
@@ -1182,6 +1202,8 @@ BOOST_AUTO_TEST_CASE(long_connect_interrupted)
               rep_disconn = true; break;
             case oob_event::failure:
               rep_fail = true; err = e_; break;
+            default:
+              break;
           }
         }
     );
@@ -1272,6 +1294,8 @@ BOOST_AUTO_TEST_CASE(no_service)
               rep_disconn = true; break;
             case oob_event::failure:
               rep_fail = true; err = e_; break;
+            default:
+              break;
           }
         }
     );
@@ -1324,6 +1348,8 @@ BOOST_AUTO_TEST_CASE(destination_unreachable)
               rep_disconn = true; break;
             case oob_event::failure:
               rep_fail = true; err = e_; break;
+            default:
+              break;
           }
         }
     );
@@ -1347,6 +1373,955 @@ BOOST_AUTO_TEST_CASE(destination_unreachable)
 }
 #endif
 
+#if TEST13 == 1
+// Several writes are issued without waiting for the write handler; the stream
+// queues them and the peer must receive the data in order.
+BOOST_AUTO_TEST_CASE(queued_writes)
+{
+  check_start_sockets();
+
+  std::string header("HEADER:");
+  std::string body(100000, 'b');
+  std::string trailer(":TRAILER");
+  std::vector<uint8_t> owned(50000, 'o');
+  std::string expected = header + body + trailer + std::string(owned.begin(), owned.end());
+
+  auto r = std::make_shared<test_runner>();
+  auto r2 = std::make_shared<test_runner>();
+
+  {
+    cool::ng::async::net::stream srv_stream;
+    std::mutex m;
+    std::string received;
+    std::vector<std::size_t> written;
+    std::atomic<bool> srv_connect(false);
+    std::atomic<bool> clt_connect(false);
+
+    auto server = async::net::server(
+        std::weak_ptr<test_runner>(r)
+      , ipv4::any
+      , 12131
+      , std::bind(stream_factory, _1, _2, _3, r
+            , [](const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+              { }
+            , [&m, &written](const std::shared_ptr<test_runner>&, const void*, std::size_t s_)
+              {
+                std::unique_lock<std::mutex> l(m);
+                written.push_back(s_);
+              }
+            , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+              { }
+        )
+      , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+        {
+          srv_stream = s_;
+          srv_connect = true;
+        }
+    );
+    server.start();
+
+    auto clt_stream = std::make_shared<async::net::stream>(
+          std::weak_ptr<test_runner>(r2)
+        , [&m, &received] (const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+          {
+            std::unique_lock<std::mutex> l(m);
+            received.append(static_cast<const char*>(b_), s_);
+          }
+        , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+          { }
+        , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+          {
+            clt_connect = true;
+          }
+        , nullptr
+        , 4096
+      );
+    clt_stream->connect(ipv4::loopback, 12131);
+
+    spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+    BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+    srv_stream.write(header.data(), header.size());
+    srv_stream.write({ { body.data(), body.size() }, { trailer.data(), trailer.size() } });
+    srv_stream.write(std::move(owned));
+
+    spin_wait(5000,
+      [&m, &received, &written, &expected] ()
+      {
+        std::unique_lock<std::mutex> l(m);
+        return received.size() >= expected.size() && written.size() == 4;
+      });
+
+    std::unique_lock<std::mutex> l(m);
+    BOOST_CHECK(received == expected);
+    BOOST_REQUIRE_EQUAL(4, written.size());
+    BOOST_CHECK_EQUAL(header.size(), written[0]);
+    BOOST_CHECK_EQUAL(body.size(), written[1]);
+    BOOST_CHECK_EQUAL(trailer.size(), written[2]);
+    BOOST_CHECK_EQUAL(50000, written[3]);
+  }
+  std::this_thread::sleep_for(ms(100));
+}
+#endif
+
+#if TEST14 == 1
+// Bulk transfer into a small read buffer, with both a small and a large read
+// budget, must deliver all data in order. The budget of one read must make
+// a single read per event, while the large budget makes several. Each run
+// uses its own port so that the second server does not race the first one's
+// listening socket.
+BOOST_AUTO_TEST_CASE(read_budget)
+{
+  check_start_sockets();
+
+  std::vector<uint8_t> data(1000000);
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i % 251);
+
+  auto r = std::make_shared<test_runner>();
+  auto r2 = std::make_shared<test_runner>();
+
+  const struct { std::size_t budget; uint16_t port; } runs[] = { { 1, 12132 }, { 1000, 12138 } };
+  for (auto& run : runs)
+  {
+    auto budget = run.budget;
+    cool::ng::async::net::stream srv_stream;
+    std::mutex m;
+    std::vector<uint8_t> received;
+    std::atomic<bool> srv_connect(false);
+    std::atomic<bool> clt_connect(false);
+
+    auto server = async::net::server(
+        std::weak_ptr<test_runner>(r)
+      , ipv4::any
+      , run.port
+      , std::bind(stream_factory, _1, _2, _3, r
+            , [](const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+              { }
+            , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+              { }
+            , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+              { }
+        )
+      , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+        {
+          srv_stream = s_;
+          srv_connect = true;
+        }
+    );
+    server.start();
+
+    auto clt_stream = std::make_shared<async::net::stream>(
+          std::weak_ptr<test_runner>(r2)
+        , [&m, &received] (const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+          {
+            std::unique_lock<std::mutex> l(m);
+            auto p = static_cast<const uint8_t*>(b_);
+            received.insert(received.end(), p, p + s_);
+          }
+        , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+          { }
+        , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+          {
+            clt_connect = true;
+          }
+        , nullptr
+        , 4096
+      );
+    BOOST_CHECK_THROW(clt_stream->read_budget(0, 1), cool::ng::exception::illegal_argument);
+    BOOST_CHECK_THROW(clt_stream->read_budget(1, 0), cool::ng::exception::illegal_argument);
+    clt_stream->read_budget(budget * 4096, budget);
+    clt_stream->connect(ipv4::loopback, run.port);
+
+    spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+    BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+    srv_stream.write(data.data(), data.size());
+    spin_wait(5000,
+      [&m, &received, &data] ()
+      {
+        std::unique_lock<std::mutex> l(m);
+        return received.size() >= data.size();
+      });
+
+    std::unique_lock<std::mutex> l(m);
+    BOOST_CHECK(received == data);
+
+    auto s = clt_stream->stats();
+    BOOST_CHECK_GE(s.read_events, 1);
+    if (budget == 1)
+      BOOST_CHECK_LE(s.reads, s.read_events);
+    else
+      BOOST_CHECK_GT(s.reads, s.read_events);
+  }
+  std::this_thread::sleep_for(ms(100));
+}
+#endif
+
+#if TEST15 == 1
+// The read handler keeps every other pooled buffer instead of copying the
+// data; the kept buffers must not be overwritten by the subsequent reads.
+BOOST_AUTO_TEST_CASE(pooled_read_buffers)
+{
+  check_start_sockets();
+
+  BOOST_CHECK(!async::net::stream::retain_read_buffer());
+
+  std::vector<uint8_t> data(1000000);
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i % 251);
+
+  auto r = std::make_shared<test_runner>();
+  auto r2 = std::make_shared<test_runner>();
+
+  cool::ng::async::net::stream srv_stream;
+  std::mutex m;
+  std::vector<std::pair<std::shared_ptr<uint8_t>, std::vector<uint8_t>>> chunks;
+  std::size_t total = 0;
+  bool retained = true;
+  std::atomic<bool> srv_connect(false);
+  std::atomic<bool> clt_connect(false);
+
+  auto server = async::net::server(
+      std::weak_ptr<test_runner>(r)
+    , ipv4::any
+    , 12133
+    , std::bind(stream_factory, _1, _2, _3, r
+          , [](const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+            { }
+          , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+            { }
+          , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+            { }
+      )
+    , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+      {
+        srv_stream = s_;
+        srv_connect = true;
+      }
+  );
+  server.start();
+
+  auto clt_stream = std::make_shared<async::net::stream>(
+        std::weak_ptr<test_runner>(r2)
+      , [&m, &chunks, &total, &retained] (const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+        {
+          std::unique_lock<std::mutex> l(m);
+          auto p = static_cast<const uint8_t*>(b_);
+          auto buf = async::net::stream::retain_read_buffer();
+          if (!buf || buf.get() != p)
+            retained = false;
+
+          if (chunks.size() % 2 == 0)
+            chunks.push_back(std::make_pair(buf, std::vector<uint8_t>(p, p + s_)));
+          else
+            chunks.push_back(std::make_pair(std::shared_ptr<uint8_t>(), std::vector<uint8_t>(p, p + s_)));
+          total += s_;
+        }
+      , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+        { }
+      , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+        {
+          clt_connect = true;
+        }
+      , nullptr
+      , 4096
+    );
+  clt_stream->connect(ipv4::loopback, 12133);
+
+  spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+  BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+  srv_stream.write(data.data(), data.size());
+  spin_wait(5000,
+    [&m, &total, &data] ()
+    {
+      std::unique_lock<std::mutex> l(m);
+      return total >= data.size();
+    });
+
+  std::unique_lock<std::mutex> l(m);
+  BOOST_CHECK(retained);
+  BOOST_REQUIRE_EQUAL(total, data.size());
+
+  // the retained buffers still hold the data they were read with
+  std::vector<uint8_t> received;
+  for (auto& c : chunks)
+  {
+    if (c.first)
+      BOOST_CHECK(std::equal(c.second.begin(), c.second.end(), c.first.get()));
+    received.insert(received.end(), c.second.begin(), c.second.end());
+  }
+  BOOST_CHECK(received == data);
+  l.unlock();
+
+  std::this_thread::sleep_for(ms(100));
+}
+#endif
+
+#if TEST16 == 1 && defined(LINUX_TARGET)
+namespace {
+
+long open_descriptors()
+{
+  long ret = 0;
+  auto dir = ::opendir("/proc/self/fd");
+  if (dir == nullptr)
+    return 0;
+  while (::readdir(dir) != nullptr)
+    ++ret;
+  ::closedir(dir);
+  return ret;
+}
+
+// waits for the descriptors of the previous tests, closed asynchronously by
+// their event sources, to go away before the count is taken
+long stable_descriptors()
+{
+  auto ret = open_descriptors();
+  for (int stable = 0, i = 0; stable < 5 && i < 100; ++i)
+  {
+    std::this_thread::sleep_for(ms(20));
+    auto now = open_descriptors();
+    stable = now == ret ? stable + 1 : 0;
+    ret = now;
+  }
+  return ret;
+}
+
+} // anonymous namespace
+
+// The connected and the accepted stream must each use a single descriptor
+// for their read and write event sources and release it when closed.
+BOOST_AUTO_TEST_CASE(stream_descriptors)
+{
+  auto r = std::make_shared<test_runner>();
+  cool::ng::async::net::stream srv_stream;
+  std::atomic<bool> srv_connect(false);
+  std::atomic<bool> clt_connect(false);
+  std::mutex m;
+  std::string received;
+
+  auto server = async::net::server(
+      std::weak_ptr<test_runner>(r)
+    , ipv4::any
+    , 12134
+    , std::bind(stream_factory, _1, _2, _3, r
+          , [&m, &received](const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+            {
+              std::unique_lock<std::mutex> l(m);
+              received.append(static_cast<const char*>(b_), s_);
+            }
+          , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+            { }
+          , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+            { }
+      )
+    , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+      {
+        srv_stream = s_;
+        srv_connect = true;
+      }
+  );
+  server.start();
+
+  auto before = stable_descriptors();
+  {
+    async::net::stream clt_stream(
+          std::weak_ptr<test_runner>(r)
+        , [] (const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+          { }
+        , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+          { }
+        , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+          {
+            clt_connect = true;
+          }
+      );
+    clt_stream.connect(ipv4::loopback, 12134);
+
+    spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+    BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+    // one for the connected and one for the accepted stream
+    BOOST_CHECK_EQUAL(2, open_descriptors() - before);
+
+    // the shared descriptor must serve both directions
+    clt_stream.write("hello", 5);
+    spin_wait(2000, [&m, &received]() { std::unique_lock<std::mutex> l(m); return received.size() >= 5; });
+    std::unique_lock<std::mutex> l(m);
+    BOOST_CHECK_EQUAL("hello", received);
+    l.unlock();
+
+    clt_stream.disconnect();
+  }
+  srv_stream = async::net::stream();
+  spin_wait(2000, [before]() { return open_descriptors() <= before; });
+  BOOST_CHECK_LE(open_descriptors(), before);
+}
+#endif
+
+#if TEST17 == 1
+// Server and streams with the tuned sockets must work as usual; the options
+// the platform rejects must be reported at the construction.
+BOOST_AUTO_TEST_CASE(socket_options)
+{
+  check_start_sockets();
+
+  auto r = std::make_shared<test_runner>();
+  cool::ng::async::net::stream srv_stream;
+  std::atomic<bool> srv_connect(false);
+  std::atomic<bool> clt_connect(false);
+  std::mutex m;
+  std::string received;
+
+  async::net::socket_options opts;
+  opts.no_delay = 1;
+  opts.rcv_buf = 1024 * 1024;
+  opts.snd_buf = 1024 * 1024;
+  opts.keep_alive = 1;
+  opts.keep_idle = 60;
+  opts.keep_interval = 10;
+  opts.keep_count = 3;
+  opts.tos = 0x10;
+
+  auto server = async::net::server(
+      std::weak_ptr<test_runner>(r)
+    , ipv4::any
+    , 12135
+    , std::bind(stream_factory, _1, _2, _3, r
+          , [&m, &received](const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+            {
+              std::unique_lock<std::mutex> l(m);
+              received.append(static_cast<const char*>(b_), s_);
+            }
+          , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+            { }
+          , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+            { }
+      )
+    , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+      {
+        srv_stream = s_;
+        srv_connect = true;
+      }
+    , [](const std::shared_ptr<test_runner>&, const std::error_code&)
+      { }
+    , opts
+  );
+  server.start();
+
+  async::net::stream clt_stream(
+        std::weak_ptr<test_runner>(r)
+      , [] (const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+        { }
+      , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+        { }
+      , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+        {
+          clt_connect = true;
+        }
+      , nullptr
+      , 16384
+      , opts
+    );
+  clt_stream.connect(ipv4::loopback, 12135);
+
+  spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+  BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+  clt_stream.write("hello", 5);
+  spin_wait(2000, [&m, &received]() { std::unique_lock<std::mutex> l(m); return received.size() >= 5; });
+  {
+    std::unique_lock<std::mutex> l(m);
+    BOOST_CHECK_EQUAL("hello", received);
+  }
+  clt_stream.disconnect();
+
+#if defined(LINUX_TARGET)
+  // keep-alive idle time must be at least one second
+  async::net::socket_options bad;
+  bad.keep_idle = 0;
+  async::net::stream bad_stream(
+        std::weak_ptr<test_runner>(r)
+      , [] (const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+        { }
+      , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+        { }
+      , [] (const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+        { }
+      , nullptr
+      , 16384
+      , bad
+    );
+  BOOST_CHECK_THROW(bad_stream.connect(ipv4::loopback, 12135), cool::ng::exception::socket_failure);
+#endif
+  std::this_thread::sleep_for(ms(100));
+}
+#endif
+
+#if TEST18 == 1 && !defined(WINDOWS_TARGET)
+namespace {
+
+// connects the client stream to the endpoint, writes to the accepted stream
+// and returns what the client received
+std::string local_roundtrip(const std::shared_ptr<test_runner>& r_, const async::net::local_endpoint& ep_)
+{
+  cool::ng::async::net::stream srv_stream;
+  std::atomic<bool> srv_connect(false);
+  std::atomic<bool> clt_connect(false);
+  std::mutex m;
+  std::string received;
+
+  auto server = async::net::server(
+      std::weak_ptr<test_runner>(r_)
+    , ep_
+    , std::bind(stream_factory, _1, _2, _3, r_
+          , [](const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+            { }
+          , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+            { }
+          , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+            { }
+      )
+    , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+      {
+        srv_stream = s_;
+        srv_connect = true;
+      }
+  );
+  server.start();
+
+  async::net::stream clt_stream(
+        std::weak_ptr<test_runner>(r_)
+      , ep_
+      , [&m, &received] (const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+        {
+          std::unique_lock<std::mutex> l(m);
+          received.append(static_cast<const char*>(b_), s_);
+        }
+      , [] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+        { }
+      , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event e_, const std::error_code&)
+        {
+          if (e_ == oob_event::connect)
+            clt_connect = true;
+        }
+    );
+
+  spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+  BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+  srv_stream.write("hello", 5);
+  spin_wait(2000, [&m, &received]() { std::unique_lock<std::mutex> l(m); return received.size() >= 5; });
+  clt_stream.disconnect();
+  srv_stream = async::net::stream();
+
+  std::unique_lock<std::mutex> l(m);
+  return received;
+}
+
+} // anonymous namespace
+
+// Server and stream must work over the Unix domain sockets, both with the
+// file system path and with the name in the abstract namespace.
+BOOST_AUTO_TEST_CASE(local_endpoints)
+{
+  auto r = std::make_shared<test_runner>();
+
+  const std::string path = "/tmp/cool_ng_es_reader.sock";
+  ::unlink(path.c_str());
+
+  BOOST_CHECK_EQUAL("hello", local_roundtrip(r, async::net::local_endpoint(path)));
+  // the server removes its path when destroyed
+  spin_wait(2000, [&path]() { return ::access(path.c_str(), F_OK) != 0; });
+  BOOST_CHECK(::access(path.c_str(), F_OK) != 0);
+
+#if defined(LINUX_TARGET)
+  BOOST_CHECK_EQUAL("hello", local_roundtrip(r, async::net::local_endpoint("cool_ng_es_reader", true)));
+#endif
+
+  // empty path and the path in use must be rejected
+  auto factory = std::bind(stream_factory, _1, _2, _3, r
+    , [](const std::shared_ptr<test_runner>&, void*&, std::size_t&) { }
+    , [](const std::shared_ptr<test_runner>&, const void*, std::size_t) { }
+    , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&) { });
+  auto on_connect = [](const std::shared_ptr<test_runner>&, const async::net::stream&) { };
+
+  BOOST_CHECK_THROW(
+      async::net::server(std::weak_ptr<test_runner>(r), async::net::local_endpoint(""), factory, on_connect)
+    , cool::ng::exception::illegal_argument);
+  {
+    async::net::server first(std::weak_ptr<test_runner>(r), async::net::local_endpoint(path), factory, on_connect);
+    BOOST_CHECK_THROW(
+        async::net::server(std::weak_ptr<test_runner>(r), async::net::local_endpoint(path), factory, on_connect)
+      , cool::ng::exception::socket_failure);
+  }
+  std::this_thread::sleep_for(ms(100));
+}
+#endif
+
+#if TEST19 == 1 && !defined(WINDOWS_TARGET)
+// The handle passed over the local stream must arrive in order with the
+// data and must not be reported to the write handler.
+BOOST_AUTO_TEST_CASE(pass_handles)
+{
+  auto r = std::make_shared<test_runner>();
+  cool::ng::async::net::stream srv_stream;
+  std::atomic<bool> srv_connect(false);
+  std::atomic<bool> clt_connect(false);
+  std::atomic<int> written(0);
+  std::mutex m;
+  std::string received;
+
+  const std::string path = "/tmp/cool_ng_es_reader_pass.sock";
+  ::unlink(path.c_str());
+
+  async::net::socket_options opts;
+  opts.pass_handles = 1;
+
+  auto server = async::net::server(
+      std::weak_ptr<test_runner>(r)
+    , async::net::local_endpoint(path)
+    , [r, &m, &received, opts](const std::shared_ptr<test_runner>&, const ip::address&, uint16_t)
+      {
+        return async::net::stream(
+              std::weak_ptr<test_runner>(r)
+            , [&m, &received](const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+              {
+                std::unique_lock<std::mutex> l(m);
+                received.append(static_cast<const char*>(b_), s_);
+              }
+            , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+              { }
+            , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+              { }
+            , nullptr
+            , 16384
+            , opts);
+      }
+    , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+      {
+        srv_stream = s_;
+        srv_connect = true;
+      }
+  );
+  server.start();
+
+  async::net::stream clt_stream(
+        std::weak_ptr<test_runner>(r)
+      , async::net::local_endpoint(path)
+      , [] (const std::shared_ptr<test_runner>&, void*&, std::size_t&)
+        { }
+      , [&written] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+        {
+          ++written;
+        }
+      , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event e_, const std::error_code&)
+        {
+          if (e_ == oob_event::connect)
+            clt_connect = true;
+        }
+    );
+
+  spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+  BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+  int pipe_fds[2];
+  BOOST_REQUIRE_EQUAL(0, ::pipe(pipe_fds));
+  BOOST_REQUIRE_EQUAL(3, ::write(pipe_fds[1], "abc", 3));
+
+  clt_stream.write("x", 1);
+  clt_stream.write_handle(pipe_fds[0]);
+  clt_stream.write("y", 1);
+  // the stream passes its own duplicate of the handle
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+
+  spin_wait(2000, [&m, &received]() { std::unique_lock<std::mutex> l(m); return received.size() >= 3; });
+  spin_wait(2000, [&written]() { return written.load() >= 2; });
+  {
+    std::unique_lock<std::mutex> l(m);
+    BOOST_CHECK_EQUAL(std::string("x\0y", 3), received);
+  }
+  BOOST_CHECK_EQUAL(2, written.load());
+
+  auto h = srv_stream.received_handle();
+  BOOST_REQUIRE(h != cool::ng::net::invalid_handle);
+  char buf[4] = { 0 };
+  BOOST_CHECK_EQUAL(3, ::read(h, buf, sizeof(buf)));
+  BOOST_CHECK_EQUAL("abc", std::string(buf));
+  ::close(h);
+  BOOST_CHECK(srv_stream.received_handle() == cool::ng::net::invalid_handle);
+
+  clt_stream.disconnect();
+  srv_stream = async::net::stream();
+  std::this_thread::sleep_for(ms(100));
+}
+#endif
+
+#if TEST20 == 1 && !defined(WINDOWS_TARGET)
+// The stream writing to the peer that does not read must report that its
+// writes are blocked, stop reading if asked so, and report that the writes
+// are unblocked once the peer drained the data or the stream disconnected.
+BOOST_AUTO_TEST_CASE(write_watermarks)
+{
+  auto r = std::make_shared<test_runner>();
+  cool::ng::async::net::stream srv_stream;
+  std::atomic<bool> srv_connect(false);
+  std::mutex m;
+  std::vector<oob_event> events;
+  std::string received;
+
+  auto server = async::net::server(
+      std::weak_ptr<test_runner>(r)
+    , ipv4::any
+    , 12136
+    , std::bind(stream_factory, _1, _2, _3, r
+          , [&m, &received](const std::shared_ptr<test_runner>&, void*& b_, std::size_t& s_)
+            {
+              std::unique_lock<std::mutex> l(m);
+              received.append(static_cast<const char*>(b_), s_);
+            }
+          , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+            { }
+          , [&m, &events](const std::shared_ptr<test_runner>&, oob_event e_, const std::error_code&)
+            {
+              std::unique_lock<std::mutex> l(m);
+              events.push_back(e_);
+            }
+      )
+    , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+      {
+        srv_stream = s_;
+        srv_connect = true;
+      }
+  );
+  server.start();
+
+  auto peer = ::socket(AF_INET, SOCK_STREAM, 0);
+  BOOST_REQUIRE(peer >= 0);
+  {
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(12136);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    BOOST_REQUIRE_EQUAL(0, ::connect(peer, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+  }
+  spin_wait(2000, [&srv_connect]() { return srv_connect.load(); });
+  BOOST_REQUIRE(srv_connect.load());
+
+  BOOST_CHECK_THROW(srv_stream.watermarks(1000, 1000), cool::ng::exception::illegal_argument);
+  srv_stream.watermarks(256 * 1024, 64 * 1024, true);
+
+  // write much more than the socket buffers can take; the peer does not read
+  std::vector<uint8_t> chunk(64 * 1024, 'a');
+  std::size_t total = 0;
+  for (int i = 0; i < 512; ++i)
+  {
+    srv_stream.write(chunk.data(), chunk.size());
+    total += chunk.size();
+  }
+  // the writes may get blocked and unblocked several times until the socket
+  // buffers fill up, but must end up blocked
+  auto check_events = [&m, &events](oob_event last_)
+  {
+    std::unique_lock<std::mutex> l(m);
+    if (events.empty() || events.back() != last_)
+      return false;
+    for (std::size_t i = 0; i < events.size(); ++i)
+      if (events[i] != (i % 2 == 0 ? oob_event::write_blocked : oob_event::write_unblocked))
+        return false;
+    return true;
+  };
+  spin_wait(2000, std::bind(check_events, oob_event::write_blocked));
+  BOOST_REQUIRE(check_events(oob_event::write_blocked));
+  std::size_t count;
+  {
+    std::unique_lock<std::mutex> l(m);
+    count = events.size();
+  }
+
+  // the stream must not read while blocked
+  BOOST_REQUIRE_EQUAL(4, ::send(peer, "ping", 4, 0));
+  std::this_thread::sleep_for(ms(200));
+  {
+    std::unique_lock<std::mutex> l(m);
+    BOOST_CHECK(received.empty());
+    BOOST_CHECK_EQUAL(count, events.size());
+  }
+
+  // drain the data at the peer
+  std::vector<char> buf(64 * 1024);
+  std::size_t drained = 0;
+  while (drained < total)
+  {
+    auto res = ::recv(peer, buf.data(), buf.size(), 0);
+    if (res <= 0)
+      break;
+    drained += static_cast<std::size_t>(res);
+  }
+  BOOST_CHECK_EQUAL(total, drained);
+
+  spin_wait(2000, [&m, &received]() { std::unique_lock<std::mutex> l(m); return received.size() >= 4; });
+  {
+    std::unique_lock<std::mutex> l(m);
+    BOOST_CHECK_EQUAL("ping", received);
+  }
+  BOOST_CHECK(check_events(oob_event::write_unblocked));
+
+  // block the writes again; the disconnect drops the queued data and must
+  // report the writes unblocked
+  for (int i = 0; i < 512; ++i)
+    srv_stream.write(chunk.data(), chunk.size());
+  spin_wait(2000, std::bind(check_events, oob_event::write_blocked));
+  BOOST_REQUIRE(check_events(oob_event::write_blocked));
+  srv_stream.disconnect();
+  spin_wait(2000, std::bind(check_events, oob_event::write_unblocked));
+  BOOST_CHECK(check_events(oob_event::write_unblocked));
+
+  ::close(peer);
+  srv_stream = async::net::stream();
+  std::this_thread::sleep_for(ms(100));
+}
+#endif
+
+#if TEST21 == 1
+// Both sides count the bytes and the system calls, the client records the
+// connect latency, and the server aggregates its accepted connections.
+BOOST_AUTO_TEST_CASE(stream_statistics)
+{
+  check_start_sockets();
+
+  BOOST_CHECK_THROW(async::net::stream().stats(), cool::ng::exception::empty_object);
+  BOOST_CHECK_THROW(async::net::server().stats(), cool::ng::exception::empty_object);
+
+  auto r = std::make_shared<test_runner>();
+  auto r2 = std::make_shared<test_runner>();
+
+  std::vector<uint8_t> data(200000, 0x5a);
+  const std::size_t sizes[] = { 150000, 10, 49990 };
+
+  cool::ng::async::net::stream srv_stream;
+  std::atomic<std::size_t> srv_received(0);
+  std::atomic<std::size_t> clt_received(0);
+  std::atomic<int> clt_written(0);
+  std::atomic<bool> srv_connect(false);
+  std::atomic<bool> clt_connect(false);
+
+  auto server = async::net::server(
+      std::weak_ptr<test_runner>(r)
+    , ipv4::any
+    , 12137
+    , std::bind(stream_factory, _1, _2, _3, r
+          , [&srv_received](const std::shared_ptr<test_runner>&, void*&, std::size_t& s_)
+            {
+              srv_received += s_;
+            }
+          , [](const std::shared_ptr<test_runner>&, const void*, std::size_t)
+            { }
+          , [](const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+            { }
+      )
+    , [&srv_stream, &srv_connect](const std::shared_ptr<test_runner>&, const async::net::stream& s_)
+      {
+        srv_stream = s_;
+        srv_connect = true;
+      }
+  );
+  server.start();
+
+  async::net::stream clt_stream(
+        std::weak_ptr<test_runner>(r2)
+      , [&clt_received] (const std::shared_ptr<test_runner>&, void*&, std::size_t& s_)
+        {
+          clt_received += s_;
+        }
+      , [&clt_written] (const std::shared_ptr<test_runner>&, const void*, std::size_t)
+        {
+          ++clt_written;
+        }
+      , [&clt_connect] (const std::shared_ptr<test_runner>&, oob_event, const std::error_code&)
+        {
+          clt_connect = true;
+        }
+      , nullptr
+      , 4096
+    );
+
+  {
+    auto s = clt_stream.stats();
+    BOOST_CHECK_EQUAL(0, s.connections);
+    BOOST_CHECK_EQUAL(0, s.reads);
+    BOOST_CHECK_EQUAL(0.0, s.bytes_per_read());
+  }
+
+  clt_stream.connect(ipv4::loopback, 12137);
+  spin_wait(2000, [&clt_connect, &srv_connect]() { return clt_connect.load() && srv_connect.load(); });
+  BOOST_REQUIRE(srv_connect.load() && clt_connect.load());
+
+  std::size_t offset = 0;
+  for (auto size : sizes)
+  {
+    clt_stream.write(data.data() + offset, size);
+    offset += size;
+  }
+  spin_wait(5000, [&srv_received, &clt_written, &data]()
+    {
+      return srv_received.load() >= data.size() && clt_written.load() == 3;
+    });
+  BOOST_REQUIRE_EQUAL(data.size(), srv_received.load());
+  BOOST_REQUIRE_EQUAL(3, clt_written.load());
+
+  {
+    auto s = clt_stream.stats();
+    BOOST_CHECK_EQUAL(1, s.connections);
+    BOOST_CHECK_EQUAL(data.size(), s.bytes_out);
+    BOOST_CHECK_GE(s.writes, 1);
+    BOOST_CHECK_GE(s.writes, s.write_again);
+    BOOST_CHECK_EQUAL(1, s.connect_latency.count);
+    BOOST_CHECK_EQUAL(3, s.write_latency.count);
+    BOOST_CHECK_EQUAL(0, s.bytes_in);
+  }
+  {
+    auto s = srv_stream.stats();
+    BOOST_CHECK_EQUAL(1, s.connections);
+    BOOST_CHECK_EQUAL(data.size(), s.bytes_in);
+    BOOST_CHECK_GE(s.reads, 1);
+    BOOST_CHECK_GE(s.reads, s.read_again);
+    BOOST_CHECK_CLOSE(static_cast<double>(s.bytes_in) / s.reads, s.bytes_per_read(), 0.001);
+    BOOST_CHECK_EQUAL(0, s.connect_latency.count);
+    BOOST_CHECK_EQUAL(0, s.bytes_out);
+  }
+  // the aggregate includes the open streams at the time of the snapshot
+  {
+    auto s = server.stats();
+    auto a = srv_stream.stats();
+    BOOST_CHECK_EQUAL(1, s.connections);
+    BOOST_CHECK_EQUAL(data.size(), s.bytes_in);
+    BOOST_CHECK_EQUAL(a.reads, s.reads);
+  }
+
+  srv_stream.write(data.data(), 1000);
+  spin_wait(2000, [&clt_received]() { return clt_received.load() >= 1000; });
+  BOOST_REQUIRE_EQUAL(1000, clt_received.load());
+  BOOST_CHECK_EQUAL(1000, clt_stream.stats().bytes_in);
+
+  // the aggregate outlives the accepted stream
+  srv_stream = async::net::stream();
+  std::this_thread::sleep_for(ms(100));
+  {
+    auto s = server.stats();
+    BOOST_CHECK_EQUAL(1, s.connections);
+    BOOST_CHECK_EQUAL(data.size(), s.bytes_in);
+    BOOST_CHECK_EQUAL(1000, s.bytes_out);
+    BOOST_CHECK_EQUAL(1, s.write_latency.count);
+    BOOST_CHECK_EQUAL(0, s.connect_latency.count);
+  }
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+#define BOOST_TEST_MODULE SignalEventSources
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/bases.h"
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+
+BOOST_AUTO_TEST_SUITE(signal_sources)
+
+namespace async = cool::ng::async;
+namespace exc = cool::ng::exception;
+
+class test_runner : public cool::ng::async::runner
+{ };
+
+void spin_wait(unsigned int msec, const std::function<bool()>& lambda)
+{
+  auto start = std::chrono::system_clock::now();
+  while (!lambda())
+  {
+    auto now = std::chrono::system_clock::now();
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() >= msec)
+      return;
+    std::this_thread::sleep_for(ms(1));
+  }
+}
+
+// occupies the runner until the flag is cleared, so that the triggers
+// arriving meanwhile are coalesced
+void block_runner(const std::shared_ptr<test_runner>& r_, std::atomic<bool>& blocked_)
+{
+  blocked_ = true;
+  async::factory::create(
+      r_
+    , [&blocked_] (const std::shared_ptr<test_runner>&)
+      {
+        while (blocked_)
+          std::this_thread::sleep_for(ms(1));
+      }
+  ).run();
+}
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+  auto r = std::make_shared<test_runner>();
+  std::atomic<unsigned long> value;
+  std::atomic<int> calls;
+  value = 0;
+  calls = 0;
+
+  async::signal_source sig(
+      std::weak_ptr<test_runner>(r)
+    , [&value, &calls] (const std::shared_ptr<test_runner>&, unsigned long v_)
+      {
+        value += v_;
+        ++calls;
+      });
+  BOOST_CHECK(sig);
+  BOOST_CHECK_EQUAL("si.digiverse.ng.cool.signal", sig.name().substr(0, 27));
+
+  sig.trigger();
+  spin_wait(500, [&calls] { return calls == 1; });
+  BOOST_CHECK_EQUAL(1, calls);
+  BOOST_CHECK_EQUAL(1, value);
+
+  sig.trigger(0);
+  std::this_thread::sleep_for(ms(20));
+  BOOST_CHECK_EQUAL(1, calls);
+
+  sig.trigger(5);
+  spin_wait(500, [&calls] { return calls == 2; });
+  BOOST_CHECK_EQUAL(2, calls);
+  BOOST_CHECK_EQUAL(6, value);
+}
+
+BOOST_AUTO_TEST_CASE(coalesce_add)
+{
+  auto r = std::make_shared<test_runner>();
+  std::atomic<unsigned long> value;
+  std::atomic<int> calls;
+  std::atomic<bool> blocked;
+  value = 0;
+  calls = 0;
+
+  async::signal_source sig(
+      std::weak_ptr<test_runner>(r)
+    , [&value, &calls] (const std::shared_ptr<test_runner>&, unsigned long v_)
+      {
+        value += v_;
+        ++calls;
+      });
+
+  block_runner(r, blocked);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back([&sig] { for (int n = 0; n < 250; ++n) sig.trigger(); });
+  for (auto& t : threads)
+    t.join();
+
+  blocked = false;
+  spin_wait(1000, [&value] { return value == 1000; });
+  BOOST_CHECK_EQUAL(1000, value);
+  // the triggers arrived while the runner was busy and are delivered by
+  // at most two handler calls, depending on whether the first trigger was
+  // already dispatched before the runner got blocked
+  BOOST_CHECK_LE(calls, 2);
+}
+
+BOOST_AUTO_TEST_CASE(coalesce_or)
+{
+  auto r = std::make_shared<test_runner>();
+  std::atomic<unsigned long> value;
+  std::atomic<int> calls;
+  std::atomic<bool> blocked;
+  value = 0;
+  calls = 0;
+
+  async::signal_source sig(
+      std::weak_ptr<test_runner>(r)
+    , [&value, &calls] (const std::shared_ptr<test_runner>&, unsigned long v_)
+      {
+        value |= v_;
+        ++calls;
+      }
+    , async::signal_merge::bitwise_or);
+
+  block_runner(r, blocked);
+  for (int i = 0; i < 8; ++i)
+  {
+    sig.trigger(1ul << i);
+    sig.trigger(1ul << i);
+  }
+  blocked = false;
+
+  spin_wait(1000, [&value] { return value == 0xff; });
+  BOOST_CHECK_EQUAL(0xff, value);
+  BOOST_CHECK_LE(calls, 2);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+  async::signal_source empty;
+  BOOST_CHECK(!empty);
+  BOOST_CHECK_THROW(empty.trigger(), exc::empty_object);
+  BOOST_CHECK_THROW(empty.name(), exc::empty_object);
+
+  {
+    std::weak_ptr<test_runner> gone;
+    {
+      auto r = std::make_shared<test_runner>();
+      gone = r;
+    }
+    BOOST_CHECK_THROW(
+        async::signal_source(gone, [] (const std::shared_ptr<test_runner>&, unsigned long) { })
+      , exc::runner_not_available);
+  }
+  {
+    auto r = std::make_shared<test_runner>();
+    std::function<void(const std::shared_ptr<test_runner>&, unsigned long)> h;
+    BOOST_CHECK_THROW(
+        async::signal_source(std::weak_ptr<test_runner>(r), h)
+      , exc::illegal_argument);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(destroy_pending)
+{
+  auto r = std::make_shared<test_runner>();
+  std::atomic<int> calls;
+  std::atomic<bool> blocked;
+  calls = 0;
+
+  block_runner(r, blocked);
+  {
+    async::signal_source sig(
+        std::weak_ptr<test_runner>(r)
+      , [&calls] (const std::shared_ptr<test_runner>&, unsigned long)
+        {
+          ++calls;
+        });
+    sig.trigger();
+  }
+  blocked = false;
+  std::this_thread::sleep_for(ms(50));
+  BOOST_CHECK_LE(calls, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -138,6 +138,121 @@ BOOST_AUTO_TEST_CASE(basic)
 }
 #endif
 
+BOOST_AUTO_TEST_CASE(wheel)
+{
+  auto r1 = std::make_shared<test_runner>();
+
+  {
+    async::timer timer(
+        std::weak_ptr<test_runner>(r1)
+      , [] (const std::shared_ptr<test_runner>& r)
+        {
+          r->inc();
+        }
+      , ms(100)
+      , async::timer_wheel
+    );
+
+    spin_wait(150, [&r1] () { return r1->counter() == 1; });
+    BOOST_CHECK_EQUAL(0 , r1->counter());
+
+    timer.start();
+    spin_wait(250, [&r1] () { return r1->counter() == 2; });
+    timer.stop();
+
+    BOOST_CHECK_EQUAL(2, r1->counter());
+
+    timer.period(ms(200));
+    spin_wait(250, [&r1] () { return r1->counter() == 3; });
+    BOOST_CHECK_EQUAL(2 , r1->counter());
+
+    timer.start();
+    spin_wait(300, [&r1] () { return r1->counter() == 3; });
+    timer.stop();
+
+    BOOST_CHECK_EQUAL(3, r1->counter());
+  }
+  std::this_thread::sleep_for(ms(200)); // give time for cleanup
+}
+
+BOOST_AUTO_TEST_CASE(one_shot)
+{
+  auto r1 = std::make_shared<test_runner>();
+
+  {
+    async::timer timer(
+        std::weak_ptr<test_runner>(r1)
+      , [] (const std::shared_ptr<test_runner>& r)
+        {
+          r->inc();
+        }
+      , ms(50)
+    );
+
+    timer.start_once();
+    spin_wait(200, [&r1] () { return r1->counter() == 2; });
+    BOOST_CHECK_EQUAL(1, r1->counter());
+
+    // keep pushing the deadline back; must not expire while re-armed
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5; ++i)
+    {
+      timer.start_once(ms(60));
+      std::this_thread::sleep_for(ms(20));
+    }
+    BOOST_CHECK_EQUAL(1, r1->counter());
+    spin_wait(300, [&r1] () { return r1->counter() == 2; });
+    BOOST_CHECK_EQUAL(2, r1->counter());
+    BOOST_CHECK(std::chrono::steady_clock::now() - start >= ms(140));
+
+    // re-arm after the expiration
+    timer.start_once(ms(10));
+    spin_wait(200, [&r1] () { return r1->counter() == 3; });
+    BOOST_CHECK_EQUAL(3, r1->counter());
+
+    // disarm
+    timer.start_once(ms(50));
+    timer.stop();
+    std::this_thread::sleep_for(ms(100));
+    BOOST_CHECK_EQUAL(3, r1->counter());
+
+    BOOST_CHECK_THROW(timer.start_once(0), cool::ng::exception::illegal_argument);
+  }
+  std::this_thread::sleep_for(ms(200)); // give time for cleanup
+}
+
+BOOST_AUTO_TEST_CASE(instrumentation)
+{
+  auto r1 = std::make_shared<test_runner>();
+
+  {
+    async::timer::instrument(true);
+    async::timer timer(
+        std::weak_ptr<test_runner>(r1)
+      , [] (const std::shared_ptr<test_runner>& r)
+        {
+          r->inc();
+          std::this_thread::sleep_for(ms(5));    // keep the runner busy
+        }
+      , ms(20)
+    );
+    async::timer::instrument(false);
+
+    timer.start();
+    spin_wait(500, [&r1] () { return r1->counter() >= 5; });
+    timer.stop();
+
+    auto s = timer.stats();
+    BOOST_CHECK_GE(s.fire_delay.count, 5);
+    BOOST_CHECK_GE(s.dispatch_delay.count, 5);
+    uint64_t total = 0;
+    for (auto b : s.fire_delay.buckets)
+      total += b;
+    BOOST_CHECK_EQUAL(s.fire_delay.count, total);
+    BOOST_CHECK_GE(async::timer::aggregate_stats().fire_delay.count, s.fire_delay.count);
+  }
+  std::this_thread::sleep_for(ms(200)); // give time for cleanup
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <chrono>
+
+#define BOOST_TEST_MODULE SimulatedTimer
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+#include "cool/ng/async/simulation.h"
+
+BOOST_AUTO_TEST_SUITE(simulation)
+
+namespace async = cool::ng::async;
+namespace sim = cool::ng::async::simulation;
+
+class test_runner : public async::runner
+{
+ public:
+  test_runner() : m_counter(0) { /* noop */ }
+  void inc()          { ++m_counter; }
+  int counter() const { return m_counter; }
+
+ private:
+  int m_counter;
+};
+
+BOOST_AUTO_TEST_CASE(timer_in_virtual_time)
+{
+  auto r = std::make_shared<test_runner>();
+  {
+    async::timer timer(
+        std::weak_ptr<test_runner>(r)
+      , [] (const std::shared_ptr<test_runner>& r_)
+        {
+          r_->inc();
+        }
+      , std::chrono::hours(1)
+    );
+
+    auto start = sim::now();
+    sim::advance(std::chrono::hours(10));
+    BOOST_CHECK_EQUAL(0, r->counter());
+    BOOST_CHECK_EQUAL(36000000000ull, sim::now() - start);
+
+    timer.start();
+    sim::advance(std::chrono::hours(10));
+    BOOST_CHECK_EQUAL(10, r->counter());
+
+    sim::advance(std::chrono::minutes(59));
+    BOOST_CHECK_EQUAL(10, r->counter());
+    sim::advance(std::chrono::minutes(1));
+    BOOST_CHECK_EQUAL(11, r->counter());
+
+    timer.stop();
+    sim::advance(std::chrono::hours(10));
+    BOOST_CHECK_EQUAL(11, r->counter());
+
+    timer.period(std::chrono::minutes(30));
+    timer.start();
+    sim::advance(std::chrono::hours(2));
+    BOOST_CHECK_EQUAL(15, r->counter());
+    timer.stop();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(wheel_timers_in_virtual_time)
+{
+  auto r1 = std::make_shared<test_runner>();
+  auto r2 = std::make_shared<test_runner>();
+  {
+    std::vector<async::timer> timers;
+    for (int i = 0; i < 1000; ++i)
+    {
+      auto r = i % 2 == 0 ? r1 : r2;
+      timers.push_back(async::timer(
+          std::weak_ptr<test_runner>(r)
+        , [] (const std::shared_ptr<test_runner>& r_)
+          {
+            r_->inc();
+          }
+        , std::chrono::seconds(1 + i % 10)
+        , async::timer_wheel));
+    }
+    for (auto& t : timers)
+      t.start();
+
+    sim::advance(std::chrono::milliseconds(999));
+    BOOST_CHECK_EQUAL(0, r1->counter() + r2->counter());
+    sim::advance(std::chrono::milliseconds(1));
+    BOOST_CHECK_EQUAL(100, r1->counter());   // all one second timers are even
+    BOOST_CHECK_EQUAL(0, r2->counter());
+
+    // each timer expires 10 / period times in 10 seconds
+    sim::advance(std::chrono::seconds(9));
+    int expected = 0;
+    for (int i = 0; i < 1000; ++i)
+      expected += 10 / (1 + i % 10);
+    BOOST_CHECK_EQUAL(expected, r1->counter() + r2->counter());
+
+    for (std::size_t i = 0; i < timers.size(); i += 2)
+      timers[i].stop();
+    int before = r1->counter();
+    sim::advance(std::chrono::seconds(10));
+    BOOST_CHECK_EQUAL(before, r1->counter());
+  }
+}
+
+void one_shot(bool wheel_)
+{
+  auto r = std::make_shared<test_runner>();
+  auto handler = [] (const std::shared_ptr<test_runner>& r_) { r_->inc(); };
+  auto timer = wheel_
+    ? async::timer(std::weak_ptr<test_runner>(r), handler, std::chrono::seconds(5), async::timer_wheel)
+    : async::timer(std::weak_ptr<test_runner>(r), handler, std::chrono::seconds(5));
+
+  timer.start_once();
+  sim::advance(std::chrono::seconds(60));
+  BOOST_CHECK_EQUAL(1, r->counter());
+
+  // deadline pushed back on every activity
+  for (int i = 0; i < 10; ++i)
+  {
+    timer.start_once(std::chrono::seconds(2));
+    sim::advance(std::chrono::seconds(1));
+  }
+  BOOST_CHECK_EQUAL(1, r->counter());
+  sim::advance(std::chrono::milliseconds(999));
+  BOOST_CHECK_EQUAL(1, r->counter());
+  sim::advance(std::chrono::milliseconds(1));
+  BOOST_CHECK_EQUAL(2, r->counter());
+
+  // back to periodic
+  timer.start();
+  sim::advance(std::chrono::seconds(20));
+  BOOST_CHECK_EQUAL(6, r->counter());
+  timer.stop();
+}
+
+BOOST_AUTO_TEST_CASE(one_shot_timer)
+{
+  one_shot(false);
+}
+
+BOOST_AUTO_TEST_CASE(one_shot_wheel_timer)
+{
+  one_shot(true);
+}
+
+BOOST_AUTO_TEST_CASE(instrumentation)
+{
+  auto r = std::make_shared<test_runner>();
+  auto handler = [] (const std::shared_ptr<test_runner>& r_) { r_->inc(); };
+
+  async::timer plain(std::weak_ptr<test_runner>(r), handler, std::chrono::seconds(1));
+  async::timer::instrument(true);
+  async::timer precise(std::weak_ptr<test_runner>(r), handler, std::chrono::seconds(1));
+  async::timer wheel(std::weak_ptr<test_runner>(r), handler, std::chrono::microseconds(1500), async::timer_wheel);
+  async::timer::instrument(false);
+  auto before = async::timer::aggregate_stats();
+
+  plain.start();
+  precise.start();
+  wheel.start();
+  sim::advance(std::chrono::seconds(3));
+  plain.stop();
+  precise.stop();
+  wheel.stop();
+
+  BOOST_CHECK_EQUAL(0, plain.stats().fire_delay.count);
+
+  // simulation fires exactly on time and the runner is idle
+  auto s = precise.stats();
+  BOOST_CHECK_EQUAL(3, s.fire_delay.count);
+  BOOST_CHECK_EQUAL(3, s.fire_delay.buckets[0]);
+  BOOST_CHECK_EQUAL(3, s.dispatch_delay.count);
+  BOOST_CHECK_EQUAL(0, s.dispatch_delay.max);
+
+  // timing wheel rounds the period up to 2 ms
+  s = wheel.stats();
+  BOOST_CHECK_EQUAL(1500, s.fire_delay.count);
+  BOOST_CHECK_EQUAL(0, s.fire_delay.max);
+  BOOST_CHECK_EQUAL(1500, s.dispatch_delay.count);
+
+  auto after = async::timer::aggregate_stats();
+  BOOST_CHECK_EQUAL(1503, after.fire_delay.count - before.fire_delay.count);
+  BOOST_CHECK_EQUAL(1503, after.dispatch_delay.count - before.dispatch_delay.count);
+}
+
+BOOST_AUTO_TEST_CASE(tasks_run_only_when_driven)
+{
+  auto r = std::make_shared<test_runner>();
+  auto task = async::factory::create(
+      r
+    , [] (const std::shared_ptr<test_runner>& r_)
+      {
+        r_->inc();
+      });
+
+  task.run();
+  task.run();
+  BOOST_CHECK_EQUAL(0, r->counter());
+  BOOST_CHECK_EQUAL(2, sim::run());
+  BOOST_CHECK_EQUAL(2, r->counter());
+  BOOST_CHECK_EQUAL(0, sim::run());
+}
+
+BOOST_AUTO_TEST_CASE(signal_coalesces_until_driven)
+{
+  auto r = std::make_shared<test_runner>();
+  unsigned long value = 0;
+  async::signal_source sig(
+      std::weak_ptr<test_runner>(r)
+    , [&value] (const std::shared_ptr<test_runner>& r_, unsigned long v_)
+      {
+        value = v_;
+        r_->inc();
+      });
+
+  for (int i = 0; i < 100; ++i)
+    sig.trigger();
+  BOOST_CHECK_EQUAL(0, r->counter());
+  BOOST_CHECK_EQUAL(1, sim::run());
+  BOOST_CHECK_EQUAL(1, r->counter());
+  BOOST_CHECK_EQUAL(100, value);
+
+  async::signal_source bits(
+      std::weak_ptr<test_runner>(r)
+    , [&value] (const std::shared_ptr<test_runner>&, unsigned long v_)
+      {
+        value = v_;
+      }
+    , async::signal_merge::bitwise_or);
+  bits.trigger(1);
+  bits.trigger(4);
+  bits.trigger(4);
+  BOOST_CHECK_EQUAL(1, sim::run());
+  BOOST_CHECK_EQUAL(5, value);
+}
+
+BOOST_AUTO_TEST_CASE(delayed_runs_in_virtual_time)
+{
+  auto r = std::make_shared<test_runner>();
+  auto task = async::factory::create(
+      r
+    , [] (const std::shared_ptr<test_runner>& r_)
+      {
+        r_->inc();
+      });
+
+  task.run_after(std::chrono::seconds(10));
+  auto token = task.run_after(std::chrono::seconds(20));
+  sim::advance(std::chrono::seconds(9));
+  BOOST_CHECK_EQUAL(0, r->counter());
+  sim::advance(std::chrono::seconds(1));
+  BOOST_CHECK_EQUAL(1, r->counter());
+  BOOST_CHECK(token.cancel());
+  sim::advance(std::chrono::seconds(20));
+  BOOST_CHECK_EQUAL(1, r->counter());
+}
+
+std::vector<int> interleave(uint64_t seed_)
+{
+  std::vector<int> log;
+  std::vector<std::shared_ptr<test_runner>> runners;
+  for (int i = 0; i < 4; ++i)
+    runners.push_back(std::make_shared<test_runner>());
+
+  sim::seed(seed_);
+  for (int n = 0; n < 10; ++n)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      async::factory::create(
+          runners[i]
+        , [&log, i] (const std::shared_ptr<test_runner>&)
+          {
+            log.push_back(i);
+          }).run();
+    }
+  }
+  sim::run();
+  return log;
+}
+
+BOOST_AUTO_TEST_CASE(reproducible_order)
+{
+  auto first = interleave(42);
+  auto second = interleave(42);
+  BOOST_CHECK_EQUAL(40, first.size());
+  BOOST_CHECK(first == second);
+
+  bool differs = false;
+  for (uint64_t s = 1; s < 10 && !differs; ++s)
+    differs = interleave(s) != first;
+  BOOST_CHECK(differs);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -101,6 +101,7 @@ class test_context : public context
   void set_input(const boost::any&) override { }
   void set_res_reporter(const result_reporter& arg_) override { }
   void set_exc_reporter(const exception_reporter& arg_) override { }
+  void set_err_reporter(const error_reporter& arg_) override { }
 
  private:
   std::shared_ptr<cool::ng::async::runner> m_runner;
@@ -138,6 +139,7 @@ class test_simple : public context, public context_stack
   void set_input(const boost::any&) override { }
   void set_res_reporter(const result_reporter& arg_) override { }
   void set_exc_reporter(const exception_reporter& arg_) override { }
+  void set_err_reporter(const error_reporter& arg_) override { }
 
   // context stack interface
 
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#define BOOST_TEST_MODULE TimerWheel
+#include <boost/test/unit_test.hpp>
+
+#include "src/async/timer_wheel.h"
+
+using cool::ng::async::impl::timer_wheel;
+using cool::ng::async::impl::wheel_entry;
+
+BOOST_AUTO_TEST_SUITE(timer_wheel_)
+
+struct fired
+{
+  void operator ()(wheel_entry* e_) const
+  {
+    m_log->push_back(std::make_pair(e_->m_expires, m_wheel->now()));
+  }
+  std::vector<std::pair<uint64_t, uint64_t>>* m_log;
+  timer_wheel* m_wheel;
+};
+
+BOOST_AUTO_TEST_CASE(expire_on_time)
+{
+  // start from an odd tick so that the slots are not aligned with now
+  const uint64_t start = 1234567;
+  timer_wheel wheel(start);
+  std::vector<uint64_t> distances = { 1, 2, 255, 256, 257, 1000, 65535, 65536, 65537, 100000, 16777216, 20000000 };
+  std::vector<wheel_entry> entries(distances.size());
+  for (std::size_t i = 0; i < distances.size(); ++i)
+  {
+    entries[i].m_expires = start + distances[i];
+    wheel.insert(&entries[i]);
+  }
+  BOOST_CHECK_EQUAL(distances.size(), wheel.size());
+
+  std::vector<std::pair<uint64_t, uint64_t>> log;
+  wheel.advance(start + 20000000, fired{ &log, &wheel });
+
+  BOOST_REQUIRE_EQUAL(distances.size(), log.size());
+  for (std::size_t i = 0; i < distances.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(start + distances[i], log[i].first);
+    BOOST_CHECK_EQUAL(log[i].first, log[i].second);
+  }
+  BOOST_CHECK_EQUAL(0, wheel.size());
+}
+
+BOOST_AUTO_TEST_CASE(beyond_range)
+{
+  timer_wheel wheel(0);
+  wheel_entry e;
+  e.m_expires = (static_cast<uint64_t>(1) << 32) + 12345;
+  wheel.insert(&e);
+
+  std::vector<std::pair<uint64_t, uint64_t>> log;
+  wheel.advance(e.m_expires - 1, fired{ &log, &wheel });
+  BOOST_CHECK(log.empty());
+  wheel.advance(e.m_expires, fired{ &log, &wheel });
+  BOOST_REQUIRE_EQUAL(1, log.size());
+  BOOST_CHECK_EQUAL(e.m_expires, log[0].second);
+}
+
+// advance jumps over the empty spans; the entries far apart, including the
+// ones parked beyond the range, must still expire on their tick
+BOOST_AUTO_TEST_CASE(sparse)
+{
+  const uint64_t start = 987654321;
+  timer_wheel wheel(start);
+  std::vector<uint64_t> distances = { 3, 70000, 16777215, 4294967295ull, 4294967296ull, 1099511627776ull + 7 };
+  std::vector<wheel_entry> entries(distances.size() + 1);
+  for (std::size_t i = 0; i < distances.size(); ++i)
+  {
+    entries[i].m_expires = start + distances[i];
+    wheel.insert(&entries[i]);
+  }
+  entries.back().m_expires = start + 5000;
+  wheel.insert(&entries.back());
+  wheel.remove(&entries.back());
+
+  std::vector<std::pair<uint64_t, uint64_t>> log;
+  wheel.advance(start + distances.back() + 1000, fired{ &log, &wheel });
+
+  BOOST_REQUIRE_EQUAL(distances.size(), log.size());
+  for (std::size_t i = 0; i < distances.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(start + distances[i], log[i].first);
+    BOOST_CHECK_EQUAL(log[i].first, log[i].second);
+  }
+  BOOST_CHECK_EQUAL(start + distances.back() + 1000, wheel.now());
+  BOOST_CHECK_EQUAL(0, wheel.size());
+}
+
+BOOST_AUTO_TEST_CASE(remove_and_past)
+{
+  timer_wheel wheel(100);
+  wheel_entry e1, e2, e3;
+  e1.m_expires = 150;
+  e2.m_expires = 50;     // in the past, expires on the next tick
+  e3.m_expires = 70000;
+  wheel.insert(&e1);
+  wheel.insert(&e2);
+  wheel.insert(&e3);
+  wheel.remove(&e3);
+  wheel.remove(&e3);
+  BOOST_CHECK(!e3.linked());
+  BOOST_CHECK_EQUAL(2, wheel.size());
+
+  std::vector<std::pair<uint64_t, uint64_t>> log;
+  wheel.advance(200000, fired{ &log, &wheel });
+  BOOST_REQUIRE_EQUAL(2, log.size());
+  BOOST_CHECK_EQUAL(101, log[0].second);
+  BOOST_CHECK_EQUAL(150, log[1].second);
+}
+
+BOOST_AUTO_TEST_CASE(random_order)
+{
+  std::mt19937_64 rng(7);
+  timer_wheel wheel(rng() % 1000000);
+  auto start = wheel.now();
+
+  std::vector<wheel_entry> entries(2000);
+  for (auto& e : entries)
+  {
+    e.m_expires = start + 1 + rng() % 300000;
+    wheel.insert(&e);
+  }
+  for (std::size_t i = 0; i < entries.size(); i += 3)
+    wheel.remove(&entries[i]);
+
+  std::vector<std::pair<uint64_t, uint64_t>> log;
+  wheel.advance(start + 300000, fired{ &log, &wheel });
+
+  BOOST_CHECK_EQUAL(entries.size() - (entries.size() + 2) / 3, log.size());
+  BOOST_CHECK(std::is_sorted(log.begin(), log.end()));
+  for (auto& item : log)
+    BOOST_CHECK_EQUAL(item.first, item.second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <set>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+
+#define BOOST_TEST_MODULE BatchTask
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+BOOST_AUTO_TEST_SUITE(batch_task)
+
+class my_runner : public cool::ng::async::runner
+{ };
+
+BOOST_AUTO_TEST_CASE(full_batch)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<std::size_t> batches;
+  std::set<int> results;
+
+  auto bt = cool::ng::async::factory::create(
+      runner_1
+    , [&m, &batches] (const std::shared_ptr<my_runner>& r, const std::vector<int>& items) -> std::vector<int>
+      {
+        {
+          lock l(m);
+          batches.push_back(items.size());
+        }
+        std::vector<int> ret;
+        for (auto i : items)
+          ret.push_back(i * 2);
+        return ret;
+      }
+  );
+  auto collect = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &results] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        results.insert(value);
+        cv.notify_one();
+      }
+  );
+
+  auto batch = cool::ng::async::factory::batch(bt, 4, std::chrono::seconds(10));
+  static_assert(
+      std::is_same<decltype(batch)::input_type, int>::value
+    , "batch task must accept an item of the batch input vector");
+  static_assert(
+      std::is_same<decltype(batch)::result_type, int>::value
+    , "batch task must return an item of the batch result vector");
+
+  auto task = cool::ng::async::factory::sequence(batch, collect);
+
+  for (int i = 0; i < 8; ++i)
+    task.run(i);
+
+  {
+    lock l(m);
+    cv.wait_for(l, ms(500), [&results] () { return results.size() == 8; });
+  }
+
+  BOOST_REQUIRE_EQUAL(8, results.size());
+  for (int i = 0; i < 8; ++i)
+    BOOST_CHECK(results.count(i * 2) == 1);
+  BOOST_REQUIRE_EQUAL(2, batches.size());
+  BOOST_CHECK_EQUAL(4, batches[0]);
+  BOOST_CHECK_EQUAL(4, batches[1]);
+}
+
+BOOST_AUTO_TEST_CASE(delay)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::size_t items_seen = 0;
+  int counter = 0;
+
+  auto bt = cool::ng::async::factory::create(
+      runner
+    , [&m, &items_seen] (const std::shared_ptr<my_runner>& r, const std::vector<int>& items) -> void
+      {
+        lock l(m);
+        items_seen += items.size();
+      }
+  );
+  auto done = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        lock l(m);
+        ++counter;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::sequence(
+      cool::ng::async::factory::batch(bt, 100, ms(20))
+    , done);
+
+  for (int i = 0; i < 3; ++i)
+    task.run(i);
+
+  {
+    lock l(m);
+    cv.wait_for(l, ms(500), [&counter] () { return counter == 3; });
+  }
+
+  BOOST_CHECK_EQUAL(3, counter);
+  BOOST_CHECK_EQUAL(3, items_seen);
+}
+
+// the timer armed for the batch that got full must not flush the next batch
+BOOST_AUTO_TEST_CASE(next_batch_delay)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<std::chrono::steady_clock::time_point> flushed;
+
+  auto bt = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &flushed] (const std::shared_ptr<my_runner>& r, const std::vector<int>& items) -> void
+      {
+        lock l(m);
+        flushed.push_back(std::chrono::steady_clock::now());
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::batch(bt, 2, ms(200));
+
+  task.run(0);
+  task.run(1);
+  {
+    lock l(m);
+    cv.wait_for(l, ms(500), [&flushed] () { return flushed.size() == 1; });
+  }
+  BOOST_REQUIRE_EQUAL(1, flushed.size());
+
+  std::this_thread::sleep_for(ms(150));
+  auto start = std::chrono::steady_clock::now();
+  task.run(2);
+  {
+    lock l(m);
+    cv.wait_for(l, ms(1000), [&flushed] () { return flushed.size() == 2; });
+  }
+  BOOST_REQUIRE_EQUAL(2, flushed.size());
+  BOOST_CHECK_GE(std::chrono::duration_cast<ms>(flushed[1] - start).count(), 150);
+}
+
+BOOST_AUTO_TEST_CASE(exception)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  int counter = 0;
+
+  auto bt = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, const std::vector<int>& items) -> std::vector<int>
+      {
+        throw std::runtime_error("failed");
+      }
+  );
+  auto c = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>& r, const std::runtime_error&) -> int
+      {
+        lock l(m);
+        ++counter;
+        cv.notify_one();
+        return 0;
+      }
+  );
+
+  auto task = cool::ng::async::factory::try_catch(cool::ng::async::factory::batch(bt, 3, ms(100)), c);
+
+  for (int i = 0; i < 3; ++i)
+    task.run(i);
+
+  {
+    lock l(m);
+    cv.wait_for(l, ms(500), [&counter] () { return counter == 3; });
+  }
+  BOOST_CHECK_EQUAL(3, counter);
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_run)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool blocked = true;
+  bool started = false;
+  std::vector<std::size_t> batches;
+  std::set<int> results;
+
+  auto blocker = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &blocked, &started] (const std::shared_ptr<my_runner>&)
+      {
+        lock l(m);
+        started = true;
+        cv.notify_all();
+        cv.wait(l, [&blocked] () { return !blocked; });
+      }
+  );
+  auto bt = cool::ng::async::factory::create(
+      runner
+    , [&m, &batches] (const std::shared_ptr<my_runner>& r, const std::vector<int>& items) -> std::vector<int>
+      {
+        lock l(m);
+        batches.push_back(items.size());
+        return items;
+      }
+  );
+  auto collect = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &results] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        results.insert(value);
+        cv.notify_all();
+      }
+  );
+
+  auto batch = cool::ng::async::factory::batch(bt, 4, std::chrono::seconds(10));
+
+  {
+    lock l(m);
+    blocker.run();
+    cv.wait_for(l, ms(500), [&started] () { return started; });
+  }
+  BOOST_REQUIRE(started);
+
+  // the runs deleted by the executor without running must not join the batch
+  cool::ng::async::task_group group;
+  for (int i = 0; i < 3; ++i)
+    group.spawn(batch, 100 + i);
+  group.cancel();
+
+  {
+    lock l(m);
+    blocked = false;
+    cv.notify_all();
+  }
+  BOOST_CHECK(group.join_for(ms(500)));
+
+  auto task = cool::ng::async::factory::sequence(batch, collect);
+  for (int i = 0; i < 4; ++i)
+    task.run(i);
+
+  {
+    lock l(m);
+    cv.wait_for(l, ms(500), [&results] () { return results.size() == 4; });
+  }
+
+  BOOST_REQUIRE_EQUAL(4, results.size());
+  for (int i = 0; i < 4; ++i)
+    BOOST_CHECK(results.count(i) == 1);
+  BOOST_REQUIRE_EQUAL(1, batches.size());
+  BOOST_CHECK_EQUAL(4, batches[0]);
+}
+
+BOOST_AUTO_TEST_CASE(illegal_arguments)
+{
+  auto runner = std::make_shared<my_runner>();
+  auto bt = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, const std::vector<int>& items) -> void
+      { }
+  );
+
+  BOOST_CHECK_THROW(cool::ng::async::factory::batch(bt, 0, ms(10)), cool::ng::exception::illegal_argument);
+  BOOST_CHECK_THROW(cool::ng::async::factory::batch(bt, 10, ms(0)), cool::ng::exception::illegal_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
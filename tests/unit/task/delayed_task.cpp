@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <stdexcept>
+#include <string>
+
+#define BOOST_TEST_MODULE DelayedTask
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+
+BOOST_AUTO_TEST_SUITE(delayed_task)
+
+class my_runner : public cool::ng::async::runner
+{
+
+};
+
+BOOST_AUTO_TEST_CASE(run_after)
+{
+  auto runner = std::make_shared<my_runner>();
+  std::mutex m;
+  std::condition_variable cv;
+  std::atomic<int> counter;
+  counter = 0;
+
+  auto task = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>&, int value)
+      {
+        counter = value;
+        std::unique_lock<std::mutex> l(m);
+        cv.notify_one();
+      }
+  );
+
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> l(m);
+  auto token = task.run_after(ms(50), 5);
+  BOOST_CHECK(token);
+  BOOST_CHECK(token.pending());
+  cv.wait_for(l, ms(500), [&counter] { return counter == 5; });
+
+  BOOST_CHECK_EQUAL(5, counter);
+  BOOST_CHECK(std::chrono::steady_clock::now() - start >= ms(50));
+  BOOST_CHECK(!token.pending());
+  BOOST_CHECK(!token.cancel());
+}
+
+BOOST_AUTO_TEST_CASE(run_at)
+{
+  auto runner = std::make_shared<my_runner>();
+  std::mutex m;
+  std::condition_variable cv;
+  std::atomic<int> counter;
+  counter = 0;
+
+  auto task = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>&)
+      {
+        ++counter;
+        std::unique_lock<std::mutex> l(m);
+        cv.notify_one();
+      }
+  );
+
+  std::unique_lock<std::mutex> l(m);
+  task.run_at(std::chrono::system_clock::now() + ms(20));
+  task.run_at(std::chrono::steady_clock::now() - ms(20));  // in the past
+  cv.wait_for(l, ms(500), [&counter] { return counter == 2; });
+
+  BOOST_CHECK_EQUAL(2, counter);
+}
+
+BOOST_AUTO_TEST_CASE(cancel)
+{
+  auto runner = std::make_shared<my_runner>();
+  std::atomic<int> counter;
+  counter = 0;
+
+  auto task = cool::ng::async::factory::create(
+      runner
+    , [&counter] (const std::shared_ptr<my_runner>&)
+      {
+        ++counter;
+      }
+  );
+
+  auto t1 = task.run_after(ms(50));
+  auto t2 = task.run_after(ms(50));
+  BOOST_CHECK(t1.cancel());
+  BOOST_CHECK(!t1.cancel());
+  BOOST_CHECK(!t1.pending());
+  BOOST_CHECK(t2.pending());
+
+  std::this_thread::sleep_for(ms(200));
+  BOOST_CHECK_EQUAL(1, counter);
+  BOOST_CHECK(!t2.pending());
+}
+
+// cancel must release the pending run and its input right away rather than
+// when the delay expires
+BOOST_AUTO_TEST_CASE(cancel_releases_input)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  auto task = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>&, const std::shared_ptr<int>&)
+      { /* noop */ }
+  );
+
+  auto input = std::make_shared<int>(42);
+  std::weak_ptr<int> observer = input;
+  auto token = task.run_after(std::chrono::seconds(10), input);
+  input.reset();
+  BOOST_CHECK(!observer.expired());
+
+  BOOST_CHECK(token.cancel());
+  BOOST_CHECK(observer.expired());
+}
+
+BOOST_AUTO_TEST_CASE(compound)
+{
+  auto runner = std::make_shared<my_runner>();
+  std::mutex m;
+  std::condition_variable cv;
+  std::atomic<int> counter;
+  counter = 0;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>&, int value)
+      {
+        return value * 2;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>&, int value)
+      {
+        counter = value;
+        std::unique_lock<std::mutex> l(m);
+        cv.notify_one();
+      }
+  );
+
+  std::unique_lock<std::mutex> l(m);
+  cool::ng::async::factory::sequence(t1, t2).run_after(ms(10), 21);
+  cv.wait_for(l, ms(500), [&counter] { return counter == 42; });
+  BOOST_CHECK_EQUAL(42, counter);
+}
+
+BOOST_AUTO_TEST_CASE(exception)
+{
+  auto runner = std::make_shared<my_runner>();
+  std::mutex m;
+  std::condition_variable cv;
+  std::string what;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>&, int value) -> int
+      {
+        throw std::runtime_error("delayed");
+      }
+  );
+  auto c = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &what] (const std::shared_ptr<my_runner>&, const std::runtime_error& e) -> int
+      {
+        std::unique_lock<std::mutex> l(m);
+        what = e.what();
+        cv.notify_one();
+        return 0;
+      }
+  );
+
+  // the exception thrown by the delayed run must reach the exception handler
+  std::unique_lock<std::mutex> l(m);
+  cool::ng::async::factory::try_catch(t1, c).run_after(ms(10), 1);
+  cv.wait_for(l, ms(500), [&what] { return !what.empty(); });
+  BOOST_CHECK_EQUAL("delayed", what);
+}
+
+BOOST_AUTO_TEST_CASE(empty_token)
+{
+  cool::ng::async::cancel_token token;
+  BOOST_CHECK(!token);
+  BOOST_CHECK_THROW(token.cancel(), cool::ng::exception::empty_object);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <typeinfo>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <system_error>
+
+#define BOOST_TEST_MODULE ExpectedTask
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+using cool::ng::async::expected;
+using cool::ng::async::unexpected;
+
+BOOST_AUTO_TEST_SUITE(expected_task)
+
+class my_runner : public cool::ng::async::runner
+{ };
+
+class abc { };
+
+const std::error_code not_found = std::make_error_code(std::errc::no_such_file_or_directory);
+
+BOOST_AUTO_TEST_CASE(value_and_error)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  int result = 0;
+  std::error_code error;
+  bool done = false;
+
+  auto lookup = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> expected<int>
+      {
+        if (value < 0)
+          return unexpected(not_found);
+        return value * 2;
+      }
+  );
+  auto report = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &result, &done] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        result = value;
+        done = true;
+        cv.notify_one();
+      }
+  );
+  auto wrong_catch = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, const abc&) -> void
+      { }
+  );
+  auto error_catch = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &error, &done] (const std::shared_ptr<my_runner>& r, const std::error_code& e) -> void
+      {
+        lock l(m);
+        error = e;
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  static_assert(std::is_same<decltype(lookup)::result_type, int>::value, "result type of the task must be int");
+
+  auto task = cool::ng::async::factory::try_catch(
+      cool::ng::async::factory::sequence(lookup, report)
+    , wrong_catch
+    , error_catch);
+
+  {
+    lock l(m);
+    task.run(21);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+  BOOST_CHECK(done);
+  BOOST_CHECK_EQUAL(42, result);
+  BOOST_CHECK(!error);
+
+  done = false;
+  result = 0;
+  {
+    lock l(m);
+    task.run(-1);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+  BOOST_CHECK(done);
+  BOOST_CHECK_EQUAL(0, result);
+  BOOST_CHECK(error == not_found);
+}
+
+BOOST_AUTO_TEST_CASE(void_result)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::error_code error;
+  int counter = 0;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [&counter] (const std::shared_ptr<my_runner>& r, bool fail) -> expected<void>
+      {
+        if (fail)
+          return unexpected(not_found);
+        ++counter;
+        return expected<void>();
+      }
+  );
+  auto error_catch = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &error, &done] (const std::shared_ptr<my_runner>& r, const std::system_error& e) -> void
+      {
+        lock l(m);
+        error = e.code();
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::try_catch(t1, error_catch);
+
+  {
+    lock l(m);
+    task.run(false);
+    task.run(true);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+  BOOST_CHECK(done);
+  BOOST_CHECK_EQUAL(1, counter);
+  BOOST_CHECK(error == not_found);
+}
+
+BOOST_AUTO_TEST_CASE(catch_all)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::error_code error;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r) -> expected<int>
+      {
+        return unexpected(not_found);
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        return value;
+      }
+  );
+  auto catch_all = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &error, &done] (const std::shared_ptr<my_runner>& r, const std::exception_ptr& e) -> int
+      {
+        try
+        {
+          std::rethrow_exception(e);
+        }
+        catch (const std::system_error& ex)
+        {
+          lock l(m);
+          error = ex.code();
+        }
+        catch (...)
+        { }
+
+        lock l(m);
+        done = true;
+        cv.notify_one();
+        return 0;
+      }
+  );
+
+  // error passes through the inner sequence and repeat without being caught
+  auto task = cool::ng::async::factory::try_catch(
+      cool::ng::async::factory::sequence(t1, t2)
+    , catch_all);
+
+  {
+    lock l(m);
+    task.run();
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+  BOOST_CHECK(done);
+  BOOST_CHECK(error == not_found);
+}
+
+BOOST_AUTO_TEST_CASE(fan_out)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::error_code error;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> expected<int>
+      {
+        if (value == 3)
+          return unexpected(not_found);
+        return value;
+      }
+  );
+  auto error_catch = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &error, &done] (const std::shared_ptr<my_runner>& r, const std::error_code& e) -> std::vector<int>
+      {
+        lock l(m);
+        error = e;
+        done = true;
+        cv.notify_one();
+        return std::vector<int>();
+      }
+  );
+
+  auto task = cool::ng::async::factory::try_catch(cool::ng::async::factory::fan_out(t1), error_catch);
+
+  {
+    lock l(m);
+    task.run(std::vector<int>({ 1, 2, 3, 4 }));
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+  BOOST_CHECK(done);
+  BOOST_CHECK(error == not_found);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <typeinfo>
+#include <memory>
+#include <vector>
+#include <string>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+
+#define BOOST_TEST_MODULE FanOutTask
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+BOOST_AUTO_TEST_SUITE(fan_out_task)
+
+class my_runner : public cool::ng::async::runner
+{ };
+
+BOOST_AUTO_TEST_CASE(basic)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<std::string> result;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> std::string
+      {
+        return std::to_string(value * 10);
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &result, &done] (const std::shared_ptr<my_runner>& r, const std::vector<std::string>& value) -> void
+      {
+        lock l(m);
+        result = value;
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::sequence(cool::ng::async::factory::fan_out(t1), t2);
+
+  {
+    lock l(m);
+    std::vector<int> input;
+    for (int i = 0; i < 50; ++i)
+      input.push_back(i);
+    task.run(input);
+
+    cv.wait_for(l, ms(500), [&done] () { return done; });
+  }
+
+  BOOST_REQUIRE(done);
+  BOOST_REQUIRE_EQUAL(50, result.size());
+  for (int i = 0; i < 50; ++i)
+    BOOST_CHECK_EQUAL(std::to_string(i * 10), result[i]);
+
+  // empty input
+  {
+    lock l(m);
+    done = false;
+    result.push_back("dummy");
+    task.run(std::vector<int>());
+
+    cv.wait_for(l, ms(500), [&done] () { return done; });
+  }
+
+  BOOST_REQUIRE(done);
+  BOOST_CHECK(result.empty());
+}
+
+BOOST_AUTO_TEST_CASE(bounded_concurrency)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+  auto runner_3 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::atomic<int> in_flight;
+  std::atomic<int> max_in_flight;
+  std::atomic<int> counter;
+  bool done = false;
+  in_flight = 0;
+  max_in_flight = 0;
+  counter = 0;
+
+  // subtask is a sequence of two simple tasks on different runners; the
+  // number of subtasks in flight is observed between them
+  auto enter = cool::ng::async::factory::create(
+      runner_1
+    , [&in_flight, &max_in_flight] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        int aux = ++in_flight;
+        if (aux > max_in_flight)
+          max_in_flight = aux;
+        return value;
+      }
+  );
+  auto leave = cool::ng::async::factory::create(
+      runner_2
+    , [&in_flight, &counter] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        std::this_thread::sleep_for(ms(1));
+        ++counter;
+        --in_flight;
+      }
+  );
+  auto report = cool::ng::async::factory::create(
+      runner_3
+    , [&m, &cv, &done] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        lock l(m);
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::sequence(
+      cool::ng::async::factory::fan_out(cool::ng::async::factory::sequence(enter, leave), 2)
+    , report);
+
+  {
+    lock l(m);
+    task.run(std::vector<int>(20, 1));
+
+    cv.wait_for(l, ms(1000), [&done] () { return done; });
+  }
+
+  BOOST_REQUIRE(done);
+  BOOST_CHECK_EQUAL(20, counter);
+  BOOST_CHECK_EQUAL(0, in_flight);
+  BOOST_CHECK(max_in_flight <= 2);
+}
+
+BOOST_AUTO_TEST_CASE(exception)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  int result = 0;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        if (value == 3)
+          throw value;
+        return value;
+      }
+  );
+  auto handler = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &result, &done] (const std::shared_ptr<my_runner>& r, const int& value) -> std::vector<int>
+      {
+        lock l(m);
+        result = value;
+        done = true;
+        cv.notify_one();
+        return std::vector<int>();
+      }
+  );
+
+  auto task = cool::ng::async::factory::try_catch(cool::ng::async::factory::fan_out(t1, 1), handler);
+
+  {
+    lock l(m);
+    task.run(std::vector<int>({ 1, 2, 3, 4, 5 }));
+
+    cv.wait_for(l, ms(500), [&done] () { return done; });
+  }
+
+  BOOST_REQUIRE(done);
+  BOOST_CHECK_EQUAL(3, result);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -32,6 +32,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <exception>
+#include <stdexcept>
 
 #define BOOST_TEST_MODULE InterceptTask
 #include <boost/test/unit_test.hpp>
@@ -213,4 +214,74 @@ BOOST_AUTO_TEST_CASE(catch_all)
   BOOST_CHECK_EQUAL(84, counter);
 }
 
+class derived_error : public std::runtime_error
+{
+ public:
+  derived_error() : std::runtime_error("derived") { }
+};
+
+BOOST_AUTO_TEST_CASE(catch_order)
+{
+  auto runner = std::make_shared<my_runner>();
+  std::mutex m;
+  std::condition_variable cv;
+  std::atomic<int> counter;
+  counter = 0;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>&, int value) -> int
+      {
+        switch (value)
+        {
+          case 1: throw derived_error();
+          case 2: throw std::logic_error("logic");
+          case 3: throw abc();
+          case 4: throw 4;
+        }
+        return 0;
+      }
+  );
+  auto make_catch = [&m, &cv, &counter] (int id)
+  {
+    return [&m, &cv, &counter, id] ()
+    {
+      counter = id;
+      std::unique_lock<std::mutex> l(m);
+      cv.notify_one();
+      return id;
+    };
+  };
+  auto c_abc = make_catch(10);
+  auto c_runtime = make_catch(20);
+  auto c_exception = make_catch(30);
+  auto c_all = make_catch(40);
+
+  // catch tasks are examined in order: derived_error is caught as runtime_error
+  // and logic_error as std::exception although catch-all follows
+  auto task = cool::ng::async::factory::try_catch(
+      t1
+    , cool::ng::async::factory::create(runner, [c_abc] (const std::shared_ptr<my_runner>&, const abc&) { return c_abc(); })
+    , cool::ng::async::factory::create(runner, [c_runtime] (const std::shared_ptr<my_runner>&, const std::runtime_error&) { return c_runtime(); })
+    , cool::ng::async::factory::create(runner, [c_exception] (const std::shared_ptr<my_runner>&, const std::exception&) { return c_exception(); })
+    , cool::ng::async::factory::create(runner, [c_all] (const std::shared_ptr<my_runner>&, const std::exception_ptr&) { return c_all(); }));
+
+  std::unique_lock<std::mutex> l(m);
+  task.run(1);
+  cv.wait_for(l, ms(100), [&counter] { return counter == 20; });
+  BOOST_CHECK_EQUAL(20, counter);
+
+  task.run(2);
+  cv.wait_for(l, ms(100), [&counter] { return counter == 30; });
+  BOOST_CHECK_EQUAL(30, counter);
+
+  task.run(3);
+  cv.wait_for(l, ms(100), [&counter] { return counter == 10; });
+  BOOST_CHECK_EQUAL(10, counter);
+
+  task.run(4);
+  cv.wait_for(l, ms(100), [&counter] { return counter == 40; });
+  BOOST_CHECK_EQUAL(40, counter);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
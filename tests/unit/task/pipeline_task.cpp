@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <typeinfo>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+
+#define BOOST_TEST_MODULE PipelineTask
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+BOOST_AUTO_TEST_SUITE(pipeline_task)
+
+class my_runner : public cool::ng::async::runner
+{ };
+
+BOOST_AUTO_TEST_CASE(basic_order)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+  auto runner_3 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<int> result;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        return value * 2;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> double
+      {
+        return value + 0.5;
+      }
+  );
+  auto t3 = cool::ng::async::factory::create(
+      runner_3
+    , [&m, &cv, &result] (const std::shared_ptr<my_runner>& r, double value) -> void
+      {
+        lock l(m);
+        result.push_back(static_cast<int>(value));
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::pipeline(200, t1, t2, t3);
+
+  {
+    lock l(m);
+    for (int i = 0; i < 100; ++i)
+      task.run(i);
+
+    cv.wait_for(l, ms(500), [&result] () { return result.size() == 100; });
+  }
+
+  BOOST_REQUIRE_EQUAL(100, result.size());
+  for (int i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(i * 2, result[i]);
+}
+
+BOOST_AUTO_TEST_CASE(backpressure)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+  const std::size_t capacity = 3;
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool blocked = true;
+  std::vector<int> result;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        return value;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &blocked, &result] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        cv.wait(l, [&blocked] () { return !blocked; });
+        result.push_back(value);
+        cv.notify_all();
+      }
+  );
+
+  auto task = cool::ng::async::factory::pipeline(capacity, t1, t2);
+
+  // with the last stage blocked the pipeline can hold one item in the last
+  // stage, capacity items in its queue, one stalled item in the first stage
+  // and capacity items in the first stage queue
+  int accepted = 0;
+  try
+  {
+    for ( ; accepted < 100; ++accepted)
+    {
+      task.run(accepted);
+      std::this_thread::sleep_for(ms(10));
+    }
+  }
+  catch (const cool::ng::exception::operation_failed& e)
+  {
+    BOOST_CHECK(e.code() == cool::ng::error::errc::resource_busy);
+  }
+  BOOST_CHECK_EQUAL(2 * capacity + 2, accepted);
+
+  {
+    lock l(m);
+    blocked = false;
+    cv.notify_all();
+    cv.wait_for(l, ms(500), [&result, accepted] () { return result.size() == static_cast<std::size_t>(accepted); });
+  }
+
+  BOOST_REQUIRE_EQUAL(accepted, result.size());
+  for (int i = 0; i < accepted; ++i)
+    BOOST_CHECK_EQUAL(i, result[i]);
+}
+
+BOOST_AUTO_TEST_CASE(stage_exception)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<int> result;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        if (value % 2)
+          throw value;
+        return value;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &result] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        result.push_back(value);
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::pipeline(20, t1, t2);
+  std::vector<std::pair<std::size_t, int>> failed;
+  task.on_failure(
+    [&m, &cv, &failed] (std::size_t stage_, const std::exception_ptr& e_)
+    {
+      lock l(m);
+      try { std::rethrow_exception(e_); }
+      catch (int v) { failed.push_back(std::make_pair(stage_, v)); }
+      catch (...) { failed.push_back(std::make_pair(stage_, -1)); }
+      cv.notify_one();
+    });
+
+  {
+    lock l(m);
+    for (int i = 0; i < 10; ++i)
+      task.run(i);
+
+    cv.wait_for(l, ms(500), [&result, &failed] () { return result.size() == 5 && failed.size() == 5; });
+  }
+
+  BOOST_REQUIRE_EQUAL(5, result.size());
+  for (int i = 0; i < 5; ++i)
+    BOOST_CHECK_EQUAL(i * 2, result[i]);
+
+  // the dropped items are counted and reported in order
+  BOOST_CHECK_EQUAL(5, task.dropped());
+  BOOST_REQUIRE_EQUAL(5, failed.size());
+  for (int i = 0; i < 5; ++i)
+  {
+    BOOST_CHECK_EQUAL(0, failed[i].first);
+    BOOST_CHECK_EQUAL(i * 2 + 1, failed[i].second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(nested)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<int> result;
+  bool fed = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        return value + 1;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &result] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        result.push_back(value);
+        cv.notify_all();
+      }
+  );
+  auto t3 = cool::ng::async::factory::create(
+      runner_1
+    , [&m, &cv, &fed] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        lock l(m);
+        fed = true;
+        cv.notify_all();
+      }
+  );
+
+  auto task = cool::ng::async::factory::sequence(
+      t1
+    , cool::ng::async::factory::pipeline(10, t1, t2)
+    , t3);
+
+  {
+    lock l(m);
+    task.run(1);
+
+    cv.wait_for(l, ms(500), [&result, &fed] () { return fed && result.size() == 1; });
+  }
+
+  BOOST_CHECK(fed);
+  BOOST_REQUIRE_EQUAL(1, result.size());
+  BOOST_CHECK_EQUAL(3, result[0]);
+}
+
+BOOST_AUTO_TEST_CASE(zero_capacity)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        return value;
+      }
+  );
+
+  BOOST_CHECK_THROW(cool::ng::async::factory::pipeline(0, t1, t1), cool::ng::exception::illegal_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
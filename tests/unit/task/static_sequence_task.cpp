@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <typeinfo>
+#include <memory>
+#include <vector>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+
+#define BOOST_TEST_MODULE StaticSequenceTask
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+using cool::ng::async::expected;
+using cool::ng::async::unexpected;
+
+BOOST_AUTO_TEST_SUITE(static_sequence_task)
+
+class my_runner : public cool::ng::async::runner
+{ };
+
+const std::error_code not_found = std::make_error_code(std::errc::no_such_file_or_directory);
+
+BOOST_AUTO_TEST_CASE(same_runner)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<std::thread::id> threads;
+  std::string result;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [&threads] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        threads.push_back(std::this_thread::get_id());
+        return value * 2;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner
+    , [&threads] (const std::shared_ptr<my_runner>& r, int value) -> std::string
+      {
+        threads.push_back(std::this_thread::get_id());
+        return std::to_string(value);
+      }
+  );
+  auto t3 = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &threads, &result, &done] (const std::shared_ptr<my_runner>& r, const std::string& value) -> void
+      {
+        lock l(m);
+        threads.push_back(std::this_thread::get_id());
+        result = value;
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::static_sequence(t1, t2, t3);
+
+  static_assert(
+      std::is_same<decltype(task)::tag, cool::ng::async::tag::static_sequential>::value
+    , "static sequence must have static_sequential tag");
+  static_assert(
+      std::is_same<decltype(task)::input_type, int>::value
+    , "static sequence must accept input of the first task");
+  static_assert(
+      std::is_same<decltype(task)::result_type, void>::value
+    , "static sequence must return result of the last task");
+
+  {
+    lock l(m);
+    task.run(21);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+
+  BOOST_REQUIRE(done);
+  BOOST_CHECK_EQUAL("42", result);
+  BOOST_REQUIRE_EQUAL(3, threads.size());
+  // all stages run inline within a single dispatch of the runner
+  BOOST_CHECK(threads[0] == threads[1]);
+  BOOST_CHECK(threads[1] == threads[2]);
+}
+
+BOOST_AUTO_TEST_CASE(multiple_runners)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<my_runner*> runners;
+  int result = 0;
+  bool done = false;
+
+  auto add = [&runners] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        runners.push_back(r.get());
+        return value + 1;
+      };
+  auto t1 = cool::ng::async::factory::create(runner_1, add);
+  auto t2 = cool::ng::async::factory::create(runner_1, add);
+  auto t3 = cool::ng::async::factory::create(runner_2, add);
+  auto t4 = cool::ng::async::factory::create(runner_1, add);
+  auto t5 = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &runners, &result, &done] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        runners.push_back(r.get());
+        result = value;
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::static_sequence(t1, t2, t3, t4, t5);
+
+  {
+    lock l(m);
+    task.run(10);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+
+  BOOST_REQUIRE(done);
+  BOOST_CHECK_EQUAL(14, result);
+  BOOST_REQUIRE_EQUAL(5, runners.size());
+  BOOST_CHECK_EQUAL(runner_1.get(), runners[0]);
+  BOOST_CHECK_EQUAL(runner_1.get(), runners[1]);
+  BOOST_CHECK_EQUAL(runner_2.get(), runners[2]);
+  BOOST_CHECK_EQUAL(runner_1.get(), runners[3]);
+  BOOST_CHECK_EQUAL(runner_2.get(), runners[4]);
+}
+
+BOOST_AUTO_TEST_CASE(exception)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::string what;
+  int counter = 0;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [&counter] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        ++counter;
+        return value;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [&counter] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        ++counter;
+        if (value < 0)
+          throw std::runtime_error("negative");
+        return value;
+      }
+  );
+  auto t3 = cool::ng::async::factory::create(
+      runner_1
+    , [&m, &cv, &counter, &done] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        ++counter;
+        done = true;
+        cv.notify_one();
+      }
+  );
+  auto c = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &what, &done] (const std::shared_ptr<my_runner>& r, const std::runtime_error& e) -> void
+      {
+        lock l(m);
+        what = e.what();
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::try_catch(
+      cool::ng::async::factory::static_sequence(t1, t2, t3)
+    , c);
+
+  {
+    lock l(m);
+    task.run(-1);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+
+  BOOST_REQUIRE(done);
+  BOOST_CHECK_EQUAL("negative", what);
+  BOOST_CHECK_EQUAL(2, counter);
+}
+
+BOOST_AUTO_TEST_CASE(error_code)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::error_code error;
+  int result = 0;
+  bool done = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> expected<int>
+      {
+        if (value < 0)
+          return unexpected(not_found);
+        return value * 2;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        return value + 1;
+      }
+  );
+  auto report = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &result, &done] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        result = value;
+        done = true;
+        cv.notify_one();
+      }
+  );
+  auto c = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &error, &done] (const std::shared_ptr<my_runner>& r, const std::error_code& e) -> void
+      {
+        lock l(m);
+        error = e;
+        done = true;
+        cv.notify_one();
+      }
+  );
+
+  // static sequence nested in the dynamic sequence
+  auto task = cool::ng::async::factory::try_catch(
+      cool::ng::async::factory::sequence(cool::ng::async::factory::static_sequence(t1, t2), report)
+    , c);
+
+  {
+    lock l(m);
+    task.run(20);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+  BOOST_REQUIRE(done);
+  BOOST_CHECK_EQUAL(41, result);
+  BOOST_CHECK(!error);
+
+  done = false;
+  result = 0;
+  {
+    lock l(m);
+    task.run(-1);
+    cv.wait_for(l, ms(100), [&done] () { return done; });
+  }
+  BOOST_REQUIRE(done);
+  BOOST_CHECK_EQUAL(0, result);
+  BOOST_CHECK(error == not_found);
+}
+
+BOOST_AUTO_TEST_CASE(shared_callable)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<int> results;
+  int count = 0;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [count] (const std::shared_ptr<my_runner>& r, int value) mutable -> int
+      {
+        return value + ++count;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &results] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        results.push_back(value);
+        cv.notify_one();
+      }
+  );
+
+  // simple task converts to the task type without the type of its Callable
+  cool::ng::async::task<cool::ng::async::tag::simple, my_runner, int, void> report = t2;
+  auto task = cool::ng::async::factory::static_sequence(t1, t2);
+  auto standalone = cool::ng::async::factory::sequence(t1, report);
+
+  {
+    lock l(m);
+    task.run(10);
+    cv.wait_for(l, ms(100), [&results] () { return results.size() == 1; });
+    standalone.run(10);
+    cv.wait_for(l, ms(100), [&results] () { return results.size() == 2; });
+    task.run(10);
+    cv.wait_for(l, ms(100), [&results] () { return results.size() == 3; });
+  }
+
+  // the static sequence and the task itself call the same Callable object
+  BOOST_REQUIRE_EQUAL(3, results.size());
+  BOOST_CHECK_EQUAL(11, results[0]);
+  BOOST_CHECK_EQUAL(12, results[1]);
+  BOOST_CHECK_EQUAL(13, results[2]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+
+#define BOOST_TEST_MODULE TaskGroup
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+BOOST_AUTO_TEST_SUITE(task_group)
+
+class my_runner : public cool::ng::async::runner
+{ };
+
+BOOST_AUTO_TEST_CASE(spawn_and_join)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+  std::atomic<int> counter(0);
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [&counter] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        counter += value;
+        return value;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [&counter] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        ++counter;
+      }
+  );
+
+  cool::ng::async::task_group group;
+  for (int i = 0; i < 500; ++i)
+  {
+    group.spawn(t1, 2);
+    group.spawn(t2);
+  }
+
+  BOOST_CHECK(group.join_for(ms(2000)));
+  BOOST_CHECK_EQUAL(1500, counter.load());
+  BOOST_CHECK_EQUAL(0, group.pending());
+
+  // an empty group is joined immediately
+  cool::ng::async::task_group empty;
+  empty.join();
+}
+
+BOOST_AUTO_TEST_CASE(join_task)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::atomic<int> counter(0);
+  int seen = -1;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [&counter] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        std::this_thread::sleep_for(ms(1));
+        ++counter;
+      }
+  );
+  auto report = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &counter, &seen] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        lock l(m);
+        seen = counter;
+        cv.notify_one();
+      }
+  );
+
+  cool::ng::async::task_group group;
+  for (int i = 0; i < 20; ++i)
+    group.spawn(t1);
+
+  auto task = cool::ng::async::factory::sequence(
+      group.join_task(std::weak_ptr<my_runner>(runner_2))
+    , report);
+
+  {
+    lock l(m);
+    task.run();
+    cv.wait_for(l, ms(1000), [&seen] () { return seen >= 0; });
+  }
+
+  BOOST_CHECK_EQUAL(20, seen);
+}
+
+BOOST_AUTO_TEST_CASE(cancel)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool blocked = true;
+  bool started = false;
+  std::atomic<int> counter(0);
+
+  auto blocker = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &blocked, &started] (const std::shared_ptr<my_runner>&)
+      {
+        lock l(m);
+        started = true;
+        cv.notify_all();
+        cv.wait(l, [&blocked] () { return !blocked; });
+      }
+  );
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [&counter] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        ++counter;
+      }
+  );
+
+  {
+    lock l(m);
+    blocker.run();
+    cv.wait_for(l, ms(500), [&started] () { return started; });
+  }
+  BOOST_REQUIRE(started);
+
+  cool::ng::async::task_group group;
+  for (int i = 0; i < 10; ++i)
+    group.spawn(t1);
+  BOOST_CHECK_EQUAL(10, group.pending());
+
+  group.cancel();
+  BOOST_CHECK(group.cancelled());
+  group.spawn(t1);
+
+  {
+    lock l(m);
+    blocked = false;
+    cv.notify_all();
+  }
+
+  // the cancelled members fail with request_aborted
+  try
+  {
+    group.join_for(ms(500));
+    BOOST_FAIL("join of the cancelled group must throw");
+  }
+  catch (const std::system_error& e)
+  {
+    BOOST_CHECK(e.code() == cool::ng::error::make_error_code(cool::ng::error::errc::request_aborted));
+  }
+  BOOST_CHECK_EQUAL(0, group.pending());
+  BOOST_CHECK_EQUAL(0, counter.load());
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_join)
+{
+  auto runner_1 = std::make_shared<my_runner>();
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool blocked[2] = { true, true };
+  int started = 0;
+  std::atomic<int> counter(0);
+
+  auto blocker = [&m, &cv, &blocked, &started] (int index_)
+      {
+        lock l(m);
+        ++started;
+        cv.notify_all();
+        cv.wait(l, [&blocked, index_] () { return !blocked[index_]; });
+      };
+  auto b1 = cool::ng::async::factory::create(
+      runner_1
+    , [&blocker] (const std::shared_ptr<my_runner>&) { blocker(0); }
+  );
+  auto b2 = cool::ng::async::factory::create(
+      runner_2
+    , [&blocker] (const std::shared_ptr<my_runner>&) { blocker(1); }
+  );
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [&counter] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        ++counter;
+      }
+  );
+
+  {
+    lock l(m);
+    b1.run();
+    b2.run();
+    cv.wait_for(l, ms(500), [&started] () { return started == 2; });
+  }
+  BOOST_REQUIRE_EQUAL(2, started);
+
+  cool::ng::async::task_group members;
+  members.spawn(t1);
+
+  // the join task deleted by the executor without running must not remain
+  // registered with the members group
+  cool::ng::async::task_group joins;
+  joins.spawn(members.join_task(std::weak_ptr<my_runner>(runner_2)));
+  joins.cancel();
+
+  {
+    lock l(m);
+    blocked[1] = false;
+    cv.notify_all();
+  }
+  BOOST_CHECK_THROW(joins.join_for(ms(500)), std::system_error);
+  BOOST_CHECK_EQUAL(0, joins.pending());
+
+  {
+    lock l(m);
+    blocked[0] = false;
+    cv.notify_all();
+  }
+  BOOST_CHECK(members.join_for(ms(500)));
+  BOOST_CHECK_EQUAL(1, counter.load());
+}
+
+BOOST_AUTO_TEST_CASE(exception)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool caught = false;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        if (value == 3)
+          throw std::runtime_error("failed");
+      }
+  );
+  auto c = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &caught] (const std::shared_ptr<my_runner>& r, const std::runtime_error&) -> void
+      {
+        lock l(m);
+        caught = true;
+        cv.notify_one();
+      }
+  );
+
+  cool::ng::async::task_group group;
+  for (int i = 0; i < 5; ++i)
+    group.spawn(t1, i);
+
+  BOOST_CHECK_THROW(group.join(), std::runtime_error);
+
+  auto task = cool::ng::async::factory::try_catch(group.join_task(std::weak_ptr<my_runner>(runner)), c);
+  {
+    lock l(m);
+    task.run();
+    cv.wait_for(l, ms(500), [&caught] () { return caught; });
+  }
+  BOOST_CHECK(caught);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
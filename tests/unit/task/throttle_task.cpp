@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2017 Leon Mlakar.
+ * Copyright (c) 2017 Digiverse d.o.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. The
+ * license should be included in the source distribution of the Software;
+ * if not, you may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * The above copyright notice and licensing terms shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+
+#define BOOST_TEST_MODULE ThrottleTask
+#include <boost/test/unit_test.hpp>
+
+#include "cool/ng/async.h"
+
+using ms = std::chrono::milliseconds;
+using lock = std::unique_lock<std::mutex>;
+
+BOOST_AUTO_TEST_SUITE(throttle_task)
+
+class my_runner : public cool::ng::async::runner
+{
+ public:
+  my_runner(cool::ng::async::RunPolicy policy_ = cool::ng::async::RunPolicy::SEQUENTIAL)
+    : runner(policy_)
+  { /* noop */ }
+};
+
+BOOST_AUTO_TEST_CASE(limit)
+{
+  auto runner_1 = std::make_shared<my_runner>(cool::ng::async::RunPolicy::CONCURRENT);
+  auto runner_2 = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::atomic<int> in_flight(0);
+  std::atomic<int> max_in_flight(0);
+  int counter = 0;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner_1
+    , [&in_flight, &max_in_flight] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        auto aux = ++in_flight;
+        auto max = max_in_flight.load();
+        while (aux > max && !max_in_flight.compare_exchange_weak(max, aux))
+          ;
+        std::this_thread::sleep_for(ms(5));
+        --in_flight;
+        return value;
+      }
+  );
+  auto t2 = cool::ng::async::factory::create(
+      runner_2
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>& r, int value) -> void
+      {
+        lock l(m);
+        ++counter;
+        cv.notify_one();
+      }
+  );
+
+  auto task = cool::ng::async::factory::sequence(cool::ng::async::factory::throttle(t1, 3), t2);
+
+  static_assert(
+      std::is_same<decltype(cool::ng::async::factory::throttle(t1, 3))::result_type, int>::value
+    , "throttle task must return the result of its subtask");
+
+  for (int i = 0; i < 30; ++i)
+    task.run(i);
+
+  {
+    lock l(m);
+    cv.wait_for(l, ms(2000), [&counter] () { return counter == 30; });
+  }
+
+  BOOST_CHECK_EQUAL(30, counter);
+  BOOST_CHECK(max_in_flight.load() <= 3);
+  BOOST_CHECK(max_in_flight.load() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(exception)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  int counter = 0;
+
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r, int value) -> int
+      {
+        throw std::runtime_error("failed");
+      }
+  );
+  auto c = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>& r, const std::runtime_error&) -> int
+      {
+        lock l(m);
+        ++counter;
+        cv.notify_one();
+        return 0;
+      }
+  );
+
+  // each failed run must free its slot for the next one
+  auto task = cool::ng::async::factory::try_catch(cool::ng::async::factory::throttle(t1, 1), c);
+
+  for (int i = 0; i < 10; ++i)
+    task.run(i);
+
+  {
+    lock l(m);
+    cv.wait_for(l, ms(500), [&counter] () { return counter == 10; });
+  }
+  BOOST_CHECK_EQUAL(10, counter);
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_run)
+{
+  auto runner = std::make_shared<my_runner>();
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool blocked = true;
+  bool started = false;
+  int counter = 0;
+
+  auto blocker = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &blocked, &started] (const std::shared_ptr<my_runner>&)
+      {
+        lock l(m);
+        started = true;
+        cv.notify_all();
+        cv.wait(l, [&blocked] () { return !blocked; });
+      }
+  );
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [&m, &cv, &counter] (const std::shared_ptr<my_runner>& r) -> void
+      {
+        lock l(m);
+        ++counter;
+        cv.notify_all();
+      }
+  );
+  auto task = cool::ng::async::factory::throttle(t1, 1);
+
+  {
+    lock l(m);
+    blocker.run();
+    cv.wait_for(l, ms(500), [&started] () { return started; });
+  }
+  BOOST_REQUIRE(started);
+
+  // the first run takes the only slot, the others would park; the runs are
+  // deleted by the executor without running and must release the slot
+  cool::ng::async::task_group group;
+  for (int i = 0; i < 5; ++i)
+    group.spawn(task);
+  group.cancel();
+
+  {
+    lock l(m);
+    blocked = false;
+    cv.notify_all();
+  }
+  BOOST_CHECK(group.join_for(ms(500)));
+
+  {
+    lock l(m);
+    task.run();
+    cv.wait_for(l, ms(500), [&counter] () { return counter == 1; });
+  }
+  BOOST_CHECK_EQUAL(1, counter);
+}
+
+BOOST_AUTO_TEST_CASE(zero_limit)
+{
+  auto runner = std::make_shared<my_runner>();
+  auto t1 = cool::ng::async::factory::create(
+      runner
+    , [] (const std::shared_ptr<my_runner>& r) -> void
+      { }
+  );
+
+  BOOST_CHECK_THROW(cool::ng::async::factory::throttle(t1, 0), cool::ng::exception::illegal_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()